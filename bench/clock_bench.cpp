@@ -0,0 +1,120 @@
+// Measures the playback clock's error against what a simulated device is
+// actually playing, for the previous estimate (master clock set as audio is
+// handed to SDL, extrapolated on wall time, less SDL's queue) and for
+// AudioDeviceClock. The device runs off its own crystal (a fixed drift
+// against steady_clock), plays each buffer one buffer after requesting it,
+// and its callbacks arrive late by scheduling jitter with the occasional
+// long stall.
+//
+//   cmake -S . -B build -DVIDEO_EDITOR_BENCHMARKS=ON && cmake --build build --target clock-bench
+//   ./build/clock-bench [seconds]
+
+#include "media/AudioDeviceClock.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+static constexpr double SAMPLE_RATE = 48000.0;
+static constexpr double QUERY_INTERVAL = 0.001;  // clock read every millisecond
+static constexpr double VIDEO_FRAME = 1.0 / 60.0;
+
+struct Error {
+    double worst = 0.0;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    long count = 0;
+
+    void add(double e) {
+        worst = std::max(worst, std::abs(e));
+        sum += e;
+        sumSquares += e * e;
+        count++;
+    }
+    double mean() const { return count ? sum / count : 0.0; }
+    double rms() const { return count ? std::sqrt(sumSquares / count) : 0.0; }
+};
+
+// Master clock as before: set (forward only) when a block leaves the ring,
+// read as that time plus wall time since. SDL's callback stream hands each
+// request straight to the device, so nothing stays queued to subtract.
+struct OldClock {
+    double pts = 0.0;
+    double lastUpdate = 0.0;
+    bool set = false;
+
+    void setIfForward(double value, double now) {
+        if (!set || value >= get(now) - 0.1) {
+            pts = value;
+            lastUpdate = now;
+            set = true;
+        }
+    }
+    double get(double now) const { return pts + (now - lastUpdate); }
+};
+
+static void run(int bufferFrames, double driftPpm, double seconds, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> jitter(0.0, 0.001);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    double deviceRate = SAMPLE_RATE * (1.0 + driftPpm * 1e-6);
+    double period = bufferFrames / deviceRate;
+
+    AudioDeviceClock deviceClock;
+    deviceClock.setSampleRate(SAMPLE_RATE);
+    deviceClock.setLatency(bufferFrames);
+    deviceClock.reset();
+    OldClock oldClock;
+    Error oldError, newError;
+
+    // Buffer k is requested at k periods and plays from k + 1 periods on,
+    // so at time t the device is playing frame t * deviceRate - bufferFrames
+    int64_t written = 0;
+    double nextQuery = 0.0;
+    for (int64_t k = 0;; k++) {
+        double ideal = k * period;
+        if (ideal > seconds) break;
+        double late = jitter(rng) + (chance(rng) < 0.01 ? 0.004 : 0.0);
+        double callbackTime = ideal + late;
+
+        // Clock reads between the previous callback and this one
+        for (; nextQuery < callbackTime; nextQuery += QUERY_INTERVAL) {
+            double playing = std::max(nextQuery * deviceRate - bufferFrames, 0.0);
+            double truth = playing / SAMPLE_RATE;
+            if (oldClock.set) oldError.add(oldClock.get(nextQuery) - truth);
+            double estimate;
+            if (deviceClock.get(nextQuery, estimate)) newError.add(estimate - truth);
+        }
+
+        // The callback: the device has consumed everything written so far
+        deviceClock.update(written, callbackTime, bufferFrames);
+        written += bufferFrames;
+        double handedOver = written / SAMPLE_RATE;  // timeline time at the ring's read head
+        deviceClock.anchor(written, handedOver);
+        deviceClock.publish();
+        oldClock.setIfForward(handedOver, callbackTime);
+    }
+
+    printf("%6d frames %+5.0f ppm | old: mean %+7.2f ms worst %6.2f ms | "
+           "new: mean %+6.3f ms rms %6.3f ms worst %6.3f ms %s\n",
+           bufferFrames, driftPpm,
+           oldError.mean() * 1000.0, oldError.worst * 1000.0,
+           newError.mean() * 1000.0, newError.rms() * 1000.0, newError.worst * 1000.0,
+           newError.worst < VIDEO_FRAME ? "" : "(over a video frame)");
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 60.0;
+    if (seconds <= 0.0) seconds = 60.0;
+
+    printf("Playback clock error vs the frame being played, %.0f s per run, "
+           "read every %.0f ms (one video frame at 60 fps = %.1f ms)\n",
+           seconds, QUERY_INTERVAL * 1000.0, VIDEO_FRAME * 1000.0);
+    unsigned seed = 1;
+    for (int bufferFrames : {128, 256, 512, 1024, 2048}) {
+        for (double drift : {-200.0, 0.0, 200.0}) run(bufferFrames, drift, seconds, seed++);
+    }
+    return 0;
+}
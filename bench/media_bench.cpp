@@ -0,0 +1,803 @@
+// Media pipeline benchmarks against the core library (video-editor-core):
+//   - VideoDecoder throughput, RGBA and YUV output, fed by a demux thread
+//     through PacketQueue and drained from FrameQueue as playback does
+//   - handoff latency of PacketQueue, FrameQueue and AudioFrameQueue, from
+//     push() to the consumer seeing the item
+//   - the per-frame CPU colour conversion VideoDecoder does (sws to RGBA,
+//     or the YUV 4:2:0 copy / sws the GPU path takes)
+//   - AudioMixer::fillBuffer cost per block over cached PCM sources
+//
+// Test clips are generated locally with libavfilter (testsrc2 video, sine
+// audio) into a temp directory, at several codecs, resolutions and GOP
+// lengths; clips this FFmpeg has no encoder for are reported as skipped.
+// Results go to stdout as JSON (progress to stderr), so runs can be
+// compared across releases.
+//
+//   cmake -S . -B build -DVIDEO_EDITOR_BENCHMARKS=ON && cmake --build build --target media-bench
+//   ./build/media-bench [--quick] [--keep] [--dir path] > media-bench.json
+
+#include "media/MediaFile.h"
+#include "media/VideoDecoder.h"
+#include "media/PacketQueue.h"
+#include "media/FrameQueue.h"
+#include "media/AudioFrameQueue.h"
+#include "media/AudioMixer.h"
+#include "media/AudioPcmCache.h"
+#include "media/Clock.h"
+#include "timeline/Timeline.h"
+#include "export/Muxer.h"
+#include "export/AudioEncoder.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavutil/avutil.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/log.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int FPS = 30;
+constexpr int CONVERT_FRAMES = 16;
+constexpr int MIX_BLOCK_FRAMES = 512;
+
+struct ClipSpec {
+    const char* name;
+    const char* encoder;
+    int width;
+    int height;
+    int gop;
+    const char* pixelFormat;  // what the encoder is fed
+    const char* options;      // encoder private options, key=value:key=value
+};
+
+const ClipSpec CLIP_SPECS[] = {
+    {"h264-360p-gop30",   "libx264",    640,  360,  30,  "yuv420p",     ""},
+    {"h264-1080p-gop1",   "libx264",    1920, 1080, 1,   "yuv420p",     ""},
+    {"h264-1080p-gop30",  "libx264",    1920, 1080, 30,  "yuv420p",     ""},
+    {"h264-1080p-gop250", "libx264",    1920, 1080, 250, "yuv420p",     ""},
+    {"h264-2160p-gop30",  "libx264",    3840, 2160, 30,  "yuv420p",     ""},
+    {"hevc-1080p-gop30",  "libx265",    1920, 1080, 30,  "yuv420p",     "x265-params=log-level=error"},
+    {"vp9-1080p-gop120",  "libvpx-vp9", 1920, 1080, 120, "yuv420p",     "deadline=good:cpu-used=5:row-mt=1"},
+    {"mpeg4-1080p-gop30", "mpeg4",      1920, 1080, 30,  "yuv420p",     ""},
+    {"mjpeg-1080p",       "mjpeg",      1920, 1080, 1,   "yuvj420p",    ""},
+    {"prores-1080p",      "prores_ks",  1920, 1080, 1,   "yuv422p10le", ""},
+};
+
+const int MIX_SOURCE_COUNTS[] = {8, 32, 128};
+const int MIX_WORKER_COUNTS[] = {0, 3};
+
+double seconds(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Minimal streaming JSON writer; keys and strings are ASCII
+class JsonWriter {
+public:
+    explicit JsonWriter(FILE* out) : m_out(out) {}
+
+    void beginObject(const char* key = nullptr) { open(key, '{'); }
+    void endObject() { close('}'); }
+    void beginArray(const char* key = nullptr) { open(key, '['); }
+    void endArray() { close(']'); }
+
+    void number(const char* key, double value) {
+        prefix(key);
+        if (std::isfinite(value)) fprintf(m_out, "%.6g", value);
+        else fputs("null", m_out);
+    }
+    void integer(const char* key, int64_t value) {
+        prefix(key);
+        fprintf(m_out, "%lld", static_cast<long long>(value));
+    }
+    void boolean(const char* key, bool value) {
+        prefix(key);
+        fputs(value ? "true" : "false", m_out);
+    }
+    void string(const char* key, const std::string& value) {
+        prefix(key);
+        fputc('"', m_out);
+        for (char c : value) {
+            if (c == '"' || c == '\\') fprintf(m_out, "\\%c", c);
+            else if (static_cast<unsigned char>(c) < 0x20) fprintf(m_out, "\\u%04x", c);
+            else fputc(c, m_out);
+        }
+        fputc('"', m_out);
+    }
+
+private:
+    void prefix(const char* key) {
+        if (m_comma) fputc(',', m_out);
+        if (m_depth > 0) fprintf(m_out, "\n%*s", m_depth * 2, "");
+        if (key) fprintf(m_out, "\"%s\": ", key);
+        m_comma = true;
+    }
+    void open(const char* key, char c) {
+        prefix(key);
+        fputc(c, m_out);
+        m_depth++;
+        m_comma = false;
+    }
+    void close(char c) {
+        m_depth--;
+        fprintf(m_out, "\n%*s%c", m_depth * 2, "", c);
+        m_comma = true;
+        if (m_depth == 0) fputc('\n', m_out);
+    }
+
+    FILE* m_out;
+    int m_depth = 0;
+    bool m_comma = false;
+};
+
+struct Summary {
+    size_t samples = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+Summary summarize(std::vector<double> values) {
+    Summary s;
+    if (values.empty()) return s;
+    std::sort(values.begin(), values.end());
+    auto at = [&](double q) { return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))]; };
+    s.samples = values.size();
+    for (double v : values) s.mean += v;
+    s.mean /= values.size();
+    s.p50 = at(0.50);
+    s.p99 = at(0.99);
+    s.max = values.back();
+    return s;
+}
+
+void writeSummary(JsonWriter& json, const char* key, const Summary& s, const char* unit) {
+    std::string suffix = std::string("_") + unit;
+    json.beginObject(key);
+    json.integer("samples", static_cast<int64_t>(s.samples));
+    json.number(("mean" + suffix).c_str(), s.mean);
+    json.number(("p50" + suffix).c_str(), s.p50);
+    json.number(("p99" + suffix).c_str(), s.p99);
+    json.number(("max" + suffix).c_str(), s.max);
+    json.endObject();
+}
+
+// --- Test media ---
+
+// A lavfi source chain (no inputs) ending in a buffersink
+class LavfiSource {
+public:
+    ~LavfiSource() { avfilter_graph_free(&m_graph); }
+
+    bool open(const std::string& description, bool audio) {
+        m_graph = avfilter_graph_alloc();
+        if (!m_graph) return false;
+
+        const AVFilter* sink = avfilter_get_by_name(audio ? "abuffersink" : "buffersink");
+        int ret = avfilter_graph_create_filter(&m_sink, sink, "out", nullptr, nullptr, m_graph);
+
+        AVFilterInOut* inputs = nullptr;
+        AVFilterInOut* outputs = nullptr;
+        if (ret >= 0) ret = avfilter_graph_parse2(m_graph, description.c_str(), &inputs, &outputs);
+        if (ret >= 0 && (inputs || !outputs || outputs->next)) ret = AVERROR(EINVAL);
+        if (ret >= 0) ret = avfilter_link(outputs->filter_ctx, outputs->pad_idx, m_sink, 0);
+        avfilter_inout_free(&inputs);
+        avfilter_inout_free(&outputs);
+        if (ret >= 0) ret = avfilter_graph_config(m_graph, nullptr);
+
+        if (ret < 0) {
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            fprintf(stderr, "media-bench: cannot set up lavfi \"%s\": %s\n", description.c_str(), errbuf);
+            return false;
+        }
+        return true;
+    }
+
+    // Next frame into `frame`; false at the end
+    bool next(AVFrame* frame) { return av_buffersink_get_frame(m_sink, frame) >= 0; }
+
+private:
+    AVFilterGraph* m_graph = nullptr;
+    AVFilterContext* m_sink = nullptr;
+};
+
+bool generateVideoClip(const ClipSpec& spec, const AVCodec* codec, double duration, const std::string& path) {
+    char description[256];
+    snprintf(description, sizeof(description), "testsrc2=size=%dx%d:rate=%d:duration=%g,format=%s",
+             spec.width, spec.height, FPS, duration, spec.pixelFormat);
+    LavfiSource source;
+    if (!source.open(description, false)) return false;
+
+    Muxer muxer;
+    if (!muxer.open(path, "matroska")) return false;
+
+    AVCodecContext* ctx = avcodec_alloc_context3(codec);
+    if (!ctx) return false;
+    ctx->width = spec.width;
+    ctx->height = spec.height;
+    ctx->pix_fmt = av_get_pix_fmt(spec.pixelFormat);
+    if (ctx->pix_fmt == AV_PIX_FMT_YUVJ420P) ctx->color_range = AVCOL_RANGE_JPEG;
+    ctx->time_base = AVRational{1, FPS};
+    ctx->framerate = AVRational{FPS, 1};
+    ctx->gop_size = spec.gop;
+    ctx->max_b_frames = spec.gop > 1 ? 2 : 0;
+    ctx->bit_rate = static_cast<int64_t>(spec.width) * spec.height * FPS / 10;  // 0.1 bit per pixel
+    if (muxer.getFormatContext()->oformat->flags & AVFMT_GLOBALHEADER) {
+        ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    AVDictionary* options = nullptr;
+    if (*spec.options) av_dict_parse_string(&options, spec.options, "=", ":", 0);
+    int ret = avcodec_open2(ctx, codec, &options);
+    av_dict_free(&options);
+    if (ret < 0 || muxer.addVideoStream(ctx) < 0 || !muxer.writeHeader()) {
+        fprintf(stderr, "media-bench: cannot set up encoder %s\n", spec.encoder);
+        avcodec_free_context(&ctx);
+        return false;
+    }
+
+    AVStream* stream = muxer.getVideoStream();
+    AVFrame* frame = av_frame_alloc();
+    AVPacket* pkt = av_packet_alloc();
+    bool ok = true;
+    auto drain = [&] {
+        while (avcodec_receive_packet(ctx, pkt) >= 0) {
+            av_packet_rescale_ts(pkt, ctx->time_base, stream->time_base);
+            pkt->stream_index = stream->index;
+            ok = muxer.writePacket(pkt) && ok;
+        }
+    };
+
+    int64_t index = 0;
+    while (ok && source.next(frame)) {
+        frame->pts = index++;
+        frame->pict_type = AV_PICTURE_TYPE_NONE;
+        ok = avcodec_send_frame(ctx, frame) >= 0;
+        av_frame_unref(frame);
+        drain();
+    }
+    avcodec_send_frame(ctx, nullptr);
+    drain();
+    ok = muxer.writeTrailer() && ok && index > 0;
+
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&ctx);
+    return ok;
+}
+
+// Stereo 48 kHz sine, encoded the way export encodes audio
+bool generateAudioClip(double duration, const std::string& path) {
+    char description[256];
+    snprintf(description, sizeof(description),
+             "sine=frequency=440:sample_rate=%d:duration=%g,aformat=sample_fmts=flt:channel_layouts=stereo",
+             AudioMixer::OUTPUT_SAMPLE_RATE, duration);
+    LavfiSource source;
+    if (!source.open(description, true)) return false;
+
+    Muxer muxer;
+    AudioEncoder encoder;
+    ExportSettings settings;
+    if (!muxer.open(path, "matroska") ||
+        !encoder.init(settings, muxer.getFormatContext()->oformat->flags) ||
+        muxer.addAudioStream(encoder.getCodecContext()) < 0 || !muxer.writeHeader()) {
+        return false;
+    }
+
+    AVStream* stream = muxer.getAudioStream();
+    AVRational codecTimeBase = encoder.getCodecContext()->time_base;
+    bool ok = true;
+    auto write = [&](AVPacket* pkt) {
+        av_packet_rescale_ts(pkt, codecTimeBase, stream->time_base);
+        pkt->stream_index = stream->index;
+        ok = muxer.writePacket(pkt) && ok;
+    };
+
+    AVFrame* frame = av_frame_alloc();
+    while (ok && source.next(frame)) {
+        ok = encoder.encode(reinterpret_cast<const float*>(frame->data[0]), frame->nb_samples, write);
+        av_frame_unref(frame);
+    }
+    av_frame_free(&frame);
+    ok = encoder.flush(write) && ok;
+    return muxer.writeTrailer() && ok;
+}
+
+// --- Video decode ---
+
+struct DecodeResult {
+    bool ok = false;
+    int frames = 0;
+    double seconds = 0.0;
+    std::string sourceFormat;
+};
+
+// Demux -> PacketQueue -> VideoDecoder -> FrameQueue, as a clip plays, as
+// fast as the decoder goes. The demuxer ends with an empty packet, which
+// drains the decoder's delayed frames.
+DecodeResult benchDecode(const std::string& path, bool yuvOutput) {
+    DecodeResult result;
+    MediaFile file;
+    if (!file.open(path)) return result;
+
+    AVStream* stream = file.getVideoStream();
+    VideoDecoder decoder;
+    PacketQueue packets;
+    FrameQueue frames;
+    if (!decoder.init(file.getVideoCodecPar(), stream->time_base, stream->avg_frame_rate, yuvOutput) ||
+        !frames.allocate(decoder.getWidth(), decoder.getHeight(), nullptr, decoder.getOutputFormat())) {
+        return result;
+    }
+    const char* formatName = av_get_pix_fmt_name(decoder.getCodecContext()->pix_fmt);
+    result.sourceFormat = formatName ? formatName : "unknown";
+
+    std::atomic<int> packetCount{0};
+    std::atomic<bool> demuxed{false};
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread demux([&] {
+        AVFormatContext* fmt = file.getFormatContext();
+        int videoIndex = file.getVideoStreamIndex();
+        for (;;) {
+            AVPacket* pkt = av_packet_alloc();
+            if (av_read_frame(fmt, pkt) < 0) {
+                av_packet_unref(pkt);
+                packets.push(pkt);
+                break;
+            }
+            if (pkt->stream_index != videoIndex) {
+                av_packet_free(&pkt);
+                continue;
+            }
+            packetCount.fetch_add(1);
+            if (!packets.push(pkt)) break;
+        }
+        demuxed.store(true);
+    });
+    decoder.start(packets, frames);
+
+    // Every packet is one frame in these clips. Poll like the render loop,
+    // without taking CPU from the decoder's threads.
+    auto last = start;
+    while (!demuxed.load() || result.frames < packetCount.load()) {
+        if (frames.peek()) {
+            frames.pop();
+            result.frames++;
+            last = std::chrono::steady_clock::now();
+            continue;
+        }
+        if (seconds(std::chrono::steady_clock::now() - last) > 5.0) {
+            fprintf(stderr, "media-bench: %s: decoder stalled after %d of %d frames\n",
+                    path.c_str(), result.frames, packetCount.load());
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    result.seconds = seconds(last - start);
+    result.ok = result.frames > 0 && result.frames == packetCount.load();
+
+    packets.abort();
+    frames.abort();
+    decoder.stop();
+    demux.join();
+    return result;
+}
+
+// --- Colour conversion ---
+
+// The first `count` decoded frames of the video stream
+std::vector<AVFrame*> decodeFrames(const std::string& path, int count) {
+    std::vector<AVFrame*> decoded;
+    MediaFile file;
+    if (!file.open(path)) return decoded;
+
+    const AVCodecParameters* par = file.getVideoCodecPar();
+    const AVCodec* codec = avcodec_find_decoder(par->codec_id);
+    AVCodecContext* ctx = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (!ctx || avcodec_parameters_to_context(ctx, par) < 0 || avcodec_open2(ctx, codec, nullptr) < 0) {
+        avcodec_free_context(&ctx);
+        return decoded;
+    }
+
+    AVPacket* pkt = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    bool draining = false;
+    while (static_cast<int>(decoded.size()) < count) {
+        int ret = avcodec_receive_frame(ctx, frame);
+        if (ret >= 0) {
+            decoded.push_back(av_frame_clone(frame));
+            av_frame_unref(frame);
+            continue;
+        }
+        if (ret != AVERROR(EAGAIN) || draining) break;
+
+        if (av_read_frame(file.getFormatContext(), pkt) < 0) {
+            avcodec_send_packet(ctx, nullptr);
+            draining = true;
+            continue;
+        }
+        if (pkt->stream_index == file.getVideoStreamIndex()) avcodec_send_packet(ctx, pkt);
+        av_packet_unref(pkt);
+    }
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avcodec_free_context(&ctx);
+    return decoded;
+}
+
+// Milliseconds per frame for what VideoDecoder does to each decoded frame:
+// sws to RGBA, or for YUV output a plane copy (4:2:0 sources) or sws to
+// yuv420p, into a packed slot-sized buffer
+double benchConvert(const std::vector<AVFrame*>& decoded, bool yuvOutput, double minSeconds) {
+    const AVFrame* first = decoded.front();
+    int width = first->width;
+    int height = first->height;
+    auto srcFormat = static_cast<AVPixelFormat>(first->format);
+    AVPixelFormat dstFormat = yuvOutput ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_RGBA;
+    bool copy = yuvOutput && (srcFormat == AV_PIX_FMT_YUV420P || srcFormat == AV_PIX_FMT_YUVJ420P);
+
+    SwsContext* sws = nullptr;
+    if (!copy) {
+        sws = sws_getContext(width, height, srcFormat, width, height, dstFormat,
+                             SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!sws) return NAN;
+    }
+
+    std::vector<uint8_t> slot(av_image_get_buffer_size(dstFormat, width, height, 1));
+    uint8_t* dstPlanes[4] = {};
+    int dstStrides[4] = {};
+    av_image_fill_arrays(dstPlanes, dstStrides, slot.data(), dstFormat, width, height, 1);
+
+    int frames = 0;
+    auto start = std::chrono::steady_clock::now();
+    do {
+        for (const AVFrame* frame : decoded) {
+            if (sws) {
+                sws_scale(sws, frame->data, frame->linesize, 0, height, dstPlanes, dstStrides);
+            } else {
+                av_image_copy(dstPlanes, dstStrides, const_cast<const uint8_t**>(frame->data), frame->linesize,
+                              dstFormat, width, height);
+            }
+            frames++;
+        }
+    } while (seconds(std::chrono::steady_clock::now() - start) < minSeconds);
+    double elapsed = seconds(std::chrono::steady_clock::now() - start);
+
+    if (sws) sws_freeContext(sws);
+    return elapsed / frames * 1000.0;
+}
+
+// --- Queue handoff ---
+//
+// The producer pushes an item stamped with the time, then sleeps a little
+// so the consumer is waiting (or polling) for it; latency is push() to the
+// consumer holding the item. PacketQueue's consumer blocks in pop(); the
+// frame queues' consumers poll, as the render loop and audio callback do,
+// here back to back so only the queue itself is measured.
+
+constexpr auto PRODUCER_GAP = std::chrono::microseconds(50);
+
+Summary benchPacketQueue(int samples) {
+    PacketQueue queue;
+    std::vector<double> latency;
+    latency.reserve(samples);
+
+    std::thread producer([&] {
+        for (int i = 0; i < samples; i++) {
+            AVPacket* pkt = av_packet_alloc();
+            pkt->pts = nowNs();
+            if (!queue.push(pkt)) break;
+            std::this_thread::sleep_for(PRODUCER_GAP);
+        }
+    });
+    while (static_cast<int>(latency.size()) < samples) {
+        AVPacket* pkt = queue.pop(1000);
+        if (!pkt) break;
+        latency.push_back((nowNs() - pkt->pts) / 1000.0);
+        av_packet_free(&pkt);
+    }
+    queue.abort();
+    producer.join();
+    return summarize(std::move(latency));
+}
+
+Summary benchFrameQueue(int samples) {
+    FrameQueue queue;
+    std::vector<double> latency;
+    latency.reserve(samples);
+    if (!queue.allocate(64, 64)) return {};
+
+    std::thread producer([&] {
+        for (int i = 0; i < samples; i++) {
+            int linesize;
+            uint8_t* dst = queue.getWriteBuffer(linesize);
+            if (!dst) break;
+            dst[0] = static_cast<uint8_t>(i);
+            queue.push(nowNs(), 0);
+            std::this_thread::sleep_for(PRODUCER_GAP);
+        }
+    });
+    while (static_cast<int>(latency.size()) < samples) {
+        int64_t pts;
+        if (queue.peek(&pts)) {
+            latency.push_back((nowNs() - pts) / 1000.0);
+            queue.pop();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    return summarize(std::move(latency));
+}
+
+Summary benchAudioFrameQueue(int samples) {
+    AudioFrameQueue queue;
+    std::vector<double> latency;
+    latency.reserve(samples);
+
+    std::thread producer([&] {
+        AVFrame* frame = av_frame_alloc();
+        AVChannelLayout stereo = AV_CHANNEL_LAYOUT_STEREO;
+        for (int i = 0; i < samples; i++) {
+            frame->format = AV_SAMPLE_FMT_FLT;
+            frame->sample_rate = AudioMixer::OUTPUT_SAMPLE_RATE;
+            frame->nb_samples = 1024;
+            av_channel_layout_copy(&frame->ch_layout, &stereo);
+            if (av_frame_get_buffer(frame, 0) < 0) break;
+            frame->pts = nowNs();
+            if (!queue.push(frame, 0)) break;
+            std::this_thread::sleep_for(PRODUCER_GAP);
+        }
+        av_frame_free(&frame);
+    });
+    while (static_cast<int>(latency.size()) < samples) {
+        if (AVFrame* frame = queue.peek()) {
+            latency.push_back((nowNs() - frame->pts) / 1000.0);
+            queue.pop();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    return summarize(std::move(latency));
+}
+
+// --- Audio mix ---
+
+// `sourceCount` clips of the cached sine, four to a track, every other one
+// with a volume curve, mixed MIX_BLOCK_FRAMES at a time for `duration`.
+// Returns microseconds per block.
+Summary benchMixer(const PcmBuffer* pcm, int sourceCount, int workers, double duration) {
+    double pcmSeconds = static_cast<double>(pcm->getFrameCount()) / PcmBuffer::SAMPLE_RATE;
+    int trackCount = (sourceCount + 3) / 4;
+
+    std::vector<Track> tracks(trackCount);
+    for (int t = 0; t < trackCount; t++) {
+        tracks[t].id = t + 1;
+        tracks[t].type = TrackType::Audio;
+        tracks[t].volume = 0.8f;
+        tracks[t].pan = (t % 2) ? 0.3f : -0.3f;
+    }
+
+    std::vector<Clip> clips(sourceCount);
+    std::vector<AudioMixSource> sources;
+    for (int i = 0; i < sourceCount; i++) {
+        Clip& clip = clips[i];
+        clip.id = i + 1;
+        clip.trackId = tracks[i / 4].id;
+        clip.sourceIn = pcm->getStartTime() + std::fmod(i * 0.37, 1.0);
+        clip.sourceOut = pcm->getStartTime() + pcmSeconds;
+        if (i % 2) clip.volumeCurve = AutomationCurve({{0.0, 1.0f}, {duration, 0.5f}});
+
+        AudioMixSource src;
+        src.pcm = pcm;
+        src.clip = &clip;
+        src.track = &tracks[i / 4];
+        src.clipId = clip.id;
+        sources.push_back(src);
+    }
+
+    AudioMixer mixer;
+    mixer.setWorkerCount(workers);
+    mixer.setPlayhead(0.0);
+    mixer.setSources(std::move(sources));
+
+    Clock clock;
+    std::vector<float> out(MIX_BLOCK_FRAMES * AudioMixer::OUTPUT_CHANNELS);
+    int blocks = static_cast<int>(duration * AudioMixer::OUTPUT_SAMPLE_RATE / MIX_BLOCK_FRAMES);
+    std::vector<double> cost;
+    cost.reserve(blocks);
+    for (int b = 0; b < blocks; b++) {
+        auto start = std::chrono::steady_clock::now();
+        mixer.fillBuffer(out.data(), MIX_BLOCK_FRAMES, clock);
+        cost.push_back(seconds(std::chrono::steady_clock::now() - start) * 1e6);
+    }
+    mixer.clearSources();
+    mixer.reclaim();
+    return summarize(std::move(cost));
+}
+
+void usage() {
+    fprintf(stderr,
+            "usage: media-bench [--quick] [--keep] [--dir path]\n"
+            "  --quick     shorter clips and runs\n"
+            "  --keep      keep the generated media (and reuse clips already there)\n"
+            "  --dir path  where clips are generated (default: a temp directory)\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    bool keep = false;
+    std::string dir;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) {
+            quick = true;
+        } else if (!strcmp(argv[i], "--keep")) {
+            keep = true;
+        } else if (!strcmp(argv[i], "--dir") && i + 1 < argc) {
+            dir = argv[++i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    std::error_code ec;
+    if (dir.empty()) dir = (fs::temp_directory_path(ec) / "video-editor-media-bench").string();
+    fs::create_directories(dir, ec);
+    if (ec) {
+        fprintf(stderr, "media-bench: cannot create %s: %s\n", dir.c_str(), ec.message().c_str());
+        return 1;
+    }
+
+    av_log_set_level(AV_LOG_ERROR);
+
+    double clipSeconds = quick ? 2.0 : 5.0;
+    double mixSeconds = quick ? 3.0 : 10.0;
+    double convertSeconds = quick ? 0.2 : 0.5;
+    int latencySamples = quick ? 2000 : 20000;
+
+    JsonWriter json(stdout);
+    json.beginObject();
+    json.string("benchmark", "media-bench");
+    json.integer("schema", 1);
+    json.string("ffmpeg", av_version_info());
+    json.integer("hardware_threads", std::thread::hardware_concurrency());
+    json.boolean("quick", quick);
+
+    // Video clips: decode and conversion
+    json.beginArray("clips");
+    for (const ClipSpec& spec : CLIP_SPECS) {
+        json.beginObject();
+        json.string("name", spec.name);
+        json.string("encoder", spec.encoder);
+        json.integer("width", spec.width);
+        json.integer("height", spec.height);
+        json.integer("gop", spec.gop);
+        json.string("pixel_format", spec.pixelFormat);
+
+        const AVCodec* codec = avcodec_find_encoder_by_name(spec.encoder);
+        char file[64];
+        snprintf(file, sizeof(file), "%s-%gs.mkv", spec.name, clipSeconds);
+        std::string path = (fs::path(dir) / file).string();
+
+        std::string skipped;
+        if (!codec) {
+            skipped = std::string("no ") + spec.encoder + " encoder";
+        } else if (!(keep && fs::exists(path, ec))) {
+            fprintf(stderr, "media-bench: generating %s\n", spec.name);
+            if (!generateVideoClip(spec, codec, clipSeconds, path)) skipped = "generation failed";
+        }
+        if (!skipped.empty()) {
+            fprintf(stderr, "media-bench: skipping %s: %s\n", spec.name, skipped.c_str());
+            json.string("skipped", skipped);
+            json.endObject();
+            continue;
+        }
+
+        fprintf(stderr, "media-bench: decoding %s\n", spec.name);
+        const std::pair<const char*, bool> modes[] = {{"decode_rgba", false}, {"decode_yuv", true}};
+        for (const auto& [key, yuv] : modes) {
+            DecodeResult result = benchDecode(path, yuv);
+            json.beginObject(key);
+            json.boolean("ok", result.ok);
+            json.integer("frames", result.frames);
+            json.number("seconds", result.seconds);
+            json.number("fps", result.seconds > 0.0 ? result.frames / result.seconds : NAN);
+            json.number("ms_per_frame", result.frames > 0 ? result.seconds / result.frames * 1000.0 : NAN);
+            if (!yuv) json.string("source_pixel_format", result.sourceFormat);
+            json.endObject();
+        }
+
+        std::vector<AVFrame*> decoded = decodeFrames(path, CONVERT_FRAMES);
+        if (!decoded.empty()) {
+            json.beginObject("convert");
+            json.integer("frames", static_cast<int64_t>(decoded.size()));
+            json.number("rgba_ms_per_frame", benchConvert(decoded, false, convertSeconds));
+            json.number("yuv_ms_per_frame", benchConvert(decoded, true, convertSeconds));
+            json.endObject();
+        }
+        for (AVFrame*& frame : decoded) av_frame_free(&frame);
+        json.endObject();
+
+        if (!keep) fs::remove(path, ec);
+    }
+    json.endArray();
+
+    // Queue handoff
+    fprintf(stderr, "media-bench: queue handoff latency\n");
+    json.beginObject("queues");
+    writeSummary(json, "packet_queue", benchPacketQueue(latencySamples), "us");
+    writeSummary(json, "frame_queue", benchFrameQueue(latencySamples), "us");
+    writeSummary(json, "audio_frame_queue", benchAudioFrameQueue(latencySamples), "us");
+    json.endObject();
+
+    // Audio mix, over the sine decoded into the PCM cache
+    json.beginArray("mixer");
+    std::string audioPath = (fs::path(dir) / "sine.mkv").string();
+    std::shared_ptr<const PcmBuffer> pcm;
+    AudioPcmCache pcmCache;
+    fprintf(stderr, "media-bench: generating sine\n");
+    if (generateAudioClip(mixSeconds + 2.0, audioPath)) {
+        pcmCache.start((fs::path(dir) / "audio").string());
+        auto start = std::chrono::steady_clock::now();
+        while (!(pcm = pcmCache.get(1, audioPath)) && seconds(std::chrono::steady_clock::now() - start) < 60.0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    if (!pcm) fprintf(stderr, "media-bench: no PCM for the mixer benchmark\n");
+
+    double blockMicros = MIX_BLOCK_FRAMES * 1e6 / AudioMixer::OUTPUT_SAMPLE_RATE;
+    for (int sourceCount : MIX_SOURCE_COUNTS) {
+        for (int workers : MIX_WORKER_COUNTS) {
+            if (!pcm) break;
+            fprintf(stderr, "media-bench: mixing %d sources, %d workers\n", sourceCount, workers);
+            Summary cost = benchMixer(pcm.get(), sourceCount, workers, mixSeconds);
+            json.beginObject();
+            json.integer("sources", sourceCount);
+            json.integer("workers", workers);
+            json.integer("block_frames", MIX_BLOCK_FRAMES);
+            writeSummary(json, "block", cost, "us");
+            json.number("mean_realtime_percent", cost.mean / blockMicros * 100.0);
+            json.number("max_realtime_percent", cost.max / blockMicros * 100.0);
+            json.endObject();
+        }
+    }
+    json.endArray();
+    json.endObject();
+
+    pcm.reset();
+    pcmCache.shutdown();
+    if (!keep) {
+        // Only what was generated here; the directory goes if that empties it
+        fs::remove(audioPath, ec);
+        fs::remove_all(fs::path(dir) / "audio", ec);
+        fs::remove(dir, ec);
+    }
+    return 0;
+}
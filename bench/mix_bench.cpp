@@ -0,0 +1,98 @@
+// Mixes 64 sources into one output block, comparing the previous mixer loop
+// (copy to a temp buffer, scalar gain-accumulate, scalar clamp) with the
+// fused MixKernels path, for mono, stereo and 5.1.
+//
+//   cmake -S . -B build -DVIDEO_EDITOR_BENCHMARKS=ON && cmake --build build --target mix-bench
+//   ./build/mix-bench [iterations]
+
+#include "media/MixKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static constexpr int SOURCE_COUNT = 64;
+static constexpr int BLOCK_FRAMES = 512;
+
+template <int Channels>
+static void mixScalar(const std::vector<std::vector<float>>& sources, const std::vector<float>& gains,
+                      std::vector<float>& temp, float* out) {
+    const int samples = BLOCK_FRAMES * Channels;
+    memset(out, 0, samples * sizeof(float));
+    for (size_t s = 0; s < sources.size(); s++) {
+        memcpy(temp.data(), sources[s].data(), samples * sizeof(float));
+        for (int i = 0; i < samples; i++) out[i] += temp[i] * gains[s];
+    }
+    for (int i = 0; i < samples; i++) out[i] = std::clamp(out[i], -1.0f, 1.0f);
+}
+
+template <int Channels>
+static void mixFused(const std::vector<std::vector<float>>& sources, const std::vector<float>& gains,
+                     const std::vector<float>& prevGains, float* out) {
+    const int samples = BLOCK_FRAMES * Channels;
+    memset(out, 0, samples * sizeof(float));
+    for (size_t s = 0; s < sources.size(); s++) {
+        float step = (gains[s] - prevGains[s]) / BLOCK_FRAMES;
+        MixKernels::mixRamp<Channels>(out, sources[s].data(), BLOCK_FRAMES, prevGains[s], step);
+    }
+    MixKernels::clamp(out, samples);
+}
+
+template <int Channels>
+static void run(const char* name, int iterations) {
+    const int samples = BLOCK_FRAMES * Channels;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> sample(-0.05f, 0.05f);
+    std::uniform_real_distribution<float> level(0.2f, 1.0f);
+
+    std::vector<std::vector<float>> sources(SOURCE_COUNT, std::vector<float>(samples));
+    std::vector<float> gains(SOURCE_COUNT);
+    for (auto& src : sources) for (auto& v : src) v = sample(rng);
+    for (auto& g : gains) g = level(rng);
+
+    std::vector<float> temp(samples), outScalar(samples), outFused(samples);
+
+    // Same gains at both block ends: results must match the scalar loop
+    mixScalar<Channels>(sources, gains, temp, outScalar.data());
+    mixFused<Channels>(sources, gains, gains, outFused.data());
+    float maxDiff = 0.0f;
+    for (int i = 0; i < samples; i++) maxDiff = std::max(maxDiff, std::fabs(outScalar[i] - outFused[i]));
+
+    using clock = std::chrono::steady_clock;
+    double checksum = 0.0;
+
+    auto t0 = clock::now();
+    for (int it = 0; it < iterations; it++) {
+        mixScalar<Channels>(sources, gains, temp, outScalar.data());
+        checksum += outScalar[it % samples];
+    }
+    auto t1 = clock::now();
+
+    // Ramped: every source changes gain across every block
+    std::vector<float> prevGains(gains.rbegin(), gains.rend());
+    for (int it = 0; it < iterations; it++) {
+        mixFused<Channels>(sources, gains, prevGains, outFused.data());
+        checksum += outFused[it % samples];
+    }
+    auto t2 = clock::now();
+
+    double scalarUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / iterations;
+    double fusedUs = std::chrono::duration<double, std::micro>(t2 - t1).count() / iterations;
+    double blockUs = 1e6 * BLOCK_FRAMES / 48000.0;
+    printf("%-7s scalar %8.2f us  fused+ramp %8.2f us  speedup %5.2fx  (%.1f%% of a %.0f us block, max diff %.2g, checksum %.3f)\n",
+           name, scalarUs, fusedUs, scalarUs / fusedUs, 100.0 * fusedUs / blockUs, blockUs,
+           maxDiff, checksum);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::max(1, atoi(argv[1])) : 20000;
+    printf("%d sources x %d frames, %d iterations\n", SOURCE_COUNT, BLOCK_FRAMES, iterations);
+    run<1>("mono", iterations);
+    run<2>("stereo", iterations);
+    run<6>("5.1", iterations);
+    return 0;
+}
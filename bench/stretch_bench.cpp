@@ -0,0 +1,88 @@
+// Time-stretches 16 tracks at once, as the mixer does for retimed clips:
+// each pulls one output block at a time and is fed from its source as it
+// runs dry. Reports the cost per block against the block's playback time,
+// the worst block included (that's the one that would glitch).
+//
+//   cmake -S . -B build -DVIDEO_EDITOR_BENCHMARKS=ON && cmake --build build --target stretch-bench
+//   ./build/stretch-bench [seconds]
+
+#include "media/TimeStretch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+static constexpr int TRACK_COUNT = 16;
+static constexpr int BLOCK_FRAMES = 512;
+static constexpr double SAMPLE_RATE = 48000.0;
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 30.0;
+    if (seconds <= 0.0) seconds = 30.0;
+
+    // Source: tones plus noise, long enough for the fastest track
+    int sourceFrames = static_cast<int>(seconds * TimeStretch::MAX_SPEED * SAMPLE_RATE) + 48000;
+    std::vector<float> source(static_cast<size_t>(sourceFrames) * TimeStretch::CHANNELS);
+    std::mt19937 rng(1);
+    std::normal_distribution<float> noise(0.0f, 0.02f);
+    for (int i = 0; i < sourceFrames; i++) {
+        double t = i / SAMPLE_RATE;
+        float v = 0.2f * static_cast<float>(std::sin(2.0 * 3.14159265 * 220.0 * t) +
+                                            0.5 * std::sin(2.0 * 3.14159265 * 331.0 * t));
+        source[2 * i] = v + noise(rng);
+        source[2 * i + 1] = v + noise(rng);
+    }
+
+    struct Track {
+        std::unique_ptr<TimeStretch> stretch;
+        int64_t input = 0;
+        double speed = 1.0;
+    };
+    std::vector<Track> tracks(TRACK_COUNT);
+    for (int i = 0; i < TRACK_COUNT; i++) {
+        Track& track = tracks[i];
+        track.speed = TimeStretch::MIN_SPEED * std::pow(TimeStretch::MAX_SPEED / TimeStretch::MIN_SPEED,
+                                                        i / (TRACK_COUNT - 1.0));
+        track.stretch = std::make_unique<TimeStretch>();
+        track.stretch->reset(track.speed, 0);
+        track.input = track.stretch->seekOutput(0);
+    }
+
+    int blocks = static_cast<int>(seconds * SAMPLE_RATE / BLOCK_FRAMES);
+    double blockSeconds = BLOCK_FRAMES / SAMPLE_RATE;
+    std::vector<float> out(BLOCK_FRAMES * TimeStretch::CHANNELS);
+    double total = 0.0, worst = 0.0;
+    double checksum = 0.0;
+
+    for (int b = 0; b < blocks; b++) {
+        auto start = std::chrono::steady_clock::now();
+        for (Track& track : tracks) {
+            int frames = 0;
+            while (frames < BLOCK_FRAMES) {
+                int got = track.stretch->pull(out.data() + frames * TimeStretch::CHANNELS, BLOCK_FRAMES - frames);
+                frames += got;
+                if (got == 0) {
+                    int count = std::min<int64_t>(4096, sourceFrames - track.input);
+                    track.input += track.stretch->push(source.data() + track.input * TimeStretch::CHANNELS, count);
+                }
+            }
+            checksum += out[0];
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        total += elapsed;
+        worst = std::max(worst, elapsed);
+    }
+
+    printf("%d tracks, speeds %.2fx - %.2fx, %d-frame blocks (%.2f ms), %.0f s\n",
+           TRACK_COUNT, TimeStretch::MIN_SPEED, TimeStretch::MAX_SPEED, BLOCK_FRAMES, blockSeconds * 1000.0, seconds);
+    printf("  mean %.3f ms per block (%.1f%% of real time), worst %.3f ms (%.1f%%)\n",
+           total / blocks * 1000.0, total / blocks / blockSeconds * 100.0,
+           worst * 1000.0, worst / blockSeconds * 100.0);
+    printf("  per track: %.1f us per block, %.0fx faster than real time   [checksum %.3f]\n",
+           total / blocks / TRACK_COUNT * 1e6, blockSeconds * TRACK_COUNT / (total / blocks), checksum);
+    return 0;
+}
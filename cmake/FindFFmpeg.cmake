@@ -2,11 +2,13 @@
 include(FindPackageHandleStandardArgs)
 
 set(FFMPEG_COMPONENTS avcodec avformat avutil swscale swresample)
+# Found if present, as FFmpeg::<name> only (not part of FFmpeg::FFmpeg)
+set(FFMPEG_OPTIONAL_COMPONENTS avfilter)
 
 set(FFMPEG_INCLUDE_DIRS "")
 set(FFMPEG_LIBRARIES "")
 
-foreach(comp ${FFMPEG_COMPONENTS})
+foreach(comp ${FFMPEG_COMPONENTS} ${FFMPEG_OPTIONAL_COMPONENTS})
     find_package(PkgConfig QUIET)
     if(PkgConfig_FOUND)
         pkg_check_modules(FF_${comp} QUIET lib${comp})
@@ -26,8 +28,10 @@ foreach(comp ${FFMPEG_COMPONENTS})
 
     if(${comp}_INCLUDE_DIR AND ${comp}_LIBRARY)
         set(FFmpeg_${comp}_FOUND TRUE)
-        list(APPEND FFMPEG_INCLUDE_DIRS ${${comp}_INCLUDE_DIR})
-        list(APPEND FFMPEG_LIBRARIES ${${comp}_LIBRARY})
+        if(comp IN_LIST FFMPEG_COMPONENTS)
+            list(APPEND FFMPEG_INCLUDE_DIRS ${${comp}_INCLUDE_DIR})
+            list(APPEND FFMPEG_LIBRARIES ${${comp}_LIBRARY})
+        endif()
 
         if(NOT TARGET FFmpeg::${comp})
             add_library(FFmpeg::${comp} IMPORTED INTERFACE)
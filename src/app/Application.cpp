@@ -1,8 +1,10 @@
 #include "app/Application.h"
 #include <SDL3/SDL_vulkan.h>
 #include <imgui.h>
+#include <chrono>
 #include <cstdio>
 #include <cmath>
+#include <utility>
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -51,9 +53,19 @@ bool Application::init(const std::string& filePath) {
     // Initialize TimelinePlayback orchestrator
     m_timelinePlayback.setTimeline(&m_timeline);
     m_timelinePlayback.setAudioOutput(&m_audioOutput);
+    m_audioCache.start();
+    m_timelinePlayback.setAudioCache(&m_audioCache);
     m_timelinePlayback.setVerbose(m_verbose);
     m_timelinePlayback.init(m_vkCtx);
 
+    // Thumbnails are optional: without the atlas clips are drawn plain
+    if (m_thumbnailAtlas.init(m_vkCtx, ThumbnailService::THUMB_WIDTH, ThumbnailService::THUMB_HEIGHT)) {
+        m_thumbnails.start();
+        m_timelineUI.setThumbnails(&m_thumbnails, &m_thumbnailAtlas);
+    }
+    m_waveforms.start();
+    m_timelineUI.setWaveforms(&m_waveforms);
+
     if (m_verbose) {
         fprintf(stderr, "[APP] Verbose logging enabled\n");
     }
@@ -64,6 +76,9 @@ bool Application::init(const std::string& filePath) {
     m_playerUI.onStop = [this]() { m_timelinePlayback.stop(); };
     m_playerUI.onSeek = [this](double t) { m_timelinePlayback.seek(t); };
 
+    // Start the import worker pool before anything can be queued
+    m_importer.start(m_importSettings);
+
     // Setup file dialog callback
     m_fileDialog.setCallback([this](const std::string& path) {
         importToTimeline(path);
@@ -79,43 +94,80 @@ bool Application::init(const std::string& filePath) {
 }
 
 void Application::importToTimeline(const std::string& path) {
-    uint32_t assetId = m_timeline.importFile(path);
-    if (assetId == 0) {
-        fprintf(stderr, "Failed to import to timeline: %s\n", path.c_str());
-        return;
-    }
+    // Placeholder clip goes on the timeline now; metadata arrives via pollImports()
+    uint32_t assetId = m_timeline.beginImport(path);
+    m_importer.enqueue(assetId, path);
 
     if (m_verbose) {
-        const auto* asset = m_timeline.getAsset(assetId);
-        if (asset) {
-            fprintf(stderr, "[APP] Imported asset %u: %s (type=%d video=%d audio=%d "
-                    "dur=%.2fs %dx%d %.1ffps sr=%d ch=%d)\n",
-                    assetId, path.c_str(), (int)asset->type,
-                    asset->hasVideo, asset->hasAudio,
-                    asset->duration, asset->width, asset->height,
-                    asset->fps, asset->sampleRate, asset->channels);
+        fprintf(stderr, "[APP] Queued import of asset %u: %s (%zu pending)\n",
+                assetId, path.c_str(), m_importer.pendingCount());
+    }
+}
+
+void Application::pollImports() {
+    auto results = m_importer.takeResults();
+    if (results.empty()) return;
+
+    bool anyImported = false;
+    for (auto& result : results) {
+        if (!result.ok) {
+            const auto* asset = std::as_const(m_timeline).getAsset(result.assetId);
+            fprintf(stderr, "Failed to import to timeline: %s (%s)\n",
+                    asset ? asset->filePath.c_str() : "?", result.error.c_str());
+            m_timeline.failImport(result.assetId);
+            continue;
+        }
+
+        uint32_t assetId = result.assetId;
+        if (!m_timeline.completeImport(assetId, std::move(result.asset))) continue;
+        anyImported = true;
+
+        // Start decoding audio for playback right away, not when first played
+        if (const auto* asset = std::as_const(m_timeline).getAsset(assetId); asset && asset->hasAudio) {
+            m_audioCache.get(assetId, asset->filePath);
         }
-        // Log clips created
-        for (auto& [clipId, clip] : m_timeline.getAllClips()) {
-            if (clip.assetId == assetId) {
-                const auto* track = m_timeline.getTrack(clip.trackId);
-                fprintf(stderr, "[APP]   clip %u on track '%s' [%.2f - %.2f] src[%.2f - %.2f]\n",
-                        clipId, track ? track->name.c_str() : "?",
-                        clip.timelineStart, clip.getTimelineEnd(),
-                        clip.sourceIn, clip.sourceOut);
+
+        if (m_verbose) {
+            const auto* asset = std::as_const(m_timeline).getAsset(assetId);
+            if (asset) {
+                fprintf(stderr, "[APP] Imported asset %u: %s (type=%d video=%d audio=%d "
+                        "dur=%.2fs %dx%d %.1ffps sr=%d ch=%d)\n",
+                        assetId, asset->filePath.c_str(), (int)asset->type,
+                        asset->hasVideo, asset->hasAudio,
+                        asset->duration, asset->width, asset->height,
+                        asset->fps, asset->sampleRate, asset->channels);
+            }
+            // Log clips created
+            for (auto& [clipId, entry] : m_timeline.getAllClips()) {
+                if (entry.assetId == assetId) {
+                    const Clip& clip = *std::as_const(m_timeline).getClip(clipId);
+                    const auto* track = std::as_const(m_timeline).getTrack(clip.trackId);
+                    fprintf(stderr, "[APP]   clip %u on track '%s' [%.2f - %.2f] src[%.2f - %.2f]\n",
+                            clipId, track ? track->name.c_str() : "?",
+                            clip.timelineStart, clip.getTimelineEnd(),
+                            clip.sourceIn, clip.sourceOut);
+                }
             }
         }
     }
 
-    if (m_timelinePlayback.getState() == TimelinePlayback::State::Stopped) {
+    if (anyImported && m_timelinePlayback.getState() == TimelinePlayback::State::Stopped) {
         m_timelinePlayback.play();
     }
 }
 
 void Application::run() {
+    auto started = std::chrono::steady_clock::now();
+
     while (m_running) {
         processEvents();
 
+        if (m_quitAfter > 0.0 &&
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count() >= m_quitAfter) {
+            m_running = false;
+            break;
+        }
+
         if (m_minimized) {
             SDL_Delay(16);
             continue;
@@ -200,9 +252,25 @@ bool Application::renderFrame() {
 
     vkResetFences(m_vkCtx.device, 1, &sc.inFlightFences[frame]);
 
+    // Apply finished background imports before playback looks at the timeline
+    pollImports();
+
     // Update timeline playback state (activate/deactivate ClipPlayers)
     m_timelinePlayback.update();
 
+    // Hand finished thumbnails to the atlas; stop generating thumbnails and
+    // waveforms while playback is struggling to keep its decoders ahead
+    bool underLoad = m_timelinePlayback.isUnderLoad();
+    m_thumbnails.setPaused(underLoad);
+    m_waveforms.setPaused(underLoad);
+    m_audioCache.setPaused(underLoad);
+    // The atlas holds pictures, not ticks: ticks on one keyframe share a cell
+    for (auto& thumb : m_thumbnails.takeResults()) {
+        if (m_thumbnailAtlas.has(thumb.frame)) continue;
+        m_thumbnailAtlas.submit(thumb.frame, std::move(thumb.rgba), thumb.width, thumb.height);
+    }
+    m_thumbnailAtlas.beginFrame(m_vkCtx);
+
     // Prepare video layers (stages GPU data, returns layer descriptors)
     auto layers = m_timelinePlayback.prepareFrame(frame);
 
@@ -231,6 +299,7 @@ bool Application::renderFrame() {
                 m_exportDialog.setSourceInfo(
                     m_exportSettings.width, m_exportSettings.height,
                     m_exportSettings.fps);
+                m_exportDialog.setStemSources(m_timeline);
             }
             ImGui::Separator();
             if (ImGui::MenuItem("Exit", "Alt+F4")) {
@@ -287,20 +356,24 @@ bool Application::renderFrame() {
     // Handle timeline seek requests (clicks on ruler/playhead)
     if (m_timelineUI.hasSeekRequest()) {
         double seekTime = m_timelineUI.getSeekTime();
-        m_timelinePlayback.seek(seekTime);
+        if (m_timelineUI.isScrubbing()) m_timelinePlayback.scrub(seekTime);
+        else m_timelinePlayback.seek(seekTime);
+    }
+    if (m_timelinePlayback.isScrubbing() && !m_timelineUI.isScrubbing()) {
+        m_timelinePlayback.endScrub();
     }
 
     // Clip Properties panel
     double clipFps = 30.0;
     uint32_t selClipId = m_timelineUI.getSelectedClipId();
     if (selClipId != 0) {
-        const auto* selClip = m_timeline.getClip(selClipId);
+        const auto* selClip = std::as_const(m_timeline).getClip(selClipId);
         if (selClip) {
-            const auto* selAsset = m_timeline.getAsset(selClip->assetId);
+            const auto* selAsset = std::as_const(m_timeline).getAsset(selClip->assetId);
             if (selAsset && selAsset->fps > 0.0) clipFps = selAsset->fps;
         }
     }
-    m_clipPropertiesUI.render(m_timeline, selClipId, clipFps);
+    m_clipPropertiesUI.render(m_timeline, selClipId, clipFps, m_timelinePlayback.getCurrentTime());
 
     // File dialog
     m_fileDialog.render();
@@ -331,6 +404,7 @@ bool Application::renderFrame() {
 
     // Record GPU uploads for all tracks (before render pass)
     m_timelinePlayback.recordUploads(cmd, frame);
+    m_thumbnailAtlas.recordUploads(cmd);
 
     VkClearValue clearColor = {{{0.1f, 0.1f, 0.1f, 1.0f}}};
     VkRenderPassBeginInfo rpBegin{};
@@ -388,6 +462,11 @@ void Application::handleResize() {
 }
 
 void Application::shutdown() {
+    m_importer.shutdown();
+    m_thumbnails.shutdown();
+    m_waveforms.shutdown();
+    m_audioCache.shutdown();  // buffers stay mapped for playback
+
     // Cancel any running export
     if (m_exportSession) {
         m_exportSession->cancel();
@@ -401,6 +480,7 @@ void Application::shutdown() {
     if (m_vkCtx.device) vkDeviceWaitIdle(m_vkCtx.device);
 
     m_timelinePlayback.shutdown();
+    m_thumbnailAtlas.shutdown(m_vkCtx);
     m_imguiLayer.shutdown();
     m_swapchain.shutdown(m_vkCtx.device);
     m_vkCtx.shutdown();
@@ -13,8 +13,13 @@
 #include "export/ExportSession.h"
 #include "export/ExportSettings.h"
 #include "media/AudioOutput.h"
+#include "media/ThumbnailService.h"
+#include "media/WaveformService.h"
+#include "media/AudioPcmCache.h"
+#include "vulkan/ThumbnailAtlas.h"
 #include "timeline/Timeline.h"
 #include "timeline/TimelinePlayback.h"
+#include "timeline/MediaImporter.h"
 #include <memory>
 
 class Application {
@@ -23,6 +28,13 @@ public:
     ~Application();
 
     void setVerbose(bool v) { m_verbose = v; }
+    void setImportSettings(const ImportSettings& s) { m_importSettings = s; }
+    void setQuitAfter(double seconds) { m_quitAfter = seconds; }  // 0 = never (soak tests)
+    void setMixAhead(double seconds) { m_audioOutput.setMixAhead(seconds); }
+    void setAudioBufferFrames(int frames) { m_audioOutput.setDeviceBufferFrames(frames); }
+    void setMixdownBudget(size_t bytes) { m_timelinePlayback.setMixdownBudget(bytes); }
+    void setImageCacheBudget(VkDeviceSize bytes) { m_timelinePlayback.setImageCacheBudget(bytes); }
+    void setAudioCacheBudget(uint64_t bytes) { m_audioCache.setBudget(bytes); }
     bool init(const std::string& filePath = "");
     void run();
     void shutdown();
@@ -32,6 +44,7 @@ private:
     bool renderFrame();
     void handleResize();
     void importToTimeline(const std::string& path);
+    void pollImports();
 
     SDL_Window* m_window = nullptr;
     VulkanContext m_vkCtx;
@@ -41,10 +54,25 @@ private:
     // Audio output (shared — initialized once at 48kHz)
     AudioOutput m_audioOutput;
 
+    // Decoded audio for playback; declared before playback, which reads
+    // its buffers until destroyed
+    AudioPcmCache m_audioCache;
+
     // Timeline data model + orchestrator
     Timeline m_timeline;
     TimelinePlayback m_timelinePlayback;
 
+    // Background media probing (results applied once per frame)
+    MediaImporter m_importer;
+    ImportSettings m_importSettings;
+
+    // Timeline thumbnails: generated in the background, drawn from one atlas
+    ThumbnailService m_thumbnails;
+    ThumbnailAtlas m_thumbnailAtlas;
+
+    // Audio clip waveforms, built once per asset in the background
+    WaveformService m_waveforms;
+
     // UI
     PlayerUI m_playerUI;
     FileDialog m_fileDialog;
@@ -62,4 +90,5 @@ private:
     int m_windowHeight = 720;
     std::string m_filePath;
     bool m_verbose = false;
+    double m_quitAfter = 0.0;
 };
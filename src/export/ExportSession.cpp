@@ -1,6 +1,7 @@
 #include "export/ExportSession.h"
 #include <algorithm>
 #include <chrono>
+#include <cctype>
 #include <cstdio>
 #include <cstring>
 
@@ -19,7 +20,7 @@ bool ExportSession::start(const Timeline& timeline, const ExportSettings& settin
 
     if (m_thread.joinable()) m_thread.join();
 
-    m_timelineCopy = timeline;
+    m_timeline = std::make_shared<const Timeline>(timeline.snapshot());
     m_settings = settings;
     m_state.store(State::Running);
     m_cancelRequested.store(false);
@@ -95,9 +96,20 @@ void ExportSession::exportLoop() {
         return;
     }
 
+    // Stems: more encoders fed from the same mix
+    if (!openStems(muxerFlags)) {
+        fail("Stem export initialization failed");
+        closeStems();
+        m_audioEncoder.shutdown();
+        m_videoEncoder.shutdown();
+        m_muxer.close();
+        return;
+    }
+
     // 4. Write header
     if (!m_muxer.writeHeader()) {
         fail("Cannot write container header");
+        closeStems();
         m_audioEncoder.shutdown();
         m_videoEncoder.shutdown();
         m_muxer.close();
@@ -105,13 +117,14 @@ void ExportSession::exportLoop() {
     }
 
     // 5. Compute frame count
-    double duration = m_timelineCopy.getTotalDuration();
+    double duration = m_timeline->getTotalDuration();
     if (m_settings.endTime > 0 && m_settings.endTime < duration)
         duration = m_settings.endTime;
     double startTime = m_settings.startTime;
     double exportDuration = duration - startTime;
     if (exportDuration <= 0) {
         fail("Export range is empty");
+        closeStems();
         m_muxer.writeTrailer();
         m_muxer.close();
         return;
@@ -126,11 +139,16 @@ void ExportSession::exportLoop() {
     // 7. Setup export clock (paused — we manually set it)
     m_exportClock.set(startTime);
     m_exportClock.pause();
+    m_audioMixer.setPlayhead(startTime);  // automation is evaluated by the mixer's playhead
 
     double frameDuration = 1.0 / m_settings.fps;
     int audioSamplesPerFrame = static_cast<int>(
         m_settings.audioSampleRate * frameDuration) + 1;
     m_audioBuffer.resize(audioSamplesPerFrame * m_settings.audioChannels);
+    for (size_t i = 0; i < m_stems.size(); i++) {
+        m_stems[i].buffer.resize(m_audioBuffer.size());
+        m_stemBuffers[i] = m_stems[i].buffer.data();
+    }
 
     fprintf(stderr, "[EXPORT] Exporting %lld frames (%.2fs @ %.1f fps)\n",
             (long long)totalFrames, exportDuration, m_settings.fps);
@@ -221,6 +239,8 @@ void ExportSession::exportLoop() {
         m_muxer.writePacket(pkt);
     });
 
+    finishStems();
+
     // 10. Finalize
     m_muxer.writeTrailer();
 
@@ -229,6 +249,7 @@ void ExportSession::exportLoop() {
     m_clipPlayers.clear();
     m_activeClipIds.clear();
     m_audioMixer.clearSources();
+    closeStems();
     m_audioEncoder.shutdown();
     m_videoEncoder.shutdown();
     m_muxer.close();
@@ -242,24 +263,102 @@ void ExportSession::exportLoop() {
     }
 }
 
+// output.mp4 + "Dialogue" -> output.Dialogue.m4a. A bus and a track may
+// share a name (or sanitize to the same one): later ones get -2, -3, ...
+static std::string stemPath(const std::string& outputPath, const std::string& name,
+                            std::unordered_set<std::string>& used) {
+    size_t slash = outputPath.find_last_of('/');
+    size_t dot = outputPath.find_last_of('.');
+    std::string base = (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+        ? outputPath.substr(0, dot) : outputPath;
+
+    std::string suffix = name;
+    for (char& c : suffix) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-') c = '_';
+    }
+    std::string path = base + "." + suffix + ".m4a";
+    for (int n = 2; !used.insert(path).second; n++) {
+        path = base + "." + suffix + "-" + std::to_string(n) + ".m4a";
+    }
+    return path;
+}
+
+bool ExportSession::openStems(int muxerFlags) {
+    std::vector<AudioStemTap> taps;
+    std::unordered_set<std::string> usedPaths{m_settings.outputPath};
+    for (const ExportStem& settings : m_settings.stems) {
+        Stem stem;
+        stem.encoder = std::make_unique<AudioEncoder>();
+        bool separate = m_settings.stemOutput == StemOutput::SeparateFiles;
+
+        if (separate) {
+            std::string path = stemPath(m_settings.outputPath, settings.name, usedPaths);
+            stem.file = std::make_unique<Muxer>();
+            if (!stem.file->open(path)) {
+                fprintf(stderr, "[EXPORT] Cannot open stem file %s\n", path.c_str());
+                return false;
+            }
+            stem.muxer = stem.file.get();
+            fprintf(stderr, "[EXPORT] Stem '%s' -> %s\n", settings.name.c_str(), path.c_str());
+        } else {
+            stem.muxer = &m_muxer;
+            fprintf(stderr, "[EXPORT] Stem '%s' -> audio stream\n", settings.name.c_str());
+        }
+
+        int flags = separate ? stem.muxer->getFormatContext()->oformat->flags : muxerFlags;
+        if (!stem.encoder->init(m_settings, flags)) return false;
+        stem.streamIndex = stem.muxer->addAudioStream(stem.encoder->getCodecContext(), settings.name);
+        if (stem.streamIndex < 0) return false;
+        if (separate && !stem.file->writeHeader()) return false;
+
+        m_stems.push_back(std::move(stem));
+        taps.push_back({settings.bus, settings.id});
+    }
+
+    m_stemBuffers.assign(m_stems.size(), nullptr);
+    m_audioMixer.setStems(std::move(taps));
+    return true;
+}
+
+void ExportSession::writeStemPacket(Stem& stem, AVPacket* pkt) {
+    av_packet_rescale_ts(pkt,
+        stem.encoder->getCodecContext()->time_base,
+        stem.muxer->getStream(stem.streamIndex)->time_base);
+    pkt->stream_index = stem.streamIndex;
+    stem.muxer->writePacket(pkt);
+}
+
+void ExportSession::finishStems() {
+    for (Stem& stem : m_stems) {
+        stem.encoder->flush([&](AVPacket* pkt) { writeStemPacket(stem, pkt); });
+        if (stem.file) stem.file->writeTrailer();
+    }
+}
+
+void ExportSession::closeStems() {
+    for (Stem& stem : m_stems) {
+        stem.encoder->shutdown();
+        if (stem.file) stem.file->close();
+    }
+    m_stems.clear();
+    m_stemBuffers.clear();
+    m_audioMixer.setStems({});
+}
+
 void ExportSession::updateActiveClips(double time) {
     double lookahead = time + 0.5;
 
     std::unordered_set<uint32_t> neededClipIds;
 
-    for (uint32_t trackId : m_timelineCopy.getTrackOrder()) {
-        const auto* track = m_timelineCopy.getTrack(trackId);
+    for (uint32_t trackId : m_timeline->getTrackOrder()) {
+        const auto* track = m_timeline->getTrack(trackId);
         if (!track) continue;
         if (!track->visible && track->type != TrackType::Audio) continue;
         if (track->type == TrackType::Image) continue;
 
-        for (uint32_t clipId : track->clipIds) {
-            const auto* clip = m_timelineCopy.getClip(clipId);
-            if (!clip) continue;
-            if (clip->getTimelineEnd() > time && clip->timelineStart < lookahead) {
-                neededClipIds.insert(clipId);
-            }
-        }
+        track->clips.forEachOverlapping(time, lookahead, [&](const ClipSpan& span) {
+            neededClipIds.insert(span.clipId);
+        });
     }
 
     // Deactivate clips no longer needed
@@ -291,12 +390,12 @@ void ExportSession::updateActiveClips(double time) {
 }
 
 void ExportSession::activateClip(uint32_t clipId) {
-    const auto* clip = m_timelineCopy.getClip(clipId);
+    const auto* clip = m_timeline->getClip(clipId);
     if (!clip) return;
-    const auto* track = m_timelineCopy.getTrack(clip->trackId);
+    const auto* track = m_timeline->getTrack(clip->trackId);
     if (!track) return;
-    const auto* asset = m_timelineCopy.getAsset(clip->assetId);
-    if (!asset) return;
+    const auto* asset = m_timeline->getAsset(clip->assetId);
+    if (!asset || asset->pending) return;
 
     bool needVideo = (track->type == TrackType::Video) && asset->hasVideo;
     bool needAudio = (track->type == TrackType::Audio) && asset->hasAudio;
@@ -309,6 +408,7 @@ void ExportSession::activateClip(uint32_t clipId) {
         return;
     }
 
+    player->setAudioStretch(clip->speed, clip->sourceIn);
     player->play();
 
     double currentTime = m_exportClock.get();
@@ -335,11 +435,12 @@ void ExportSession::rebuildAudioSources() {
 
     for (auto& [clipId, player] : m_clipPlayers) {
         if (!player->hasAudio()) continue;
-        const auto* clip = m_timelineCopy.getClip(clipId);
+        const auto* clip = m_timeline->getClip(clipId);
         if (!clip) continue;
-        const auto* track = m_timelineCopy.getTrack(clip->trackId);
+        const auto* track = m_timeline->getTrack(clip->trackId);
         if (!track || track->type != TrackType::Audio) continue;
 
+        player->setAudioStretch(clip->speed, clip->sourceIn);
         AudioMixSource src;
         src.queue = &player->getAudioFrameQueue();
         src.clip = clip;
@@ -349,29 +450,31 @@ void ExportSession::rebuildAudioSources() {
         sources.push_back(src);
     }
 
-    m_audioMixer.setSources(std::move(sources));
+    std::vector<const AudioBus*> buses;
+    for (const auto& [busId, bus] : m_timeline->getAllBuses()) buses.push_back(&bus);
+    m_audioMixer.setSources(std::move(sources), buses, &m_timeline->getMasterEffects());
 }
 
 void ExportSession::compositeFrame(double time, uint8_t* outputRGBA,
                                     int outW, int outH) {
     memset(outputRGBA, 0, outW * outH * 4);
 
-    for (uint32_t trackId : m_timelineCopy.getTrackOrder()) {
-        const auto* track = m_timelineCopy.getTrack(trackId);
+    for (uint32_t trackId : m_timeline->getTrackOrder()) {
+        const auto* track = m_timeline->getTrack(trackId);
         if (!track || !track->visible) continue;
         if (track->type == TrackType::Audio) continue;
 
-        const auto* clip = m_timelineCopy.getActiveClipOnTrack(trackId, time);
+        const auto* clip = m_timeline->getActiveClipOnTrack(trackId, time);
         if (!clip) continue;
-        const auto* asset = m_timelineCopy.getAsset(clip->assetId);
+        const auto* asset = m_timeline->getAsset(clip->assetId);
         if (!asset) continue;
 
         const uint8_t* srcPixels = nullptr;
         int srcW = 0, srcH = 0;
 
         if (track->type == TrackType::Image) {
-            if (asset->imageData.empty()) continue;
-            srcPixels = asset->imageData.data();
+            if (!asset->imageData) continue;
+            srcPixels = asset->imageData->data();
             srcW = asset->width;
             srcH = asset->height;
         } else if (track->type == TrackType::Video) {
@@ -422,6 +525,10 @@ void ExportSession::encodeAudioForFrame(double frameDuration) {
 
     if ((int)m_audioBuffer.size() < numSamples * m_settings.audioChannels) {
         m_audioBuffer.resize(numSamples * m_settings.audioChannels);
+        for (size_t i = 0; i < m_stems.size(); i++) {
+            m_stems[i].buffer.resize(m_audioBuffer.size());
+            m_stemBuffers[i] = m_stems[i].buffer.data();
+        }
     }
 
     // Wait for audio frames to be available in the mixer sources.
@@ -447,7 +554,7 @@ void ExportSession::encodeAudioForFrame(double frameDuration) {
         }
     }
 
-    m_audioMixer.fillBuffer(m_audioBuffer.data(), numSamples, m_exportClock);
+    m_audioMixer.fillBuffer(m_audioBuffer.data(), numSamples, m_exportClock, m_stemBuffers.data());
 
     // Debug: check if audio has actual data
     if (s_audioFrameCount < 5) {
@@ -471,5 +578,10 @@ void ExportSession::encodeAudioForFrame(double frameDuration) {
             m_muxer.writePacket(pkt);
         });
 
+    for (Stem& stem : m_stems) {
+        stem.encoder->encode(stem.buffer.data(), numSamples,
+            [&](AVPacket* pkt) { writeStemPacket(stem, pkt); });
+    }
+
     s_audioFrameCount++;
 }
@@ -17,6 +17,10 @@
 #include <memory>
 #include <vector>
 
+// Renders a timeline snapshot to a file on a background thread: clips are
+// decoded and mixed once, the video and the full audio mix are encoded,
+// and any stems (see ExportSettings::stems) are taken from the same mix
+// pass and encoded beside it.
 class ExportSession {
 public:
     enum class State {
@@ -52,7 +56,21 @@ private:
     void compositeFrame(double time, uint8_t* outputRGBA, int width, int height);
     void encodeAudioForFrame(double frameDuration);
 
-    Timeline m_timelineCopy;
+    // A stem's encoder and where its packets go: a stream in the main
+    // file, or its own file
+    struct Stem {
+        std::unique_ptr<AudioEncoder> encoder;
+        std::unique_ptr<Muxer> file;
+        Muxer* muxer = nullptr;
+        int streamIndex = -1;
+        std::vector<float> buffer;
+    };
+    bool openStems(int muxerFlags);
+    void writeStemPacket(Stem& stem, AVPacket* pkt);
+    void finishStems();
+    void closeStems();
+
+    std::shared_ptr<const Timeline> m_timeline;  // O(1) snapshot, read-only on the export thread
     ExportSettings m_settings;
 
     std::unordered_map<uint32_t, std::unique_ptr<ClipPlayer>> m_clipPlayers;
@@ -67,6 +85,9 @@ private:
     // Audio buffer reused each frame
     std::vector<float> m_audioBuffer;
 
+    std::vector<Stem> m_stems;
+    std::vector<float*> m_stemBuffers;  // each stem's buffer, for the mixer
+
     std::thread m_thread;
     std::atomic<State> m_state{State::Idle};
     std::atomic<bool> m_cancelRequested{false};
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 enum class VideoCodecChoice {
     H264_Software,   // libx264
@@ -8,6 +10,19 @@ enum class VideoCodecChoice {
     H264_VAAPI       // h264_vaapi (hardware)
 };
 
+// A track's or bus's own output, exported beside the full mix. Its own mute
+// and volume apply; mutes on the buses it feeds don't.
+struct ExportStem {
+    std::string name;           // stream title, or file name suffix
+    bool bus = false;           // id names a bus, else a track
+    uint32_t id = 0;
+};
+
+enum class StemOutput {
+    AudioStreams,    // extra audio streams in the main file
+    SeparateFiles    // <output>.<name>.m4a beside it, <name>-2 etc. for repeated names
+};
+
 struct ExportSettings {
     std::string outputPath = "output.mp4";
 
@@ -24,6 +39,10 @@ struct ExportSettings {
     int audioChannels = 2;
     int audioBitrate = 192000;      // 192 kbps AAC
 
+    // Stems, mixed in the same pass as the full mix
+    std::vector<ExportStem> stems;
+    StemOutput stemOutput = StemOutput::AudioStreams;
+
     // Range
     double startTime = 0.0;
     double endTime = -1.0;          // -1 means entire timeline
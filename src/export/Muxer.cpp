@@ -44,19 +44,27 @@ int Muxer::addVideoStream(const AVCodecContext* codecCtx) {
     return m_videoStreamIdx;
 }
 
-int Muxer::addAudioStream(const AVCodecContext* codecCtx) {
+int Muxer::addAudioStream(const AVCodecContext* codecCtx, const std::string& title) {
     if (!m_fmtCtx) return -1;
 
-    m_audioStream = avformat_new_stream(m_fmtCtx, nullptr);
-    if (!m_audioStream) {
+    AVStream* stream = avformat_new_stream(m_fmtCtx, nullptr);
+    if (!stream) {
         fprintf(stderr, "Muxer: cannot create audio stream\n");
         return -1;
     }
 
-    avcodec_parameters_from_context(m_audioStream->codecpar, codecCtx);
-    m_audioStream->time_base = codecCtx->time_base;
-    m_audioStreamIdx = m_audioStream->index;
-    return m_audioStreamIdx;
+    avcodec_parameters_from_context(stream->codecpar, codecCtx);
+    stream->time_base = codecCtx->time_base;
+    if (!title.empty()) av_dict_set(&stream->metadata, "title", title.c_str(), 0);
+
+    if (!m_audioStream) {
+        m_audioStream = stream;
+        m_audioStreamIdx = stream->index;
+    } else {
+        // Players pick the default stream; that stays the full mix
+        stream->disposition &= ~AV_DISPOSITION_DEFAULT;
+    }
+    return stream->index;
 }
 
 bool Muxer::writeHeader() {
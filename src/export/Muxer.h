@@ -14,7 +14,9 @@ public:
     bool open(const std::string& path, const std::string& formatName = "mp4");
 
     int addVideoStream(const AVCodecContext* codecCtx);
-    int addAudioStream(const AVCodecContext* codecCtx);
+    // The first audio stream added is the main one (getAudioStream());
+    // later ones (stems) are reached by index. title names the stream.
+    int addAudioStream(const AVCodecContext* codecCtx, const std::string& title = "");
 
     bool writeHeader();
     bool writePacket(AVPacket* pkt);
@@ -26,6 +28,10 @@ public:
     AVStream* getAudioStream() { return m_audioStream; }
     int getVideoStreamIndex() const { return m_videoStreamIdx; }
     int getAudioStreamIndex() const { return m_audioStreamIdx; }
+    AVStream* getStream(int index) {
+        return m_fmtCtx && index >= 0 && index < static_cast<int>(m_fmtCtx->nb_streams)
+            ? m_fmtCtx->streams[index] : nullptr;
+    }
 
 private:
     AVFormatContext* m_fmtCtx = nullptr;
@@ -1,27 +1,65 @@
 #include "app/Application.h"
+#include "media/RtCheck.h"
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <string>
 
 int main(int argc, char* argv[]) {
     std::string filePath;
     bool verbose = false;
+    ImportSettings importSettings;
+    double quitAfter = 0.0;
+    double mixAheadMs = 0.0;
+    int audioBufferFrames = 0;
+    double mixdownMb = -1.0;
+    double imageCacheMb = 0.0;
+    double audioCacheMb = 0.0;
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--verbose") == 0 || strcmp(argv[i], "-v") == 0) {
             verbose = true;
+        } else if (strcmp(argv[i], "--probe-size") == 0 && i + 1 < argc) {
+            importSettings.probeSize = strtoll(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--analyze-duration") == 0 && i + 1 < argc) {
+            importSettings.analyzeDuration = strtoll(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--import-threads") == 0 && i + 1 < argc) {
+            importSettings.workerCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mix-ahead") == 0 && i + 1 < argc) {
+            mixAheadMs = strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--audio-buffer") == 0 && i + 1 < argc) {
+            audioBufferFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mixdown-cache") == 0 && i + 1 < argc) {
+            mixdownMb = strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--image-cache") == 0 && i + 1 < argc) {
+            imageCacheMb = strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--audio-cache") == 0 && i + 1 < argc) {
+            audioCacheMb = strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--quit-after") == 0 && i + 1 < argc) {
+            quitAfter = strtod(argv[++i], nullptr);
         } else if (argv[i][0] != '-') {
             filePath = argv[i];
         }
     }
 
-    Application app;
-    app.setVerbose(verbose);
-    if (!app.init(filePath)) {
-        fprintf(stderr, "Failed to initialize application\n");
-        return 1;
+    {
+        Application app;
+        app.setVerbose(verbose);
+        app.setImportSettings(importSettings);
+        app.setQuitAfter(quitAfter);
+        if (mixAheadMs > 0.0) app.setMixAhead(mixAheadMs / 1000.0);
+        if (audioBufferFrames > 0) app.setAudioBufferFrames(audioBufferFrames);
+        if (mixdownMb >= 0.0) app.setMixdownBudget(static_cast<size_t>(mixdownMb * 1024 * 1024));
+        if (imageCacheMb > 0.0) app.setImageCacheBudget(static_cast<VkDeviceSize>(imageCacheMb * 1024 * 1024));
+        if (audioCacheMb > 0.0) app.setAudioCacheBudget(static_cast<uint64_t>(audioCacheMb * 1024 * 1024));
+        if (!app.init(filePath)) {
+            fprintf(stderr, "Failed to initialize application\n");
+            return 1;
+        }
+
+        app.run();
     }
 
-    app.run();
-    return 0;
+    // Checker builds only: fail if the audio thread allocated, locked or blocked
+    return RtCheck::report() ? 0 : 1;
 }
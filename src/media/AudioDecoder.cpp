@@ -1,10 +1,15 @@
 #include "media/AudioDecoder.h"
 #include "media/PacketQueue.h"
 #include "media/AudioFrameQueue.h"
+#include <cmath>
 #include <cstdio>
 
+// Stretched audio goes out in frames of this many samples
+static constexpr int STRETCH_FRAME_SAMPLES = 1024;
+
 AudioDecoder::~AudioDecoder() {
     stop();
+    av_frame_free(&m_stretchFrame);
     if (m_swrCtx) swr_free(&m_swrCtx);
     if (m_codecCtx) avcodec_free_context(&m_codecCtx);
 }
@@ -55,11 +60,61 @@ void AudioDecoder::stop() {
     if (m_thread.joinable()) m_thread.join();
 }
 
+void AudioDecoder::setStretch(double speed, double anchorSeconds) {
+    m_stretchSpeed.store(speed);
+    m_stretchAnchor.store(anchorSeconds);
+    m_stretchRequests.fetch_add(1);
+}
+
+void AudioDecoder::pushStretched(AVFrame* resampled, int serial, AudioFrameQueue& frameQueue) {
+    if (!m_stretch) m_stretch = std::make_unique<TimeStretch>();
+    if (!m_stretchFrame) m_stretchFrame = av_frame_alloc();
+    TimeStretch& stretch = *m_stretch;
+
+    // Starts from whatever decodes first: after a seek that's the keyframe
+    // before the target, so the stretch settles before the clip is heard
+    if (!m_stretchStarted) {
+        if (resampled->pts == AV_NOPTS_VALUE) return;
+        double pts = resampled->pts * av_q2d(m_timeBase);
+        stretch.reset(m_stretchSpeed.load(), std::llround(m_anchorSeconds * m_sampleRate));
+        m_stretchOutput = stretch.beginInput(std::llround(pts * m_sampleRate));
+        m_stretchStarted = true;
+    }
+
+    const float* in = reinterpret_cast<const float*>(resampled->data[0]);
+    int remaining = resampled->nb_samples;
+    while (m_running.load()) {
+        int taken = stretch.push(in, remaining);
+        in += taken * TimeStretch::CHANNELS;
+        remaining -= taken;
+
+        bool pushed = false;
+        while (stretch.available() >= STRETCH_FRAME_SAMPLES) {
+            AVFrame* out = m_stretchFrame;
+            out->format = AV_SAMPLE_FMT_FLT;
+            out->ch_layout = AV_CHANNEL_LAYOUT_STEREO;
+            out->sample_rate = m_sampleRate;
+            out->nb_samples = STRETCH_FRAME_SAMPLES;
+            if (av_frame_get_buffer(out, 0) < 0) return;
+            stretch.pull(reinterpret_cast<float*>(out->data[0]), STRETCH_FRAME_SAMPLES);
+
+            // Source time of the frame's first sample
+            double source = m_anchorSeconds + m_stretchOutput * stretch.getSpeed() / m_sampleRate;
+            out->pts = std::llround(source / av_q2d(m_timeBase));
+            m_stretchOutput += STRETCH_FRAME_SAMPLES;
+            if (!frameQueue.push(out, serial)) return;
+            pushed = true;
+        }
+        if (remaining == 0 || (taken == 0 && !pushed)) break;
+    }
+}
+
 void AudioDecoder::decodeLoop(PacketQueue& packetQueue, AudioFrameQueue& frameQueue) {
     AVFrame* decoded = av_frame_alloc();
     AVFrame* resampled = av_frame_alloc();
 
     int serial = packetQueue.getSerial();
+    double speed = 1.0;
 
     while (m_running.load()) {
         AVPacket* pkt = packetQueue.pop(50);
@@ -69,6 +124,16 @@ void AudioDecoder::decodeLoop(PacketQueue& packetQueue, AudioFrameQueue& frameQu
         if (newSerial != serial) {
             avcodec_flush_buffers(m_codecCtx);
             serial = newSerial;
+            m_stretchStarted = false;
+        }
+        uint64_t stretchRequests = m_stretchRequests.load();
+        if (stretchRequests != m_stretchRequestsSeen) {
+            m_stretchRequestsSeen = stretchRequests;
+            double newSpeed = m_stretchSpeed.load();
+            double newAnchor = m_stretchAnchor.load();
+            if (newSpeed != speed || newAnchor != m_anchorSeconds) m_stretchStarted = false;
+            speed = newSpeed;
+            m_anchorSeconds = newAnchor;
         }
 
         int ret = avcodec_send_packet(m_codecCtx, pkt);
@@ -99,7 +164,12 @@ void AudioDecoder::decodeLoop(PacketQueue& packetQueue, AudioFrameQueue& frameQu
             if (resampled->pts == AV_NOPTS_VALUE)
                 resampled->pts = decoded->best_effort_timestamp;
 
-            frameQueue.push(resampled, serial);
+            if (speed != 1.0) {
+                pushStretched(resampled, serial, frameQueue);
+                av_frame_unref(resampled);
+            } else {
+                frameQueue.push(resampled, serial);
+            }
 
             av_frame_unref(decoded);
         }
@@ -5,8 +5,10 @@ extern "C" {
 #include <libswresample/swresample.h>
 }
 
+#include "media/TimeStretch.h"
 #include <thread>
 #include <atomic>
+#include <memory>
 
 class PacketQueue;
 class AudioFrameQueue;
@@ -19,6 +21,13 @@ public:
     void start(PacketQueue& packetQueue, AudioFrameQueue& frameQueue);
     void stop();
 
+    // Time-stretch the output for a clip playing at `speed` (1 = off),
+    // after the resampler. Frame pts stay in source time, spaced by speed
+    // times their length. The stretch's grid is anchored at source time
+    // `anchorSeconds` (the clip's sourceIn), which lines it up with the
+    // mixer's for the same clip. Any thread; applies from the next frame.
+    void setStretch(double speed, double anchorSeconds);
+
     int getSampleRate() const { return m_sampleRate; }
     int getChannels() const { return m_channels; }
     AVRational getTimeBase() const { return m_timeBase; }
@@ -26,6 +35,7 @@ public:
 
 private:
     void decodeLoop(PacketQueue& packetQueue, AudioFrameQueue& frameQueue);
+    void pushStretched(AVFrame* resampled, int serial, AudioFrameQueue& frameQueue);
 
     AVCodecContext* m_codecCtx = nullptr;
     SwrContext* m_swrCtx = nullptr;
@@ -35,4 +45,16 @@ private:
 
     std::thread m_thread;
     std::atomic<bool> m_running{false};
+
+    std::atomic<double> m_stretchSpeed{1.0};
+    std::atomic<double> m_stretchAnchor{0.0};
+    std::atomic<uint64_t> m_stretchRequests{0};
+
+    // Decode thread
+    std::unique_ptr<TimeStretch> m_stretch;
+    uint64_t m_stretchRequestsSeen = 0;
+    bool m_stretchStarted = false;
+    double m_anchorSeconds = 0.0;
+    int64_t m_stretchOutput = 0;   // output frames since the anchor
+    AVFrame* m_stretchFrame = nullptr;
 };
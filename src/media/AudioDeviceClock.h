@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+
+// Timeline position of the audio the device is playing right now, for any
+// thread to read.
+//
+// Each time the audio callback runs it reports how many frames the device
+// has consumed so far. Those arrive in device-buffer-sized steps at jittery
+// times, so a delay-locked loop fits a smooth line through them: frames
+// consumed as a function of steady_clock time, tracking the device's actual
+// rate (its drift against steady_clock) as well as its phase. The device
+// plays a frame one latency after consuming it. The callback also anchors
+// output frames to timeline times as it hands audio over, which maps the
+// frame being played back onto the timeline.
+//
+// Header-only so the clock benchmark can drive it with simulated time.
+// One writer: the audio callback, or any thread while the callback is
+// stopped. Readers never block; they retry if a publish lands mid-read.
+class AudioDeviceClock {
+public:
+    static constexpr double BANDWIDTH = 1.0;        // Hz, loop filter
+    static constexpr double MAX_DRIFT = 0.005;      // device rate vs nominal
+    static constexpr double RESYNC_SECONDS = 0.05;  // larger jumps restart the loop
+    static constexpr double STALE_SECONDS = 0.5;    // no callback for this long: unknown
+    static constexpr int MAX_ANCHORS = 16;
+
+    // Writer side, before the device starts
+    void setSampleRate(double rate) { m_sampleRate = rate; }
+    void setLatency(double frames) { m_latency = frames; }
+
+    // Forget everything (the device's buffers were cleared)
+    void reset() {
+        m_locked = false;
+        m_lastConsumed = -1;
+        m_anchorCount = 0;
+        m_anchorHead = 0;
+        publish();
+    }
+
+    // Callback: `consumed` frames taken by the device in total as of `now`
+    // (steady_clock seconds), `requested` of them asked for this time. The
+    // device can't be playing the start of a request it hasn't got yet, so
+    // the latency is at least one request.
+    void update(int64_t consumed, double now, int requested) {
+        m_latency = std::max(m_latency, static_cast<double>(requested));
+        if (consumed == m_lastConsumed) return;
+        m_lastConsumed = consumed;
+
+        if (!m_locked) {
+            m_time = now;
+            m_frames = static_cast<double>(consumed);
+            m_rate = m_sampleRate;
+            m_locked = true;
+            return;
+        }
+
+        double dt = now - m_time;
+        if (dt <= 0.0) return;
+        double error = static_cast<double>(consumed) - (m_frames + dt * m_rate);
+        if (std::abs(error) > RESYNC_SECONDS * m_sampleRate) {
+            // Stall or xrun: start over from here, keeping the rate
+            m_time = now;
+            m_frames = static_cast<double>(consumed);
+            return;
+        }
+
+        // Second-order loop, critically damped; gains scale with the
+        // update interval so the bandwidth holds for any buffer size
+        double omega = 2.0 * std::numbers::pi * BANDWIDTH * dt;
+        double b = std::min(std::numbers::sqrt2 * omega, 1.0);
+        double c = omega * omega;
+        m_frames += dt * m_rate + b * error;
+        m_time = now;
+        m_rate = std::clamp(m_rate + c * error / dt,
+                            m_sampleRate * (1.0 - MAX_DRIFT), m_sampleRate * (1.0 + MAX_DRIFT));
+    }
+
+    // Callback: output frame `frame` plays timeline time `seconds`
+    void anchor(int64_t frame, double seconds) {
+        m_anchorFrame[m_anchorHead] = static_cast<double>(frame);
+        m_anchorTime[m_anchorHead] = seconds;
+        m_anchorHead = (m_anchorHead + 1) % MAX_ANCHORS;
+        m_anchorCount = std::min(m_anchorCount + 1, MAX_ANCHORS);
+    }
+
+    // Callback: make update()s and anchor()s visible to readers
+    void publish() {
+        uint32_t seq = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_pub.locked.store(m_locked, std::memory_order_relaxed);
+        m_pub.time.store(m_time, std::memory_order_relaxed);
+        m_pub.frames.store(m_frames, std::memory_order_relaxed);
+        m_pub.rate.store(m_rate, std::memory_order_relaxed);
+        m_pub.latency.store(m_latency, std::memory_order_relaxed);
+        m_pub.anchorCount.store(m_anchorCount, std::memory_order_relaxed);
+        // Oldest first
+        for (int i = 0; i < m_anchorCount; i++) {
+            int src = (m_anchorHead - m_anchorCount + i + MAX_ANCHORS) % MAX_ANCHORS;
+            m_pub.anchorFrame[i].store(m_anchorFrame[src], std::memory_order_relaxed);
+            m_pub.anchorTime[i].store(m_anchorTime[src], std::memory_order_relaxed);
+        }
+
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // Any thread: timeline seconds being played at `now`. False until the
+    // device has run and audio with a known timeline position was handed
+    // over, or when the callback has stopped running.
+    bool get(double now, double& seconds) const {
+        bool locked;
+        double time, frames, rate, latency;
+        int count;
+        double anchorFrame[MAX_ANCHORS], anchorTime[MAX_ANCHORS];
+        for (;;) {
+            uint32_t seq = m_seq.load(std::memory_order_acquire);
+            if (seq & 1) continue;
+            locked = m_pub.locked.load(std::memory_order_relaxed);
+            time = m_pub.time.load(std::memory_order_relaxed);
+            frames = m_pub.frames.load(std::memory_order_relaxed);
+            rate = m_pub.rate.load(std::memory_order_relaxed);
+            latency = m_pub.latency.load(std::memory_order_relaxed);
+            count = m_pub.anchorCount.load(std::memory_order_relaxed);
+            for (int i = 0; i < count; i++) {
+                anchorFrame[i] = m_pub.anchorFrame[i].load(std::memory_order_relaxed);
+                anchorTime[i] = m_pub.anchorTime[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_seq.load(std::memory_order_relaxed) == seq) break;
+        }
+        if (!locked || count == 0 || now - time > STALE_SECONDS) return false;
+
+        // Output frame leaving the device. Before the first one has, hold
+        // at the start of what was handed over.
+        double playing = std::max(frames + (now - time) * rate - latency, 0.0);
+
+        // Newest anchor at or before it; the oldest if it's older than all
+        int a = 0;
+        while (a + 1 < count && anchorFrame[a + 1] <= playing) a++;
+        seconds = anchorTime[a] + (playing - anchorFrame[a]) / m_sampleRate;
+        return true;
+    }
+
+    // Frames between being consumed and being heard
+    double getLatency() const { return m_pub.latency.load(std::memory_order_relaxed); }
+
+private:
+    double m_sampleRate = 48000.0;
+
+    // Writer
+    bool m_locked = false;
+    int64_t m_lastConsumed = -1;
+    double m_time = 0.0;    // steady_clock seconds of the loop's last point
+    double m_frames = 0.0;  // filtered frames consumed at m_time
+    double m_rate = 48000.0;
+    double m_latency = 0.0;
+    double m_anchorFrame[MAX_ANCHORS] = {};
+    double m_anchorTime[MAX_ANCHORS] = {};
+    int m_anchorHead = 0;
+    int m_anchorCount = 0;
+
+    // Readers, under m_seq (odd while a publish is in progress)
+    struct Published {
+        std::atomic<bool> locked{false};
+        std::atomic<double> time{0.0};
+        std::atomic<double> frames{0.0};
+        std::atomic<double> rate{48000.0};
+        std::atomic<double> latency{0.0};
+        std::atomic<int> anchorCount{0};
+        std::atomic<double> anchorFrame[MAX_ANCHORS] = {};
+        std::atomic<double> anchorTime[MAX_ANCHORS] = {};
+    };
+    Published m_pub;
+    std::atomic<uint32_t> m_seq{0};
+};
@@ -0,0 +1,353 @@
+#pragma once
+
+#include "media/MixKernels.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Insert effects for audio tracks and the master output: a multi-band
+// biquad EQ, a compressor and a brickwall limiter, run in that order.
+// Parameters (AudioEffectChain) live on the timeline; the filter and
+// envelope state (AudioEffectProcessor) lives with whoever mixes, so the
+// same chain runs in playback and export. Header-only like MixKernels,
+// which lets the benchmark use it directly.
+
+enum class EqBandType {
+    LowShelf,
+    Peak,
+    HighShelf,
+    LowPass,
+    HighPass
+};
+
+struct EqBand {
+    EqBandType type = EqBandType::Peak;
+    float frequency = 1000.0f;  // Hz
+    float gainDb = 0.0f;        // shelves and peaks
+    float q = 0.707f;
+
+    bool operator==(const EqBand&) const = default;
+};
+
+struct CompressorParams {
+    bool enabled = false;
+    float thresholdDb = -18.0f;
+    float ratio = 4.0f;
+    float attackMs = 10.0f;
+    float releaseMs = 150.0f;
+    float makeupDb = 0.0f;
+
+    bool operator==(const CompressorParams&) const = default;
+};
+
+struct LimiterParams {
+    bool enabled = false;
+    float ceilingDb = -0.3f;   // never exceeded
+    float releaseMs = 50.0f;
+
+    bool operator==(const LimiterParams&) const = default;
+};
+
+struct AudioEffectChain {
+    static constexpr int EQ_BANDS = 4;
+
+    bool eqEnabled = false;
+    std::array<EqBand, EQ_BANDS> eq = {{
+        {EqBandType::LowShelf, 100.0f, 0.0f, 0.707f},
+        {EqBandType::Peak, 400.0f, 0.0f, 1.0f},
+        {EqBandType::Peak, 2500.0f, 0.0f, 1.0f},
+        {EqBandType::HighShelf, 8000.0f, 0.0f, 0.707f},
+    }};
+    CompressorParams compressor;
+    LimiterParams limiter;
+
+    bool isActive() const { return eqEnabled || compressor.enabled || limiter.enabled; }
+    bool operator==(const AudioEffectChain&) const = default;
+
+    // Master output default: the limiter stands in for a hard clip
+    static AudioEffectChain master() {
+        AudioEffectChain chain;
+        chain.limiter.enabled = true;
+        return chain;
+    }
+};
+
+// Normalized biquad coefficients (a0 = 1)
+struct BiquadCoefs {
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
+    float a1 = 0.0f, a2 = 0.0f;
+};
+
+// RBJ audio EQ cookbook designs
+inline BiquadCoefs designBiquad(const EqBand& band, float sampleRate) {
+    double freq = std::clamp(static_cast<double>(band.frequency), 10.0, 0.45 * sampleRate);
+    double w0 = 2.0 * std::numbers::pi * freq / sampleRate;
+    double cosW = std::cos(w0);
+    double alpha = std::sin(w0) / (2.0 * std::max(0.05, static_cast<double>(band.q)));
+    double a = std::pow(10.0, band.gainDb / 40.0);
+    double shelf = 2.0 * std::sqrt(a) * alpha;
+
+    double b0, b1, b2, a0, a1, a2;
+    switch (band.type) {
+        case EqBandType::LowShelf:
+            b0 = a * ((a + 1) - (a - 1) * cosW + shelf);
+            b1 = 2 * a * ((a - 1) - (a + 1) * cosW);
+            b2 = a * ((a + 1) - (a - 1) * cosW - shelf);
+            a0 = (a + 1) + (a - 1) * cosW + shelf;
+            a1 = -2 * ((a - 1) + (a + 1) * cosW);
+            a2 = (a + 1) + (a - 1) * cosW - shelf;
+            break;
+        case EqBandType::HighShelf:
+            b0 = a * ((a + 1) + (a - 1) * cosW + shelf);
+            b1 = -2 * a * ((a - 1) + (a + 1) * cosW);
+            b2 = a * ((a + 1) + (a - 1) * cosW - shelf);
+            a0 = (a + 1) - (a - 1) * cosW + shelf;
+            a1 = 2 * ((a - 1) - (a + 1) * cosW);
+            a2 = (a + 1) - (a - 1) * cosW - shelf;
+            break;
+        case EqBandType::LowPass:
+            b0 = (1 - cosW) / 2;
+            b1 = 1 - cosW;
+            b2 = (1 - cosW) / 2;
+            a0 = 1 + alpha;
+            a1 = -2 * cosW;
+            a2 = 1 - alpha;
+            break;
+        case EqBandType::HighPass:
+            b0 = (1 + cosW) / 2;
+            b1 = -(1 + cosW);
+            b2 = (1 + cosW) / 2;
+            a0 = 1 + alpha;
+            a1 = -2 * cosW;
+            a2 = 1 - alpha;
+            break;
+        case EqBandType::Peak:
+        default:
+            b0 = 1 + alpha * a;
+            b1 = -2 * cosW;
+            b2 = 1 - alpha * a;
+            a0 = 1 + alpha / a;
+            a1 = -2 * cosW;
+            a2 = 1 - alpha / a;
+            break;
+    }
+
+    BiquadCoefs c;
+    c.b0 = static_cast<float>(b0 / a0);
+    c.b1 = static_cast<float>(b1 / a0);
+    c.b2 = static_cast<float>(b2 / a0);
+    c.a1 = static_cast<float>(a1 / a0);
+    c.a2 = static_cast<float>(a2 / a0);
+    return c;
+}
+
+namespace MixKernels {
+
+#if defined(__SSE2__)
+// One interleaved frame in the low lanes of a vector, zeros above
+template <int Channels>
+inline __m128 loadFrame(const float* p) {
+    if constexpr (Channels == 4) return _mm_loadu_ps(p);
+    else if constexpr (Channels == 2) return _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p));
+    else if constexpr (Channels == 1) return _mm_load_ss(p);
+    else {
+        alignas(16) float lanes[4] = {};
+        memcpy(lanes, p, Channels * sizeof(float));
+        return _mm_load_ps(lanes);
+    }
+}
+
+template <int Channels>
+inline void storeFrame(float* p, __m128 v) {
+    if constexpr (Channels == 4) _mm_storeu_ps(p, v);
+    else if constexpr (Channels == 2) _mm_storel_pi(reinterpret_cast<__m64*>(p), v);
+    else if constexpr (Channels == 1) _mm_store_ss(p, v);
+    else {
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, v);
+        memcpy(p, lanes, Channels * sizeof(float));
+    }
+}
+#endif
+
+// Transposed direct form II biquad, in place. z1/z2 hold one state value
+// per channel (at least 4 floats each, 16-byte aligned). The recursion is
+// serial in time, so the SIMD path runs every channel of a frame in one
+// vector instead (2 to 4 channels; mono gains nothing from it).
+template <int Channels>
+inline void biquad(float* buf, int frames, const BiquadCoefs& c, float* z1, float* z2) {
+    static_assert(Channels >= 1 && Channels <= 8, "unsupported channel count");
+
+#if defined(__SSE2__)
+    if constexpr (Channels >= 2 && Channels <= 4) {
+        const __m128 b0 = _mm_set1_ps(c.b0), b1 = _mm_set1_ps(c.b1), b2 = _mm_set1_ps(c.b2);
+        const __m128 a1 = _mm_set1_ps(c.a1), a2 = _mm_set1_ps(c.a2);
+        __m128 s1 = _mm_load_ps(z1);
+        __m128 s2 = _mm_load_ps(z2);
+        for (int f = 0; f < frames; f++, buf += Channels) {
+            __m128 x = loadFrame<Channels>(buf);
+            __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), s1);
+            s1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), s2);
+            s2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+            storeFrame<Channels>(buf, y);
+        }
+        // Flush decaying tails before they go denormal
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const __m128 tiny = _mm_set1_ps(1e-15f);
+        s1 = _mm_and_ps(s1, _mm_cmpge_ps(_mm_and_ps(s1, absMask), tiny));
+        s2 = _mm_and_ps(s2, _mm_cmpge_ps(_mm_and_ps(s2, absMask), tiny));
+        _mm_store_ps(z1, s1);
+        _mm_store_ps(z2, s2);
+        return;
+    }
+#endif
+
+    // State in locals so it stays in registers (buf could alias z1/z2)
+    float s1[Channels], s2[Channels];
+    for (int ch = 0; ch < Channels; ch++) {
+        s1[ch] = z1[ch];
+        s2[ch] = z2[ch];
+    }
+    for (int f = 0; f < frames; f++, buf += Channels) {
+        for (int ch = 0; ch < Channels; ch++) {
+            float x = buf[ch];
+            float y = c.b0 * x + s1[ch];
+            s1[ch] = c.b1 * x - c.a1 * y + s2[ch];
+            s2[ch] = c.b2 * x - c.a2 * y;
+            buf[ch] = y;
+        }
+    }
+    for (int ch = 0; ch < Channels; ch++) {
+        z1[ch] = std::fabs(s1[ch]) < 1e-15f ? 0.0f : s1[ch];
+        z2[ch] = std::fabs(s2[ch]) < 1e-15f ? 0.0f : s2[ch];
+    }
+}
+
+} // namespace MixKernels
+
+// Runs an AudioEffectChain over interleaved float blocks, keeping filter
+// and envelope state between calls. Real-time safe: fixed-size state, no
+// allocation; coefficients are recomputed only when the parameters change.
+class AudioEffectProcessor {
+public:
+    static constexpr int MAX_CHANNELS = 8;
+
+    // Process `frames` frames of `buf` in place
+    template <int Channels>
+    void process(float* buf, int frames, const AudioEffectChain& chain, float sampleRate) {
+        static_assert(Channels <= MAX_CHANNELS, "unsupported channel count");
+        if (!(chain == m_chain) || sampleRate != m_sampleRate) configure(chain, sampleRate);
+
+        if (chain.eqEnabled) {
+            for (int b = 0; b < AudioEffectChain::EQ_BANDS; b++) {
+                if (!m_eqActive[b]) continue;
+                MixKernels::biquad<Channels>(buf, frames, m_eqCoefs[b], m_eqZ1[b], m_eqZ2[b]);
+            }
+        }
+        if (chain.compressor.enabled) compress<Channels>(buf, frames);
+        if (chain.limiter.enabled) limit<Channels>(buf, frames);
+    }
+
+    void reset() { *this = AudioEffectProcessor(); }
+
+private:
+    // Compressor gain is computed once per segment and ramped across it
+    static constexpr int COMPRESSOR_SEGMENT = 16;
+
+    void configure(const AudioEffectChain& chain, float sampleRate) {
+        if (chain.eqEnabled && !m_chain.eqEnabled) {
+            memset(m_eqZ1, 0, sizeof(m_eqZ1));
+            memset(m_eqZ2, 0, sizeof(m_eqZ2));
+        }
+        m_chain = chain;
+        m_sampleRate = sampleRate;
+
+        for (int b = 0; b < AudioEffectChain::EQ_BANDS; b++) {
+            const EqBand& band = chain.eq[b];
+            bool flat = std::fabs(band.gainDb) < 0.01f &&
+                        band.type != EqBandType::LowPass && band.type != EqBandType::HighPass;
+            m_eqActive[b] = !flat;
+            m_eqCoefs[b] = designBiquad(band, sampleRate);
+        }
+
+        auto segmentCoef = [&](float ms, int frames) {
+            return std::exp(-frames / (std::max(0.1f, ms) * 0.001f * sampleRate));
+        };
+        const auto& comp = chain.compressor;
+        m_compAttack = segmentCoef(comp.attackMs, COMPRESSOR_SEGMENT);
+        m_compRelease = segmentCoef(comp.releaseMs, COMPRESSOR_SEGMENT);
+        m_compSlope = 1.0f - 1.0f / std::max(1.0f, comp.ratio);
+
+        m_limitCeiling = std::pow(10.0f, std::min(0.0f, chain.limiter.ceilingDb) / 20.0f);
+        m_limitRelease = segmentCoef(chain.limiter.releaseMs, 1);
+    }
+
+    // Feed-forward peak compressor, stereo-linked: one gain for all channels
+    template <int Channels>
+    void compress(float* buf, int frames) {
+        const auto& comp = m_chain.compressor;
+        for (int f = 0; f < frames; f += COMPRESSOR_SEGMENT) {
+            int n = std::min(COMPRESSOR_SEGMENT, frames - f);
+            float* seg = buf + f * Channels;
+
+            float level = MixKernels::peak(seg, n * Channels);
+            float levelDb = 20.0f * std::log10(std::max(level, 1e-9f));
+            float over = levelDb - comp.thresholdDb;
+            float target = over > 0.0f ? over * m_compSlope : 0.0f;
+            float coef = target > m_gainReduction ? m_compAttack : m_compRelease;
+            m_gainReduction = target + (m_gainReduction - target) * coef;
+
+            float gain = std::pow(10.0f, (comp.makeupDb - m_gainReduction) / 20.0f);
+            MixKernels::scaleRamp<Channels>(seg, n, m_compGain, (gain - m_compGain) / n);
+            m_compGain = gain;
+        }
+    }
+
+    // Instant attack, so no sample ever exceeds the ceiling; no lookahead,
+    // so the chain adds no latency
+    template <int Channels>
+    void limit(float* buf, int frames) {
+        if (m_limitGain >= 1.0f && MixKernels::peak(buf, frames * Channels) <= m_limitCeiling) return;
+
+        for (int f = 0; f < frames; f++, buf += Channels) {
+            float level = 0.0f;
+            for (int ch = 0; ch < Channels; ch++) level = std::max(level, std::fabs(buf[ch]));
+            float target = level > m_limitCeiling ? m_limitCeiling / level : 1.0f;
+            m_limitGain = target < m_limitGain ? target
+                                               : target + (m_limitGain - target) * m_limitRelease;
+#if defined(__SSE2__)
+            if constexpr (Channels <= 4) {
+                MixKernels::storeFrame<Channels>(
+                    buf, _mm_mul_ps(MixKernels::loadFrame<Channels>(buf), _mm_set1_ps(m_limitGain)));
+                continue;
+            }
+#endif
+            for (int ch = 0; ch < Channels; ch++) buf[ch] *= m_limitGain;
+        }
+        if (m_limitGain > 0.99999f) m_limitGain = 1.0f;
+    }
+
+    AudioEffectChain m_chain;
+    float m_sampleRate = 0.0f;
+
+    BiquadCoefs m_eqCoefs[AudioEffectChain::EQ_BANDS];
+    bool m_eqActive[AudioEffectChain::EQ_BANDS] = {};
+    alignas(16) float m_eqZ1[AudioEffectChain::EQ_BANDS][MAX_CHANNELS] = {};
+    alignas(16) float m_eqZ2[AudioEffectChain::EQ_BANDS][MAX_CHANNELS] = {};
+
+    float m_compAttack = 0.0f;
+    float m_compRelease = 0.0f;
+    float m_compSlope = 0.0f;
+    float m_gainReduction = 0.0f;  // dB
+    float m_compGain = 1.0f;       // applied at the end of the last segment
+
+    float m_limitCeiling = 1.0f;
+    float m_limitRelease = 0.0f;
+    float m_limitGain = 1.0f;
+};
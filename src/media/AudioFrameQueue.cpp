@@ -1,4 +1,6 @@
 #include "media/AudioFrameQueue.h"
+#include <algorithm>
+#include <chrono>
 
 AudioFrameQueue::AudioFrameQueue() {
     for (auto& e : m_ring) {
@@ -14,54 +16,58 @@ AudioFrameQueue::~AudioFrameQueue() {
 }
 
 bool AudioFrameQueue::push(AVFrame* frame, int serial) {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    m_condWrite.wait(lock, [this] { return m_count < CAPACITY || m_abort.load(); });
-    if (m_abort.load()) return false;
+    uint64_t write = m_writeCount.load(std::memory_order_relaxed);
 
-    av_frame_unref(m_ring[m_writeIdx].frame);
-    av_frame_move_ref(m_ring[m_writeIdx].frame, frame);
-    m_ring[m_writeIdx].serial = serial;
-    m_writeIdx = (m_writeIdx + 1) % CAPACITY;
-    m_count++;
+    // Space is freed by the consumer's pop() (or its skip past a flush),
+    // which doesn't notify, so poll; flush() and abort() wake us early
+    if (write - m_readCount.load(std::memory_order_acquire) >= CAPACITY) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_abort.load() && write - m_readCount.load(std::memory_order_acquire) >= CAPACITY) {
+            m_condWrite.wait_for(lock, std::chrono::milliseconds(2));
+        }
+    }
+    if (m_abort.load()) return false;
 
-    lock.unlock();
-    m_condRead.notify_one();
+    // The consumer is done with this slot; free what it held last time
+    Entry& e = m_ring[write % CAPACITY];
+    av_frame_unref(e.frame);
+    av_frame_move_ref(e.frame, frame);
+    e.serial = serial;
+    m_writeCount.store(write + 1, std::memory_order_release);
     return true;
 }
 
 AVFrame* AudioFrameQueue::peek(int* outSerial) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_count == 0) return nullptr;
-    if (outSerial) *outSerial = m_ring[m_readIdx].serial;
-    return m_ring[m_readIdx].frame;
+    uint64_t read = m_readCount.load(std::memory_order_relaxed);
+    uint64_t flushed = m_flushCount.load(std::memory_order_acquire);
+    if (read < flushed) {
+        read = flushed;
+        m_readCount.store(read, std::memory_order_release);
+    }
+    if (read == m_writeCount.load(std::memory_order_acquire)) return nullptr;
+
+    const Entry& e = m_ring[read % CAPACITY];
+    if (outSerial) *outSerial = e.serial;
+    return e.frame;
 }
 
 void AudioFrameQueue::pop() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_count == 0) return;
-    av_frame_unref(m_ring[m_readIdx].frame);
-    m_ring[m_readIdx].serial = -1;
-    m_readIdx = (m_readIdx + 1) % CAPACITY;
-    m_count--;
-    m_condWrite.notify_one();
+    uint64_t read = m_readCount.load(std::memory_order_relaxed);
+    if (read == m_writeCount.load(std::memory_order_acquire)) return;
+    m_readCount.store(read + 1, std::memory_order_release);
 }
 
 void AudioFrameQueue::flush() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    for (int i = 0; i < m_count; i++) {
-        int idx = (m_readIdx + i) % CAPACITY;
-        av_frame_unref(m_ring[idx].frame);
-        m_ring[idx].serial = -1;
-    }
-    m_readIdx = 0;
-    m_writeIdx = 0;
-    m_count = 0;
+    // Frames stay referenced until the producer overwrites their slots
+    m_flushCount.store(m_writeCount.load(std::memory_order_acquire), std::memory_order_release);
     m_condWrite.notify_all();
 }
 
 void AudioFrameQueue::abort() {
-    m_abort.store(true);
-    m_condRead.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_abort.store(true);
+    }
     m_condWrite.notify_all();
 }
 
@@ -70,11 +76,12 @@ void AudioFrameQueue::start() {
 }
 
 size_t AudioFrameQueue::size() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_count;
+    uint64_t write = m_writeCount.load(std::memory_order_acquire);
+    uint64_t read = std::max(m_readCount.load(std::memory_order_acquire),
+                             m_flushCount.load(std::memory_order_acquire));
+    return write > read ? static_cast<size_t>(write - read) : 0;
 }
 
 bool AudioFrameQueue::empty() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_count == 0;
+    return size() == 0;
 }
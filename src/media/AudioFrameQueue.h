@@ -7,8 +7,16 @@ extern "C" {
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <cstdint>
 
 // AVFrame-based ring buffer for audio decoded frames.
+//
+// Single producer (the decoder), single consumer (the audio callback or the
+// export thread). The consumer side is wait-free: peek() and pop() only
+// touch atomics and never free memory, so they are safe on a real-time
+// thread. A popped frame keeps its buffers until the producer reuses the
+// slot. flush() may be called from any thread; the consumer skips the
+// flushed frames on its next peek().
 class AudioFrameQueue {
 public:
     static constexpr int CAPACITY = 32;
@@ -33,12 +41,15 @@ private:
         int serial;
     };
 
+    // Free-running counters; slot = count % CAPACITY
     Entry m_ring[CAPACITY]{};
-    int m_readIdx = 0;
-    int m_writeIdx = 0;
-    int m_count = 0;
-    mutable std::mutex m_mutex;
-    std::condition_variable m_condRead;
+    std::atomic<uint64_t> m_writeCount{0};  // producer
+    std::atomic<uint64_t> m_readCount{0};   // consumer
+    std::atomic<uint64_t> m_flushCount{0};  // everything before this is dropped
+
+    // Only the producer waits (for space); it polls, so the consumer never
+    // has to signal
+    std::mutex m_mutex;
     std::condition_variable m_condWrite;
     std::atomic<bool> m_abort{false};
 };
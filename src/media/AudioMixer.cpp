@@ -1,85 +1,586 @@
 #include "media/AudioMixer.h"
+#include "media/AudioPcmCache.h"
+#include "media/MixKernels.h"
+#include "media/MixdownCache.h"
 #include "timeline/Timeline.h"
 #include <cstring>
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <cmath>
 #include <cstdio>
+#include <numbers>
+#include <unordered_map>
 
 extern "C" {
 #include <libavutil/frame.h>
 #include <libavutil/mathematics.h>
 }
 
+static_assert(PcmBuffer::SAMPLE_RATE == AudioMixer::OUTPUT_SAMPLE_RATE &&
+              PcmBuffer::CHANNELS == AudioMixer::OUTPUT_CHANNELS,
+              "PCM cache must hold mixer-format audio");
+
 AudioMixer::~AudioMixer() {
-    clearSources();
+    // Rendering must be stopped by now
+    reclaim();
+    delete m_active;
+    delete m_pending.load();
 }
 
-void AudioMixer::setSources(std::vector<AudioMixSource> sources) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    for (auto& src : m_sources) {
-        src.currentFrame = nullptr;
-        src.frameByteOffset = 0;
+// Add `in` to `out` ramping gain and stereo balance across the frames
+static void mixGainPan(float* out, const float* in, int frames,
+                       float gainStart, float gainEnd, float panStart, float panEnd) {
+    static_assert(AudioMixer::OUTPUT_CHANNELS == 2, "pan is stereo balance");
+    if (frames <= 0) return;
+    if (panStart == 0.0f && panEnd == 0.0f) {
+        MixKernels::mixRamp<2>(out, in, frames, gainStart, (gainEnd - gainStart) / frames);
+        return;
     }
-    m_sources = std::move(sources);
+    float leftStart, rightStart, leftEnd, rightEnd;
+    Automation::balance(panStart, leftStart, rightStart);
+    Automation::balance(panEnd, leftEnd, rightEnd);
+    float gain[2] = {gainStart * leftStart, gainStart * rightStart};
+    float step[2] = {(gainEnd * leftEnd - gain[0]) / frames, (gainEnd * rightEnd - gain[1]) / frames};
+    MixKernels::mixRampChannels<2>(out, in, frames, gain, step);
 }
 
-void AudioMixer::clearSources() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    for (auto& src : m_sources) {
-        src.currentFrame = nullptr;
-        src.frameByteOffset = 0;
+// Node keys: master is 0, tracks and buses are tagged with their kind
+static constexpr uint64_t TRACK_NODE = 1ull << 32;
+static constexpr uint64_t BUS_NODE = 2ull << 32;
+
+uint64_t AudioMixer::setSources(std::vector<AudioMixSource> sources,
+                                const std::vector<const AudioBus*>& buses,
+                                const AudioEffectChain* masterEffects) {
+    reclaim();
+    m_publishedCount = sources.size();
+
+    // A list published earlier but never adopted can be freed right away:
+    // the exchange proves render() never saw it
+    auto* list = new SourceList();
+    list->sources = std::move(sources);
+    for (auto& src : list->sources) {
+        list->queueSources += src.pcm ? 0 : 1;
+        if (src.clip) {
+            src.volumeCurve = src.clip->volumeCurve;
+            src.panCurve = src.clip->panCurve;
+        }
+        if (src.pcm && src.clip && src.clip->speed != 1.0) src.stretch = std::make_shared<TimeStretch>();
     }
-    m_sources.clear();
+    buildGraph(*list, buses, masterEffects);
+    for (const AudioStemTap& stem : m_stems) {
+        uint64_t key = (stem.bus ? BUS_NODE : TRACK_NODE) | stem.id;
+        auto node = std::find_if(list->nodes.begin(), list->nodes.end(),
+                                 [&](const MixNode& n) { return n.key == key; });
+        list->stemNodes.push_back(node == list->nodes.end() ? -1 : static_cast<int>(node - list->nodes.begin()));
+        if (node != list->nodes.end()) node->tapped = true;
+    }
+    delete m_pending.exchange(list);
+
+    // A render() that began before the exchange may still be on the old list
+    return m_renderCount.load();
 }
 
-bool AudioMixer::hasSources() const {
-    return !m_sources.empty();
+void AudioMixer::buildGraph(SourceList& list, const std::vector<const AudioBus*>& buses,
+                            const AudioEffectChain* masterEffects) {
+    std::unordered_map<uint32_t, const AudioBus*> busById;
+    for (const AudioBus* bus : buses) busById[bus->id] = bus;
+
+    auto& nodes = list.nodes;
+    std::unordered_map<uint64_t, int> nodeByKey;
+    nodes.emplace_back();  // master
+    nodes[0].effects = masterEffects;
+
+    // Nodes are created parent first, so every parent has a lower index.
+    // Only buses something feeds get a node. A chain longer than there are
+    // buses must loop, and is cut off at master.
+    auto busNode = [&](auto& self, uint32_t busId, size_t hops) -> int {
+        auto bus = busById.find(busId);
+        if (bus == busById.end() || hops > buses.size()) return 0;
+        uint64_t key = BUS_NODE | busId;
+        if (auto it = nodeByKey.find(key); it != nodeByKey.end()) return it->second;
+
+        int parent = self(self, bus->second->parentId, hops + 1);
+        int index = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+        nodes[index].key = key;
+        nodes[index].bus = bus->second;
+        nodes[index].parent = parent;
+        nodeByKey[key] = index;
+        return index;
+    };
+
+    for (int i = 0; i < static_cast<int>(list.sources.size()); i++) {
+        const Track* track = list.sources[i].track;
+        if (!track) {
+            nodes[0].sources.push_back(i);
+            continue;
+        }
+        uint64_t key = TRACK_NODE | track->id;
+        auto it = nodeByKey.find(key);
+        if (it == nodeByKey.end()) {
+            int parent = busNode(busNode, track->busId, 0);
+            int index = static_cast<int>(nodes.size());
+            nodes.emplace_back();
+            nodes[index].key = key;
+            nodes[index].track = track;
+            nodes[index].effects = &track->effects;
+            nodes[index].volumeCurve = track->volumeCurve;
+            nodes[index].panCurve = track->panCurve;
+            nodes[index].parent = parent;
+            it = nodeByKey.emplace(key, index).first;
+        }
+        nodes[it->second].sources.push_back(i);
+    }
+
+    std::vector<int> depth(nodes.size(), 0);
+    list.levels.push_back({0});
+    for (int i = 1; i < static_cast<int>(nodes.size()); i++) {
+        nodes[nodes[i].parent].children.push_back(i);
+        depth[i] = depth[nodes[i].parent] + 1;
+        if (depth[i] >= static_cast<int>(list.levels.size())) list.levels.resize(depth[i] + 1);
+        list.levels[depth[i]].push_back(i);
+    }
+
+    // Master mixes straight into the output
+    size_t stride = MAX_BLOCK_FRAMES * OUTPUT_CHANNELS;
+    list.buffers.assign((nodes.size() - 1) * stride, 0.0f);
+    for (size_t i = 1; i < nodes.size(); i++) {
+        nodes[i].buffer = list.buffers.data() + (i - 1) * stride;
+    }
+}
+
+void AudioMixer::reclaim() {
+    SourceList* list = m_retired.exchange(nullptr);
+    while (list) {
+        SourceList* next = list->nextRetired;
+        delete list;
+        list = next;
+    }
 }
 
 void AudioMixer::lockClockForSeek(double targetTime) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_clockLocked = true;
-    m_seekTargetTime = targetTime;
-    m_clockLockTime = std::chrono::steady_clock::now();
+    m_seekRequestTime.store(targetTime);
+    m_seekRequests.fetch_add(1);
+    setPlayhead(targetTime);
 }
 
-void AudioMixer::fillBuffer(float* out, int frames, Clock& masterClock) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+void AudioMixer::setPlayhead(double timelineSeconds) {
+    m_playheadRequestTime.store(timelineSeconds);
+    m_playheadRequests.fetch_add(1);
+}
 
+void AudioMixer::adoptPending() {
+    if (!m_pending.load()) return;
+    SourceList* next = m_pending.exchange(nullptr);
+    if (!next) return;
+
+    if (m_active) {
+        for (auto& src : next->sources) {
+            for (auto& old : m_active->sources) {
+                if (old.clipId == src.clipId && old.queue == src.queue) {
+                    src.currentFrame = old.currentFrame;
+                    src.frameByteOffset = old.frameByteOffset;
+                    // Swapped, so the list freeing the spare is the
+                    // retired one, off this thread
+                    if (src.stretch && old.stretch) {
+                        std::swap(src.stretch, old.stretch);
+                        src.stretchNext = old.stretchNext;
+                        src.stretchInput = old.stretchInput;
+                    }
+                    break;
+                }
+            }
+        }
+        for (auto& node : next->nodes) {
+            for (auto& old : m_active->nodes) {
+                if (old.key == node.key) {
+                    node.gain = old.gain;
+                    node.pan = old.pan;
+                    node.effectState = old.effectState;
+                    break;
+                }
+            }
+        }
+
+        // Freeing is left to the publishing thread. Only render()
+        // pushes and reclaim() takes the whole stack, so there's no ABA.
+        SourceList* old = m_active;
+        old->nextRetired = m_retired.load();
+        while (!m_retired.compare_exchange_weak(old->nextRetired, old)) {}
+    }
+    m_active = next;
+}
+
+void AudioClockUpdate::apply(Clock& clock, double offsetSeconds) const {
+    if (!valid) return;
+    if (force) clock.set(blockStart + offsetSeconds);
+    else clock.setIfForward(blockStart + offsetSeconds);
+}
+
+void AudioMixer::render(float* out, int frames, AudioClockUpdate& clockUpdate) {
+    // Odd while render() may touch a source list; see isReleased()
+    m_renderCount.fetch_add(1);
+    adoptPending();
+
+    uint64_t seekRequests = m_seekRequests.load();
+    if (seekRequests != m_seekRequestsSeen) {
+        m_seekRequestsSeen = seekRequests;
+        m_clockLocked = true;
+        m_seekTargetTime = m_seekRequestTime.load();
+        m_clockLockTime = std::chrono::steady_clock::now();
+    }
+    uint64_t playheadRequests = m_playheadRequests.load();
+    if (playheadRequests != m_playheadRequestsSeen) {
+        m_playheadRequestsSeen = playheadRequests;
+        m_playhead = std::llround(m_playheadRequestTime.load() * OUTPUT_SAMPLE_RATE);
+        m_playheadMoved = true;
+    }
+
+    clockUpdate = {};
+    bool scrubbing = m_scrubRequested.load();
+    if (scrubbing != m_scrubbing) {
+        m_scrubbing = scrubbing;
+        m_scrubPos = m_scrubTarget.load() * OUTPUT_SAMPLE_RATE;
+        m_scrubReady = 0;
+        memset(m_scrubOut, 0, sizeof(m_scrubOut));
+    }
+    if (m_scrubbing) renderScrub(out, frames);
+    else mixFrames(out, frames, clockUpdate);
+    m_renderCount.fetch_add(1);
+}
+
+void AudioMixer::mixFrames(float* out, int frames, AudioClockUpdate& clockUpdate) {
+    // Chunk clock updates are rebased onto the start of the whole request
+    for (int offset = 0; offset < frames;) {
+        int chunk = std::min(frames - offset, MAX_BLOCK_FRAMES);
+        float* chunkOut = out + offset * OUTPUT_CHANNELS;
+        AudioClockUpdate chunkUpdate;
+        // The mixdown holds no stems
+        if (m_stemOut || !readMixdown(chunkOut, chunk, chunkUpdate)) {
+            mixBlock(chunkOut, chunk, chunkUpdate, offset);
+        }
+        m_playhead += chunk;
+        if (chunkUpdate.valid && (chunkUpdate.force || !clockUpdate.force)) {
+            clockUpdate = chunkUpdate;
+            clockUpdate.blockStart -= static_cast<double>(offset) / OUTPUT_SAMPLE_RATE;
+        }
+        offset += chunk;
+    }
+}
+
+// Periodic Hann, halved: grains a quarter grain apart sum to unity gain
+static const std::array<float, AudioMixer::SCRUB_GRAIN_FRAMES> s_scrubWindow = [] {
+    std::array<float, AudioMixer::SCRUB_GRAIN_FRAMES> window{};
+    for (int i = 0; i < AudioMixer::SCRUB_GRAIN_FRAMES; i++) {
+        window[i] = 0.25f - 0.25f * static_cast<float>(std::cos(2.0 * std::numbers::pi * i / AudioMixer::SCRUB_GRAIN_FRAMES));
+    }
+    return window;
+}();
+
+void AudioMixer::renderScrub(float* out, int frames) {
+    constexpr int hop = SCRUB_HOP_FRAMES;
+    constexpr int channels = OUTPUT_CHANNELS;
+    for (int done = 0; done < frames;) {
+        if (m_scrubReady == 0) {
+            // The leading hop is final once played: no later grain reaches
+            // back into it
+            memmove(m_scrubOut, m_scrubOut + hop * channels,
+                    (SCRUB_GRAIN_FRAMES - hop) * channels * sizeof(float));
+            memset(m_scrubOut + (SCRUB_GRAIN_FRAMES - hop) * channels, 0, hop * channels * sizeof(float));
+            addScrubGrain();
+            m_scrubReady = hop;
+        }
+        int n = std::min(frames - done, m_scrubReady);
+        memcpy(out + done * channels, m_scrubOut + (hop - m_scrubReady) * channels,
+               n * channels * sizeof(float));
+        m_scrubReady -= n;
+        done += n;
+    }
+}
+
+void AudioMixer::addScrubGrain() {
+    // Speed follows how far the target is ahead or behind, so steady drags
+    // play at their own pace and a released drag slows to a stop. Clicking
+    // somewhere else on the ruler jumps instead of racing over.
+    constexpr double chaseFrames = 0.05 * OUTPUT_SAMPLE_RATE;
+    constexpr double maxSpeed = 4.0;
+    constexpr double minSpeed = 0.05;
+    double distance = m_scrubTarget.load() * OUTPUT_SAMPLE_RATE - m_scrubPos;
+    if (std::fabs(distance) > maxSpeed * chaseFrames) {
+        m_scrubPos += distance;
+        return;
+    }
+    double speed = std::clamp(distance / chaseFrames, -maxSpeed, maxSpeed);
+    if (std::fabs(speed) < minSpeed) return;  // holding still: silence
+
+    // Grains play at normal pitch starting at the scrub position; dragging
+    // backwards plays the grain behind it, reversed
+    bool reverse = speed < 0.0;
+    m_playhead = std::llround(m_scrubPos) - (reverse ? SCRUB_GRAIN_FRAMES : 0);
+    AudioClockUpdate ignored;
+    mixFrames(m_scrubGrain, SCRUB_GRAIN_FRAMES, ignored);
+    m_scrubPos += speed * SCRUB_HOP_FRAMES;
+
+    for (int i = 0; i < SCRUB_GRAIN_FRAMES; i++) {
+        const float* in = m_scrubGrain + (reverse ? SCRUB_GRAIN_FRAMES - 1 - i : i) * OUTPUT_CHANNELS;
+        float* outFrame = m_scrubOut + i * OUTPUT_CHANNELS;
+        for (int ch = 0; ch < OUTPUT_CHANNELS; ch++) outFrame[ch] += s_scrubWindow[i] * in[ch];
+    }
+}
+
+bool AudioMixer::readMixdown(float* out, int& frames, AudioClockUpdate& clockUpdate) {
+    // Decoder queues must keep being drained in step, so any of them
+    // keeps the whole mix live (scrubbing leaves them alone anyway)
+    if (!m_mixdown || m_playhead < 0) return false;
+    if (!m_scrubbing && m_active && m_active->queueSources > 0) return false;
+
+    frames = static_cast<int>(std::min<int64_t>(frames, MixdownCache::blockEnd(m_playhead) - m_playhead));
+    if (!m_mixdown->read(m_playhead, out, frames)) return false;
+
+    // Like PCM sources, the cached mix is exactly where the playhead says
+    clockUpdate = {true, m_playheadMoved, static_cast<double>(m_playhead) / OUTPUT_SAMPLE_RATE};
+    if (clockUpdate.force) m_clockLocked = false;
+    m_playheadMoved = false;
+    return true;
+}
+
+void AudioMixer::fillBuffer(float* out, int frames, Clock& masterClock, float* const* stemOut) {
+    AudioClockUpdate clockUpdate;
+    m_stemOut = m_stems.empty() ? nullptr : stemOut;
+    render(out, frames, clockUpdate);
+    m_stemOut = nullptr;
+    clockUpdate.apply(masterClock, static_cast<double>(frames) / OUTPUT_SAMPLE_RATE);
+}
+
+void AudioMixer::mixBlock(float* out, int frames, AudioClockUpdate& clockUpdate, int stemOffset) {
     int totalSamples = frames * OUTPUT_CHANNELS;
-    memset(out, 0, totalSamples * sizeof(float));
+    if (!m_active || m_active->sources.empty() || frames <= 0) {
+        memset(out, 0, totalSamples * sizeof(float));
+        writeStems(frames, stemOffset);
+        return;
+    }
+
+    // Gains, top down: a node mixes only if it and every node above it
+    // are audible somewhere in this block. Fully muted subtrees leave
+    // their queues alone, as before gain ramps existed. A stem tap only
+    // needs its own gain: its stem plays even if a bus above is muted.
+    // Track automation is taken at the block's end; its first block
+    // starts from the value at its start
+    double blockStart = static_cast<double>(m_playhead) / OUTPUT_SAMPLE_RATE;
+    double blockEnd = static_cast<double>(m_playhead + frames) / OUTPUT_SAMPLE_RATE;
+    auto& nodes = m_active->nodes;
+    for (auto& node : nodes) {
+        float target = 1.0f;
+        float pan = 0.0f;
+        if (node.track) {
+            const Track& track = *node.track;
+            target = track.muted ? 0.0f : track.volume * node.volumeCurve.evaluate(blockEnd, 1.0f);
+            pan = node.panCurve.evaluate(blockEnd, track.pan);
+            if (node.gain < 0.0f) {
+                node.gain = track.muted ? 0.0f : track.volume * node.volumeCurve.evaluate(blockStart, 1.0f);
+                node.pan = node.panCurve.evaluate(blockStart, track.pan);
+            }
+        } else if (node.bus) {
+            target = node.bus->muted ? 0.0f : node.bus->volume;
+        }
+        node.gainStart = node.gain < 0.0f ? target : node.gain;
+        node.gainEnd = target;
+        node.gain = target;
+        node.panStart = node.pan;
+        node.panEnd = pan;
+        node.pan = pan;
+        node.active = !(node.gainStart == 0.0f && node.gainEnd == 0.0f) &&
+                      (node.parent < 0 || nodes[node.parent].active || node.tapped);
+        node.clockUpdate = {};
+        node.pcmPlayed = false;
+    }
 
-    if (m_sources.empty()) return;
+    // Deepest level first; each level only reads its children's buffers
+    for (int level = static_cast<int>(m_active->levels.size()) - 1; level >= 0; level--) {
+        LevelTask task{this, &m_active->levels[level], out, frames};
+        m_pool.parallelFor(static_cast<int>(task.nodes->size()), &AudioMixer::mixNodeTask, &task);
+    }
 
-    if ((int)m_tempBuf.size() < totalSamples) {
-        m_tempBuf.resize(totalSamples);
+    if (!nodes[0].limited) MixKernels::clamp(out, totalSamples);
+    writeStems(frames, stemOffset);
+
+    // A landed seek wins, else the last node's update (as when sources
+    // were read one after another)
+    bool pcmPlayed = false;
+    for (const auto& node : nodes) {
+        const AudioClockUpdate& update = node.clockUpdate;
+        if (update.valid && (update.force || !clockUpdate.force)) clockUpdate = update;
+        pcmPlayed |= node.pcmPlayed;
     }
+    if (clockUpdate.force) m_clockLocked = false;
 
-    for (auto& src : m_sources) {
-        if (!src.queue) continue;
-        if (src.track && src.track->muted) continue;
+    // PCM audio is exactly where the playhead says
+    if (pcmPlayed) {
+        clockUpdate = {true, m_playheadMoved, static_cast<double>(m_playhead) / OUTPUT_SAMPLE_RATE};
+        m_playheadMoved = false;
+    }
+}
+
+void AudioMixer::writeStems(int frames, int stemOffset) {
+    if (!m_stemOut) return;
+    for (size_t i = 0; i < m_stems.size(); i++) {
+        float* out = m_stemOut[i] + static_cast<size_t>(stemOffset) * OUTPUT_CHANNELS;
+        memset(out, 0, static_cast<size_t>(frames) * OUTPUT_CHANNELS * sizeof(float));
+
+        // A list published before setStems() has no taps
+        int index = m_active && i < m_active->stemNodes.size() ? m_active->stemNodes[i] : -1;
+        if (index < 0) continue;
+        const MixNode& node = m_active->nodes[index];
+        if (!node.active) continue;
+        mixGainPan(out, node.buffer, frames, node.gainStart, node.gainEnd, node.panStart, node.panEnd);
+        MixKernels::clamp(out, frames * OUTPUT_CHANNELS);
+    }
+}
+
+void AudioMixer::mixNodeTask(void* context, int index) {
+    auto* task = static_cast<LevelTask*>(context);
+    MixNode& node = task->mixer->m_active->nodes[(*task->nodes)[index]];
+    task->mixer->mixNode(node, node.buffer ? node.buffer : task->out, task->frames);
+}
 
-        float volume = (src.track) ? src.track->volume : 1.0f;
+void AudioMixer::mixNode(MixNode& node, float* out, int frames) {
+    if (!node.active) return;
+    memset(out, 0, frames * OUTPUT_CHANNELS * sizeof(float));
 
-        int framesRead = readSource(src, m_tempBuf.data(), frames, masterClock);
-        if (framesRead <= 0) continue;
+    for (int index : node.sources) {
+        AudioMixSource& src = m_active->sources[index];
+        if (src.pcm) node.pcmPlayed |= readPcmSource(src, out, frames);
+        else if (!m_scrubbing) readSource(src, out, frames, node.clockUpdate);
+    }
+    for (int index : node.children) {
+        const MixNode& child = m_active->nodes[index];
+        if (!child.active) continue;
+        mixGainPan(out, child.buffer, frames, child.gainStart, child.gainEnd, child.panStart, child.panEnd);
+    }
 
-        int samplesToMix = framesRead * OUTPUT_CHANNELS;
-        for (int i = 0; i < samplesToMix; i++) {
-            out[i] += m_tempBuf[i] * volume;
+    // Inserts, pre-fader. Copied first: the UI may be editing them.
+    node.limited = false;
+    if (node.effects) {
+        AudioEffectChain chain = *node.effects;
+        if (chain.isActive()) {
+            node.effectState.process<OUTPUT_CHANNELS>(out, frames, chain, OUTPUT_SAMPLE_RATE);
+            node.limited = chain.limiter.enabled;
         }
     }
+}
+
+float AudioMixer::clipGain(const AudioMixSource& src, int64_t frame) const {
+    const Clip& clip = *src.clip;
+    double t = static_cast<double>(frame) / OUTPUT_SAMPLE_RATE - clip.timelineStart;
+    float gain = src.volumeCurve.evaluate(t, 1.0f);
+    if (clip.fadeIn > 0.0) gain *= Automation::fadeGain(t / clip.fadeIn);
+    if (clip.fadeOut > 0.0) gain *= Automation::fadeGain((clip.getDuration() - t) / clip.fadeOut);
+    return gain;
+}
+
+float AudioMixer::clipPan(const AudioMixSource& src, int64_t frame) const {
+    double t = static_cast<double>(frame) / OUTPUT_SAMPLE_RATE - src.clip->timelineStart;
+    return src.panCurve.evaluate(t, 0.0f);
+}
+
+bool AudioMixer::readPcmSource(AudioMixSource& src, float* out, int frames) {
+    if (!src.clip) return false;
+    const PcmBuffer& pcm = *src.pcm;
+
+    // The clip's span in timeline frames, and the buffer frame at its start
+    int64_t clipStart = std::llround(src.clip->timelineStart * OUTPUT_SAMPLE_RATE);
+    int64_t clipEnd = std::llround(src.clip->getTimelineEnd() * OUTPUT_SAMPLE_RATE);
+    int64_t sourceStart = std::llround((src.clip->sourceIn - pcm.getStartTime()) * OUTPUT_SAMPLE_RATE);
+
+    int64_t from = std::max(m_playhead, clipStart);
+    int64_t to = std::min(m_playhead + frames, clipEnd);
+    if (from >= to) return false;
+    if (src.clip->speed != 1.0 && src.stretch) {
+        readStretchedPcm(src, out, from, to);
+        return true;
+    }
+
+    // Before the first decoded sample or past the last is silence
+    int64_t first = std::max<int64_t>(sourceStart + (from - clipStart), 0);
+    int64_t last = std::min(sourceStart + (to - clipStart), pcm.getFrameCount());
+    if (first < last) {
+        int64_t outFrame = from + (first - (sourceStart + (from - clipStart))) - m_playhead;
+        int64_t end = m_playhead + outFrame + (last - first);
+        mixGainPan(out + outFrame * OUTPUT_CHANNELS, pcm.getSamples() + first * OUTPUT_CHANNELS,
+                   static_cast<int>(last - first),
+                   clipGain(src, m_playhead + outFrame), clipGain(src, end),
+                   clipPan(src, m_playhead + outFrame), clipPan(src, end));
+    }
+    return true;
+}
+
+void AudioMixer::readStretchedPcm(AudioMixSource& src, float* out, int64_t from, int64_t to) {
+    static const float silence[1024 * OUTPUT_CHANNELS] = {};
+    const Clip& clip = *src.clip;
+    const PcmBuffer& pcm = *src.pcm;
+    TimeStretch& stretch = *src.stretch;
 
-    // Clamp to [-1, 1]
-    for (int i = 0; i < totalSamples; i++) {
-        out[i] = std::clamp(out[i], -1.0f, 1.0f);
+    // The stretch's output frames count from the clip's start and its input
+    // is the buffer; it starts over wherever playback isn't carrying on
+    int64_t clipStart = std::llround(clip.timelineStart * OUTPUT_SAMPLE_RATE);
+    int64_t sourceStart = std::llround((clip.sourceIn - pcm.getStartTime()) * OUTPUT_SAMPLE_RATE);
+    double speed = std::clamp(clip.speed, TimeStretch::MIN_SPEED, TimeStretch::MAX_SPEED);
+    if (from != src.stretchNext || stretch.getSpeed() != speed || stretch.getAnchor() != sourceStart ||
+        stretch.nextOutputFrame() != from - clipStart) {
+        stretch.reset(speed, sourceStart);
+        src.stretchInput = stretch.seekOutput(from - clipStart);
     }
+
+    float gain[2] = {clipGain(src, from), clipGain(src, to)};
+    float pan[2] = {clipPan(src, from), clipPan(src, to)};
+    auto at = [&](const float (&ramp)[2], int64_t frame) {
+        return ramp[0] + (ramp[1] - ramp[0]) * static_cast<float>(frame - from) / static_cast<float>(to - from);
+    };
+
+    float chunk[256 * OUTPUT_CHANNELS];
+    int64_t frame = from;
+    while (frame < to) {
+        int got = stretch.pull(chunk, static_cast<int>(std::min<int64_t>(to - frame, 256)));
+        if (got == 0) {
+            // Feed it: the buffer, or silence before and after it
+            int64_t input = src.stretchInput;
+            int taken;
+            if (input >= 0 && input < pcm.getFrameCount()) {
+                int count = static_cast<int>(std::min<int64_t>(pcm.getFrameCount() - input, 4096));
+                taken = stretch.push(pcm.getSamples() + input * OUTPUT_CHANNELS, count);
+            } else {
+                int count = input < 0 ? static_cast<int>(std::min<int64_t>(-input, 1024)) : 1024;
+                taken = stretch.push(silence, count);
+            }
+            src.stretchInput += taken;
+            if (taken == 0) break;
+            continue;
+        }
+        mixGainPan(out + (frame - m_playhead) * OUTPUT_CHANNELS, chunk, got,
+                   at(gain, frame), at(gain, frame + got), at(pan, frame), at(pan, frame + got));
+        frame += got;
+    }
+    src.stretchNext = frame;
 }
 
-int AudioMixer::readSource(AudioMixSource& src, float* buf, int frames, Clock& masterClock) {
+int AudioMixer::readSource(AudioMixSource& src, float* out, int frames, AudioClockUpdate& clockUpdate) {
     if (!src.queue) return 0;
 
+    // Clip automation across the block, by the playhead (decoded audio
+    // follows it to within its clock slack)
+    float gain[2] = {1.0f, 1.0f};
+    float pan[2] = {0.0f, 0.0f};
+    if (src.clip) {
+        gain[0] = clipGain(src, m_playhead);
+        gain[1] = clipGain(src, m_playhead + frames);
+        pan[0] = clipPan(src, m_playhead);
+        pan[1] = clipPan(src, m_playhead + frames);
+    }
+    auto at = [frames](const float (&ramp)[2], int frame) {
+        return ramp[0] + (ramp[1] - ramp[0]) * static_cast<float>(frame) / static_cast<float>(frames);
+    };
+
     int framesWritten = 0;
     int bytesPerFrame = OUTPUT_CHANNELS * sizeof(float);
 
@@ -103,11 +604,14 @@ int AudioMixer::readSource(AudioMixSource& src, float* buf, int frames, Clock& m
 
             double timelineTime = pts;
             if (src.clip) {
-                timelineTime = (pts - src.clip->sourceIn) + src.clip->timelineStart;
+                timelineTime = (pts - src.clip->sourceIn) / src.clip->speed + src.clip->timelineStart;
             }
+            double blockStart = timelineTime - static_cast<double>(framesWritten) / OUTPUT_SAMPLE_RATE;
 
             // During an explicit seek, discard stale pre-seek frames
             // (from before the demux thread processes the seek request).
+            // The lock is lifted after the block, once every source has
+            // had its say (sources may be read in parallel).
             if (m_clockLocked) {
                 auto elapsed = std::chrono::steady_clock::now() - m_clockLockTime;
                 bool timedOut = elapsed > std::chrono::milliseconds(1000);
@@ -115,8 +619,7 @@ int AudioMixer::readSource(AudioMixSource& src, float* buf, int frames, Clock& m
                 // for keyframe-based seeking landing a bit before target).
                 bool ptsReasonable = timelineTime >= m_seekTargetTime - 3.0;
                 if (ptsReasonable || timedOut) {
-                    m_clockLocked = false;
-                    masterClock.set(timelineTime);
+                    if (!clockUpdate.force) clockUpdate = {true, true, blockStart};
                 } else {
                     // Definitely stale — discard
                     src.queue->pop();
@@ -125,7 +628,7 @@ int AudioMixer::readSource(AudioMixSource& src, float* buf, int frames, Clock& m
                 }
             } else {
                 // Normal playback — update clock but never jump backward.
-                masterClock.setIfForward(timelineTime);
+                if (!clockUpdate.force) clockUpdate = {true, false, blockStart};
             }
         }
 
@@ -133,27 +636,21 @@ int AudioMixer::readSource(AudioMixSource& src, float* buf, int frames, Clock& m
         int frameBytes = frameSamples * bytesPerFrame;
         int remaining = frameBytes - src.frameByteOffset;
         int needed = (frames - framesWritten) * bytesPerFrame;
+        int span = std::min(remaining, needed) / bytesPerFrame;
+
+        mixGainPan(out + framesWritten * OUTPUT_CHANNELS,
+                   reinterpret_cast<const float*>(frame->data[0] + src.frameByteOffset), span,
+                   at(gain, framesWritten), at(gain, framesWritten + span),
+                   at(pan, framesWritten), at(pan, framesWritten + span));
+        framesWritten += span;
 
         if (remaining <= needed) {
-            memcpy(reinterpret_cast<uint8_t*>(buf) + framesWritten * bytesPerFrame,
-                   frame->data[0] + src.frameByteOffset,
-                   remaining);
-            framesWritten += remaining / bytesPerFrame;
             src.frameByteOffset = 0;
             src.queue->pop();
         } else {
-            memcpy(reinterpret_cast<uint8_t*>(buf) + framesWritten * bytesPerFrame,
-                   frame->data[0] + src.frameByteOffset,
-                   needed);
             src.frameByteOffset += needed;
-            framesWritten += needed / bytesPerFrame;
         }
     }
 
-    if (framesWritten < frames) {
-        memset(reinterpret_cast<uint8_t*>(buf) + framesWritten * bytesPerFrame,
-               0, (frames - framesWritten) * bytesPerFrame);
-    }
-
     return framesWritten;
 }
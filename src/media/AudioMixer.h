@@ -1,9 +1,12 @@
 #pragma once
 
+#include "media/AudioEffects.h"
 #include "media/AudioFrameQueue.h"
 #include "media/Clock.h"
+#include "media/MixWorkerPool.h"
+#include "media/TimeStretch.h"
+#include "timeline/Automation.h"
 #include <vector>
-#include <mutex>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -14,60 +17,282 @@ extern "C" {
 
 struct Clip;
 struct Track;
+struct AudioBus;
+class PcmBuffer;
+class MixdownCache;
 
-// A single audio source feeding into the mixer.
+// A single audio source feeding into the mixer: either a decoder's frame
+// queue, or (once its asset is cached) decoded PCM read by position.
 struct AudioMixSource {
     AudioFrameQueue* queue = nullptr;
+    const PcmBuffer* pcm = nullptr;     // preferred over queue; needs clip
     const Clip* clip = nullptr;         // for time mapping
-    const Track* track = nullptr;       // for volume/mute
+    const Track* track = nullptr;       // for volume/mute and bus routing
     AVRational timeBase{};
     uint32_t clipId = 0;
 
-    // Per-source read state (owned by mixer, only touched under lock)
+    // The clip's automation, copied by setSources()
+    AutomationCurve volumeCurve;
+    AutomationCurve panCurve;
+
+    // Per-source read state (owned by the mixing thread)
     AVFrame* currentFrame = nullptr;
     int frameByteOffset = 0;
+
+    // Retimed PCM sources: stretch (allocated by setSources()), the
+    // timeline frame its next output plays at and the buffer frame it
+    // takes next
+    std::shared_ptr<TimeStretch> stretch;
+    int64_t stretchNext = -1;
+    int64_t stretchInput = 0;
+};
+
+// A track's or bus's own output, delivered beside the mix (stem export)
+struct AudioStemTap {
+    bool bus = false;  // id names a bus, else a track
+    uint32_t id = 0;
+};
+
+// Master clock update produced while mixing a block. The time refers to the
+// block's first sample, so it can be applied whenever that block is actually
+// played, however far ahead it was mixed.
+struct AudioClockUpdate {
+    bool valid = false;
+    bool force = false;       // set() (a seek landed), else setIfForward()
+    double blockStart = 0.0;  // timeline seconds
+
+    // Apply as of offsetSeconds into the block
+    void apply(Clock& clock, double offsetSeconds) const;
 };
 
 // Mixes multiple AudioFrameQueue sources into a single interleaved float buffer.
-// Called from the SDL audio callback thread.
+// Called from AudioOutput's render thread (or the export thread).
+//
+// Sources are mixed through a tree of sub-mixes: each clip's audio is summed
+// into its track, each track into the AudioBus it is routed to, buses into
+// their parent buses, and the top level into the master output. Every node
+// has its own block buffer; nodes at the same depth are independent and are
+// mixed in parallel on a MixWorkerPool, deepest level first, so each level
+// only reads finished children. Sources are read straight out of their
+// decoded frames (see MixKernels). Tracks and the master run their insert
+// effects (AudioEffectChain) on their sub-mix before its volume is applied;
+// the master chain's limiter, when enabled, replaces the final hard clip.
+// Gain changes (track and bus volume, mute) ramp linearly across one output
+// block, and a silent node skips its whole subtree.
+//
+// Automation (track and clip volume and pan, clip fades) is evaluated once
+// per block, at its edges, and applied as part of those ramps. Curves are
+// copied into the published graph, so the UI editing them needs a new
+// setSources(); fades are read live.
+//
+// PCM sources are read at the mixer's own playhead (timeline frames, set by
+// setPlayhead() and advanced by every block), so they start and seek
+// instantly and land on exact samples; their blocks also drive the master
+// clock. Queue sources go through pre-roll skipping and the seek clock lock.
+// With a MixdownCache attached and only PCM sources playing, blocks the
+// cache holds a current mix for are copied from it instead of mixed.
+//
+// The source list is published RCU-style, so neither side ever waits on the
+// other: setSources() hands a new list over through an atomic pointer, the
+// mixing thread adopts it at the start of its next block (carrying read state
+// over) and hands the old list back for the publishing thread to free.
+// Whatever the old list referenced (frame queues, and the clips, tracks and
+// buses behind its pointers) must stay alive until isReleased() reports
+// that no render() can still be reading it.
 class AudioMixer {
 public:
     static constexpr int OUTPUT_SAMPLE_RATE = 48000;
     static constexpr int OUTPUT_CHANNELS = 2;
 
+    // Largest block mixed in one pass; render() splits bigger requests
+    static constexpr int MAX_BLOCK_FRAMES = 1024;
+
+    // Scrub grains: 21 ms long, one started every 5.3 ms
+    static constexpr int SCRUB_GRAIN_FRAMES = 1024;
+    static constexpr int SCRUB_HOP_FRAMES = SCRUB_GRAIN_FRAMES / 4;
+
     ~AudioMixer();
 
-    // Replace the active set of sources. Called from main thread when
-    // active clips change. Thread-safe with the audio callback.
-    void setSources(std::vector<AudioMixSource> sources);
+    // Threads helping the mixing thread; 0 (default) mixes on it alone.
+    // Only while nothing is rendering.
+    void setWorkerCount(int workers) { m_pool.start(workers); }
+
+    // Play pre-rendered blocks from `mixdown` wherever they are current.
+    // Only while nothing is rendering.
+    void setMixdown(const MixdownCache* mixdown) { m_mixdown = mixdown; }
+
+    // Publish a new set of sources, routed through `buses` (the tracks'
+    // busId and the buses' parentId are read now; gains and effect
+    // parameters, including masterEffects, are read live).
+    // Called from the thread that owns the mixer's sources (main or export
+    // thread); never blocks. Sources that survive (same clipId and queue)
+    // keep their read position. Returns a token for isReleased().
+    uint64_t setSources(std::vector<AudioMixSource> sources,
+                        const std::vector<const AudioBus*>& buses = {},
+                        const AudioEffectChain* masterEffects = nullptr);
+
+    // Publish an empty set. Called on stop.
+    uint64_t clearSources() { return setSources({}); }
 
-    // Clear all sources. Called on stop.
-    void clearSources();
+    // True once no render() can still be using sources replaced by the
+    // setSources() call that returned token
+    bool isReleased(uint64_t token) const {
+        return (token & 1) == 0 || m_renderCount.load() != token;
+    }
+
+    // Free source lists the mixing thread has handed back. setSources()
+    // does this too; call it periodically so retired lists don't pile up.
+    void reclaim();
 
     // Lock the master clock after a seek. While locked, readSource() will
     // only update the clock once the audio PTS is within tolerance of the
     // target (meaning the seek has been processed). Auto-unlocks after 500ms.
     void lockClockForSeek(double targetTime);
 
-    // Called from SDL audio thread to fill output buffer.
-    // Mixes all sources, updates master clock from the first source with data.
-    void fillBuffer(float* out, int frames, Clock& masterClock);
+    // Move the playhead PCM sources are read at, as of the next block.
+    // lockClockForSeek() does this too.
+    void setPlayhead(double timelineSeconds);
+
+    // Scrubbing (main thread). While on, render() plays short windowed
+    // grains around a scrub position that chases the scrubTo() target, so
+    // they follow the drag's speed and direction and die away when it stops.
+    // Only PCM sources (and the mixdown cache) are heard, and the master
+    // clock is left alone.
+    void setScrubbing(bool scrubbing) { m_scrubRequested.store(scrubbing); }
+    void scrubTo(double timelineSeconds) { m_scrubTarget.store(timelineSeconds); }
+
+    // Mix the next block. The master clock update it implies is returned
+    // rather than applied, for audio that is rendered ahead of playback.
+    void render(float* out, int frames, AudioClockUpdate& clockUpdate);
 
-    bool hasSources() const;
+    // Also deliver these tracks' or buses' own output (after their effects
+    // and volume, before whatever they feed) beside the mix, from the next
+    // setSources() on. Same thread as setSources(); only while nothing is
+    // rendering.
+    void setStems(std::vector<AudioStemTap> stems) { m_stems = std::move(stems); }
+
+    // Mix the next block and update the clock straight away (export). With
+    // stems set, stemOut holds one buffer of `frames` frames per stem.
+    void fillBuffer(float* out, int frames, Clock& masterClock, float* const* stemOut = nullptr);
+
+    // Whether the last published set is non-empty (publishing thread)
+    bool hasSources() const { return m_publishedCount > 0; }
 
 private:
-    // Read up to `frames` samples from one source into `buf`.
+    // A track or bus sub-mix, or the master output (node 0)
+    struct MixNode {
+        uint64_t key = 0;               // identifies the node across publishes
+        const Track* track = nullptr;   // gain source: the track,
+        const AudioBus* bus = nullptr;  // the bus, or neither (unity)
+        const AudioEffectChain* effects = nullptr;
+        int parent = -1;
+        std::vector<int> sources;       // indices into SourceList::sources
+        std::vector<int> children;
+        float* buffer = nullptr;        // MAX_BLOCK_FRAMES frames; master mixes into the output
+        bool tapped = false;            // a stem reads it, so a mute above doesn't silence it
+
+        AutomationCurve volumeCurve;    // the track's, copied when published
+        AutomationCurve panCurve;
+
+        // Per block (mixing thread)
+        float gain = -1.0f;             // applied at the end of the last block, <0 = none yet
+        float gainStart = 0.0f;
+        float gainEnd = 0.0f;
+        float pan = 0.0f;               // as gain
+        float panStart = 0.0f;
+        float panEnd = 0.0f;
+        bool active = false;
+        bool limited = false;           // the chain's limiter ran
+        bool pcmPlayed = false;         // a PCM source had audio this block
+        AudioClockUpdate clockUpdate;
+        AudioEffectProcessor effectState;  // carried across publishes
+    };
+
+    // Everything one publish hands to the mixing thread
+    struct SourceList {
+        std::vector<AudioMixSource> sources;
+        std::vector<MixNode> nodes;          // parents before children
+        std::vector<std::vector<int>> levels;  // node indices by depth
+        std::vector<float> buffers;
+        int queueSources = 0;                // sources read from decoders
+        std::vector<int> stemNodes;          // per stem tap, -1 = nothing feeds it
+        SourceList* nextRetired = nullptr;
+    };
+
+    // One level's worth of parallel work (mixing thread)
+    struct LevelTask {
+        AudioMixer* mixer = nullptr;
+        const std::vector<int>* nodes = nullptr;
+        float* out = nullptr;
+        int frames = 0;
+    };
+
+    static void buildGraph(SourceList& list, const std::vector<const AudioBus*>& buses,
+                           const AudioEffectChain* masterEffects);
+
+    // Adopt a newly published list, if any (audio thread)
+    void adoptPending();
+    // Mix from m_playhead on, advancing it
+    void mixFrames(float* out, int frames, AudioClockUpdate& clockUpdate);
+    // stemOffset: frames into the stem buffers that `out` starts at
+    void mixBlock(float* out, int frames, AudioClockUpdate& clockUpdate, int stemOffset = 0);
+    void writeStems(int frames, int stemOffset);
+    // Copy the block from the mixdown cache if it's current there; may
+    // shorten frames to end at a cache block boundary
+    bool readMixdown(float* out, int& frames, AudioClockUpdate& clockUpdate);
+    static void mixNodeTask(void* context, int index);
+    void mixNode(MixNode& node, float* out, int frames);
+    void renderScrub(float* out, int frames);
+    void addScrubGrain();
+
+    // A clip's own gain and pan at timeline frame `frame`
+    float clipGain(const AudioMixSource& src, int64_t frame) const;
+    float clipPan(const AudioMixSource& src, int64_t frame) const;
+
+    // Add up to `frames` samples from one source into `out`.
     // Returns number of frames actually read.
-    int readSource(AudioMixSource& src, float* buf, int frames, Clock& masterClock);
+    int readSource(AudioMixSource& src, float* out, int frames, AudioClockUpdate& clockUpdate);
+    // Add a PCM source's samples under [m_playhead, m_playhead + frames).
+    // Returns true if the clip covers any of it.
+    bool readPcmSource(AudioMixSource& src, float* out, int frames);
+    // readPcmSource() for a retimed clip, timeline frames [from, to)
+    void readStretchedPcm(AudioMixSource& src, float* out, int64_t from, int64_t to);
+
+    SourceList* m_active = nullptr;               // audio thread only
+    std::atomic<SourceList*> m_pending{nullptr};  // published, not yet adopted
+    std::atomic<SourceList*> m_retired{nullptr};  // stack of lists handed back for freeing
+    MixWorkerPool m_pool;
+    const MixdownCache* m_mixdown = nullptr;
+    std::vector<AudioStemTap> m_stems;
+    float* const* m_stemOut = nullptr;            // during fillBuffer()
+    std::atomic<uint64_t> m_renderCount{0};       // odd while inside render()
+    size_t m_publishedCount = 0;
 
-    std::vector<AudioMixSource> m_sources;
-    std::mutex m_mutex;
+    // Seek requests from the main thread, picked up by the next render()
+    std::atomic<double> m_seekRequestTime{0.0};
+    std::atomic<uint64_t> m_seekRequests{0};
+    uint64_t m_seekRequestsSeen = 0;
+    std::atomic<double> m_playheadRequestTime{0.0};
+    std::atomic<uint64_t> m_playheadRequests{0};
+    uint64_t m_playheadRequestsSeen = 0;
 
-    // Clock lock state — prevents stale audio from overwriting seek target
+    // Timeline frame of the next block's first sample (mixing thread)
+    int64_t m_playhead = 0;
+    bool m_playheadMoved = false;  // force the next PCM clock update
+
+    // Scrub state. m_scrubOut overlap-adds grains; its first
+    // m_scrubReady frames of the leading hop are still to be played.
+    std::atomic<bool> m_scrubRequested{false};
+    std::atomic<double> m_scrubTarget{0.0};
+    bool m_scrubbing = false;  // mixing thread; read-only while nodes mix
+    double m_scrubPos = 0.0;   // timeline frames
+    int m_scrubReady = 0;
+    float m_scrubOut[SCRUB_GRAIN_FRAMES * OUTPUT_CHANNELS] = {};
+    float m_scrubGrain[SCRUB_GRAIN_FRAMES * OUTPUT_CHANNELS] = {};
+
+    // Clock lock state (audio thread) — prevents stale audio from
+    // overwriting seek target. Read-only while nodes mix in parallel.
     bool m_clockLocked = false;
     double m_seekTargetTime = 0.0;
     std::chrono::steady_clock::time_point m_clockLockTime;
-
-    // Temp mixing buffer (reused across calls)
-    std::vector<float> m_tempBuf;
 };
@@ -1,15 +1,23 @@
 #include "media/AudioOutput.h"
 #include "media/AudioFrameQueue.h"
 #include "media/AudioMixer.h"
+#include "media/RtCheck.h"
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
-#include <vector>
+#include <string>
 
 extern "C" {
 #include <libavutil/frame.h>
 #include <libavutil/mathematics.h>
 }
 
+static double steadySeconds() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
 AudioOutput::~AudioOutput() {
     shutdown();
 }
@@ -17,12 +25,21 @@ AudioOutput::~AudioOutput() {
 bool AudioOutput::init(int sampleRate, int channels) {
     m_sampleRate = sampleRate;
     m_channels = 2; // Always output stereo
+    m_mixBuffer.assign(MAX_CHUNK_FRAMES * m_channels, 0.0f);
+    m_silence.assign(MAX_CHUNK_FRAMES * m_channels, 0.0f);
+    m_ring.init(m_channels);
+    if (m_mixAheadFrames.load() == 0) setMixAhead(0.030);
 
     SDL_AudioSpec spec;
     spec.freq = sampleRate;
     spec.format = SDL_AUDIO_F32;
     spec.channels = m_channels;
 
+    // Only read when the device opens
+    if (m_deviceBufferFrames > 0) {
+        SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, std::to_string(m_deviceBufferFrames).c_str());
+    }
+
     m_stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK,
                                           &spec, audioCallback, this);
     if (!m_stream) {
@@ -30,10 +47,25 @@ bool AudioOutput::init(int sampleRate, int channels) {
         return false;
     }
 
+    // The device holds one buffer (at its own rate) past what it has
+    // consumed; requests larger than that raise the estimate as they come
+    m_deviceClock.setSampleRate(sampleRate);
+    SDL_AudioSpec deviceSpec;
+    int deviceFrames = 0;
+    if (SDL_GetAudioDeviceFormat(SDL_GetAudioStreamDevice(m_stream), &deviceSpec, &deviceFrames) &&
+        deviceSpec.freq > 0) {
+        m_deviceClock.setLatency(static_cast<double>(deviceFrames) * sampleRate / deviceSpec.freq);
+    }
+    if (m_deviceBufferFrames > 0 && deviceFrames != m_deviceBufferFrames) {
+        fprintf(stderr, "Audio device buffer: asked for %d frames, got %d\n",
+                m_deviceBufferFrames, deviceFrames);
+    }
+
     return true;
 }
 
 void AudioOutput::shutdown() {
+    stopRenderThread();
     if (m_stream) {
         SDL_DestroyAudioStream(m_stream);
         m_stream = nullptr;
@@ -46,6 +78,7 @@ void AudioOutput::shutdown() {
 }
 
 void AudioOutput::start(AudioFrameQueue& frameQueue, Clock& audioClock, AVRational timeBase) {
+    stopRenderThread();
     m_frameQueue = &frameQueue;
     m_audioClock = &audioClock;
     m_timeBase = timeBase;
@@ -56,12 +89,76 @@ void AudioOutput::start(AudioFrameQueue& frameQueue, Clock& audioClock, AVRation
 }
 
 void AudioOutput::startWithMixer(AudioMixer& mixer, Clock& masterClock) {
+    stopRenderThread();
     m_mixer = &mixer;
     m_masterClock = &masterClock;
     m_mixerMode = true;
     m_frameQueue = nullptr;
     m_audioClock = nullptr;
     m_frameByteOffset = 0;
+
+    m_ring.reset();
+    m_renderRunning = true;
+    m_renderThread = std::thread(&AudioOutput::renderLoop, this);
+}
+
+void AudioOutput::stopRenderThread() {
+    {
+        std::lock_guard<std::mutex> lock(m_renderMutex);
+        m_renderRunning = false;
+    }
+    m_renderCond.notify_all();
+    if (m_renderThread.joinable()) m_renderThread.join();
+}
+
+void AudioOutput::setMixAhead(double seconds) {
+    int frames = static_cast<int>(seconds * AudioMixer::OUTPUT_SAMPLE_RATE);
+    frames = std::clamp(frames, AudioRenderRing::BLOCK_FRAMES,
+                        (AudioRenderRing::MAX_BLOCKS - 1) * AudioRenderRing::BLOCK_FRAMES);
+    m_mixAheadFrames.store(frames);
+}
+
+void AudioOutput::discardBuffered() {
+    // A block the render thread is mixing now is dropped when it sees the
+    // generation change. The callback is idle: pause() cleared the stream,
+    // which waits out a running callback, and a paused device starts no
+    // new ones.
+    std::lock_guard<std::mutex> lock(m_renderMutex);
+    m_discardGeneration++;
+    m_ring.reset();
+}
+
+void AudioOutput::renderLoop() {
+    // Best effort: raising priority can need privileges
+    SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_TIME_CRITICAL);
+
+    std::unique_lock<std::mutex> lock(m_renderMutex);
+    while (m_renderRunning) {
+        float* block = nullptr;
+        int mixAhead = m_scrubbing.load() ? AudioRenderRing::BLOCK_FRAMES : m_mixAheadFrames.load();
+        if (!m_paused.load() && m_ring.bufferedFrames() < mixAhead) {
+            block = m_ring.beginWrite();
+        }
+        if (!block) {
+            // The callback is real-time and never signals, so poll well
+            // inside one block's duration
+            m_renderCond.wait_for(lock, std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // Mix unlocked so discardBuffered() never waits on a block
+        uint64_t generation = m_discardGeneration;
+        lock.unlock();
+        AudioClockUpdate clockUpdate;
+        {
+            RtCheck::Scope realtime("audio render thread");
+            m_mixer->render(block, AudioRenderRing::BLOCK_FRAMES, clockUpdate);
+        }
+        lock.lock();
+
+        // Mixed from before a discard: the ring was reset under it
+        if (generation == m_discardGeneration) m_ring.commitWrite(clockUpdate);
+    }
 }
 
 void AudioOutput::pause() {
@@ -70,12 +167,17 @@ void AudioOutput::pause() {
         SDL_PauseAudioStreamDevice(m_stream);
         SDL_ClearAudioStream(m_stream);
     }
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_frameByteOffset = 0;
+    m_resetOffset.store(true);
+
+    // The callback is idle (see discardBuffered()) and what the device
+    // had queued is gone
+    m_framesWritten = 0;
+    m_deviceClock.reset();
 }
 
 void AudioOutput::resume() {
     m_paused.store(false);
+    m_renderCond.notify_all();  // start filling the ring before the device asks
     if (m_stream) {
         SDL_ResumeAudioStreamDevice(m_stream);
     }
@@ -85,8 +187,15 @@ double AudioOutput::getPlaybackClock() const {
     Clock* clock = m_mixerMode ? m_masterClock : m_audioClock;
     if (!clock) return 0.0;
 
+    // What the device is playing, once it has taken audio with a known
+    // timeline position
+    double seconds;
+    if (!m_paused.load() && m_deviceClock.get(steadySeconds(), seconds)) return seconds;
+
     double rawClock = clock->get();
 
+    // Mixer mode clock updates are applied as audio leaves the render ring,
+    // so only what SDL holds is still unplayed.
     // Subtract the latency of audio data buffered in SDL but not yet played.
     // Cap at 200ms — during seeks/transitions, silence fills the SDL buffer
     // and unbounded subtraction makes the clock drift far backward.
@@ -101,41 +210,73 @@ double AudioOutput::getPlaybackClock() const {
     return rawClock;
 }
 
+double AudioOutput::getLatency() const {
+    return m_sampleRate > 0 ? m_deviceClock.getLatency() / m_sampleRate : 0.0;
+}
+
 void AudioOutput::audioCallback(void* userdata, SDL_AudioStream* stream, int additionalAmount, int totalAmount) {
     auto* self = static_cast<AudioOutput*>(userdata);
-    self->fillBuffer(stream, additionalAmount);
+    RtCheck::Scope realtime("SDL audio callback");
+    self->fillBuffer(stream, additionalAmount, totalAmount);
+}
+
+void AudioOutput::putData(SDL_AudioStream* stream, const void* data, int bytes) {
+    // Part of SDL's callback contract; it takes the stream's own lock
+    RtCheck::Exempt sdl;
+    SDL_PutAudioStreamData(stream, data, bytes);
 }
 
-void AudioOutput::fillBuffer(SDL_AudioStream* stream, int additionalAmount) {
+void AudioOutput::fillBuffer(SDL_AudioStream* stream, int additionalAmount, int totalAmount) {
     if (m_paused.load()) return;
 
+    int bytesPerFrame = m_channels * sizeof(float);
+
+    // The device is about to take totalAmount; what is still queued from
+    // earlier calls it hasn't consumed yet
+    int requested = totalAmount / bytesPerFrame;
+    int64_t consumed = m_framesWritten - (totalAmount - additionalAmount) / bytesPerFrame;
+    m_deviceClock.update(consumed, steadySeconds(), requested);
+
     if (m_mixerMode) {
-        // Mixer mode: delegate to AudioMixer
+        // Mixer mode: copy out what the render thread mixed ahead
         if (!m_mixer || !m_masterClock) return;
 
-        int bytesPerFrame = m_channels * sizeof(float);
         int frames = additionalAmount / bytesPerFrame;
-        if (frames <= 0) return;
+        while (frames > 0) {
+            int chunk = std::min(frames, MAX_CHUNK_FRAMES);
+            int copied = m_ring.read(m_mixBuffer.data(), chunk, *m_masterClock);
+            if (copied < chunk) {
+                // Render thread fell behind: pad with silence
+                memset(m_mixBuffer.data() + copied * m_channels, 0,
+                       (chunk - copied) * bytesPerFrame);
+            }
+            putData(stream, m_mixBuffer.data(), chunk * bytesPerFrame);
+            m_framesWritten += chunk;
+            frames -= chunk;
+        }
 
-        std::vector<float> buf(frames * m_channels);
-        m_mixer->fillBuffer(buf.data(), frames, *m_masterClock);
-        SDL_PutAudioStreamData(stream, buf.data(), frames * bytesPerFrame);
+        double seconds;
+        if (m_ring.readHeadTime(seconds)) m_deviceClock.anchor(m_framesWritten, seconds);
+        m_deviceClock.publish();
         return;
     }
 
     // Single-source mode (legacy)
     if (!m_frameQueue || !m_audioClock) return;
 
-    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_resetOffset.exchange(false)) m_frameByteOffset = 0;
     int bytesNeeded = additionalAmount;
 
     while (bytesNeeded > 0) {
         AVFrame* frame = m_frameQueue->peek();
         if (!frame) {
             // Underrun — push silence
-            std::vector<uint8_t> silence(bytesNeeded, 0);
-            SDL_PutAudioStreamData(stream, silence.data(), bytesNeeded);
-            return;
+            while (bytesNeeded > 0) {
+                int chunk = std::min(bytesNeeded, MAX_CHUNK_FRAMES * bytesPerFrame);
+                putData(stream, m_silence.data(), chunk);
+                bytesNeeded -= chunk;
+            }
+            break;
         }
 
         int frameBytes = frame->nb_samples * m_channels * sizeof(float);
@@ -145,17 +286,20 @@ void AudioOutput::fillBuffer(SDL_AudioStream* stream, int additionalAmount) {
         if (frame->pts != AV_NOPTS_VALUE && m_frameByteOffset == 0) {
             double pts = frame->pts * av_q2d(m_timeBase);
             m_audioClock->set(pts);
+            m_deviceClock.anchor(m_framesWritten + (additionalAmount - bytesNeeded) / bytesPerFrame, pts);
         }
 
         if (remaining <= bytesNeeded) {
-            SDL_PutAudioStreamData(stream, frame->data[0] + m_frameByteOffset, remaining);
+            putData(stream, frame->data[0] + m_frameByteOffset, remaining);
             bytesNeeded -= remaining;
             m_frameByteOffset = 0;
             m_frameQueue->pop();
         } else {
-            SDL_PutAudioStreamData(stream, frame->data[0] + m_frameByteOffset, bytesNeeded);
+            putData(stream, frame->data[0] + m_frameByteOffset, bytesNeeded);
             m_frameByteOffset += bytesNeeded;
             bytesNeeded = 0;
         }
     }
+    m_framesWritten += additionalAmount / bytesPerFrame;
+    m_deviceClock.publish();
 }
@@ -2,9 +2,14 @@
 
 #include <SDL3/SDL.h>
 #include "media/Clock.h"
-#include <mutex>
+#include "media/AudioRenderRing.h"
+#include "media/AudioDeviceClock.h"
 #include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 extern "C" {
 #include <libavutil/rational.h>
@@ -13,10 +18,26 @@ extern "C" {
 class AudioFrameQueue;
 class AudioMixer;
 
+// Plays audio through an SDL audio stream. The stream's callback runs on
+// SDL's audio thread and is real-time: it never allocates or locks (see
+// RtCheck), working out of buffers sized in init().
+//
+// In mixer mode the mixing happens on a separate high-priority render
+// thread that keeps a set amount of audio (the mix-ahead) in an
+// AudioRenderRing; the callback only copies out of it. A slow block then
+// eats into the mix-ahead instead of causing a dropout.
+//
+// The playback clock comes from an AudioDeviceClock: frames the device has
+// consumed, less its latency, mapped back onto the timeline. A smaller
+// device buffer (setDeviceBufferFrames) shortens that latency.
 class AudioOutput {
 public:
     ~AudioOutput();
 
+    // Frames per device buffer, before init(). 0 leaves it to SDL; small
+    // values (128-256) give low latency where the device allows it.
+    void setDeviceBufferFrames(int frames) { m_deviceBufferFrames = frames; }
+
     bool init(int sampleRate, int channels);
     void shutdown();
 
@@ -29,13 +50,29 @@ public:
     void pause();
     void resume();
 
+    // Audio the render thread keeps mixed ahead of the callback (clamped to
+    // the ring). Default 30 ms.
+    void setMixAhead(double seconds);
+
+    // While scrubbing the render thread keeps a single block ahead, so
+    // grains reach the device a few milliseconds after the drag moves
+    void setScrubbing(bool scrubbing) { m_scrubbing.store(scrubbing); }
+
+    // Drop audio mixed ahead (after a seek). Only while paused.
+    void discardBuffered();
+
     double getPlaybackClock() const;
+    // Seconds between audio reaching the device and being heard
+    double getLatency() const;
     int getSampleRate() const { return m_sampleRate; }
     int getChannels() const { return m_channels; }
 
 private:
     static void audioCallback(void* userdata, SDL_AudioStream* stream, int additionalAmount, int totalAmount);
-    void fillBuffer(SDL_AudioStream* stream, int additionalAmount);
+    void fillBuffer(SDL_AudioStream* stream, int additionalAmount, int totalAmount);
+    static void putData(SDL_AudioStream* stream, const void* data, int bytes);
+    void renderLoop();
+    void stopRenderThread();
 
     SDL_AudioStream* m_stream = nullptr;
 
@@ -49,10 +86,29 @@ private:
     Clock* m_masterClock = nullptr;
     bool m_mixerMode = false;
 
+    // Mixer mode render thread
+    AudioRenderRing m_ring;
+    std::thread m_renderThread;
+    std::mutex m_renderMutex;  // guards the ring's producer side; not held while mixing
+    std::condition_variable m_renderCond;
+    bool m_renderRunning = false;
+    uint64_t m_discardGeneration = 0;  // bumped by discardBuffered()
+    std::atomic<int> m_mixAheadFrames{0};
+    std::atomic<bool> m_scrubbing{false};
+
     int m_sampleRate = 0;
     int m_channels = 2;
     std::atomic<bool> m_paused{true};
 
-    int m_frameByteOffset = 0;
-    std::mutex m_mutex;
+    int m_deviceBufferFrames = 0;
+    AudioDeviceClock m_deviceClock;
+    int64_t m_framesWritten = 0;  // audio thread: frames put since the stream was cleared
+
+    // Mix and silence buffers, allocated once; larger requests are chunked
+    static constexpr int MAX_CHUNK_FRAMES = 4096;
+    std::vector<float> m_mixBuffer;
+    std::vector<float> m_silence;
+
+    int m_frameByteOffset = 0;               // audio thread
+    std::atomic<bool> m_resetOffset{false};  // set by pause(), applied by the callback
 };
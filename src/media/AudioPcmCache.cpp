@@ -0,0 +1,395 @@
+#include "media/AudioPcmCache.h"
+#include "media/MediaCache.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswresample/swresample.h>
+}
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// .pcm file: this header, then frames * CHANNELS floats. 64 bytes keeps the
+// samples 16-byte aligned in the mapping.
+struct PcmFileHeader {
+    char magic[8];
+    uint32_t sampleRate;
+    uint32_t channels;
+    int64_t frames;
+    double startTime;
+    uint8_t reserved[32];
+};
+static_assert(sizeof(PcmFileHeader) == 64, "PCM header layout");
+
+constexpr char PCM_MAGIC[8] = {'V', 'E', 'P', 'C', 'M', '0', '1', '\0'};
+
+// Leftover .tmp files older than this are from a decode that never finished
+constexpr auto ABANDONED_TMP_AGE = std::chrono::hours(1);
+
+// Whether the media a cache file was decoded from is gone or has changed
+// since. Files without a readable .src are left to the size budget.
+bool isStale(const fs::path& pcmFile) {
+    fs::path src = pcmFile;
+    src.replace_extension(".src");
+    std::ifstream in(src);
+    std::string mediaPath;
+    if (!in || !std::getline(in, mediaPath) || mediaPath.empty()) return false;
+    return mediaCacheKey(mediaPath) != pcmFile.stem().string();
+}
+
+} // namespace
+
+PcmBuffer::~PcmBuffer() {
+    if (m_map) munmap(m_map, m_mapSize);
+}
+
+std::shared_ptr<PcmBuffer> PcmBuffer::map(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(PcmFileHeader))) {
+        close(fd);
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return nullptr;
+
+    std::shared_ptr<PcmBuffer> buffer(new PcmBuffer());
+    buffer->m_map = mapped;
+    buffer->m_mapSize = size;
+
+    PcmFileHeader header;
+    memcpy(&header, mapped, sizeof(header));
+    size_t frameBytes = CHANNELS * sizeof(float);
+    if (memcmp(header.magic, PCM_MAGIC, sizeof(PCM_MAGIC)) != 0 ||
+        header.sampleRate != SAMPLE_RATE || header.channels != CHANNELS || header.frames < 0 ||
+        static_cast<size_t>(header.frames) != (size - sizeof(header)) / frameBytes) {
+        fprintf(stderr, "PcmBuffer: %s is not a valid PCM cache file\n", path.c_str());
+        return nullptr;
+    }
+
+    buffer->m_samples = reinterpret_cast<const float*>(static_cast<const uint8_t*>(mapped) + sizeof(header));
+    buffer->m_frames = header.frames;
+    buffer->m_startTime = header.startTime;
+    return buffer;
+}
+
+void PcmBuffer::prefetch(double sourceTime, double seconds) const {
+    int64_t first = static_cast<int64_t>((sourceTime - m_startTime) * SAMPLE_RATE);
+    int64_t last = first + static_cast<int64_t>(seconds * SAMPLE_RATE);
+    first = std::clamp<int64_t>(first, 0, m_frames);
+    last = std::clamp<int64_t>(last, 0, m_frames);
+    if (last <= first) return;
+
+    // madvise wants a page-aligned start
+    static const uintptr_t pageMask = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE)) - 1;
+    auto begin = reinterpret_cast<uintptr_t>(m_samples + first * CHANNELS) & ~pageMask;
+    auto end = reinterpret_cast<uintptr_t>(m_samples + last * CHANNELS);
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+}
+
+AudioPcmCache::~AudioPcmCache() {
+    shutdown();
+}
+
+void AudioPcmCache::start(const std::string& cacheDir) {
+    shutdown();
+    m_abort.store(false);
+    m_cacheDir = cacheDir.empty() ? mediaCacheDir("audio") : cacheDir;
+    m_worker = std::thread(&AudioPcmCache::workerLoop, this);
+}
+
+void AudioPcmCache::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_abort.store(true);
+        // Undecoded assets may be requested again after a restart
+        for (const auto& job : m_jobs) m_requested.erase(job.assetId);
+        m_jobs.clear();
+    }
+    m_cond.notify_all();
+    if (m_worker.joinable()) m_worker.join();
+}
+
+std::shared_ptr<const PcmBuffer> AudioPcmCache::get(uint32_t assetId, const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_ready.find(assetId);
+        if (it != m_ready.end()) return it->second;
+        if (!m_worker.joinable() || !m_requested.insert(assetId).second) return nullptr;
+        m_jobs.push_back({assetId, path});
+    }
+    m_cond.notify_one();
+    return nullptr;
+}
+
+std::shared_ptr<const PcmBuffer> AudioPcmCache::find(uint32_t assetId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_ready.find(assetId);
+    return it != m_ready.end() ? it->second : nullptr;
+}
+
+void AudioPcmCache::setPaused(bool paused) {
+    if (m_paused.exchange(paused) && !paused) {
+        m_cond.notify_all();
+    }
+}
+
+bool AudioPcmCache::waitWhilePaused() {
+    if (!m_paused.load()) return !m_abort.load();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait(lock, [this] { return m_abort.load() || !m_paused.load(); });
+    return !m_abort.load();
+}
+
+void AudioPcmCache::workerLoop() {
+    if (!m_cacheDir.empty()) trimCache(true);
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this] {
+                return m_abort.load() || (!m_paused.load() && !m_jobs.empty());
+            });
+            if (m_abort.load()) return;
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        // Mapping needs a file, so without a cache directory playback just
+        // keeps decoding
+        std::string key = m_cacheDir.empty() ? std::string() : mediaCacheKey(job.path);
+        std::shared_ptr<PcmBuffer> buffer;
+        if (!key.empty()) {
+            std::string file = m_cacheDir + "/" + key + ".pcm";
+            std::error_code ec;
+            bool decoded = false;
+            buffer = PcmBuffer::map(file);
+            if (buffer) {
+                // Marks it recently used for trimCache()
+                fs::last_write_time(file, fs::file_time_type::clock::now(), ec);
+            } else {
+                // Write then rename, so a half-written file is never mapped
+                fs::create_directories(m_cacheDir, ec);
+                std::string tmp = file + ".tmp";
+                if (!ec && decodeToFile(job.path, tmp)) {
+                    std::ofstream(m_cacheDir + "/" + key + ".src") << job.path << '\n';
+                    fs::rename(tmp, file, ec);
+                    if (!ec) buffer = PcmBuffer::map(file);
+                    decoded = buffer != nullptr;
+                } else {
+                    fs::remove(tmp, ec);
+                }
+            }
+            if (buffer) m_mappedKeys.insert(key);
+            // A new file may take the directory over budget
+            if (decoded) trimCache(false);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_abort.load()) {
+            // Possibly cut short; let a restarted cache decode it again
+            m_requested.erase(job.assetId);
+            return;
+        }
+        // A failed asset stays requested, so it isn't retried every frame
+        if (buffer) {
+            m_ready[job.assetId] = std::move(buffer);
+            m_readyCount++;
+        }
+    }
+}
+
+void AudioPcmCache::trimCache(bool dropStale) {
+    struct Entry {
+        fs::path file;
+        fs::file_time_type lastUsed;
+        uintmax_t size = 0;
+    };
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+    auto now = fs::file_time_type::clock::now();
+
+    auto removeEntry = [](const fs::path& pcm) {
+        std::error_code ec;
+        fs::path src = pcm;
+        src.replace_extension(".src");
+        fs::remove(pcm, ec);
+        fs::remove(src, ec);
+    };
+
+    std::error_code ec;
+    for (fs::directory_iterator it(m_cacheDir, ec), end; !ec && it != end; it.increment(ec)) {
+        const fs::path& path = it->path();
+        std::error_code statEc;
+        auto lastUsed = fs::last_write_time(path, statEc);
+        if (statEc) continue;
+
+        if (path.extension() == ".tmp") {
+            if (dropStale && now - lastUsed > ABANDONED_TMP_AGE) fs::remove(path, statEc);
+            continue;
+        }
+        if (path.extension() != ".pcm") continue;
+
+        bool inUse = m_mappedKeys.count(path.stem().string()) > 0;
+        if (dropStale && !inUse && isStale(path)) {
+            removeEntry(path);
+            continue;
+        }
+        uintmax_t size = fs::file_size(path, statEc);
+        if (statEc) continue;
+        total += size;
+        if (!inUse) entries.push_back({path, lastUsed, size});
+    }
+
+    // Least recently used first
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.lastUsed < b.lastUsed; });
+    for (const Entry& entry : entries) {
+        if (total <= m_budget) break;
+        removeEntry(entry.file);
+        total -= entry.size;
+    }
+    if (total > m_budget) {
+        fprintf(stderr, "AudioPcmCache: %.1f GB in use exceeds the %.1f GB budget\n",
+                total / 1e9, m_budget / 1e9);
+    }
+}
+
+bool AudioPcmCache::decodeToFile(const std::string& mediaPath, const std::string& file) {
+    AVFormatContext* fmt = nullptr;
+    AVCodecContext* codec = nullptr;
+    SwrContext* swr = nullptr;
+    AVPacket* pkt = nullptr;
+    AVFrame* frame = nullptr;
+    FILE* out = nullptr;
+
+    auto cleanup = [&]() {
+        if (out) fclose(out);
+        if (frame) av_frame_free(&frame);
+        if (pkt) av_packet_free(&pkt);
+        if (swr) swr_free(&swr);
+        if (codec) avcodec_free_context(&codec);
+        if (fmt) avformat_close_input(&fmt);
+    };
+
+    if (avformat_open_input(&fmt, mediaPath.c_str(), nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(fmt, nullptr) < 0) {
+        fprintf(stderr, "AudioPcmCache: cannot open %s\n", mediaPath.c_str());
+        cleanup();
+        return false;
+    }
+
+    int stream = av_find_best_stream(fmt, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    const AVCodec* dec = stream >= 0 ? avcodec_find_decoder(fmt->streams[stream]->codecpar->codec_id) : nullptr;
+    if (!dec) {
+        cleanup();
+        return false;
+    }
+    for (unsigned i = 0; i < fmt->nb_streams; i++) {
+        if (static_cast<int>(i) != stream) fmt->streams[i]->discard = AVDISCARD_ALL;
+    }
+    AVRational timeBase = fmt->streams[stream]->time_base;
+
+    // Same conversion as AudioDecoder, so cached and decoded playback match
+    codec = avcodec_alloc_context3(dec);
+    avcodec_parameters_to_context(codec, fmt->streams[stream]->codecpar);
+    AVChannelLayout stereo = AV_CHANNEL_LAYOUT_STEREO;
+    if (avcodec_open2(codec, dec, nullptr) < 0 ||
+        swr_alloc_set_opts2(&swr, &stereo, AV_SAMPLE_FMT_FLT, PcmBuffer::SAMPLE_RATE,
+                            &codec->ch_layout, codec->sample_fmt, codec->sample_rate,
+                            0, nullptr) < 0 ||
+        swr_init(swr) < 0) {
+        fprintf(stderr, "AudioPcmCache: cannot decode audio from %s\n", mediaPath.c_str());
+        cleanup();
+        return false;
+    }
+
+    out = fopen(file.c_str(), "wb");
+    if (!out) {
+        fprintf(stderr, "AudioPcmCache: cannot write %s\n", file.c_str());
+        cleanup();
+        return false;
+    }
+
+    PcmFileHeader header{};
+    memcpy(header.magic, PCM_MAGIC, sizeof(PCM_MAGIC));
+    header.sampleRate = PcmBuffer::SAMPLE_RATE;
+    header.channels = PcmBuffer::CHANNELS;
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    bool haveStart = false;
+
+    pkt = av_packet_alloc();
+    frame = av_frame_alloc();
+    std::vector<float> converted;
+
+    auto write = [&](int frames) {
+        if (frames <= 0) return;
+        ok = ok && fwrite(converted.data(), sizeof(float) * PcmBuffer::CHANNELS, frames, out) ==
+                       static_cast<size_t>(frames);
+        header.frames += frames;
+    };
+
+    auto drainDecoder = [&]() {
+        while (avcodec_receive_frame(codec, frame) == 0) {
+            if (!haveStart) {
+                int64_t pts = frame->pts != AV_NOPTS_VALUE ? frame->pts : frame->best_effort_timestamp;
+                header.startTime = pts != AV_NOPTS_VALUE ? pts * av_q2d(timeBase) : 0.0;
+                haveStart = true;
+            }
+            int capacity = swr_get_out_samples(swr, frame->nb_samples);
+            if (converted.size() < static_cast<size_t>(capacity) * PcmBuffer::CHANNELS) {
+                converted.resize(static_cast<size_t>(capacity) * PcmBuffer::CHANNELS);
+            }
+            uint8_t* dst = reinterpret_cast<uint8_t*>(converted.data());
+            write(swr_convert(swr, &dst, capacity,
+                              const_cast<const uint8_t**>(frame->extended_data), frame->nb_samples));
+            av_frame_unref(frame);
+        }
+    };
+
+    while (ok && waitWhilePaused() && av_read_frame(fmt, pkt) >= 0) {
+        if (pkt->stream_index == stream && avcodec_send_packet(codec, pkt) >= 0) {
+            drainDecoder();
+        }
+        av_packet_unref(pkt);
+    }
+
+    if (ok && !m_abort.load()) {
+        avcodec_send_packet(codec, nullptr);
+        drainDecoder();
+        int capacity = swr_get_out_samples(swr, 0);
+        if (capacity > 0) {
+            converted.resize(std::max(converted.size(), static_cast<size_t>(capacity) * PcmBuffer::CHANNELS));
+            uint8_t* dst = reinterpret_cast<uint8_t*>(converted.data());
+            write(swr_convert(swr, &dst, capacity, nullptr, 0));
+        }
+
+        // Frame count last: a file cut short never validates
+        ok = ok && fseek(out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, out) == 1;
+    } else {
+        ok = false;
+    }
+
+    ok = fclose(out) == 0 && ok;
+    out = nullptr;
+    cleanup();
+    return ok;
+}
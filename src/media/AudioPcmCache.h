@@ -0,0 +1,117 @@
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// One asset's audio, decoded to interleaved 48 kHz stereo float and
+// memory-mapped read-only from its cache file. Frame 0 plays at source time
+// getStartTime() (the first decoded frame's timestamp), so any source time
+// maps to a frame index with one multiply.
+class PcmBuffer {
+public:
+    static constexpr int SAMPLE_RATE = 48000;
+    static constexpr int CHANNELS = 2;
+
+    ~PcmBuffer();
+
+    // Map a cache file; null if it's missing or not a complete PCM file
+    static std::shared_ptr<PcmBuffer> map(const std::string& path);
+
+    const float* getSamples() const { return m_samples; }
+    int64_t getFrameCount() const { return m_frames; }
+    double getStartTime() const { return m_startTime; }
+
+    // Ask the kernel to start reading [sourceTime, sourceTime + seconds)
+    // so the mixer doesn't take the page faults. Non-blocking.
+    void prefetch(double sourceTime, double seconds) const;
+
+private:
+    PcmBuffer() = default;
+
+    void* m_map = nullptr;
+    size_t m_mapSize = 0;
+    const float* m_samples = nullptr;
+    int64_t m_frames = 0;
+    double m_startTime = 0.0;
+};
+
+// Decodes audio assets to PcmBuffers on a background thread.
+//
+// Each asset is decoded once into a .pcm file in the media cache (written
+// then renamed, like the peak files); later sessions just map that file.
+// Once an asset's buffer is ready, playback reads sample ranges straight
+// out of it instead of running a decoder, which makes audio seeks and clip
+// activations instant and sample-accurate.
+//
+// The files are large (about 1.4 GB per hour), so the directory is kept
+// within a size budget: each file's modification time records its last use,
+// and the least recently used go first. Files whose media is gone or has
+// changed since (a .src file beside each names its media) are deleted
+// whenever the cache starts.
+class AudioPcmCache {
+public:
+    static constexpr uint64_t DEFAULT_BUDGET = 8ull << 30;
+
+    ~AudioPcmCache();
+
+    // Disk space for cache files, before start()
+    void setBudget(uint64_t bytes) { m_budget = bytes; }
+
+    // cacheDir empty = the "audio" media cache directory
+    void start(const std::string& cacheDir = "");
+
+    // Stops the worker. Buffers already handed out stay mapped until the
+    // cache is destroyed.
+    void shutdown();
+
+    // An asset's decoded audio, or null while it's being decoded (the first
+    // call queues it). Main thread, non-blocking. The buffer lives as long
+    // as the cache.
+    std::shared_ptr<const PcmBuffer> get(uint32_t assetId, const std::string& path);
+
+    // Like get(), but never queues a decode
+    std::shared_ptr<const PcmBuffer> find(uint32_t assetId);
+
+    // Buffers decoded so far; goes up whenever find() may return more
+    uint64_t getReadyCount() const { return m_readyCount.load(); }
+
+    // While paused, the worker stops between packets
+    void setPaused(bool paused);
+
+private:
+    struct Job {
+        uint32_t assetId = 0;
+        std::string path;
+    };
+
+    void workerLoop();
+    bool decodeToFile(const std::string& mediaPath, const std::string& file);
+    // Drop files for missing media and the least recently used beyond the
+    // budget, never one mapped this session (worker thread)
+    void trimCache(bool dropStale);
+    bool waitWhilePaused();  // false once aborted
+
+    std::string m_cacheDir;
+    uint64_t m_budget = DEFAULT_BUDGET;
+    std::unordered_set<std::string> m_mappedKeys;  // worker: cache files in use
+    std::thread m_worker;
+
+    std::deque<Job> m_jobs;
+    std::unordered_set<uint32_t> m_requested;  // queued, decoding, done or failed
+    std::unordered_map<uint32_t, std::shared_ptr<const PcmBuffer>> m_ready;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    std::atomic<uint64_t> m_readyCount{0};
+    std::atomic<bool> m_paused{false};
+    std::atomic<bool> m_abort{false};
+};
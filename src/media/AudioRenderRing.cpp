@@ -0,0 +1,76 @@
+#include "media/AudioRenderRing.h"
+#include <algorithm>
+#include <cstring>
+
+void AudioRenderRing::init(int channels) {
+    m_channels = channels;
+    m_samples.assign(static_cast<size_t>(MAX_BLOCKS) * BLOCK_FRAMES * channels, 0.0f);
+    reset();
+}
+
+float* AudioRenderRing::beginWrite() {
+    uint64_t write = m_writeFrames.load(std::memory_order_relaxed);
+    uint64_t read = m_readFrames.load(std::memory_order_acquire);
+    if (write - read > static_cast<uint64_t>((MAX_BLOCKS - 1) * BLOCK_FRAMES)) return nullptr;
+
+    size_t block = (write / BLOCK_FRAMES) % MAX_BLOCKS;
+    return m_samples.data() + block * BLOCK_FRAMES * m_channels;
+}
+
+void AudioRenderRing::commitWrite(const AudioClockUpdate& clockUpdate) {
+    uint64_t write = m_writeFrames.load(std::memory_order_relaxed);
+    m_clockUpdates[(write / BLOCK_FRAMES) % MAX_BLOCKS] = clockUpdate;
+    m_writeFrames.store(write + BLOCK_FRAMES, std::memory_order_release);
+}
+
+int AudioRenderRing::read(float* out, int frames, Clock& clock) {
+    uint64_t read = m_readFrames.load(std::memory_order_relaxed);
+    uint64_t write = m_writeFrames.load(std::memory_order_acquire);
+    bool clockChanged = false;
+    int copied = 0;
+
+    while (copied < frames && read < write) {
+        size_t block = (read / BLOCK_FRAMES) % MAX_BLOCKS;
+        int offset = static_cast<int>(read % BLOCK_FRAMES);
+
+        if (offset == 0 && m_clockUpdates[block].valid) {
+            m_clock = m_clockUpdates[block];
+            m_framesSinceClock = 0;
+            clockChanged = true;
+        }
+
+        int n = std::min(frames - copied, BLOCK_FRAMES - offset);
+        memcpy(out + static_cast<size_t>(copied) * m_channels,
+               m_samples.data() + (block * BLOCK_FRAMES + offset) * m_channels,
+               static_cast<size_t>(n) * m_channels * sizeof(float));
+        copied += n;
+        read += n;
+        m_framesSinceClock += n;
+    }
+    m_readFrames.store(read, std::memory_order_release);
+
+    // As of the end of what was just handed to the device
+    if (clockChanged) {
+        m_clock.apply(clock, static_cast<double>(m_framesSinceClock) / AudioMixer::OUTPUT_SAMPLE_RATE);
+    }
+    return copied;
+}
+
+bool AudioRenderRing::readHeadTime(double& seconds) const {
+    if (!m_clock.valid) return false;
+    seconds = m_clock.blockStart + static_cast<double>(m_framesSinceClock) / AudioMixer::OUTPUT_SAMPLE_RATE;
+    return true;
+}
+
+int AudioRenderRing::bufferedFrames() const {
+    uint64_t write = m_writeFrames.load(std::memory_order_acquire);
+    uint64_t read = m_readFrames.load(std::memory_order_acquire);
+    return static_cast<int>(write - read);
+}
+
+void AudioRenderRing::reset() {
+    m_writeFrames.store(0);
+    m_readFrames.store(0);
+    m_clock = {};
+    m_framesSinceClock = 0;
+}
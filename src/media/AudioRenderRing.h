@@ -0,0 +1,54 @@
+#pragma once
+
+#include "media/AudioMixer.h"
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+// Single-producer/single-consumer ring of mixed audio blocks, between
+// AudioOutput's render thread and the SDL audio callback. Both sides only
+// touch atomics.
+//
+// Each block carries the clock update it was mixed with, and the consumer
+// applies it as the block is played. The master clock therefore follows
+// what leaves the ring, however far ahead the producer is.
+class AudioRenderRing {
+public:
+    static constexpr int BLOCK_FRAMES = 256;  // 5.3 ms at 48 kHz
+    static constexpr int MAX_BLOCKS = 32;     // 170 ms
+
+    void init(int channels);
+
+    // Producer: block to mix into (BLOCK_FRAMES frames), null while full.
+    // commitWrite() publishes it.
+    float* beginWrite();
+    void commitWrite(const AudioClockUpdate& clockUpdate);
+
+    // Consumer: copy up to `frames` frames out, applying the clock updates
+    // of the blocks played. Returns the frame count copied.
+    int read(float* out, int frames, Clock& clock);
+
+    // Consumer: timeline seconds at the read head, once a block with a
+    // clock update has been read since the last reset()
+    bool readHeadTime(double& seconds) const;
+
+    // Frames written but not yet read
+    int bufferedFrames() const;
+
+    // Drop everything. The consumer must be idle, and a block the producer
+    // got from beginWrite() before the reset must not be committed.
+    void reset();
+
+private:
+    int m_channels = 2;
+    std::vector<float> m_samples;  // MAX_BLOCKS blocks
+    AudioClockUpdate m_clockUpdates[MAX_BLOCKS];
+
+    // Free-running frame counters; the writer advances a block at a time
+    std::atomic<uint64_t> m_writeFrames{0};
+    std::atomic<uint64_t> m_readFrames{0};
+
+    // Consumer: last clock update seen and frames played since its block began
+    AudioClockUpdate m_clock;
+    int64_t m_framesSinceClock = 0;
+};
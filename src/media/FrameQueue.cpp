@@ -10,18 +10,39 @@ extern "C" {
 FrameQueue::FrameQueue() = default;
 
 FrameQueue::~FrameQueue() {
+    freeSlots();
+}
+
+void FrameQueue::freeSlots() {
     for (auto& s : m_ring) {
-        av_free(s.data);
+        if (m_allocator) {
+            if (s.block.data) m_allocator->free(s.block);
+        } else {
+            av_free(s.data);
+        }
+        s.block = {};
+        s.data = nullptr;
     }
 }
 
-bool FrameQueue::allocate(int width, int height) {
+bool FrameQueue::allocate(int width, int height, FrameSlotAllocator* allocator,
+                          AVPixelFormat format) {
+    freeSlots();
+    m_allocator = allocator;
     m_width = width;
     m_height = height;
-    int linesize = width * 4; // RGBA, packed
+    m_readIdx = m_writeIdx = m_count = m_held = 0;
+    // For planar formats, linesize is the first plane's; the decoder derives
+    // the rest with av_image_fill_arrays(..., align=1).
+    int linesize = (format == AV_PIX_FMT_RGBA) ? width * 4 : width;
+    size_t bytes = av_image_get_buffer_size(format, width, height, 1);
     for (auto& s : m_ring) {
-        av_free(s.data);
-        s.data = (uint8_t*)av_malloc(linesize * height);
+        if (m_allocator) {
+            s.block = m_allocator->allocate(bytes);
+            s.data = s.block.data;
+        } else {
+            s.data = (uint8_t*)av_malloc(bytes);
+        }
         if (!s.data) return false;
         s.linesize = linesize;
         s.pts = 0;
@@ -32,7 +53,7 @@ bool FrameQueue::allocate(int width, int height) {
 
 uint8_t* FrameQueue::getWriteBuffer(int& linesize) {
     std::unique_lock<std::mutex> lock(m_mutex);
-    m_condWrite.wait(lock, [this] { return m_count < CAPACITY || m_abort.load(); });
+    m_condWrite.wait(lock, [this] { return m_count + m_held < CAPACITY || m_abort.load(); });
     if (m_abort.load()) { linesize = 0; return nullptr; }
     linesize = m_ring[m_writeIdx].linesize;
     return m_ring[m_writeIdx].data;
@@ -55,6 +76,12 @@ const uint8_t* FrameQueue::peek(int64_t* outPts, int* outLinesize) {
     return m_ring[m_readIdx].data;
 }
 
+void* FrameQueue::peekHandle() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_count == 0) return nullptr;
+    return m_ring[m_readIdx].block.handle;
+}
+
 void FrameQueue::pop() {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_count == 0) return;
@@ -63,10 +90,30 @@ void FrameQueue::pop() {
     m_condWrite.notify_one();
 }
 
+void FrameQueue::popHeld() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_count == 0) return;
+    m_readIdx = (m_readIdx + 1) % CAPACITY;
+    m_count--;
+    m_held++;
+}
+
+void FrameQueue::releaseHeld() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_held == 0) return;
+    m_held--;
+    m_condWrite.notify_one();
+}
+
+int FrameQueue::heldCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_held;
+}
+
 void FrameQueue::flush() {
     std::lock_guard<std::mutex> lock(m_mutex);
-    m_readIdx = 0;
-    m_writeIdx = 0;
+    // Held slots sit just behind the read index and must survive the flush
+    m_writeIdx = m_readIdx;
     m_count = 0;
     m_condWrite.notify_all();
 }
@@ -9,9 +9,29 @@ extern "C" {
 #include <libavutil/frame.h>
 }
 
+// Backing storage for FrameQueue slots. The default is av_malloc; the
+// renderer supplies one backed by persistently mapped GPU staging buffers
+// so the decoder's sws_scale output is what the GPU copies from.
+class FrameSlotAllocator {
+public:
+    struct Block {
+        uint8_t* data = nullptr;
+        void* handle = nullptr;     // allocator-specific (e.g. VkBuffer record)
+    };
+
+    virtual ~FrameSlotAllocator() = default;
+    virtual Block allocate(size_t bytes) = 0;
+    virtual void free(Block& block) = 0;
+};
+
 // Ring buffer of decoded video frames with pre-allocated RGBA storage.
 // The decoder writes directly into the next slot's buffer via getWriteBuffer(),
 // then commits with push(). The consumer peeks/pops from the read side.
+//
+// A consumer that hands slot memory to the GPU uses popHeld() instead of
+// pop(): the slot leaves the queue but isn't reused by the decoder until
+// releaseHeld() is called once the GPU copy has completed. Held slots are
+// always released in the order they were popped.
 class FrameQueue {
 public:
     static constexpr int CAPACITY = 16;
@@ -19,12 +39,15 @@ public:
     FrameQueue();
     ~FrameQueue();
 
-    // Allocate RGBA storage for all slots. Call once after knowing frame dimensions.
-    bool allocate(int width, int height);
+    // Allocate storage for all slots. Call once after knowing frame dimensions.
+    // format is RGBA or a planar YUV layout packed with align=1.
+    // allocator may be null for plain heap memory; it must outlive the queue.
+    bool allocate(int width, int height, FrameSlotAllocator* allocator = nullptr,
+                  AVPixelFormat format = AV_PIX_FMT_RGBA);
 
     // --- Producer (decoder thread) ---
 
-    // Get a pointer to the next writable slot's RGBA buffer.
+    // Get a pointer to the next writable slot's buffer (RGBA or packed planes).
     // Blocks until a slot is free. Returns nullptr if aborted.
     uint8_t* getWriteBuffer(int& linesize);
 
@@ -37,8 +60,16 @@ public:
     // Sets outPts/outLinesize if non-null.
     const uint8_t* peek(int64_t* outPts = nullptr, int* outLinesize = nullptr);
 
+    // Allocator handle of the front slot (see FrameSlotAllocator::Block)
+    void* peekHandle() const;
+
     void pop();
 
+    // Pop the front slot but keep its memory reserved until releaseHeld()
+    void popHeld();
+    void releaseHeld();
+    int heldCount() const;
+
     // --- Control ---
     void flush();
     void abort();
@@ -48,7 +79,10 @@ public:
     bool empty() const;
 
 private:
+    void freeSlots();
+
     struct Slot {
+        FrameSlotAllocator::Block block;
         uint8_t* data = nullptr;
         int linesize = 0;
         int64_t pts = 0;
@@ -59,9 +93,11 @@ private:
     int m_readIdx = 0;
     int m_writeIdx = 0;
     int m_count = 0;
+    int m_held = 0;             // popped slots still in use by the consumer
     int m_width = 0;
     int m_height = 0;
     mutable std::mutex m_mutex;
+    FrameSlotAllocator* m_allocator = nullptr;
     std::condition_variable m_condRead;
     std::condition_variable m_condWrite;
     std::atomic<bool> m_abort{false};
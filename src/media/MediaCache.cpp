@@ -0,0 +1,29 @@
+#include "media/MediaCache.h"
+#include <filesystem>
+#include <functional>
+#include <cstdio>
+#include <cstdlib>
+
+namespace fs = std::filesystem;
+
+std::string mediaCacheDir(const char* kind) {
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+    if (xdg && *xdg) return std::string(xdg) + "/video-editor/" + kind;
+    if (home && *home) return std::string(home) + "/.cache/video-editor/" + kind;
+    return {};
+}
+
+std::string mediaCacheKey(const std::string& mediaPath) {
+    std::error_code ec;
+    auto size = fs::file_size(mediaPath, ec);
+    if (ec) return {};
+    auto mtime = fs::last_write_time(mediaPath, ec);
+    if (ec) return {};
+
+    std::string id = mediaPath + '|' + std::to_string(size) + '|' +
+                     std::to_string(mtime.time_since_epoch().count());
+    char key[32];
+    snprintf(key, sizeof(key), "%016zx", std::hash<std::string>{}(id));
+    return key;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+// Data derived from media files (thumbnails, waveform peaks) is cached under
+// $XDG_CACHE_HOME/video-editor/<kind>, or ~/.cache/video-editor/<kind>.
+// Returns an empty string if neither variable is set.
+std::string mediaCacheDir(const char* kind);
+
+// Stable name for one version of a media file: a hash of its path, size and
+// modification time, so a file edited in place gets fresh cache entries.
+// Empty if the file can't be stat'd.
+std::string mediaCacheKey(const std::string& mediaPath);
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Inner loops of the audio mixer, specialized at compile time on the channel
+// count of the interleaved float buffers (1 = mono, 2 = stereo, 6 = 5.1).
+namespace MixKernels {
+
+// out[f*C + c] += in[f*C + c] * (gain + gainStep * f) for f in [0, frames).
+// Stepping the gain per frame across a block is what keeps volume changes
+// from clicking. The SIMD path handles 4 frames (C vectors) per iteration:
+// lane l of vector v belongs to frame (4v + l) / C, so each vector keeps its
+// own gains and they all advance by 4 * gainStep.
+template <int Channels>
+inline void mixRamp(float* out, const float* in, int frames, float gain, float gainStep) {
+    static_assert(Channels >= 1 && Channels <= 8, "unsupported channel count");
+    int f = 0;
+
+#if defined(__SSE2__)
+    __m128 gains[Channels];
+    for (int v = 0; v < Channels; v++) {
+        alignas(16) float lanes[4];
+        for (int l = 0; l < 4; l++) lanes[l] = gain + gainStep * static_cast<float>((4 * v + l) / Channels);
+        gains[v] = _mm_load_ps(lanes);
+    }
+    const __m128 advance = _mm_set1_ps(4.0f * gainStep);
+
+    for (; f + 4 <= frames; f += 4) {
+        float* o = out + f * Channels;
+        const float* s = in + f * Channels;
+        for (int v = 0; v < Channels; v++) {
+            __m128 acc = _mm_loadu_ps(o + 4 * v);
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(s + 4 * v), gains[v]));
+            _mm_storeu_ps(o + 4 * v, acc);
+            gains[v] = _mm_add_ps(gains[v], advance);
+        }
+    }
+#endif
+
+    out += f * Channels;
+    in += f * Channels;
+    for (; f < frames; f++, out += Channels, in += Channels) {
+        float g = gain + gainStep * static_cast<float>(f);
+        for (int c = 0; c < Channels; c++) {
+            out[c] += in[c] * g;
+        }
+    }
+}
+
+// mixRamp with a gain and step per channel (pan):
+// out[f*C + c] += in[f*C + c] * (gain[c] + gainStep[c] * f)
+template <int Channels>
+inline void mixRampChannels(float* out, const float* in, int frames, const float* gain, const float* gainStep) {
+    static_assert(Channels >= 1 && Channels <= 8, "unsupported channel count");
+    int f = 0;
+
+#if defined(__SSE2__)
+    __m128 gains[Channels];
+    __m128 advance[Channels];
+    for (int v = 0; v < Channels; v++) {
+        alignas(16) float lanes[4];
+        alignas(16) float steps[4];
+        for (int l = 0; l < 4; l++) {
+            int c = (4 * v + l) % Channels;
+            lanes[l] = gain[c] + gainStep[c] * static_cast<float>((4 * v + l) / Channels);
+            steps[l] = 4.0f * gainStep[c];
+        }
+        gains[v] = _mm_load_ps(lanes);
+        advance[v] = _mm_load_ps(steps);
+    }
+
+    for (; f + 4 <= frames; f += 4) {
+        float* o = out + f * Channels;
+        const float* s = in + f * Channels;
+        for (int v = 0; v < Channels; v++) {
+            __m128 acc = _mm_loadu_ps(o + 4 * v);
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(s + 4 * v), gains[v]));
+            _mm_storeu_ps(o + 4 * v, acc);
+            gains[v] = _mm_add_ps(gains[v], advance[v]);
+        }
+    }
+#endif
+
+    out += f * Channels;
+    in += f * Channels;
+    for (; f < frames; f++, out += Channels, in += Channels) {
+        for (int c = 0; c < Channels; c++) {
+            out[c] += in[c] * (gain[c] + gainStep[c] * static_cast<float>(f));
+        }
+    }
+}
+
+// buf[f*C + c] *= gain + gainStep * f, the in-place counterpart of mixRamp
+template <int Channels>
+inline void scaleRamp(float* buf, int frames, float gain, float gainStep) {
+    static_assert(Channels >= 1 && Channels <= 8, "unsupported channel count");
+    int f = 0;
+
+#if defined(__SSE2__)
+    __m128 gains[Channels];
+    for (int v = 0; v < Channels; v++) {
+        alignas(16) float lanes[4];
+        for (int l = 0; l < 4; l++) lanes[l] = gain + gainStep * static_cast<float>((4 * v + l) / Channels);
+        gains[v] = _mm_load_ps(lanes);
+    }
+    const __m128 advance = _mm_set1_ps(4.0f * gainStep);
+
+    for (; f + 4 <= frames; f += 4) {
+        float* b = buf + f * Channels;
+        for (int v = 0; v < Channels; v++) {
+            _mm_storeu_ps(b + 4 * v, _mm_mul_ps(_mm_loadu_ps(b + 4 * v), gains[v]));
+            gains[v] = _mm_add_ps(gains[v], advance);
+        }
+    }
+#endif
+
+    buf += f * Channels;
+    for (; f < frames; f++, buf += Channels) {
+        float g = gain + gainStep * static_cast<float>(f);
+        for (int c = 0; c < Channels; c++) {
+            buf[c] *= g;
+        }
+    }
+}
+
+// Largest absolute sample value
+inline float peak(const float* buf, int samples) {
+    float result = 0.0f;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= samples; i += 4) {
+        acc = _mm_max_ps(acc, _mm_and_ps(_mm_loadu_ps(buf + i), absMask));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, acc);
+    result = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+    for (; i < samples; i++) {
+        result = std::max(result, std::fabs(buf[i]));
+    }
+    return result;
+}
+
+// Clamp every sample to [-1, 1]
+inline void clamp(float* buf, int samples) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    for (; i + 4 <= samples; i += 4) {
+        _mm_storeu_ps(buf + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(buf + i), lo), hi));
+    }
+#endif
+    for (; i < samples; i++) {
+        buf[i] = std::clamp(buf[i], -1.0f, 1.0f);
+    }
+}
+
+} // namespace MixKernels
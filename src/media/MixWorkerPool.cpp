@@ -0,0 +1,96 @@
+#include "media/MixWorkerPool.h"
+#include "media/RtCheck.h"
+#include <SDL3/SDL.h>
+#include <chrono>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static void cpuRelax() {
+#if defined(__SSE2__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+MixWorkerPool::~MixWorkerPool() {
+    shutdown();
+}
+
+void MixWorkerPool::start(int workerCount) {
+    shutdown();
+    m_running.store(true);
+    for (int i = 0; i < workerCount; i++) {
+        m_workers.emplace_back(&MixWorkerPool::workerLoop, this);
+    }
+}
+
+void MixWorkerPool::shutdown() {
+    m_running.store(false);
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) worker.join();
+    }
+    m_workers.clear();
+}
+
+void MixWorkerPool::parallelFor(int count, TaskFn fn, void* context) {
+    if (count <= 0) return;
+    if (m_workers.empty() || count == 1) {
+        for (int i = 0; i < count; i++) fn(context, i);
+        return;
+    }
+
+    // Seqlock-style handoff: odd serial fences workers off the job fields,
+    // and anyone still registered from the last job is on its way out
+    m_serial.fetch_add(1);
+    while (m_busy.load() != 0) cpuRelax();
+    m_fn = fn;
+    m_context = context;
+    m_count = count;
+    m_done.store(0);
+    m_next.store(0);
+    m_serial.fetch_add(1);
+
+    runTasks();
+    while (m_done.load() < count) cpuRelax();
+}
+
+void MixWorkerPool::runTasks() {
+    int done = 0;
+    for (int i = m_next.fetch_add(1); i < m_count; i = m_next.fetch_add(1)) {
+        m_fn(m_context, i);
+        done++;
+    }
+    if (done) m_done.fetch_add(done);
+}
+
+void MixWorkerPool::workerLoop() {
+    // Best effort: raising priority can need privileges
+    SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_TIME_CRITICAL);
+
+    uint64_t seen = m_serial.load();
+    int idle = 0;
+    while (m_running.load()) {
+        uint64_t serial = m_serial.load();
+        if ((serial & 1) == 0 && serial != seen) {
+            m_busy.fetch_add(1);
+            if (m_serial.load() == serial) {
+                RtCheck::Scope realtime("audio mix worker");
+                runTasks();
+            }
+            m_busy.fetch_sub(1);
+            seen = serial;
+            idle = 0;
+            continue;
+        }
+
+        // Hot for about a block after the last job, then nap
+        if (++idle < 20000) {
+            cpuRelax();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+// Small pool of high-priority threads that help the audio render thread mix
+// a block. parallelFor() is real-time safe: no locks, no allocation, and
+// the caller never waits on a sleeping worker. It runs whatever nobody else
+// has claimed and only waits for work already running elsewhere. Idle
+// workers spin briefly, then nap between polls, so a busy project keeps
+// them hot and a paused one costs next to nothing.
+class MixWorkerPool {
+public:
+    using TaskFn = void (*)(void* context, int index);
+
+    ~MixWorkerPool();
+
+    // workerCount 0 = everything runs on the caller
+    void start(int workerCount);
+    void shutdown();
+    int getWorkerCount() const { return static_cast<int>(m_workers.size()); }
+
+    // fn(context, i) for every i in [0, count); returns once all are done.
+    // One caller at a time.
+    void parallelFor(int count, TaskFn fn, void* context);
+
+private:
+    void workerLoop();
+    void runTasks();
+
+    std::vector<std::thread> m_workers;
+    std::atomic<bool> m_running{false};
+
+    // Current job. m_serial is odd while the caller rewrites it; workers
+    // register in m_busy before reading it, and the caller waits for
+    // m_busy to drain before touching it again.
+    std::atomic<uint64_t> m_serial{0};
+    std::atomic<int> m_busy{0};
+    TaskFn m_fn = nullptr;
+    void* m_context = nullptr;
+    int m_count = 0;
+    std::atomic<int> m_next{0};
+    std::atomic<int> m_done{0};
+};
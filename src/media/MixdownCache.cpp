@@ -0,0 +1,419 @@
+#include "media/MixdownCache.h"
+#include "media/AudioPcmCache.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+
+// How long keys must stay unchanged before the renderer gets a snapshot,
+// so dragging a clip or a fader doesn't re-render on every frame
+constexpr auto SETTLE_TIME = std::chrono::milliseconds(500);
+
+// FNV-1a over the bytes of plain values
+struct KeyHash {
+    uint64_t value = 14695981039346656037ull;
+
+    template <typename T>
+    KeyHash& add(const T& v) {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "hash plain values only");
+        unsigned char bytes[sizeof(T)];
+        memcpy(bytes, &v, sizeof(T));
+        for (unsigned char b : bytes) {
+            value ^= b;
+            value *= 1099511628211ull;
+        }
+        return *this;
+    }
+};
+
+void addEffects(KeyHash& hash, const AudioEffectChain& chain) {
+    hash.add(chain.eqEnabled);
+    for (const EqBand& band : chain.eq) {
+        hash.add(band.type).add(band.frequency).add(band.gainDb).add(band.q);
+    }
+    const CompressorParams& comp = chain.compressor;
+    hash.add(comp.enabled).add(comp.thresholdDb).add(comp.ratio)
+        .add(comp.attackMs).add(comp.releaseMs).add(comp.makeupDb);
+    const LimiterParams& limiter = chain.limiter;
+    hash.add(limiter.enabled).add(limiter.ceilingDb).add(limiter.releaseMs);
+}
+
+// Track gain and effects plus every bus on its way to master (followed as
+// AudioMixer does). False if the track or a bus above it is muted.
+bool addTrack(KeyHash& hash, const Timeline& timeline, const Track& track) {
+    if (track.muted) return false;
+    hash.add(track.id).add(track.volume).add(track.pan);
+    addEffects(hash, track.effects);
+
+    size_t busCount = timeline.getAllBuses().size();
+    uint32_t busId = track.busId;
+    for (size_t hops = 0; busId != 0 && hops <= busCount; hops++) {
+        const AudioBus* bus = timeline.getBus(busId);
+        if (!bus) break;
+        if (bus->muted) return false;
+        hash.add(bus->id).add(bus->volume);
+        busId = bus->parentId;
+    }
+    return true;
+}
+
+// A curve's shape over [from, to]: its value at both ends and every point
+// between, so editing automation only changes the blocks it reaches
+void addCurve(KeyHash& hash, const AutomationCurve& curve, double from, double to) {
+    if (curve.empty()) return;
+    hash.add(curve.evaluate(from, 0.0f)).add(curve.evaluate(to, 0.0f));
+    auto [first, last] = curve.pointsBetween(from, to);
+    for (auto it = first; it != last; ++it) hash.add(it->time).add(it->value);
+}
+
+} // namespace
+
+MixdownCache::~MixdownCache() {
+    shutdown();
+}
+
+void MixdownCache::start(size_t budgetBytes) {
+    shutdown();
+    size_t blockBytes = static_cast<size_t>(BLOCK_FRAMES) * AudioMixer::OUTPUT_CHANNELS * sizeof(float);
+    m_slotCount = static_cast<int>(std::min<size_t>(budgetBytes / blockBytes, MAX_BLOCKS));
+    if (m_slotCount == 0) return;
+
+    // Left uninitialised: pages are only committed once a block lands in them
+    m_samples.reset(new float[static_cast<size_t>(m_slotCount) * BLOCK_FRAMES * AudioMixer::OUTPUT_CHANNELS]);
+    m_blocks.reset(new Block[MAX_BLOCKS]);
+    m_slotBlock.assign(m_slotCount, -1);
+    m_keys.clear();
+    m_pcm.clear();
+    m_keysVersion = 0;
+    m_keysPosted = true;
+    m_requestedBlock = -1;
+    m_starvedAt.store(-1);
+
+    m_abort.store(false);
+    m_worker = std::thread(&MixdownCache::workerLoop, this);
+}
+
+void MixdownCache::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_abort.store(true);
+        m_job.reset();
+    }
+    m_cond.notify_all();
+    if (m_worker.joinable()) m_worker.join();
+}
+
+void MixdownCache::computeKeys(const Timeline& timeline, AudioPcmCache& pcmCache,
+                               std::vector<uint64_t>& keys,
+                               std::unordered_map<uint32_t, std::shared_ptr<const PcmBuffer>>& pcm) const {
+    constexpr double rate = AudioMixer::OUTPUT_SAMPLE_RATE;
+    int64_t frames = static_cast<int64_t>(std::ceil(timeline.getTotalDuration() * rate));
+    int count = static_cast<int>(std::min<int64_t>((frames + BLOCK_FRAMES - 1) / BLOCK_FRAMES, MAX_BLOCKS));
+    keys.assign(count, 0);
+    std::vector<bool> live(count, false);  // something in the block can't be pre-rendered
+
+    KeyHash master;
+    addEffects(master, timeline.getMasterEffects());
+
+    for (uint32_t trackId : timeline.getTrackOrder()) {
+        const Track* track = timeline.getTrack(trackId);
+        if (!track || track->type != TrackType::Audio) continue;
+
+        // Muted tracks are silent whichever way they're mixed, so they
+        // don't feed any block
+        KeyHash trackHash;
+        if (!addTrack(trackHash, timeline, *track)) continue;
+
+        track->clips.forEach([&](const ClipSpan& span) {
+            const Clip* clip = timeline.getClip(span.clipId);
+            const MediaAsset* asset = clip ? timeline.getAsset(clip->assetId) : nullptr;
+            if (!asset || (!asset->pending && !asset->hasAudio)) return;
+
+            // Only looks: decodes are requested near the playhead (requestPcm)
+            bool cached = false;
+            if (!asset->pending) {
+                auto it = pcm.find(asset->id);
+                if (it == pcm.end()) {
+                    auto buffer = pcmCache.find(asset->id);
+                    if (buffer) it = pcm.emplace(asset->id, std::move(buffer)).first;
+                }
+                cached = it != pcm.end();
+            }
+
+            KeyHash clipHash;
+            clipHash.add(trackHash.value).add(clip->id).add(clip->assetId)
+                .add(span.start).add(span.end).add(clip->sourceIn).add(clip->sourceOut)
+                .add(clip->fadeIn).add(clip->fadeOut);
+
+            // Every block whose pre-roll or body the clip overlaps
+            int first = static_cast<int>(std::floor(span.start * rate / BLOCK_FRAMES));
+            int last = static_cast<int>(std::ceil((span.end * rate + PREROLL_FRAMES) / BLOCK_FRAMES)) - 1;
+            // Retimed clips play live: a block rendered on its own would
+            // start the time-stretch afresh and not join up with the next
+            bool retimed = clip->speed != 1.0;
+            for (int b = std::max(first, 0); b <= std::min(last, count - 1); b++) {
+                if (!cached || retimed) {
+                    live[b] = true;
+                    continue;
+                }
+                // Automation over the block's pre-roll and body
+                double from = (static_cast<double>(b) * BLOCK_FRAMES - PREROLL_FRAMES) / rate;
+                double to = static_cast<double>(b + 1) * BLOCK_FRAMES / rate;
+                KeyHash blockHash{keys[b] ? keys[b] : master.value};
+                blockHash.add(clipHash.value);
+                addCurve(blockHash, track->volumeCurve, from, to);
+                addCurve(blockHash, track->panCurve, from, to);
+                addCurve(blockHash, clip->volumeCurve, from - span.start, to - span.start);
+                addCurve(blockHash, clip->panCurve, from - span.start, to - span.start);
+                keys[b] = blockHash.value;
+            }
+        });
+    }
+
+    // 0 = play live: nothing to mix, or something only a decoder can play
+    for (int b = 0; b < count; b++) {
+        if (live[b]) keys[b] = 0;
+    }
+}
+
+void MixdownCache::requestPcm(const Timeline& timeline, AudioPcmCache& pcmCache, int playheadBlock) const {
+    constexpr double rate = AudioMixer::OUTPUT_SAMPLE_RATE;
+    double from = (static_cast<double>(playheadBlock) * BLOCK_FRAMES - PREROLL_FRAMES) / rate;
+    double to = static_cast<double>(playheadBlock + REQUEST_BLOCKS) * BLOCK_FRAMES / rate;
+
+    for (uint32_t trackId : timeline.getTrackOrder()) {
+        const Track* track = timeline.getTrack(trackId);
+        if (!track || track->type != TrackType::Audio || track->muted) continue;
+
+        track->clips.forEachOverlapping(from, to, [&](const ClipSpan& span) {
+            const Clip* clip = timeline.getClip(span.clipId);
+            const MediaAsset* asset = clip ? timeline.getAsset(clip->assetId) : nullptr;
+            if (asset && !asset->pending && asset->hasAudio) pcmCache.get(asset->id, asset->filePath);
+        });
+    }
+}
+
+void MixdownCache::update(const Timeline& timeline, AudioPcmCache& pcmCache, double playheadSeconds) {
+    if (!isEnabled()) return;
+
+    int playheadBlock = static_cast<int>(playheadSeconds * AudioMixer::OUTPUT_SAMPLE_RATE / BLOCK_FRAMES);
+    playheadBlock = std::clamp(playheadBlock, 0, MAX_BLOCKS - 1);
+    m_playheadBlock.store(playheadBlock);
+
+    uint64_t version = timeline.getEditVersion();
+    if (playheadBlock != m_requestedBlock || version != m_requestedVersion) {
+        requestPcm(timeline, pcmCache, playheadBlock);
+        m_requestedBlock = playheadBlock;
+        m_requestedVersion = version;
+    }
+
+    // Keys only move with an edit, or once more audio has been decoded
+    auto now = std::chrono::steady_clock::now();
+    uint64_t pcmReady = pcmCache.getReadyCount();
+    if (version != m_keysVersion || pcmReady != m_keysPcmReady) {
+        std::vector<uint64_t> keys;
+        m_pcm.clear();
+        computeKeys(timeline, pcmCache, keys, m_pcm);
+        m_keysVersion = version;
+        m_keysPcmReady = pcmReady;
+
+        // Changed blocks stop playing from the cache straight away
+        if (keys != m_keys) {
+            size_t count = std::max(keys.size(), m_keys.size());
+            for (size_t b = 0; b < count; b++) {
+                uint64_t key = b < keys.size() ? keys[b] : 0;
+                if (b >= m_keys.size() || m_keys[b] != key) m_blocks[b].wanted.store(key);
+            }
+            m_keys = std::move(keys);
+            m_lastChange = now;
+            m_keysPosted = false;
+        }
+    }
+
+    // The worker dropped its snapshot for lack of room; once the playhead
+    // moves on, blocks behind it can make way
+    int starvedAt = m_starvedAt.load();
+    if (starvedAt >= 0 && starvedAt != playheadBlock) m_keysPosted = false;
+
+    if (!m_keysPosted && now - m_lastChange >= SETTLE_TIME) {
+        m_keysPosted = true;
+        m_starvedAt.store(-1);
+        if (!hasStaleBlocks()) return;
+
+        auto job = std::make_unique<Job>(Job{timeline.snapshot(), m_pcm, m_keys});
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_job = std::move(job);
+        }
+        m_cond.notify_one();
+    }
+}
+
+bool MixdownCache::read(int64_t frame, float* out, int frames) const {
+    if (!m_blocks || frame < 0 || frame / BLOCK_FRAMES >= MAX_BLOCKS) return false;
+    int64_t index = frame / BLOCK_FRAMES;
+    const Block& block = m_blocks[index];
+    uint64_t key = block.wanted.load();
+    if (key == 0 || block.ready.load() != key) return false;
+    int slot = block.slot.load();
+    if (slot < 0) return false;
+
+    // Claim the slot, then make sure it still holds this block: the worker
+    // evicts first and waits out any claim before reusing a slot
+    m_readerSlot.store(slot);
+    bool current = block.ready.load() == key && block.slot.load() == slot;
+    if (current) {
+        memcpy(out, slotData(slot) + (frame - index * BLOCK_FRAMES) * AudioMixer::OUTPUT_CHANNELS,
+               static_cast<size_t>(frames) * AudioMixer::OUTPUT_CHANNELS * sizeof(float));
+    }
+    m_readerSlot.store(-1);
+    return current;
+}
+
+bool MixdownCache::hasStaleBlocks() const {
+    for (size_t b = 0; b < m_keys.size(); b++) {
+        if (m_keys[b] != 0 && m_blocks[b].ready.load() != m_keys[b]) return true;
+    }
+    return false;
+}
+
+int MixdownCache::getReadyBlockCount() const {
+    int ready = 0;
+    for (size_t b = 0; b < m_keys.size(); b++) {
+        uint64_t key = m_blocks[b].wanted.load();
+        if (key != 0 && m_blocks[b].ready.load() == key) ready++;
+    }
+    return ready;
+}
+
+void MixdownCache::workerLoop() {
+    std::unique_ptr<Job> job;
+    std::vector<float> preroll(static_cast<size_t>(PREROLL_FRAMES) * AudioMixer::OUTPUT_CHANNELS);
+
+    while (!m_abort.load()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_job) job = std::move(m_job);
+        }
+
+        int slot = -1;
+        int block = job ? nextBlock(*job, slot) : -1;
+        if (block < 0) {
+            // Up to date, or full of blocks nearer the playhead: let the
+            // snapshot go and wait for the next one (after an edit, or once
+            // playback moves on)
+            job.reset();
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait_for(lock, std::chrono::milliseconds(250),
+                            [this] { return m_abort.load() || m_job != nullptr; });
+            continue;
+        }
+
+        renderBlock(*job, block, slotData(slot), preroll);
+        m_slotBlock[slot] = block;
+        m_blocks[block].slot.store(slot);
+        m_blocks[block].ready.store(job->keys[block]);
+    }
+}
+
+int MixdownCache::nextBlock(const Job& job, int& slot) {
+    int count = static_cast<int>(job.keys.size());
+    if (count == 0) return -1;
+    int start = std::min(m_playheadBlock.load(), count - 1);
+    auto distance = [&](int b) { return (b - start + count) % count; };  // ahead of the playhead
+
+    // Nearest stale block at or after the playhead, wrapping around. A key
+    // that no longer matches means a newer snapshot is on its way.
+    int target = -1;
+    for (int i = 0; i < count && target < 0; i++) {
+        int b = (start + i) % count;
+        uint64_t key = job.keys[b];
+        if (key != 0 && m_blocks[b].wanted.load() == key && m_blocks[b].ready.load() != key) target = b;
+    }
+    if (target < 0) return -1;
+
+    // Re-render in place if the block already has a slot, else take a free
+    // slot, one holding an outdated block, or the block furthest ahead
+    // (just behind the playhead) if that is further than the target
+    int held = m_blocks[target].slot.load();
+    if (held >= 0) {
+        evict(held);
+        slot = held;
+        return target;
+    }
+    int victim = -1;
+    int victimDistance = distance(target);
+    for (int s = 0; s < m_slotCount; s++) {
+        int b = m_slotBlock[s];
+        if (b < 0) {
+            slot = s;
+            return target;
+        }
+        if (b >= count || m_blocks[b].ready.load() != m_blocks[b].wanted.load()) {
+            victim = s;
+            victimDistance = INT_MAX;
+        } else if (distance(b) > victimDistance) {
+            victim = s;
+            victimDistance = distance(b);
+        }
+    }
+    if (victim < 0) {
+        m_starvedAt.store(m_playheadBlock.load());
+        return -1;
+    }
+    evict(victim);
+    slot = victim;
+    return target;
+}
+
+void MixdownCache::evict(int slot) {
+    Block& block = m_blocks[m_slotBlock[slot]];
+    block.ready.store(0);
+    block.slot.store(-1);
+    m_slotBlock[slot] = -1;
+    // A read() that claimed the slot before the eviction is a memcpy away
+    while (m_readerSlot.load() == slot) std::this_thread::yield();
+}
+
+void MixdownCache::renderBlock(const Job& job, int block, float* out, std::vector<float>& preroll) {
+    const Timeline& timeline = job.timeline;
+    int64_t start = static_cast<int64_t>(block) * BLOCK_FRAMES;
+    int prerollFrames = static_cast<int>(std::min<int64_t>(PREROLL_FRAMES, start));
+    double from = static_cast<double>(start - prerollFrames) / AudioMixer::OUTPUT_SAMPLE_RATE;
+    double to = static_cast<double>(start + BLOCK_FRAMES) / AudioMixer::OUTPUT_SAMPLE_RATE;
+
+    // The same sources playback would have, all read from the PCM cache
+    std::vector<AudioMixSource> sources;
+    for (uint32_t trackId : timeline.getTrackOrder()) {
+        const Track* track = timeline.getTrack(trackId);
+        KeyHash unused;
+        if (!track || track->type != TrackType::Audio || !addTrack(unused, timeline, *track)) continue;
+
+        track->clips.forEachOverlapping(from, to, [&](const ClipSpan& span) {
+            const Clip* clip = timeline.getClip(span.clipId);
+            auto pcm = clip ? job.pcm.find(clip->assetId) : job.pcm.end();
+            if (pcm == job.pcm.end()) return;
+
+            AudioMixSource src;
+            src.pcm = pcm->second.get();
+            src.clip = clip;
+            src.track = track;
+            src.clipId = clip->id;
+            sources.push_back(src);
+        });
+    }
+    std::vector<const AudioBus*> buses;
+    for (const auto& [busId, bus] : timeline.getAllBuses()) buses.push_back(&bus);
+
+    // A fresh mixer per block, so no gain or effect state carries over from
+    // whichever block was rendered last
+    AudioMixer mixer;
+    mixer.setSources(std::move(sources), buses, &timeline.getMasterEffects());
+    mixer.setPlayhead(from);
+    AudioClockUpdate clockUpdate;
+    if (prerollFrames > 0) mixer.render(preroll.data(), prerollFrames, clockUpdate);
+    mixer.render(out, BLOCK_FRAMES, clockUpdate);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "media/AudioMixer.h"
+#include "timeline/Timeline.h"
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+class AudioPcmCache;
+class PcmBuffer;
+
+// Pre-rendered timeline mix, so heavy sections don't have to be mixed live.
+//
+// The timeline is cut into one-second blocks. Each block's key hashes
+// everything that feeds it: the clips overlapping it (timing and asset),
+// their tracks' volume, mute, effects and bus routing, the buses' gains and
+// the master effects. update() recomputes the keys only when the timeline's
+// edit version changes or more audio has been decoded; once they have
+// stayed put for a moment, a background thread mixes the blocks whose key
+// changed from a timeline snapshot, into a fixed budget of memory, nearest
+// the playhead first. An edit only changes the keys of the blocks it
+// touches, so everything else stays cached. The snapshot is only taken when
+// some block needs rendering and is dropped once none does, so the live
+// timeline isn't kept shared (and cloned on its next edit) in between.
+//
+// AudioMixer::render() plays a block from here whenever its stored key
+// matches the current one, and mixes live otherwise (edited ranges, or
+// clips whose asset isn't in the AudioPcmCache yet, which are never
+// pre-rendered). Decodes are only requested for clips within
+// REQUEST_BLOCKS of the playhead, where blocks are rendered first. Each
+// block is rendered from a short pre-roll so effect state has settled by
+// its first sample.
+class MixdownCache {
+public:
+    static constexpr int BLOCK_FRAMES = AudioMixer::OUTPUT_SAMPLE_RATE;  // 1 s
+    static constexpr int PREROLL_FRAMES = AudioMixer::OUTPUT_SAMPLE_RATE / 10;
+    static constexpr int MAX_BLOCKS = 4 * 60 * 60;  // 4 h of timeline
+    static constexpr int REQUEST_BLOCKS = 60;        // PCM requested this far ahead
+    static constexpr size_t DEFAULT_BUDGET = 256ull << 20;
+
+    ~MixdownCache();
+
+    // budgetBytes 0 disables the cache. Before anything reads from it.
+    void start(size_t budgetBytes = DEFAULT_BUDGET);
+    void shutdown();
+    bool isEnabled() const { return m_slotCount > 0; }
+
+    // Main thread, once per frame while playing or paused. Publishes the
+    // current block keys and, once they've settled, hands a snapshot to the
+    // renderer.
+    void update(const Timeline& timeline, AudioPcmCache& pcmCache, double playheadSeconds);
+
+    // First timeline frame after `frame` that starts a new block
+    static int64_t blockEnd(int64_t frame) { return (frame / BLOCK_FRAMES + 1) * BLOCK_FRAMES; }
+
+    // Copy [frame, frame + frames) if its block is cached and current; the
+    // range must lie within one block. Real-time safe; one reading thread.
+    bool read(int64_t frame, float* out, int frames) const;
+
+    // Blocks currently playable from the cache (main thread, for stats)
+    int getReadyBlockCount() const;
+
+private:
+    struct Block {
+        std::atomic<uint64_t> wanted{0};  // current key, 0 = play live
+        std::atomic<uint64_t> ready{0};   // key of the audio in slot
+        std::atomic<int> slot{-1};
+    };
+
+    // Everything the renderer needs, frozen at one moment
+    struct Job {
+        Timeline timeline;
+        std::unordered_map<uint32_t, std::shared_ptr<const PcmBuffer>> pcm;  // by asset
+        std::vector<uint64_t> keys;
+    };
+
+    void computeKeys(const Timeline& timeline, AudioPcmCache& pcmCache,
+                     std::vector<uint64_t>& keys,
+                     std::unordered_map<uint32_t, std::shared_ptr<const PcmBuffer>>& pcm) const;
+    void requestPcm(const Timeline& timeline, AudioPcmCache& pcmCache, int playheadBlock) const;
+    void workerLoop();
+    // Next block to render and the slot for it, or -1 if there is none.
+    // Sets m_starvedAt if stale blocks are left that the budget can't fit
+    // before the playhead moves.
+    int nextBlock(const Job& job, int& slot);
+    bool hasStaleBlocks() const;
+    void renderBlock(const Job& job, int block, float* out, std::vector<float>& preroll);
+    void evict(int slot);
+    float* slotData(int slot) const {
+        return m_samples.get() + static_cast<size_t>(slot) * BLOCK_FRAMES * AudioMixer::OUTPUT_CHANNELS;
+    }
+
+    int m_slotCount = 0;
+    std::unique_ptr<float[]> m_samples;  // m_slotCount blocks, touched as rendered
+    std::unique_ptr<Block[]> m_blocks;   // MAX_BLOCKS
+    std::vector<int> m_slotBlock;        // worker: block held by each slot, -1 = free
+
+    // The slot the render thread is copying out of, so the worker never
+    // reuses its slot underneath it
+    mutable std::atomic<int> m_readerSlot{-1};
+
+    // Main thread
+    std::vector<uint64_t> m_keys;
+    std::unordered_map<uint32_t, std::shared_ptr<const PcmBuffer>> m_pcm;  // what m_keys counted as cached
+    uint64_t m_keysVersion = 0;    // timeline edit version m_keys were computed at, 0 = none yet
+    uint64_t m_keysPcmReady = 0;   // and the PCM cache's ready count
+    bool m_keysPosted = true;
+    int m_requestedBlock = -1;     // playhead block and version PCM was last requested for
+    uint64_t m_requestedVersion = 0;
+    std::chrono::steady_clock::time_point m_lastChange;
+
+    std::atomic<int> m_playheadBlock{0};
+    std::atomic<int> m_starvedAt{-1};  // playhead block the worker ran out of slots at
+    std::unique_ptr<Job> m_job;  // newest snapshot, not yet taken
+    std::thread m_worker;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::atomic<bool> m_abort{false};
+};
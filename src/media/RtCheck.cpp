@@ -0,0 +1,332 @@
+#include "media/RtCheck.h"
+
+#if defined(VIDEO_EDITOR_RT_CHECK)
+
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// glibc's allocator entry points, used as the real malloc & co. so the
+// hooks never need dlsym (which may allocate) to find them
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace {
+
+enum Kind { Malloc, Free, MutexLock, CondWait, Sleep, FileIo, Poll, KIND_COUNT };
+
+const char* const KIND_NAMES[KIND_COUNT] = {
+    "malloc", "free", "mutex lock", "condition wait", "sleep", "file I/O", "poll",
+};
+
+// Per-thread state. Trivially initialized, so touching it from inside
+// malloc never allocates.
+struct ThreadState {
+    const char* scope = nullptr;  // innermost Scope, null = not real-time
+    int exempt = 0;
+    bool inHook = false;          // recording a violation
+};
+thread_local ThreadState t_state;
+
+constexpr int MAX_FRAMES = 24;
+constexpr int MAX_STACKS = 64;
+
+// A distinct violating call stack. Slots are claimed once, never freed.
+struct StackRecord {
+    std::atomic<uint64_t> hash{0};  // 0 = free
+    std::atomic<bool> ready{false};
+    Kind kind = Malloc;
+    const char* scope = nullptr;
+    int depth = 0;
+    void* frames[MAX_FRAMES];
+    std::atomic<uint64_t> count{0};
+};
+
+StackRecord g_stacks[MAX_STACKS];
+std::atomic<uint64_t> g_counts[KIND_COUNT];
+std::atomic<uint64_t> g_droppedStacks{0};
+bool g_abortOnViolation = false;
+
+struct Init {
+    Init() {
+        const char* env = getenv("VE_RT_CHECK_ABORT");
+        g_abortOnViolation = env && env[0] == '1';
+        // backtrace() loads the unwinder on first use, which allocates
+        void* frames[4];
+        backtrace(frames, 4);
+    }
+} g_init;
+
+bool shouldFlag() {
+    const ThreadState& t = t_state;
+    return t.scope && t.exempt == 0 && !t.inHook;
+}
+
+uint64_t hashFrames(void* const* frames, int depth, Kind kind) {
+    uint64_t h = 1469598103934665603ull ^ static_cast<uint64_t>(kind);
+    for (int i = 0; i < depth; i++) {
+        h = (h ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211ull;
+    }
+    return h ? h : 1;
+}
+
+void record(Kind kind) {
+    ThreadState& t = t_state;
+    t.inHook = true;
+    g_counts[kind].fetch_add(1, std::memory_order_relaxed);
+
+    void* frames[MAX_FRAMES];
+    int depth = backtrace(frames, MAX_FRAMES);
+
+    if (g_abortOnViolation) {
+        fprintf(stderr, "RtCheck: %s in real-time scope '%s'\n", KIND_NAMES[kind], t.scope);
+        backtrace_symbols_fd(frames, depth, STDERR_FILENO);
+        abort();
+    }
+
+    // Skip this function and the hook itself
+    void** stack = frames + 2;
+    depth = depth > 2 ? depth - 2 : 0;
+    uint64_t hash = hashFrames(stack, depth, kind);
+
+    bool stored = false;
+    for (int probe = 0; probe < MAX_STACKS; probe++) {
+        StackRecord& rec = g_stacks[(hash + probe) % MAX_STACKS];
+        uint64_t current = rec.hash.load(std::memory_order_acquire);
+        if (current == 0) {
+            uint64_t expected = 0;
+            if (rec.hash.compare_exchange_strong(expected, hash)) {
+                rec.kind = kind;
+                rec.scope = t.scope;
+                rec.depth = depth;
+                memcpy(rec.frames, stack, depth * sizeof(void*));
+                rec.ready.store(true, std::memory_order_release);
+                rec.count.fetch_add(1, std::memory_order_relaxed);
+                stored = true;
+                break;
+            }
+            current = expected;
+        }
+        if (current == hash) {
+            rec.count.fetch_add(1, std::memory_order_relaxed);
+            stored = true;
+            break;
+        }
+    }
+    if (!stored) g_droppedStacks.fetch_add(1, std::memory_order_relaxed);
+
+    t.inHook = false;
+}
+
+// Next definition of a libc function, looked up on first use
+void* next(std::atomic<void*>& cache, const char* name) {
+    void* fn = cache.load(std::memory_order_relaxed);
+    if (!fn) {
+        fn = dlsym(RTLD_NEXT, name);
+        cache.store(fn, std::memory_order_relaxed);
+    }
+    return fn;
+}
+
+#define RT_CHECK_NEXT(name) \
+    static std::atomic<void*> s_next{nullptr}; \
+    auto real = reinterpret_cast<decltype(&::name)>(next(s_next, #name))
+
+} // namespace
+
+namespace RtCheck {
+
+Scope::Scope(const char* name) : m_previous(t_state.scope) {
+    t_state.scope = name;
+}
+
+Scope::~Scope() {
+    t_state.scope = m_previous;
+}
+
+Exempt::Exempt() {
+    t_state.exempt++;
+}
+
+Exempt::~Exempt() {
+    t_state.exempt--;
+}
+
+bool report() {
+    t_state.inHook = true;
+
+    uint64_t total = 0;
+    for (const auto& count : g_counts) total += count.load();
+    if (total == 0) {
+        fprintf(stderr, "RtCheck: no real-time violations\n");
+        t_state.inHook = false;
+        return true;
+    }
+
+    fprintf(stderr, "RtCheck: %llu real-time violation(s):", (unsigned long long)total);
+    for (int k = 0; k < KIND_COUNT; k++) {
+        uint64_t n = g_counts[k].load();
+        if (n) fprintf(stderr, " %s=%llu", KIND_NAMES[k], (unsigned long long)n);
+    }
+    fprintf(stderr, "\n");
+
+    for (const auto& rec : g_stacks) {
+        if (!rec.ready.load(std::memory_order_acquire)) continue;
+        fprintf(stderr, "\n  %llu x %s in '%s':\n",
+                (unsigned long long)rec.count.load(), KIND_NAMES[rec.kind], rec.scope);
+        fflush(stderr);
+        backtrace_symbols_fd(rec.frames, rec.depth, STDERR_FILENO);
+    }
+    if (uint64_t dropped = g_droppedStacks.load()) {
+        fprintf(stderr, "\n  (%llu violations from further stacks not recorded)\n",
+                (unsigned long long)dropped);
+    }
+
+    t_state.inHook = false;
+    return false;
+}
+
+} // namespace RtCheck
+
+// Interposed definitions. The executable's symbols take precedence over
+// libc's for every library in the process.
+extern "C" {
+
+void* malloc(size_t size) {
+    if (shouldFlag()) record(Malloc);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    if (shouldFlag()) record(Malloc);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    if (shouldFlag()) record(Malloc);
+    return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) return EINVAL;
+    if (shouldFlag()) record(Malloc);
+    void* ptr = __libc_memalign(alignment, size);
+    if (!ptr) return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    if (shouldFlag()) record(Malloc);
+    return __libc_memalign(alignment, size);
+}
+
+void free(void* ptr) {
+    if (ptr && shouldFlag()) record(Free);
+    __libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+    RT_CHECK_NEXT(pthread_mutex_lock);
+    if (shouldFlag()) record(MutexLock);
+    return real(mutex);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* lock) {
+    RT_CHECK_NEXT(pthread_rwlock_rdlock);
+    if (shouldFlag()) record(MutexLock);
+    return real(lock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* lock) {
+    RT_CHECK_NEXT(pthread_rwlock_wrlock);
+    if (shouldFlag()) record(MutexLock);
+    return real(lock);
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+    RT_CHECK_NEXT(pthread_cond_wait);
+    if (shouldFlag()) record(CondWait);
+    return real(cond, mutex);
+}
+
+int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* abstime) {
+    RT_CHECK_NEXT(pthread_cond_timedwait);
+    if (shouldFlag()) record(CondWait);
+    return real(cond, mutex, abstime);
+}
+
+int nanosleep(const struct timespec* duration, struct timespec* remaining) {
+    RT_CHECK_NEXT(nanosleep);
+    if (shouldFlag()) record(Sleep);
+    return real(duration, remaining);
+}
+
+int clock_nanosleep(clockid_t clock, int flags, const struct timespec* request, struct timespec* remaining) {
+    RT_CHECK_NEXT(clock_nanosleep);
+    if (shouldFlag()) record(Sleep);
+    return real(clock, flags, request, remaining);
+}
+
+int usleep(useconds_t usec) {
+    RT_CHECK_NEXT(usleep);
+    if (shouldFlag()) record(Sleep);
+    return real(usec);
+}
+
+ssize_t read(int fd, void* buf, size_t count) {
+    RT_CHECK_NEXT(read);
+    if (shouldFlag()) record(FileIo);
+    return real(fd, buf, count);
+}
+
+ssize_t write(int fd, const void* buf, size_t count) {
+    RT_CHECK_NEXT(write);
+    if (shouldFlag()) record(FileIo);
+    return real(fd, buf, count);
+}
+
+int open(const char* path, int flags, ...) {
+    RT_CHECK_NEXT(open);
+    if (shouldFlag()) record(FileIo);
+    mode_t mode = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, mode_t);
+        va_end(args);
+    }
+    return real(path, flags, mode);
+}
+
+int fsync(int fd) {
+    RT_CHECK_NEXT(fsync);
+    if (shouldFlag()) record(FileIo);
+    return real(fd);
+}
+
+int poll(struct pollfd* fds, nfds_t count, int timeout) {
+    RT_CHECK_NEXT(poll);
+    if (shouldFlag()) record(Poll);
+    return real(fds, count, timeout);
+}
+
+} // extern "C"
+
+#endif // VIDEO_EDITOR_RT_CHECK
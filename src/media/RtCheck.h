@@ -0,0 +1,58 @@
+#pragma once
+
+// Real-time safety checker for threads that must never block (the SDL
+// audio callback).
+//
+// Code running on such a thread is wrapped in an RtCheck::Scope. In builds
+// configured with -DVIDEO_EDITOR_RT_CHECK=ON, malloc/free, mutex and
+// condition-variable waits, and blocking syscalls (sleeps, file I/O, poll)
+// are intercepted process-wide; any call made inside a Scope is counted and
+// its stack recorded, and report() prints a summary at exit. Setting
+// VE_RT_CHECK_ABORT=1 aborts on the first violation instead, with the stack.
+//
+// In normal builds the scopes compile to nothing.
+namespace RtCheck {
+
+#if defined(VIDEO_EDITOR_RT_CHECK)
+
+class Scope {
+public:
+    explicit Scope(const char* name);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* m_previous;
+};
+
+// Lifts the check inside a Scope, for calls a real-time thread can't avoid
+// (e.g. handing data back to SDL, which locks its stream)
+class Exempt {
+public:
+    Exempt();
+    ~Exempt();
+    Exempt(const Exempt&) = delete;
+    Exempt& operator=(const Exempt&) = delete;
+};
+
+// Print violation counts and stacks to stderr. True if there were none.
+bool report();
+
+#else
+
+class Scope {
+public:
+    explicit Scope(const char*) {}
+};
+
+class Exempt {
+public:
+    Exempt() {}
+};
+
+inline bool report() { return true; }
+
+#endif
+
+} // namespace RtCheck
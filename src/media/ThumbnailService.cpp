@@ -0,0 +1,371 @@
+#include "media/ThumbnailService.h"
+#include "media/MediaCache.h"
+#include <algorithm>
+#include <filesystem>
+#include <cstdio>
+#include <cmath>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+namespace fs = std::filesystem;
+
+// Give up on a seek that hasn't produced a frame after this many packets
+static constexpr int MAX_PACKETS_PER_THUMBNAIL = 600;
+
+struct ThumbnailService::Source {
+    std::string path;
+    AVFormatContext* fmt = nullptr;
+    AVCodecContext* codec = nullptr;
+    SwsContext* sws = nullptr;
+    AVPacket* pkt = nullptr;
+    AVFrame* frame = nullptr;
+    int stream = -1;
+
+    ~Source() { close(); }
+
+    bool open(const std::string& filePath) {
+        close();
+        path = filePath;
+        if (avformat_open_input(&fmt, filePath.c_str(), nullptr, nullptr) < 0) return false;
+        if (avformat_find_stream_info(fmt, nullptr) < 0) return false;
+
+        stream = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (stream < 0) return false;
+        // Only the video stream is read
+        for (unsigned i = 0; i < fmt->nb_streams; i++) {
+            if (static_cast<int>(i) != stream) fmt->streams[i]->discard = AVDISCARD_ALL;
+        }
+
+        auto* par = fmt->streams[stream]->codecpar;
+        const AVCodec* dec = avcodec_find_decoder(par->codec_id);
+        if (!dec) return false;
+        codec = avcodec_alloc_context3(dec);
+        avcodec_parameters_to_context(codec, par);
+        codec->thread_count = 1;              // several workers already run in parallel
+        codec->skip_frame = AVDISCARD_NONKEY; // thumbnails only need keyframes
+        if (avcodec_open2(codec, dec, nullptr) < 0) return false;
+
+        pkt = av_packet_alloc();
+        frame = av_frame_alloc();
+        return true;
+    }
+
+    void close() {
+        if (sws) { sws_freeContext(sws); sws = nullptr; }
+        if (frame) av_frame_free(&frame);
+        if (pkt) av_packet_free(&pkt);
+        if (codec) avcodec_free_context(&codec);
+        if (fmt) avformat_close_input(&fmt);
+        stream = -1;
+        path.clear();
+    }
+};
+
+ThumbnailService::~ThumbnailService() {
+    shutdown();
+}
+
+void ThumbnailService::start(const std::string& cacheDir, int workerCount) {
+    shutdown();
+    m_abort.store(false);
+
+    m_cacheDir = cacheDir.empty() ? mediaCacheDir("thumbnails") : cacheDir;
+
+    for (int i = 0; i < std::max(1, workerCount); i++) {
+        m_workers.emplace_back(&ThumbnailService::workerLoop, this);
+    }
+}
+
+void ThumbnailService::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_abort.store(true);
+        m_jobs.clear();
+        m_pendingKeys.clear();
+    }
+    m_jobCond.notify_all();
+    for (auto& t : m_workers) {
+        if (t.joinable()) t.join();
+    }
+    m_workers.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        m_recentFrames.clear();
+        m_recentOrder.clear();
+    }
+    m_frameOfTick.clear();
+
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    m_results.clear();
+}
+
+int ThumbnailService::levelForSpacing(double seconds) {
+    int level = 0;
+    while (level < MAX_LEVEL && TICK_SECONDS * ticksPerStep(level) < seconds) level++;
+    return level;
+}
+
+void ThumbnailService::request(uint32_t assetId, const std::string& path, int64_t tick) {
+    uint64_t k = key(assetId, tick);
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        if (m_workers.empty() || m_pendingKeys.count(k) || m_failedKeys.count(k)) return;
+
+        m_pendingKeys.insert(k);
+        m_jobs.push_front({assetId, tick, path});
+        if (m_jobs.size() > MAX_QUEUED) {
+            m_pendingKeys.erase(key(m_jobs.back().assetId, m_jobs.back().tick));
+            m_jobs.pop_back();
+        }
+    }
+    m_jobCond.notify_one();
+}
+
+std::vector<Thumbnail> ThumbnailService::takeResults() {
+    std::vector<Thumbnail> out;
+    {
+        std::lock_guard<std::mutex> lock(m_resultMutex);
+        out.swap(m_results);
+    }
+    if (!out.empty()) {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        for (const auto& t : out) m_pendingKeys.erase(key(t.assetId, t.tick));
+    }
+    for (const auto& t : out) m_frameOfTick[key(t.assetId, t.tick)] = {t.frame, t.time};
+    return out;
+}
+
+bool ThumbnailService::frameFor(uint32_t assetId, int64_t tick, FrameRef& out) const {
+    auto it = m_frameOfTick.find(key(assetId, tick));
+    if (it == m_frameOfTick.end()) return false;
+    out = it->second;
+    return true;
+}
+
+void ThumbnailService::setPaused(bool paused) {
+    if (m_paused.exchange(paused) && !paused) {
+        m_jobCond.notify_all();
+    }
+}
+
+void ThumbnailService::workerLoop() {
+    Source src;
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_jobMutex);
+            m_jobCond.wait(lock, [this] {
+                return m_abort.load() || (!m_paused.load() && !m_jobs.empty());
+            });
+            if (m_abort.load()) return;
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        Thumbnail thumb;
+        thumb.assetId = job.assetId;
+        thumb.tick = job.tick;
+
+        std::string file = cacheFile(job.path, job.tick);
+        bool ok = !file.empty() && loadCached(file, thumb);
+        if (!ok) {
+            ok = produce(src, job, thumb);
+            if (ok && !file.empty()) storeCached(file, thumb);
+        }
+
+        // A finished thumbnail stays pending until takeResults() hands it
+        // over, so it can't be requested again in between
+        if (ok) {
+            std::lock_guard<std::mutex> lock(m_resultMutex);
+            m_results.push_back(std::move(thumb));
+        } else {
+            std::lock_guard<std::mutex> lock(m_jobMutex);
+            uint64_t k = key(job.assetId, job.tick);
+            m_pendingKeys.erase(k);
+            m_failedKeys.insert(k);
+        }
+    }
+}
+
+bool ThumbnailService::produce(Source& src, const Job& job, Thumbnail& out) {
+    if (src.path != job.path && !src.open(job.path)) {
+        fprintf(stderr, "ThumbnailService: cannot decode video from %s\n", job.path.c_str());
+        src.close();
+        return false;
+    }
+
+    // Without a seek index the keyframe is only known once decoded
+    int64_t pts = 0;
+    if (!resolveKeyframe(src, job.tick, pts)) return decode(src, job.tick, out);
+    uint64_t frame = key(job.assetId, pts);
+
+    // Copy the picture if another tick on this keyframe already decoded it,
+    // waiting for it if that decode is still running
+    {
+        std::unique_lock<std::mutex> lock(m_frameMutex);
+        m_frameCond.wait(lock, [&] { return !m_decodingFrames.count(frame); });
+        auto it = m_recentFrames.find(frame);
+        if (it != m_recentFrames.end()) {
+            const Thumbnail& hit = *it->second;
+            out.frame = frame;
+            out.time = hit.time;
+            out.width = hit.width;
+            out.height = hit.height;
+            out.rgba = hit.rgba;
+            return true;
+        }
+        m_decodingFrames.insert(frame);
+    }
+
+    bool ok = decode(src, job.tick, out);
+    out.frame = frame;
+    {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        m_decodingFrames.erase(frame);
+        if (ok && m_recentFrames.emplace(frame, std::make_shared<const Thumbnail>(out)).second) {
+            m_recentOrder.push_back(frame);
+            if (m_recentOrder.size() > MAX_RECENT_FRAMES) {
+                m_recentFrames.erase(m_recentOrder.front());
+                m_recentOrder.pop_front();
+            }
+        }
+    }
+    m_frameCond.notify_all();
+    return ok;
+}
+
+int64_t ThumbnailService::seekTarget(Source& src, int64_t tick) {
+    AVStream* stream = src.fmt->streams[src.stream];
+    int64_t ts = static_cast<int64_t>(tick * TICK_SECONDS / av_q2d(stream->time_base));
+    if (stream->start_time != AV_NOPTS_VALUE) ts += stream->start_time;
+    return ts;
+}
+
+// The keyframe a backward seek to the tick lands on, from the seek index
+bool ThumbnailService::resolveKeyframe(Source& src, int64_t tick, int64_t& pts) {
+    const AVIndexEntry* entry = avformat_index_get_entry_from_timestamp(
+        src.fmt->streams[src.stream], seekTarget(src, tick), AVSEEK_FLAG_BACKWARD);
+    if (!entry || !(entry->flags & AVINDEX_KEYFRAME)) return false;
+    pts = entry->timestamp;
+    return true;
+}
+
+bool ThumbnailService::decode(Source& src, int64_t tick, Thumbnail& out) {
+    AVStream* stream = src.fmt->streams[src.stream];
+    int64_t ts = seekTarget(src, tick);
+
+    // Keyframe at or before the target; a keyframe-only decoder must then
+    // emit exactly that frame. Fall back to full decoding if it won't.
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (attempt == 1) src.codec->skip_frame = AVDISCARD_DEFAULT;
+        av_seek_frame(src.fmt, src.stream, ts, AVSEEK_FLAG_BACKWARD);
+        avcodec_flush_buffers(src.codec);
+
+        bool got = false;
+        bool draining = false;
+        for (int packets = 0; !got && packets < MAX_PACKETS_PER_THUMBNAIL; packets++) {
+            if (!draining) {
+                int ret = av_read_frame(src.fmt, src.pkt);
+                if (ret < 0) {
+                    draining = true;
+                    avcodec_send_packet(src.codec, nullptr);
+                } else {
+                    if (src.pkt->stream_index == src.stream) {
+                        avcodec_send_packet(src.codec, src.pkt);
+                    }
+                    av_packet_unref(src.pkt);
+                }
+            }
+            int ret = avcodec_receive_frame(src.codec, src.frame);
+            if (ret == 0) got = true;
+            else if (ret == AVERROR_EOF) break;
+        }
+        src.codec->skip_frame = AVDISCARD_NONKEY;
+        if (!got) continue;
+
+        AVFrame* f = src.frame;
+        int64_t shown = f->best_effort_timestamp != AV_NOPTS_VALUE ? f->best_effort_timestamp : ts;
+        int64_t origin = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+        out.frame = key(out.assetId, shown);
+        out.time = std::max(0.0, (shown - origin) * av_q2d(stream->time_base));
+
+        double aspect = f->height > 0 ? static_cast<double>(f->width) / f->height : 16.0 / 9.0;
+        out.height = THUMB_HEIGHT;
+        out.width = std::clamp(static_cast<int>(std::lround(THUMB_HEIGHT * aspect)), 1, THUMB_WIDTH);
+        out.rgba.resize(static_cast<size_t>(out.width) * out.height * 4);
+
+        src.sws = sws_getCachedContext(src.sws, f->width, f->height,
+                                       static_cast<AVPixelFormat>(f->format),
+                                       out.width, out.height, AV_PIX_FMT_RGBA,
+                                       SWS_AREA, nullptr, nullptr, nullptr);
+        if (!src.sws) {
+            av_frame_unref(f);
+            return false;
+        }
+        uint8_t* dst[1] = {out.rgba.data()};
+        int dstStride[1] = {out.width * 4};
+        sws_scale(src.sws, f->data, f->linesize, 0, f->height, dst, dstStride);
+        av_frame_unref(f);
+        return true;
+    }
+    return false;
+}
+
+std::string ThumbnailService::cacheFile(const std::string& mediaPath, int64_t tick) const {
+    if (m_cacheDir.empty()) return {};
+    std::string media = mediaCacheKey(mediaPath);
+    if (media.empty()) return {};
+    return m_cacheDir + "/" + media + "/" + std::to_string(tick) + ".thumb";
+}
+
+// Cache file: "VET2", int32 width, int32 height, int64 frame (the key's
+// time bits), double time, then RGBA rows
+bool ThumbnailService::loadCached(const std::string& file, Thumbnail& out) {
+    FILE* f = fopen(file.c_str(), "rb");
+    if (!f) return false;
+
+    char magic[4];
+    int32_t dims[2];
+    int64_t frame = 0;
+    bool ok = fread(magic, 1, 4, f) == 4 && std::equal(magic, magic + 4, "VET2") &&
+              fread(dims, sizeof(int32_t), 2, f) == 2 &&
+              dims[0] > 0 && dims[0] <= THUMB_WIDTH && dims[1] == THUMB_HEIGHT &&
+              fread(&frame, sizeof(frame), 1, f) == 1 &&
+              fread(&out.time, sizeof(out.time), 1, f) == 1;
+    if (ok) {
+        out.frame = key(out.assetId, frame);
+        out.width = dims[0];
+        out.height = dims[1];
+        out.rgba.resize(static_cast<size_t>(out.width) * out.height * 4);
+        ok = fread(out.rgba.data(), 1, out.rgba.size(), f) == out.rgba.size();
+    }
+    fclose(f);
+    return ok;
+}
+
+void ThumbnailService::storeCached(const std::string& file, const Thumbnail& thumb) {
+    std::error_code ec;
+    fs::create_directories(fs::path(file).parent_path(), ec);
+    if (ec) return;
+
+    // Write then rename, so a concurrent reader never sees a partial file
+    std::string tmp = file + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return;
+    int32_t dims[2] = {thumb.width, thumb.height};
+    int64_t frame = static_cast<int64_t>(thumb.frame & ((uint64_t(1) << 40) - 1));
+    bool ok = fwrite("VET2", 1, 4, f) == 4 &&
+              fwrite(dims, sizeof(int32_t), 2, f) == 2 &&
+              fwrite(&frame, sizeof(frame), 1, f) == 1 &&
+              fwrite(&thumb.time, sizeof(thumb.time), 1, f) == 1 &&
+              fwrite(thumb.rgba.data(), 1, thumb.rgba.size(), f) == thumb.rgba.size();
+    ok = (fclose(f) == 0) && ok;
+    if (ok) fs::rename(tmp, file, ec);
+    if (!ok || ec) fs::remove(tmp, ec);
+}
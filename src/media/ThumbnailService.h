@@ -0,0 +1,122 @@
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// One decoded thumbnail: RGBA, THUMB_HEIGHT rows, at most THUMB_WIDTH wide.
+struct Thumbnail {
+    uint32_t assetId = 0;
+    int64_t tick = 0;               // grid time in ThumbnailService::TICK_SECONDS
+    uint64_t frame = 0;             // picture shown; ticks on one keyframe share it
+    double time = 0.0;              // source time of that picture, seconds
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> rgba;
+};
+
+// Generates timeline thumbnails on background worker threads.
+//
+// Thumbnails sit on a grid of source times: level L has one every
+// TICK_SECONDS * 2^L seconds, so each level's grid is a subset of every finer
+// one and zooming never generates the same thumbnail twice. Each is taken
+// from the keyframe at or before its time, decoding keyframes only where the
+// codec allows, and is kept in an on-disk cache keyed by the file's path,
+// size and modification time, so reopening media doesn't decode it again.
+// Ticks that land on the same keyframe share one decode: a result names the
+// picture it shows (frame) and that picture's actual source time.
+//
+// Requests are served newest first and the backlog is capped, so scrolling
+// past a clip doesn't leave work queued for thumbnails nobody sees anymore.
+class ThumbnailService {
+public:
+    static constexpr int THUMB_WIDTH = 96;
+    static constexpr int THUMB_HEIGHT = 54;
+    static constexpr double TICK_SECONDS = 0.5;   // level 0 spacing
+    static constexpr int MAX_LEVEL = 14;          // ~2.3 h spacing
+    static constexpr size_t MAX_QUEUED = 256;
+    static constexpr size_t MAX_RECENT_FRAMES = 64;
+
+    // Picture a delivered tick resolved to
+    struct FrameRef {
+        uint64_t frame = 0;
+        double time = 0.0;
+    };
+
+    ~ThumbnailService();
+
+    // cacheDir empty = $XDG_CACHE_HOME (or ~/.cache)/video-editor/thumbnails
+    void start(const std::string& cacheDir = "", int workerCount = 2);
+    void shutdown();
+
+    // Smallest level whose spacing is at least `seconds`
+    static int levelForSpacing(double seconds);
+    static int64_t ticksPerStep(int level) { return int64_t(1) << level; }
+    static uint64_t key(uint32_t assetId, int64_t tick) {
+        return (uint64_t(assetId) << 40) | (uint64_t(tick) & ((uint64_t(1) << 40) - 1));
+    }
+
+    // Queue a thumbnail unless it is already queued, in flight or known to
+    // fail (main thread, non-blocking)
+    void request(uint32_t assetId, const std::string& path, int64_t tick);
+
+    // Move all finished thumbnails out (main thread, non-blocking)
+    std::vector<Thumbnail> takeResults();
+
+    // Picture a tick resolved to, once its thumbnail has been taken
+    // (main thread)
+    bool frameFor(uint32_t assetId, int64_t tick, FrameRef& out) const;
+
+    // While paused, workers finish the thumbnail in hand and then wait
+    void setPaused(bool paused);
+
+private:
+    struct Job {
+        uint32_t assetId = 0;
+        int64_t tick = 0;
+        std::string path;
+    };
+    struct Source;  // a worker's open demuxer + decoder, reused across jobs
+
+    void workerLoop();
+    bool produce(Source& src, const Job& job, Thumbnail& out);
+    static int64_t seekTarget(Source& src, int64_t tick);
+    static bool resolveKeyframe(Source& src, int64_t tick, int64_t& pts);
+    static bool decode(Source& src, int64_t tick, Thumbnail& out);
+    std::string cacheFile(const std::string& mediaPath, int64_t tick) const;
+    static bool loadCached(const std::string& file, Thumbnail& out);
+    static void storeCached(const std::string& file, const Thumbnail& thumb);
+
+    std::string m_cacheDir;
+    std::vector<std::thread> m_workers;
+
+    std::deque<Job> m_jobs;                     // newest at the front
+    std::unordered_set<uint64_t> m_pendingKeys; // queued or in flight
+    std::unordered_set<uint64_t> m_failedKeys;
+    std::mutex m_jobMutex;
+    std::condition_variable m_jobCond;
+
+    std::vector<Thumbnail> m_results;
+    std::mutex m_resultMutex;
+
+    // Recently decoded pictures, so other ticks on the same keyframe copy
+    // them instead of decoding again; oldest dropped first
+    std::unordered_map<uint64_t, std::shared_ptr<const Thumbnail>> m_recentFrames;
+    std::deque<uint64_t> m_recentOrder;
+    std::unordered_set<uint64_t> m_decodingFrames;  // claimed by a worker
+    std::mutex m_frameMutex;
+    std::condition_variable m_frameCond;
+
+    std::unordered_map<uint64_t, FrameRef> m_frameOfTick;  // main thread
+
+    std::atomic<bool> m_paused{false};
+    std::atomic<bool> m_abort{false};
+};
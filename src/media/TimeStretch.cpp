@@ -0,0 +1,265 @@
+#include "media/TimeStretch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr int C = TimeStretch::CHANNELS;
+constexpr int SEARCH_FRAMES = 2 * TimeStretch::SEEK + TimeStretch::SEGMENT;
+
+// dot = sum a[i] * b[i], energy = sum b[i]^2
+void correlate(const float* a, const float* b, int n, float& dot, float& energy) {
+    int i = 0;
+    float d = 0.0f, e = 0.0f;
+#if defined(__SSE2__)
+    __m128 vd = _mm_setzero_ps();
+    __m128 ve = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(b + i);
+        vd = _mm_add_ps(vd, _mm_mul_ps(_mm_loadu_ps(a + i), x));
+        ve = _mm_add_ps(ve, _mm_mul_ps(x, x));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, vd);
+    d = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm_store_ps(lanes, ve);
+    e = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; i++) {
+        d += a[i] * b[i];
+        e += b[i] * b[i];
+    }
+    dot = d;
+    energy = e;
+}
+
+// out[f] = in[2f] + in[2f + 1]
+void downmix(float* out, const float* in, int frames) {
+    int f = 0;
+#if defined(__SSE2__)
+    for (; f + 4 <= frames; f += 4) {
+        __m128 a = _mm_loadu_ps(in + 2 * f);
+        __m128 b = _mm_loadu_ps(in + 2 * f + 4);
+        __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + f, _mm_add_ps(left, right));
+    }
+#endif
+    for (in += 2 * f; f < frames; f++, in += 2) out[f] = in[0] + in[1];
+}
+
+// out[i] = tail[i] + in[i] * rise[i]; tail[i] = in[n + i] * fall[i]
+void crossfade(float* out, float* tail, const float* in, const float* rise, const float* fall, int n) {
+    int i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= n; i += 4) {
+        __m128 t = _mm_loadu_ps(tail + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(in + i), _mm_loadu_ps(rise + i))));
+        _mm_storeu_ps(tail + i, _mm_mul_ps(_mm_loadu_ps(in + n + i), _mm_loadu_ps(fall + i)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = tail[i] + in[i] * rise[i];
+        tail[i] = in[n + i] * fall[i];
+    }
+}
+
+} // namespace
+
+TimeStretch::TimeStretch()
+    : m_input(new float[INPUT_CAPACITY * C]),
+      m_output(new float[OUTPUT_CAPACITY * C]),
+      m_tail(new float[SEGMENT * C]),
+      m_rise(new float[SEGMENT * C]),
+      m_fall(new float[SEGMENT * C]),
+      m_reference(new float[SEGMENT]),
+      m_mono(new float[SEARCH_FRAMES]) {
+    // sin^2 and cos^2 sum to one: aligned segments crossfade at unity gain
+    for (int f = 0; f < SEGMENT; f++) {
+        double x = std::sin(std::numbers::pi / 2.0 * (f + 0.5) / SEGMENT);
+        for (int c = 0; c < C; c++) {
+            m_rise[f * C + c] = static_cast<float>(x * x);
+            m_fall[f * C + c] = static_cast<float>(1.0 - x * x);
+        }
+    }
+    reset(1.0, 0);
+}
+
+TimeStretch::~TimeStretch() = default;
+
+void TimeStretch::reset(double speed, int64_t anchor) {
+    m_speed = std::clamp(speed, MIN_SPEED, MAX_SPEED);
+    m_anchor = anchor;
+    m_segment = 0;
+    m_havePrevious = false;
+    m_discard = 0;
+    m_nextOutput = 0;
+    m_inputStart = anchor;
+    m_inputFrames = 0;
+    m_outputRead = 0;
+    m_outputFrames = 0;
+}
+
+int64_t TimeStretch::nominalStart(int64_t segment) const {
+    return m_anchor + std::llround(static_cast<double>(segment) * SEGMENT * m_speed);
+}
+
+int64_t TimeStretch::lowestInput(int64_t segment) const {
+    return segment <= 0 ? m_anchor : std::max(nominalStart(segment) - SEEK, m_anchor);
+}
+
+int64_t TimeStretch::seekOutput(int64_t outputFrame) {
+    outputFrame = std::max<int64_t>(outputFrame, 0);
+    m_segment = std::max<int64_t>(outputFrame / SEGMENT - WARMUP_SEGMENTS, 0);
+    m_havePrevious = false;
+    m_discard = static_cast<int>(outputFrame - m_segment * SEGMENT);
+    m_nextOutput = outputFrame;
+    m_inputStart = lowestInput(m_segment);
+    m_inputFrames = 0;
+    m_outputRead = 0;
+    m_outputFrames = 0;
+    return m_inputStart;
+}
+
+int64_t TimeStretch::beginInput(int64_t inputFrame) {
+    // First segment whose whole search range is in the input
+    double hop = SEGMENT * m_speed;
+    m_segment = std::max<int64_t>(static_cast<int64_t>(std::ceil((inputFrame + SEEK - m_anchor) / hop)), 0);
+    while (lowestInput(m_segment) < inputFrame) m_segment++;
+    while (m_segment > 0 && lowestInput(m_segment - 1) >= inputFrame) m_segment--;
+    m_havePrevious = false;
+    m_discard = 0;
+    m_nextOutput = m_segment * SEGMENT;
+    m_inputStart = inputFrame;
+    m_inputFrames = 0;
+    m_outputRead = 0;
+    m_outputFrames = 0;
+    return m_nextOutput;
+}
+
+void TimeStretch::discardInput() {
+    int64_t keep = lowestInput(m_segment);
+    int64_t drop = std::clamp<int64_t>(keep - m_inputStart, 0, m_inputFrames);
+    if (drop == 0) return;
+    m_inputFrames -= static_cast<int>(drop);
+    memmove(m_input.get(), m_input.get() + drop * C, static_cast<size_t>(m_inputFrames) * C * sizeof(float));
+    m_inputStart += drop;
+}
+
+int TimeStretch::push(const float* in, int frames) {
+    int taken = 0;
+    while (taken < frames) {
+        process();
+        discardInput();
+
+        // Input no segment reaches (before the anchor, or between hops
+        // longer than the search range)
+        int64_t keep = lowestInput(m_segment);
+        if (m_inputFrames == 0 && keep > m_inputStart) {
+            int skip = static_cast<int>(std::min<int64_t>(keep - m_inputStart, frames - taken));
+            m_inputStart += skip;
+            taken += skip;
+            continue;
+        }
+
+        int count = std::min(INPUT_CAPACITY - m_inputFrames, frames - taken);
+        if (count == 0) break;  // output is full
+        memcpy(m_input.get() + static_cast<size_t>(m_inputFrames) * C, in + static_cast<size_t>(taken) * C,
+               static_cast<size_t>(count) * C * sizeof(float));
+        m_inputFrames += count;
+        taken += count;
+    }
+    process();
+    return taken;
+}
+
+int TimeStretch::pull(float* out, int frames) {
+    process();
+    int count = std::min(frames, m_outputFrames);
+    memcpy(out, m_output.get() + static_cast<size_t>(m_outputRead) * C, static_cast<size_t>(count) * C * sizeof(float));
+    m_outputRead += count;
+    m_outputFrames -= count;
+    if (m_outputFrames == 0) m_outputRead = 0;
+    m_nextOutput += count;
+    return count;
+}
+
+int TimeStretch::findOffset(int64_t start, int lo, int hi) {
+    // Mono over every candidate, scored by normalized correlation with the
+    // reference: every COARSE_STEP frames, then every frame around the best
+    const float* base = m_input.get() + (start + lo - m_inputStart) * C;
+    int searchFrames = hi - lo + SEGMENT;
+    downmix(m_mono.get(), base, searchFrames);
+
+    auto score = [&](int offset) {
+        float dot, energy;
+        correlate(m_reference.get(), m_mono.get() + (offset - lo), SEGMENT, dot, energy);
+        return energy > 1e-9f ? dot / std::sqrt(energy) : 0.0f;
+    };
+
+    int best = std::clamp(0, lo, hi);
+    float bestScore = score(best);
+    for (int offset = lo; offset <= hi; offset += COARSE_STEP) {
+        float s = score(offset);
+        if (s > bestScore) {
+            bestScore = s;
+            best = offset;
+        }
+    }
+    int coarse = best;
+    for (int offset = std::max(lo, coarse - COARSE_STEP + 1); offset <= std::min(hi, coarse + COARSE_STEP - 1); offset++) {
+        if (offset == coarse) continue;
+        float s = score(offset);
+        if (s > bestScore) {
+            bestScore = s;
+            best = offset;
+        }
+    }
+    return best;
+}
+
+void TimeStretch::process() {
+    for (;;) {
+        if (m_outputRead + m_outputFrames + SEGMENT > OUTPUT_CAPACITY) {
+            if (m_outputFrames + SEGMENT > OUTPUT_CAPACITY) return;
+            memmove(m_output.get(), m_output.get() + static_cast<size_t>(m_outputRead) * C,
+                    static_cast<size_t>(m_outputFrames) * C * sizeof(float));
+            m_outputRead = 0;
+        }
+
+        int64_t start = nominalStart(m_segment);
+        if (start + SEEK + 2 * SEGMENT > nextInputFrame()) return;
+
+        // Segment 0 always starts afresh, so every run that plays into the
+        // anchor from before it stretches the same way from there on
+        if (m_segment == 0) m_havePrevious = false;
+        int offset = 0;
+        if (m_havePrevious) offset = findOffset(start, static_cast<int>(lowestInput(m_segment) - start), SEEK);
+        const float* in = m_input.get() + (start + offset - m_inputStart) * C;
+        float* out = m_output.get() + static_cast<size_t>(m_outputRead + m_outputFrames) * C;
+
+        if (m_havePrevious) {
+            crossfade(out, m_tail.get(), in, m_rise.get(), m_fall.get(), SEGMENT * C);
+        } else {
+            // Nothing to fade from: the first half plays as is
+            memcpy(out, in, SEGMENT * C * sizeof(float));
+            for (int i = 0; i < SEGMENT * C; i++) m_tail[i] = in[SEGMENT * C + i] * m_fall[i];
+        }
+        // The next segment should carry on from where this one fades out
+        downmix(m_reference.get(), in + SEGMENT * C, SEGMENT);
+        m_havePrevious = true;
+        m_segment++;
+
+        m_outputFrames += SEGMENT;
+        int drop = std::min(m_discard, m_outputFrames);
+        m_outputRead += drop;
+        m_outputFrames -= drop;
+        m_discard -= drop;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+// Pitch-preserving time-stretch (WSOLA) for interleaved stereo float at
+// 48 kHz, streaming: push() source audio in, pull() stretched audio out.
+//
+// Output is cut into SEGMENT-frame hops, each crossfaded over the one before.
+// Segment k nominally comes from input frame anchor + k * SEGMENT * speed;
+// the actual start is moved by up to SEEK frames to where the input best
+// continues the previous segment's waveform (normalized cross-correlation
+// on a mono downmix, coarse then fine). So output frame n plays input frame
+// anchor + n * speed, to within SEEK.
+//
+// The segment grid hangs off the anchor, not off where playback started,
+// and nothing before the anchor is used: the stretch starts afresh at
+// segment 0, so any run that plays from the anchor on gives the same
+// output. After a seek past it, a few segments before the wanted one are
+// stretched and thrown away to settle the search, which usually lands on
+// the same offsets as a run that played through.
+//
+// All memory is allocated by the constructor; push() and pull() are
+// real-time safe.
+class TimeStretch {
+public:
+    static constexpr int CHANNELS = 2;
+    static constexpr int SEGMENT = 960;         // 20 ms hop
+    static constexpr int SEEK = 480;            // +-10 ms search
+    static constexpr int WARMUP_SEGMENTS = 8;
+    static constexpr double MIN_SPEED = 0.25;
+    static constexpr double MAX_SPEED = 4.0;
+
+    TimeStretch();
+    ~TimeStretch();
+
+    // Start over at `speed`, lining output frame 0 up with input frame
+    // `anchor`. Input and output positions are in frames throughout.
+    void reset(double speed, int64_t anchor);
+
+    // Output will start at `outputFrame` (>= 0); returns the input frame
+    // the following push()es must start from.
+    int64_t seekOutput(int64_t outputFrame);
+
+    // Input will start at `inputFrame`, wherever that falls; returns the
+    // output frame the first pull() starts at (>= 0: earlier input is
+    // skipped).
+    int64_t beginInput(int64_t inputFrame);
+
+    // Append contiguous input; returns the frames taken (fewer once the
+    // output backs up: pull() and push the rest).
+    int push(const float* in, int frames);
+
+    // Copy out up to `frames` stretched frames; returns how many.
+    int pull(float* out, int frames);
+
+    int available() const { return m_outputFrames; }
+    int64_t nextOutputFrame() const { return m_nextOutput; }
+    int64_t nextInputFrame() const { return m_inputStart + m_inputFrames; }
+    double getSpeed() const { return m_speed; }
+    int64_t getAnchor() const { return m_anchor; }
+
+private:
+    static constexpr int INPUT_CAPACITY = 8192;
+    static constexpr int OUTPUT_CAPACITY = 4 * SEGMENT;
+    static constexpr int COARSE_STEP = 8;
+
+    int64_t nominalStart(int64_t segment) const;
+    int64_t lowestInput(int64_t segment) const;
+    void discardInput();
+    void process();
+    int findOffset(int64_t start, int lo, int hi);
+
+    double m_speed = 1.0;
+    int64_t m_anchor = 0;
+    int64_t m_segment = 0;       // next to stretch
+    bool m_havePrevious = false;
+    int m_discard = 0;           // output frames still to drop (warm-up)
+    int64_t m_nextOutput = 0;
+
+    std::unique_ptr<float[]> m_input;   // frames [m_inputStart, +m_inputFrames)
+    int64_t m_inputStart = 0;
+    int m_inputFrames = 0;
+
+    std::unique_ptr<float[]> m_output;  // frames [m_outputRead, +m_outputFrames)
+    int m_outputRead = 0;
+    int m_outputFrames = 0;
+
+    std::unique_ptr<float[]> m_tail;    // previous segment's fading half
+    std::unique_ptr<float[]> m_rise;    // crossfade, per sample
+    std::unique_ptr<float[]> m_fall;
+    std::unique_ptr<float[]> m_reference;  // mono, what the next segment should continue
+    std::unique_ptr<float[]> m_mono;       // mono, the search range
+};
@@ -14,7 +14,8 @@ VideoDecoder::~VideoDecoder() {
     if (m_codecCtx) avcodec_free_context(&m_codecCtx);
 }
 
-bool VideoDecoder::init(AVCodecParameters* codecPar, AVRational timeBase, AVRational frameRate) {
+bool VideoDecoder::init(AVCodecParameters* codecPar, AVRational timeBase, AVRational frameRate,
+                        bool yuvOutput) {
     const AVCodec* codec = avcodec_find_decoder(codecPar->codec_id);
     if (!codec) {
         fprintf(stderr, "Unsupported video codec\n");
@@ -41,9 +42,34 @@ bool VideoDecoder::init(AVCodecParameters* codecPar, AVRational timeBase, AVRati
     fprintf(stderr, "Video: %dx%d, %.2f fps, time_base=%d/%d\n",
             m_width, m_height, m_frameRate, timeBase.num, timeBase.den);
 
+    AVPixelFormat srcFmt = m_codecCtx->pix_fmt;
+    m_outputFormat = yuvOutput ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_RGBA;
+
+    if (yuvOutput) {
+        // Matrix: tagged colorspace, else the usual SD/HD guess
+        switch (m_codecCtx->colorspace) {
+            case AVCOL_SPC_BT709:      m_kr = 0.2126f; m_kb = 0.0722f; break;
+            case AVCOL_SPC_BT2020_NCL: m_kr = 0.2627f; m_kb = 0.0593f; break;
+            case AVCOL_SPC_BT470BG:
+            case AVCOL_SPC_SMPTE170M:  m_kr = 0.299f;  m_kb = 0.114f;  break;
+            default:
+                if (m_height >= 720) { m_kr = 0.2126f; m_kb = 0.0722f; }
+                else                 { m_kr = 0.299f;  m_kb = 0.114f;  }
+                break;
+        }
+
+        if (srcFmt == AV_PIX_FMT_YUV420P || srcFmt == AV_PIX_FMT_YUVJ420P) {
+            m_fullRange = (srcFmt == AV_PIX_FMT_YUVJ420P) ||
+                          (m_codecCtx->color_range == AVCOL_RANGE_JPEG);
+            return true;  // planes are copied straight into the slot
+        }
+        // sws produces limited-range yuv420p
+        m_fullRange = false;
+    }
+
     m_swsCtx = sws_getContext(
-        m_width, m_height, m_codecCtx->pix_fmt,
-        m_width, m_height, AV_PIX_FMT_RGBA,
+        m_width, m_height, srcFmt,
+        m_width, m_height, m_outputFormat,
         SWS_BILINEAR, nullptr, nullptr, nullptr
     );
     if (!m_swsCtx) {
@@ -98,12 +124,22 @@ void VideoDecoder::decodeLoop(PacketQueue& packetQueue, FrameQueue& frameQueue)
             uint8_t* dst = frameQueue.getWriteBuffer(dstLinesize);
             if (!dst) { av_frame_unref(decoded); break; } // aborted
 
-            // Scale directly into the queue's slot buffer
-            uint8_t* dstPlanes[1] = {dst};
-            int dstStrides[1] = {dstLinesize};
-            g_stats.decoderSwsScaleCalls++;
-            sws_scale(m_swsCtx, decoded->data, decoded->linesize,
-                      0, m_height, dstPlanes, dstStrides);
+            // Scale (or copy planes) directly into the queue's slot buffer
+            uint8_t* dstPlanes[4] = {dst};
+            int dstStrides[4] = {dstLinesize};
+            if (m_outputFormat != AV_PIX_FMT_RGBA) {
+                av_image_fill_arrays(dstPlanes, dstStrides, dst, m_outputFormat,
+                                     m_width, m_height, 1);
+            }
+            if (m_swsCtx) {
+                g_stats.decoderSwsScaleCalls++;
+                sws_scale(m_swsCtx, decoded->data, decoded->linesize,
+                          0, m_height, dstPlanes, dstStrides);
+            } else {
+                av_image_copy(dstPlanes, dstStrides,
+                              const_cast<const uint8_t**>(decoded->data), decoded->linesize,
+                              m_outputFormat, m_width, m_height);
+            }
 
             int64_t pts = decoded->pts;
             if (pts == AV_NOPTS_VALUE)
@@ -15,7 +15,10 @@ class VideoDecoder {
 public:
     ~VideoDecoder();
 
-    bool init(AVCodecParameters* codecPar, AVRational timeBase, AVRational frameRate);
+    // yuvOutput: emit packed YUV 4:2:0 planes instead of RGBA, so the GPU
+    // does the colour conversion. 4:2:0 sources are copied without sws.
+    bool init(AVCodecParameters* codecPar, AVRational timeBase, AVRational frameRate,
+              bool yuvOutput = false);
     void start(PacketQueue& packetQueue, FrameQueue& frameQueue);
     void stop();
 
@@ -24,12 +27,22 @@ public:
     AVRational getTimeBase() const { return m_timeBase; }
     double getFrameRate() const { return m_frameRate; }
     AVCodecContext* getCodecContext() const { return m_codecCtx; }
+    AVPixelFormat getOutputFormat() const { return m_outputFormat; }
+
+    // Y'CbCr colour metadata of the output (YUV output only)
+    float getLumaKr() const { return m_kr; }
+    float getLumaKb() const { return m_kb; }
+    bool isFullRange() const { return m_fullRange; }
 
 private:
     void decodeLoop(PacketQueue& packetQueue, FrameQueue& frameQueue);
 
     AVCodecContext* m_codecCtx = nullptr;
-    SwsContext* m_swsCtx = nullptr;
+    SwsContext* m_swsCtx = nullptr;      // null when planes are copied as-is
+    AVPixelFormat m_outputFormat = AV_PIX_FMT_RGBA;
+    float m_kr = 0.299f;
+    float m_kb = 0.114f;
+    bool m_fullRange = false;
     AVRational m_timeBase{};
     int m_width = 0;
     int m_height = 0;
@@ -0,0 +1,228 @@
+#include "media/WaveformPeaks.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Min, max and sum of squares of a block of samples
+static void blockStats(const float* x, size_t n, float& outMin, float& outMax, double& outSumSq) {
+    size_t i = 0;
+    float mn = 0.0f, mx = 0.0f;
+    double sumSq = 0.0;
+    if (n > 0) mn = mx = x[0];
+
+#if defined(__SSE2__)
+    if (n >= 8) {
+        __m128 vmin = _mm_loadu_ps(x), vmax = vmin;
+        __m128 vsum0 = _mm_setzero_ps(), vsum1 = _mm_setzero_ps();
+        for (; i + 8 <= n; i += 8) {
+            __m128 a = _mm_loadu_ps(x + i);
+            __m128 b = _mm_loadu_ps(x + i + 4);
+            vmin = _mm_min_ps(vmin, _mm_min_ps(a, b));
+            vmax = _mm_max_ps(vmax, _mm_max_ps(a, b));
+            vsum0 = _mm_add_ps(vsum0, _mm_mul_ps(a, a));
+            vsum1 = _mm_add_ps(vsum1, _mm_mul_ps(b, b));
+        }
+        alignas(16) float lanesMin[4], lanesMax[4], lanesSum[4];
+        _mm_store_ps(lanesMin, vmin);
+        _mm_store_ps(lanesMax, vmax);
+        _mm_store_ps(lanesSum, _mm_add_ps(vsum0, vsum1));
+        for (int l = 0; l < 4; l++) {
+            mn = std::min(mn, lanesMin[l]);
+            mx = std::max(mx, lanesMax[l]);
+            sumSq += lanesSum[l];
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        mn = std::min(mn, x[i]);
+        mx = std::max(mx, x[i]);
+        sumSq += static_cast<double>(x[i]) * x[i];
+    }
+    outMin = mn;
+    outMax = mx;
+    outSumSq = sumSq;
+}
+
+static int16_t toPeak(float v) {
+    return static_cast<int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
+
+static uint16_t toRms(double v) {
+    return static_cast<uint16_t>(std::lround(std::clamp(v, 0.0, 1.0) * 65535.0));
+}
+
+int64_t WaveformPeaks::samplesPerBin(int level) {
+    int64_t n = BASE_SAMPLES_PER_BIN;
+    for (int i = 0; i < level; i++) n *= LEVEL_FACTOR;
+    return n;
+}
+
+bool WaveformPeaks::query(double from, double to, float& min, float& max, float& rms) const {
+    if (m_levels.empty() || m_sampleRate <= 0) return false;
+    double s0 = std::max(from, 0.0) * m_sampleRate;
+    double s1 = std::min(to * m_sampleRate, static_cast<double>(m_sampleCount));
+    if (s1 <= s0) return false;
+
+    // Coarsest level whose bins are no wider than the range
+    int level = 0;
+    while (level + 1 < getLevelCount() && samplesPerBin(level + 1) <= s1 - s0) level++;
+
+    const auto& bins = m_levels[level];
+    double spb = static_cast<double>(samplesPerBin(level));
+    size_t b0 = static_cast<size_t>(s0 / spb);
+    size_t b1 = std::max(b0 + 1, static_cast<size_t>(std::ceil(s1 / spb)));
+    b1 = std::min(b1, bins.size());
+    if (b0 >= b1) return false;
+
+    int mn = bins[b0].min, mx = bins[b0].max;
+    double sumSq = 0.0;
+    for (size_t b = b0; b < b1; b++) {
+        mn = std::min<int>(mn, bins[b].min);
+        mx = std::max<int>(mx, bins[b].max);
+        double r = bins[b].rms / 65535.0;
+        sumSq += r * r;
+    }
+    min = mn / 32767.0f;
+    max = mx / 32767.0f;
+    rms = static_cast<float>(std::sqrt(sumSq / (b1 - b0)));
+    return true;
+}
+
+// File: "VEPK", uint32 version, int32 sample rate, int64 sample count,
+// int32 level count, then per level a uint64 bin count and the bins
+static constexpr uint32_t PEAK_FILE_VERSION = 2;  // 2: levels up to one bin
+
+bool WaveformPeaks::save(const std::string& path) const {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+
+    int32_t levelCount = getLevelCount();
+    bool ok = fwrite("VEPK", 1, 4, f) == 4 &&
+              fwrite(&PEAK_FILE_VERSION, sizeof(uint32_t), 1, f) == 1 &&
+              fwrite(&m_sampleRate, sizeof(int32_t), 1, f) == 1 &&
+              fwrite(&m_sampleCount, sizeof(int64_t), 1, f) == 1 &&
+              fwrite(&levelCount, sizeof(int32_t), 1, f) == 1;
+    for (const auto& bins : m_levels) {
+        if (!ok) break;
+        uint64_t count = bins.size();
+        ok = fwrite(&count, sizeof(uint64_t), 1, f) == 1 &&
+             fwrite(bins.data(), sizeof(PeakBin), bins.size(), f) == bins.size();
+    }
+    ok = (fclose(f) == 0) && ok;
+    return ok;
+}
+
+std::shared_ptr<WaveformPeaks> WaveformPeaks::load(const std::string& path) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return nullptr;
+
+    auto peaks = std::make_shared<WaveformPeaks>();
+    char magic[4];
+    uint32_t version = 0;
+    int32_t levelCount = 0;
+    bool ok = fread(magic, 1, 4, f) == 4 && memcmp(magic, "VEPK", 4) == 0 &&
+              fread(&version, sizeof(uint32_t), 1, f) == 1 && version == PEAK_FILE_VERSION &&
+              fread(&peaks->m_sampleRate, sizeof(int32_t), 1, f) == 1 && peaks->m_sampleRate > 0 &&
+              fread(&peaks->m_sampleCount, sizeof(int64_t), 1, f) == 1 && peaks->m_sampleCount >= 0 &&
+              fread(&levelCount, sizeof(int32_t), 1, f) == 1 &&
+              levelCount > 0 && levelCount <= MAX_LEVELS;
+    for (int32_t l = 0; ok && l < levelCount; l++) {
+        uint64_t count = 0;
+        int64_t expected = (peaks->m_sampleCount + samplesPerBin(l) - 1) / samplesPerBin(l);
+        ok = fread(&count, sizeof(uint64_t), 1, f) == 1 && count == static_cast<uint64_t>(expected);
+        if (!ok) break;
+        auto& bins = peaks->m_levels.emplace_back(count);
+        ok = fread(bins.data(), sizeof(PeakBin), count, f) == count;
+    }
+    fclose(f);
+    return ok ? peaks : nullptr;
+}
+
+WaveformPeaksBuilder::WaveformPeaksBuilder(int sampleRate)
+    : m_peaks(std::make_shared<WaveformPeaks>()) {
+    m_peaks->m_sampleRate = sampleRate;
+    m_peaks->m_levels.resize(1);
+    m_partial.reserve(WaveformPeaks::BASE_SAMPLES_PER_BIN);
+}
+
+void WaveformPeaksBuilder::append(const float* samples, size_t count) {
+    const size_t binSize = WaveformPeaks::BASE_SAMPLES_PER_BIN;
+    m_peaks->m_sampleCount += static_cast<int64_t>(count);
+
+    if (!m_partial.empty()) {
+        size_t take = std::min(count, binSize - m_partial.size());
+        m_partial.insert(m_partial.end(), samples, samples + take);
+        samples += take;
+        count -= take;
+        if (m_partial.size() < binSize) return;
+        addBin(m_partial.data(), binSize);
+        m_partial.clear();
+    }
+
+    // Whole bins straight from the caller's buffer
+    for (; count >= binSize; samples += binSize, count -= binSize) {
+        addBin(samples, binSize);
+    }
+    m_partial.assign(samples, samples + count);
+}
+
+void WaveformPeaksBuilder::addBin(const float* samples, size_t count) {
+    float mn, mx;
+    double sumSq;
+    blockStats(samples, count, mn, mx, sumSq);
+    double meanSq = sumSq / count;
+    m_peaks->m_levels[0].push_back({toPeak(mn), toPeak(mx), toRms(std::sqrt(meanSq))});
+    m_meanSquares.push_back(static_cast<float>(meanSq));
+}
+
+std::shared_ptr<WaveformPeaks> WaveformPeaksBuilder::finish() {
+    if (!m_partial.empty()) {
+        addBin(m_partial.data(), m_partial.size());
+        m_partial.clear();
+    }
+
+    // Each level merges LEVEL_FACTOR bins of the one below. RMS is merged
+    // from level-0 mean squares, weighted by sample count, so it stays exact.
+    auto& levels = m_peaks->m_levels;
+    int64_t total = m_peaks->m_sampleCount;
+    const int64_t base = WaveformPeaks::BASE_SAMPLES_PER_BIN;
+    while (levels.back().size() > 1) {
+        int level = static_cast<int>(levels.size());
+        const auto& below = levels.back();
+        int64_t span = WaveformPeaks::samplesPerBin(level) / base;  // level-0 bins per bin
+        std::vector<PeakBin> bins((below.size() + WaveformPeaks::LEVEL_FACTOR - 1) / WaveformPeaks::LEVEL_FACTOR);
+
+        for (size_t b = 0; b < bins.size(); b++) {
+            size_t first = b * WaveformPeaks::LEVEL_FACTOR;
+            size_t last = std::min(first + WaveformPeaks::LEVEL_FACTOR, below.size());
+            PeakBin out = below[first];
+            for (size_t i = first + 1; i < last; i++) {
+                out.min = std::min(out.min, below[i].min);
+                out.max = std::max(out.max, below[i].max);
+            }
+
+            size_t z0 = b * span;
+            size_t z1 = std::min(z0 + span, m_meanSquares.size());
+            double sumSq = 0.0;
+            int64_t samples = 0;
+            for (size_t z = z0; z < z1; z++) {
+                int64_t n = std::min<int64_t>(base, total - static_cast<int64_t>(z) * base);
+                sumSq += static_cast<double>(m_meanSquares[z]) * n;
+                samples += n;
+            }
+            out.rms = toRms(samples > 0 ? std::sqrt(sumSq / samples) : 0.0);
+            bins[b] = out;
+        }
+        levels.push_back(std::move(bins));
+    }
+
+    m_meanSquares.clear();
+    return std::exchange(m_peaks, nullptr);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Summary of BASE_SAMPLES_PER_BIN * LEVEL_FACTOR^level mono samples
+struct PeakBin {
+    int16_t min = 0;   // -32767..32767 = -1..1
+    int16_t max = 0;
+    uint16_t rms = 0;  // 0..65535 = 0..1
+};
+
+// Min/max/RMS pyramid of an audio stream for drawing waveforms.
+//
+// Level 0 summarizes every BASE_SAMPLES_PER_BIN samples and each level above
+// merges LEVEL_FACTOR bins of the one below, up to a single bin for the
+// whole stream. Any zoom is then served by a level with at most LEVEL_FACTOR
+// bins per pixel: drawing costs O(visible pixels) however long the
+// recording. An hour at 48 kHz is about 5 MB in total.
+class WaveformPeaks {
+public:
+    static constexpr int BASE_SAMPLES_PER_BIN = 256;
+    static constexpr int LEVEL_FACTOR = 4;
+    // Enough for any int64 sample count; only bounds what load() accepts
+    static constexpr int MAX_LEVELS = 28;
+
+    int getSampleRate() const { return m_sampleRate; }
+    int64_t getSampleCount() const { return m_sampleCount; }
+    int getLevelCount() const { return static_cast<int>(m_levels.size()); }
+    const std::vector<PeakBin>& getLevel(int level) const { return m_levels[level]; }
+    static int64_t samplesPerBin(int level);
+
+    // Peaks over source seconds [from, to), normalized to -1..1 (rms 0..1).
+    // False if the range lies outside the stream.
+    bool query(double from, double to, float& min, float& max, float& rms) const;
+
+    // Compact sidecar file ("VEPK"); load returns null on any mismatch
+    bool save(const std::string& path) const;
+    static std::shared_ptr<WaveformPeaks> load(const std::string& path);
+
+private:
+    friend class WaveformPeaksBuilder;
+
+    int m_sampleRate = 0;
+    int64_t m_sampleCount = 0;
+    std::vector<std::vector<PeakBin>> m_levels;
+};
+
+// Builds WaveformPeaks from a stream of mono float samples. Single use:
+// finish() hands over the result.
+class WaveformPeaksBuilder {
+public:
+    explicit WaveformPeaksBuilder(int sampleRate);
+
+    void append(const float* samples, size_t count);
+    std::shared_ptr<WaveformPeaks> finish();
+
+private:
+    void addBin(const float* samples, size_t count);
+
+    std::shared_ptr<WaveformPeaks> m_peaks;
+    std::vector<float> m_partial;   // samples of the unfinished level-0 bin
+    std::vector<float> m_meanSquares;  // level 0, exact RMS source for the levels above
+};
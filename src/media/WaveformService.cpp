@@ -0,0 +1,186 @@
+#include "media/WaveformService.h"
+#include "media/MediaCache.h"
+#include <filesystem>
+#include <vector>
+#include <cstdio>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswresample/swresample.h>
+}
+
+namespace fs = std::filesystem;
+
+WaveformService::~WaveformService() {
+    shutdown();
+}
+
+void WaveformService::start(const std::string& cacheDir) {
+    shutdown();
+    m_abort.store(false);
+    m_cacheDir = cacheDir.empty() ? mediaCacheDir("waveforms") : cacheDir;
+    m_worker = std::thread(&WaveformService::workerLoop, this);
+}
+
+void WaveformService::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_abort.store(true);
+        // Unbuilt assets may be requested again after a restart
+        for (const auto& job : m_jobs) m_requested.erase(job.assetId);
+        m_jobs.clear();
+    }
+    m_cond.notify_all();
+    if (m_worker.joinable()) m_worker.join();
+}
+
+std::shared_ptr<const WaveformPeaks> WaveformService::get(uint32_t assetId, const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_ready.find(assetId);
+        if (it != m_ready.end()) return it->second;
+        if (!m_worker.joinable() || !m_requested.insert(assetId).second) return nullptr;
+        m_jobs.push_back({assetId, path});
+    }
+    m_cond.notify_one();
+    return nullptr;
+}
+
+void WaveformService::setPaused(bool paused) {
+    if (m_paused.exchange(paused) && !paused) {
+        m_cond.notify_all();
+    }
+}
+
+bool WaveformService::waitWhilePaused() {
+    if (!m_paused.load()) return !m_abort.load();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait(lock, [this] { return m_abort.load() || !m_paused.load(); });
+    return !m_abort.load();
+}
+
+void WaveformService::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this] {
+                return m_abort.load() || (!m_paused.load() && !m_jobs.empty());
+            });
+            if (m_abort.load()) return;
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        std::string key = m_cacheDir.empty() ? std::string() : mediaCacheKey(job.path);
+        std::string file = key.empty() ? std::string() : m_cacheDir + "/" + key + ".peaks";
+
+        std::shared_ptr<WaveformPeaks> peaks;
+        if (!file.empty()) peaks = WaveformPeaks::load(file);
+        if (!peaks) {
+            peaks = build(job.path);
+            if (peaks && !file.empty()) {
+                // Write then rename, so a half-written file is never loaded
+                std::error_code ec;
+                fs::create_directories(m_cacheDir, ec);
+                std::string tmp = file + ".tmp";
+                if (!ec && peaks->save(tmp)) fs::rename(tmp, file, ec);
+                else fs::remove(tmp, ec);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_abort.load()) {
+            // Possibly cut short; let a restarted service build it again
+            m_requested.erase(job.assetId);
+            return;
+        }
+        // A failed asset stays requested, so it isn't retried every frame
+        if (peaks) m_ready[job.assetId] = std::move(peaks);
+    }
+}
+
+std::shared_ptr<WaveformPeaks> WaveformService::build(const std::string& path) {
+    AVFormatContext* fmt = nullptr;
+    AVCodecContext* codec = nullptr;
+    SwrContext* swr = nullptr;
+    AVPacket* pkt = nullptr;
+    AVFrame* frame = nullptr;
+    std::shared_ptr<WaveformPeaks> result;
+
+    auto cleanup = [&]() {
+        if (frame) av_frame_free(&frame);
+        if (pkt) av_packet_free(&pkt);
+        if (swr) swr_free(&swr);
+        if (codec) avcodec_free_context(&codec);
+        if (fmt) avformat_close_input(&fmt);
+    };
+
+    if (avformat_open_input(&fmt, path.c_str(), nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(fmt, nullptr) < 0) {
+        fprintf(stderr, "WaveformService: cannot open %s\n", path.c_str());
+        cleanup();
+        return nullptr;
+    }
+
+    int stream = av_find_best_stream(fmt, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    const AVCodec* dec = stream >= 0 ? avcodec_find_decoder(fmt->streams[stream]->codecpar->codec_id) : nullptr;
+    if (!dec) {
+        cleanup();
+        return nullptr;
+    }
+    for (unsigned i = 0; i < fmt->nb_streams; i++) {
+        if (static_cast<int>(i) != stream) fmt->streams[i]->discard = AVDISCARD_ALL;
+    }
+
+    codec = avcodec_alloc_context3(dec);
+    avcodec_parameters_to_context(codec, fmt->streams[stream]->codecpar);
+    AVChannelLayout mono = AV_CHANNEL_LAYOUT_MONO;
+    if (avcodec_open2(codec, dec, nullptr) < 0 ||
+        swr_alloc_set_opts2(&swr, &mono, AV_SAMPLE_FMT_FLT, codec->sample_rate,
+                            &codec->ch_layout, codec->sample_fmt, codec->sample_rate,
+                            0, nullptr) < 0 ||
+        swr_init(swr) < 0) {
+        fprintf(stderr, "WaveformService: cannot decode audio from %s\n", path.c_str());
+        cleanup();
+        return nullptr;
+    }
+
+    pkt = av_packet_alloc();
+    frame = av_frame_alloc();
+    WaveformPeaksBuilder builder(codec->sample_rate);
+    std::vector<float> mixed;
+
+    auto drainDecoder = [&]() {
+        while (avcodec_receive_frame(codec, frame) == 0) {
+            // Same rate in and out, so only the resampler's small delay is added
+            int capacity = frame->nb_samples + 256;
+            if (mixed.size() < static_cast<size_t>(capacity)) mixed.resize(capacity);
+            uint8_t* out = reinterpret_cast<uint8_t*>(mixed.data());
+            int n = swr_convert(swr, &out, capacity,
+                                const_cast<const uint8_t**>(frame->extended_data), frame->nb_samples);
+            if (n > 0) builder.append(mixed.data(), n);
+            av_frame_unref(frame);
+        }
+    };
+
+    while (waitWhilePaused() && av_read_frame(fmt, pkt) >= 0) {
+        if (pkt->stream_index == stream && avcodec_send_packet(codec, pkt) >= 0) {
+            drainDecoder();
+        }
+        av_packet_unref(pkt);
+    }
+
+    if (!m_abort.load()) {
+        avcodec_send_packet(codec, nullptr);
+        drainDecoder();
+        uint8_t* out = reinterpret_cast<uint8_t*>(mixed.data());
+        int n = mixed.empty() ? 0 : swr_convert(swr, &out, static_cast<int>(mixed.size()), nullptr, 0);
+        if (n > 0) builder.append(mixed.data(), n);
+        result = builder.finish();
+    }
+
+    cleanup();
+    return result;
+}
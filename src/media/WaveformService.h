@@ -0,0 +1,56 @@
+#pragma once
+
+#include "media/WaveformPeaks.h"
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+// Builds waveform peaks for audio assets on a background thread.
+//
+// Each asset's audio is decoded once, downmixed to mono at its own sample
+// rate, and summarized into a WaveformPeaks pyramid that is saved as a
+// sidecar peak file in the media cache; later sessions just load that file.
+class WaveformService {
+public:
+    ~WaveformService();
+
+    // cacheDir empty = the "waveforms" media cache directory
+    void start(const std::string& cacheDir = "");
+    void shutdown();
+
+    // Peaks of an asset, or null while they're being built (the first call
+    // queues the build). Main thread, non-blocking.
+    std::shared_ptr<const WaveformPeaks> get(uint32_t assetId, const std::string& path);
+
+    // While paused, the worker stops between packets
+    void setPaused(bool paused);
+
+private:
+    struct Job {
+        uint32_t assetId = 0;
+        std::string path;
+    };
+
+    void workerLoop();
+    std::shared_ptr<WaveformPeaks> build(const std::string& path);
+    bool waitWhilePaused();  // false once aborted
+
+    std::string m_cacheDir;
+    std::thread m_worker;
+
+    std::deque<Job> m_jobs;
+    std::unordered_set<uint32_t> m_requested;  // queued, building, done or failed
+    std::unordered_map<uint32_t, std::shared_ptr<const WaveformPeaks>> m_ready;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    std::atomic<bool> m_paused{false};
+    std::atomic<bool> m_abort{false};
+};
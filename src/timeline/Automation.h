@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numbers>
+#include <utility>
+#include <vector>
+
+// One keyframe. Times are timeline seconds on a track, and seconds from the
+// clip's start on a clip (so automation moves with the clip).
+struct AutomationPoint {
+    double time = 0.0;
+    float value = 0.0f;
+
+    bool operator==(const AutomationPoint&) const = default;
+};
+
+// Keyframed value, linear between points and held flat before the first
+// and after the last. The points are immutable and shared: copying a curve
+// is a pointer copy, and editing replaces the whole list, so a copy taken
+// for the mixer stays valid while the UI edits the original.
+class AutomationCurve {
+public:
+    AutomationCurve() = default;
+    explicit AutomationCurve(std::vector<AutomationPoint> points) { setPoints(std::move(points)); }
+
+    bool empty() const { return !m_points || m_points->empty(); }
+
+    const std::vector<AutomationPoint>& points() const {
+        static const std::vector<AutomationPoint> none;
+        return m_points ? *m_points : none;
+    }
+
+    // Replace every point; sorted by time here
+    void setPoints(std::vector<AutomationPoint> points) {
+        std::stable_sort(points.begin(), points.end(),
+                         [](const AutomationPoint& a, const AutomationPoint& b) { return a.time < b.time; });
+        m_points = points.empty() ? nullptr
+                                  : std::make_shared<const std::vector<AutomationPoint>>(std::move(points));
+    }
+
+    // Value at `time`, or `fallback` without points. O(log k).
+    float evaluate(double time, float fallback) const {
+        if (empty()) return fallback;
+        const auto& points = *m_points;
+        auto next = std::upper_bound(points.begin(), points.end(), time,
+                                     [](double t, const AutomationPoint& p) { return t < p.time; });
+        if (next == points.begin()) return points.front().value;
+        if (next == points.end()) return points.back().value;
+        auto prev = next - 1;
+        double span = next->time - prev->time;
+        if (span <= 0.0) return next->value;
+        double x = (time - prev->time) / span;
+        return prev->value + static_cast<float>(x) * (next->value - prev->value);
+    }
+
+    // Points with from < time < to, as an iterator range. O(log k).
+    std::pair<std::vector<AutomationPoint>::const_iterator, std::vector<AutomationPoint>::const_iterator>
+    pointsBetween(double from, double to) const {
+        const auto& all = points();
+        auto less = [](const AutomationPoint& p, double t) { return p.time < t; };
+        auto first = std::upper_bound(all.begin(), all.end(), from,
+                                      [](double t, const AutomationPoint& p) { return t < p.time; });
+        auto last = std::lower_bound(first, all.end(), to, less);
+        return {first, last};
+    }
+
+    bool operator==(const AutomationCurve& other) const { return points() == other.points(); }
+
+private:
+    std::shared_ptr<const std::vector<AutomationPoint>> m_points;
+};
+
+enum class AutomationParam {
+    Volume,  // gain, 0 - 1, multiplied into the static volume
+    Pan      // -1 (left) - 1 (right), replaces the static pan
+};
+
+namespace Automation {
+
+// Equal-power fade gain, 0 at x = 0 to 1 at x = 1. A fade-out and a
+// fade-in over the same span keep the summed power of unrelated material
+// steady, which is what makes an overlap of two faded clips a crossfade.
+inline float fadeGain(double x) {
+    if (x <= 0.0) return 0.0f;
+    if (x >= 1.0) return 1.0f;
+    return static_cast<float>(std::sin(x * std::numbers::pi / 2.0));
+}
+
+// Stereo balance: the far side is attenuated, centre is unity on both
+inline void balance(float pan, float& left, float& right) {
+    pan = std::clamp(pan, -1.0f, 1.0f);
+    left = pan > 0.0f ? 1.0f - pan : 1.0f;
+    right = pan < 0.0f ? 1.0f + pan : 1.0f;
+}
+
+} // namespace Automation
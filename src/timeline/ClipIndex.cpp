@@ -0,0 +1,203 @@
+#include "timeline/ClipIndex.h"
+#include <algorithm>
+#include <cmath>
+
+void ClipIndex::insert(uint32_t clipId, double start, double end) {
+    if (m_nodeOf.count(clipId)) erase(clipId);
+
+    // After any spans with the same start, so equal starts keep insertion order
+    int left, right;
+    split(m_root, countStartsBefore(start, true), left, right);
+    int node = allocNode(clipId, start, end);
+    m_root = merge(merge(left, node), right);
+    m_nodes[m_root].parent = -1;
+}
+
+bool ClipIndex::erase(uint32_t clipId) {
+    auto it = m_nodeOf.find(clipId);
+    if (it == m_nodeOf.end()) return false;
+    int node = it->second;
+    m_nodeOf.erase(it);
+
+    int left, rest, mid, right;
+    split(m_root, rankOf(node), left, rest);
+    split(rest, 1, mid, right);
+    m_root = merge(left, right);
+    if (m_root >= 0) m_nodes[m_root].parent = -1;
+
+    m_freeNodes.push_back(mid);
+    return true;
+}
+
+void ClipIndex::assign(std::vector<ClipSpan> spans) {
+    std::stable_sort(spans.begin(), spans.end(),
+                     [](const ClipSpan& a, const ClipSpan& b) { return a.start < b.start; });
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_nodeOf.clear();
+    m_root = -1;
+    for (const auto& s : spans) {
+        m_root = merge(m_root, allocNode(s.clipId, s.start, s.end));
+    }
+    if (m_root >= 0) m_nodes[m_root].parent = -1;
+}
+
+bool ClipIndex::find(uint32_t clipId, ClipSpan& out) const {
+    auto it = m_nodeOf.find(clipId);
+    if (it == m_nodeOf.end()) return false;
+
+    const Node& n = m_nodes[it->second];
+    double acc = 0.0;
+    for (int p = n.parent; p >= 0; p = m_nodes[p].parent) {
+        acc += m_nodes[p].offset;
+    }
+    out = ClipSpan{n.start + acc, n.end + acc, clipId};
+    return true;
+}
+
+void ClipIndex::shiftFrom(double from, double delta) {
+    if (delta == 0.0) return;
+    int left, right;
+    split(m_root, countStartsBefore(from, false), left, right);
+    if (right >= 0) applyOffset(right, delta);
+    m_root = merge(left, right);
+    if (m_root >= 0) m_nodes[m_root].parent = -1;
+}
+
+uint32_t ClipIndex::clipIdAt(double time) const {
+    uint32_t found = 0;
+    // Spans ending after `time` and starting at or before it; the first
+    // visited is the first in start order
+    forEachOverlapping(time, std::nextafter(time, 1e300), [&](const ClipSpan& s) {
+        found = s.clipId;
+        return false;
+    });
+    return found;
+}
+
+int ClipIndex::allocNode(uint32_t clipId, double start, double end) {
+    // xorshift32: only needs to be cheap and well spread
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+
+    Node n;
+    n.start = n.minStart = start;
+    n.end = n.maxEnd = end;
+    n.maxLength = end - start;
+    n.clipId = clipId;
+    n.priority = m_seed;
+
+    int index;
+    if (!m_freeNodes.empty()) {
+        index = m_freeNodes.back();
+        m_freeNodes.pop_back();
+        m_nodes[index] = n;
+    } else {
+        index = static_cast<int>(m_nodes.size());
+        m_nodes.push_back(n);
+    }
+    m_nodeOf[clipId] = index;
+    return index;
+}
+
+void ClipIndex::applyOffset(int x, double delta) {
+    Node& n = m_nodes[x];
+    n.start += delta;
+    n.end += delta;
+    n.minStart += delta;
+    n.maxEnd += delta;
+    n.offset += delta;
+}
+
+void ClipIndex::push(int x) {
+    Node& n = m_nodes[x];
+    if (n.offset == 0.0) return;
+    if (n.left >= 0) applyOffset(n.left, n.offset);
+    if (n.right >= 0) applyOffset(n.right, n.offset);
+    n.offset = 0.0;
+}
+
+void ClipIndex::pull(int x) {
+    Node& n = m_nodes[x];
+    n.size = 1 + sizeOf(n.left) + sizeOf(n.right);
+    n.minStart = n.start;
+    n.maxEnd = n.end;
+    n.maxLength = n.end - n.start;
+    if (n.left >= 0) {
+        m_nodes[n.left].parent = x;
+        n.minStart = m_nodes[n.left].minStart;
+        n.maxEnd = std::max(n.maxEnd, m_nodes[n.left].maxEnd);
+        n.maxLength = std::max(n.maxLength, m_nodes[n.left].maxLength);
+    }
+    if (n.right >= 0) {
+        m_nodes[n.right].parent = x;
+        n.maxEnd = std::max(n.maxEnd, m_nodes[n.right].maxEnd);
+        n.maxLength = std::max(n.maxLength, m_nodes[n.right].maxLength);
+    }
+}
+
+void ClipIndex::split(int x, uint32_t count, int& left, int& right) {
+    if (x < 0) { left = right = -1; return; }
+    push(x);
+    Node& n = m_nodes[x];
+    if (sizeOf(n.left) < count) {
+        int a, b;
+        split(n.right, count - sizeOf(n.left) - 1, a, b);
+        m_nodes[x].right = a;
+        pull(x);
+        left = x;
+        right = b;
+    } else {
+        int a, b;
+        split(n.left, count, a, b);
+        m_nodes[x].left = b;
+        pull(x);
+        left = a;
+        right = x;
+    }
+    if (left >= 0) m_nodes[left].parent = -1;
+    if (right >= 0) m_nodes[right].parent = -1;
+}
+
+int ClipIndex::merge(int a, int b) {
+    if (a < 0) return b;
+    if (b < 0) return a;
+    if (m_nodes[a].priority > m_nodes[b].priority) {
+        push(a);
+        int r = merge(m_nodes[a].right, b);
+        m_nodes[a].right = r;
+        pull(a);
+        return a;
+    }
+    push(b);
+    int l = merge(a, m_nodes[b].left);
+    m_nodes[b].left = l;
+    pull(b);
+    return b;
+}
+
+uint32_t ClipIndex::countStartsBefore(double time, bool inclusive) const {
+    uint32_t count = 0;
+    double acc = 0.0;
+    for (int x = m_root; x >= 0;) {
+        const Node& n = m_nodes[x];
+        double start = n.start + acc;
+        acc += n.offset;
+        if (start < time || (inclusive && start == time)) {
+            count += sizeOf(n.left) + 1;
+            x = n.right;
+        } else {
+            x = n.left;
+        }
+    }
+    return count;
+}
+
+uint32_t ClipIndex::rankOf(int x) const {
+    uint32_t rank = sizeOf(m_nodes[x].left);
+    for (int p = m_nodes[x].parent; p >= 0; x = p, p = m_nodes[p].parent) {
+        if (m_nodes[p].right == x) rank += sizeOf(m_nodes[p].left) + 1;
+    }
+    return rank;
+}
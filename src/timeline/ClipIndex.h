@@ -0,0 +1,161 @@
+#pragma once
+
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// A clip's extent on the timeline.
+struct ClipSpan {
+    double start = 0.0;
+    double end = 0.0;
+    uint32_t clipId = 0;
+};
+
+// Per-track interval index over clip spans, ordered by start.
+//
+// Backed by an implicit treap whose nodes carry a pending time offset for
+// their subtree, plus the subtree's earliest start and latest end. Shifting
+// every span from some time onward (a ripple edit) splits the tree once and
+// adds the offset to one node, so it costs O(log n) regardless of how many
+// clips follow. Absolute times are recovered by summing offsets on the way
+// down (queries) or up (find), also O(log n).
+//
+// Point and range queries prune on the subtree bounds and cost O(log n + k)
+// for k results. Each node also keeps its subtree's span count and longest
+// span, so a zoomed-out view can take a run of short clips as one bucket. Nodes live in one vector addressed by index, so the index
+// is a plain value type and copies with its Track.
+//
+// The index only knows what it's told: Timeline keeps it in step with clip
+// edits (see Timeline::setClipTiming).
+class ClipIndex {
+public:
+    size_t size() const { return m_nodeOf.size(); }
+    bool empty() const { return m_nodeOf.empty(); }
+
+    void insert(uint32_t clipId, double start, double end);
+    bool erase(uint32_t clipId);
+    // Replace all spans (any order), e.g. after a bulk edit
+    void assign(std::vector<ClipSpan> spans);
+
+    // Current span of a clip; false if it isn't indexed
+    bool find(uint32_t clipId, ClipSpan& out) const;
+
+    // Move every span starting at or after `from` by delta. The caller must
+    // not move them past spans that start before `from`.
+    void shiftFrom(double from, double delta);
+
+    // First clip (in start order) containing time, or 0
+    uint32_t clipIdAt(double time) const;
+
+    // Calls fn(const ClipSpan&) for every span overlapping [from, to),
+    // in start order. fn may return bool; false stops the walk.
+    template <typename Fn>
+    void forEachOverlapping(double from, double to, Fn&& fn) const {
+        visit(m_root, 0.0, from, to, fn);
+    }
+
+    // Like forEachOverlapping, but spans shorter than minLength are reported
+    // in buckets: bucketFn(double start, double end, uint32_t count) covers
+    // `count` spans lying within [start, end]. A subtree of only short spans
+    // whose extent is under `resolution` is taken whole, so the walk costs
+    // O(log n) per resolution step rather than O(spans). spanFn gets the rest.
+    template <typename SpanFn, typename BucketFn>
+    void forEachOverlappingCoarse(double from, double to, double minLength, double resolution,
+                                  SpanFn&& spanFn, BucketFn&& bucketFn) const {
+        visitCoarse(m_root, 0.0, from, to, minLength, resolution, spanFn, bucketFn);
+    }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        visit(m_root, 0.0, -1e300, 1e300, fn);
+    }
+
+    // Latest end time of any span, 0 when empty
+    double maxEnd() const { return m_root >= 0 ? m_nodes[m_root].maxEnd : 0.0; }
+
+private:
+    // Times are exact for a node once the offsets of all its ancestors are
+    // added; `offset` is pending for the node's children only.
+    struct Node {
+        double start = 0.0;
+        double end = 0.0;
+        double minStart = 0.0;  // subtree
+        double maxEnd = 0.0;    // subtree
+        double maxLength = 0.0; // subtree, longest end - start
+        double offset = 0.0;
+        uint32_t clipId = 0;
+        uint32_t priority = 0;
+        uint32_t size = 1;
+        int left = -1;
+        int right = -1;
+        int parent = -1;
+    };
+
+    // Returns false once fn asked to stop
+    template <typename Fn>
+    bool visit(int x, double acc, double from, double to, Fn& fn) const {
+        if (x < 0) return true;
+        const Node& n = m_nodes[x];
+        if (n.maxEnd + acc <= from || n.minStart + acc >= to) return true;
+
+        double childAcc = acc + n.offset;
+        if (!visit(n.left, childAcc, from, to, fn)) return false;
+        if (n.start + acc >= to) return true;  // everything to the right starts later
+        if (n.end + acc > from) {
+            ClipSpan span{n.start + acc, n.end + acc, n.clipId};
+            if constexpr (std::is_same_v<std::invoke_result_t<Fn&, const ClipSpan&>, bool>) {
+                if (!fn(span)) return false;
+            } else {
+                fn(span);
+            }
+        }
+        return visit(n.right, childAcc, from, to, fn);
+    }
+
+    template <typename SpanFn, typename BucketFn>
+    void visitCoarse(int x, double acc, double from, double to, double minLength,
+                     double resolution, SpanFn& spanFn, BucketFn& bucketFn) const {
+        if (x < 0) return;
+        const Node& n = m_nodes[x];
+        double minStart = n.minStart + acc;
+        double maxEnd = n.maxEnd + acc;
+        if (maxEnd <= from || minStart >= to) return;
+
+        if (n.maxLength < minLength && maxEnd - minStart < resolution &&
+            minStart >= from && maxEnd <= to) {
+            bucketFn(minStart, maxEnd, n.size);
+            return;
+        }
+
+        double childAcc = acc + n.offset;
+        visitCoarse(n.left, childAcc, from, to, minLength, resolution, spanFn, bucketFn);
+        if (n.start + acc >= to) return;
+        if (n.end + acc > from) {
+            ClipSpan span{n.start + acc, n.end + acc, n.clipId};
+            if (n.end - n.start >= minLength) {
+                spanFn(span);
+            } else {
+                bucketFn(span.start, span.end, 1u);
+            }
+        }
+        visitCoarse(n.right, childAcc, from, to, minLength, resolution, spanFn, bucketFn);
+    }
+
+    int allocNode(uint32_t clipId, double start, double end);
+    uint32_t sizeOf(int x) const { return x >= 0 ? m_nodes[x].size : 0; }
+    void applyOffset(int x, double delta);
+    void push(int x);
+    void pull(int x);
+    void split(int x, uint32_t count, int& left, int& right);
+    int merge(int a, int b);
+    uint32_t countStartsBefore(double time, bool inclusive) const;
+    uint32_t rankOf(int x) const;
+
+    std::vector<Node> m_nodes;
+    std::vector<int> m_freeNodes;
+    std::unordered_map<uint32_t, int> m_nodeOf;  // clipId -> node
+    int m_root = -1;
+    uint32_t m_seed = 0x9e3779b9u;
+};
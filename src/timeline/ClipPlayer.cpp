@@ -34,7 +34,7 @@ bool ClipPlayer::open(const std::string& path, bool needVideo, bool needAudio,
         auto fr = vstream->avg_frame_rate;
 
         m_videoDecoder = new VideoDecoder();
-        if (!m_videoDecoder->init(par, tb, fr)) {
+        if (!m_videoDecoder->init(par, tb, fr, m_outputYuv)) {
             delete m_videoDecoder;
             m_videoDecoder = nullptr;
             return false;
@@ -43,15 +43,19 @@ bool ClipPlayer::open(const std::string& path, bool needVideo, bool needAudio,
         int w = m_videoDecoder->getWidth();
         int h = m_videoDecoder->getHeight();
 
-        if (!m_videoFrameQueue.allocate(w, h)) {
+        if (!m_videoFrameQueue.allocate(w, h, m_frameAllocator,
+                                        m_videoDecoder->getOutputFormat())) {
             fprintf(stderr, "ClipPlayer: failed to allocate video frame queue\n");
             delete m_videoDecoder;
             m_videoDecoder = nullptr;
             return false;
         }
 
-        int bufSize = av_image_get_buffer_size(AV_PIX_FMT_RGBA, w, h, 1);
-        m_currentFrameBuffer = (uint8_t*)av_malloc(bufSize);
+        // The copying path keeps its own display buffer for held frames
+        if (!m_frameAllocator && !m_outputYuv) {
+            int bufSize = av_image_get_buffer_size(AV_PIX_FMT_RGBA, w, h, 1);
+            m_currentFrameBuffer = (uint8_t*)av_malloc(bufSize);
+        }
         m_currentFrameWidth = w;
         m_currentFrameHeight = h;
     }
@@ -164,31 +168,12 @@ const uint8_t* ClipPlayer::getVideoFrameAtTime(double targetPts, int& width, int
     width = m_currentFrameWidth;
     height = m_currentFrameHeight;
 
-    // Peek at next frame and advance to match targetPts
-    int64_t pts;
     int linesize;
-    const uint8_t* data = m_videoFrameQueue.peek(&pts, &linesize);
-
-    if (!data) {
+    const uint8_t* data = selectFrame(targetPts, linesize);
+    if (!data || !m_currentFrameBuffer) {
         return m_currentFrameBuffer; // Hold last frame
     }
 
-    double ptsSec = pts * av_q2d(m_videoDecoder->getTimeBase());
-    double frameDuration = 1.0 / m_videoDecoder->getFrameRate();
-
-    // Skip frames that are behind the target
-    while (ptsSec < targetPts - frameDuration * 2.0) {
-        m_videoFrameQueue.pop();
-        data = m_videoFrameQueue.peek(&pts, &linesize);
-        if (!data) return m_currentFrameBuffer;
-        ptsSec = pts * av_q2d(m_videoDecoder->getTimeBase());
-    }
-
-    // If the next frame is in the future, hold current
-    if (ptsSec > targetPts + frameDuration * 0.5) {
-        return m_currentFrameBuffer;
-    }
-
     // Copy into display buffer
     int w = m_currentFrameWidth;
     int h = m_currentFrameHeight;
@@ -204,6 +189,67 @@ const uint8_t* ClipPlayer::getVideoFrameAtTime(double targetPts, int& width, int
     return m_currentFrameBuffer;
 }
 
+bool ClipPlayer::acquireVideoFrameAtTime(double targetPts, VideoFrameRef& out) {
+    if (!m_videoDecoder) return false;
+
+    int linesize;
+    const uint8_t* data = selectFrame(targetPts, linesize);
+    if (!data) return false;
+
+    out.data = data;
+    out.handle = m_videoFrameQueue.peekHandle();
+    out.width = m_currentFrameWidth;
+    out.height = m_currentFrameHeight;
+    out.linesize = linesize;
+
+    out.yuv = m_videoDecoder->getOutputFormat() != AV_PIX_FMT_RGBA;
+    if (out.yuv) {
+        uint8_t* planes[4];
+        int linesizes[4];
+        av_image_fill_arrays(planes, linesizes, data, m_videoDecoder->getOutputFormat(),
+                             out.width, out.height, 1);
+        for (int i = 0; i < 3; i++) {
+            out.planeOffset[i] = static_cast<int>(planes[i] - data);
+            out.planeLinesize[i] = linesizes[i];
+        }
+        out.kr = m_videoDecoder->getLumaKr();
+        out.kb = m_videoDecoder->getLumaKb();
+        out.fullRange = m_videoDecoder->isFullRange();
+    }
+
+    m_videoFrameQueue.popHeld();
+    m_firstFrameReceived = true;
+    return true;
+}
+
+void ClipPlayer::releaseVideoFrame() {
+    m_videoFrameQueue.releaseHeld();
+}
+
+const uint8_t* ClipPlayer::selectFrame(double targetPts, int& linesize) {
+    // Peek at next frame and advance to match targetPts
+    int64_t pts;
+    const uint8_t* data = m_videoFrameQueue.peek(&pts, &linesize);
+    if (!data) return nullptr;
+
+    double ptsSec = pts * av_q2d(m_videoDecoder->getTimeBase());
+    double frameDuration = 1.0 / m_videoDecoder->getFrameRate();
+
+    // Skip frames that are behind the target
+    while (ptsSec < targetPts - frameDuration * 2.0) {
+        m_videoFrameQueue.pop();
+        data = m_videoFrameQueue.peek(&pts, &linesize);
+        if (!data) return nullptr;
+        ptsSec = pts * av_q2d(m_videoDecoder->getTimeBase());
+    }
+
+    // If the next frame is in the future, hold current
+    if (ptsSec > targetPts + frameDuration * 0.5) {
+        return nullptr;
+    }
+    return data;
+}
+
 int ClipPlayer::getVideoWidth() const {
     return m_videoDecoder ? m_videoDecoder->getWidth() : 0;
 }
@@ -212,6 +258,10 @@ int ClipPlayer::getVideoHeight() const {
     return m_videoDecoder ? m_videoDecoder->getHeight() : 0;
 }
 
+void ClipPlayer::setAudioStretch(double speed, double anchorSeconds) {
+    if (m_audioDecoder) m_audioDecoder->setStretch(speed, anchorSeconds);
+}
+
 int ClipPlayer::getAudioSampleRate() const {
     return m_audioDecoder ? m_audioDecoder->getSampleRate() : 48000;
 }
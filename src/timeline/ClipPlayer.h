@@ -12,12 +12,37 @@
 
 class AudioDecoder;
 
+// A decoded frame still living in its FrameQueue slot (zero-copy path).
+struct VideoFrameRef {
+    const uint8_t* data = nullptr;
+    void* handle = nullptr;     // FrameSlotAllocator block handle
+    int width = 0;
+    int height = 0;
+    int linesize = 0;
+
+    // Packed YUV 4:2:0 output (see ClipPlayer::setOutputYuv)
+    bool yuv = false;
+    int planeOffset[3]{};       // bytes from data
+    int planeLinesize[3]{};
+    float kr = 0.0f;            // luma coefficients
+    float kb = 0.0f;
+    bool fullRange = false;
+};
+
 // Lightweight per-clip decoder. Wraps existing media pipeline components.
 // Driven by target source time from the master clock (no wall-clock pacing of its own).
 class ClipPlayer {
 public:
     ~ClipPlayer();
 
+    // Back the video frame queue with custom memory (e.g. mapped GPU staging
+    // buffers). Must be called before open(); the allocator must outlive us.
+    void setFrameAllocator(FrameSlotAllocator* allocator) { m_frameAllocator = allocator; }
+
+    // Decode to packed YUV 4:2:0 planes instead of RGBA (GPU converts).
+    // Only meaningful with acquireVideoFrameAtTime(). Call before open().
+    void setOutputYuv(bool yuv) { m_outputYuv = yuv; }
+
     // Open a file. Only decode the streams you need:
     //   needVideo=true  → creates video decoder pipeline
     //   needAudio=true  → creates audio decoder pipeline
@@ -32,12 +57,22 @@ public:
     void stop();
     void seek(double sourceSeconds);
 
+    // Audio for a clip played at `speed`, time-stretched from source time
+    // `anchorSeconds` on (see AudioDecoder::setStretch)
+    void setAudioStretch(double speed, double anchorSeconds);
+
     // Get the current video frame for a target source time.
     // Returns RGBA pixel data, or nullptr if no frame available.
     // Sets *isNewFrame = true if this is a newly decoded frame (not a hold).
     const uint8_t* getVideoFrameAtTime(double targetPts, int& width, int& height,
                                         bool* isNewFrame = nullptr);
 
+    // Zero-copy variant: if a new frame is due, return its queue slot
+    // directly and keep the slot reserved until releaseVideoFrame(). Returns
+    // false when the previously returned frame should still be shown.
+    bool acquireVideoFrameAtTime(double targetPts, VideoFrameRef& out);
+    void releaseVideoFrame();
+
     bool hasVideo() const { return m_videoDecoder != nullptr; }
     bool hasAudio() const { return m_audioDecoder != nullptr; }
     int getVideoWidth() const;
@@ -61,12 +96,17 @@ private:
     void demuxLoop();
     void stopThreads();
 
+    // Drop late frames and return the front frame if it's due at targetPts
+    const uint8_t* selectFrame(double targetPts, int& linesize);
+
     MediaFile m_mediaFile;
     int m_videoStreamIdx = -1;
     int m_audioStreamIdx = -1;
 
     PacketQueue m_videoPacketQueue;
     FrameQueue m_videoFrameQueue;
+    FrameSlotAllocator* m_frameAllocator = nullptr;
+    bool m_outputYuv = false;
     VideoDecoder* m_videoDecoder = nullptr;
 
     PacketQueue m_audioPacketQueue;
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Process-wide counter behind CowPtr generations and versions. It never
+// repeats, so stamps from different holders can be compared.
+inline uint64_t nextCowStamp() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Copy-on-write holder. Copying shares the underlying value in O(1); the
+// first write() while another holder still shares it clones it so the other
+// holder is unaffected.
+//
+// Sharing is decided by the storage's reference count, so once every other
+// holder is gone (a snapshot handed to another thread and dropped there)
+// writes go back to editing in place. Other holders only ever read() or
+// copy their own CowPtr, so a count of one can't go back up underneath us.
+//
+// generation() names the storage a holder points at: copies share it, and
+// each new storage (construction, or a write() that clones) takes a fresh
+// stamp, so it never comes back. Pointers into read() stay valid for as
+// long as the generation is unchanged. version() is restamped by every
+// write(), so it changes whenever the value may have.
+template <typename T>
+class CowPtr {
+public:
+    CowPtr() : m_data(std::make_shared<T>()), m_generation(nextCowStamp()), m_version(m_generation) {}
+
+    CowPtr(const CowPtr&) = default;
+    CowPtr& operator=(const CowPtr&) = default;
+    CowPtr(CowPtr&&) noexcept = default;
+    CowPtr& operator=(CowPtr&&) noexcept = default;
+
+    const T& read() const { return *m_data; }
+    uint64_t generation() const { return m_generation; }
+    uint64_t version() const { return m_version; }
+
+    T& write() {
+        m_version = nextCowStamp();
+        if (m_data.use_count() > 1) {
+            m_data = std::make_shared<T>(*m_data);
+            m_generation = m_version;
+        } else {
+            // Pairs with the release in the last other holder's drop, so its
+            // reads are done before we write
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *m_data;
+    }
+
+private:
+    std::shared_ptr<T> m_data;
+    uint64_t m_generation = 0;
+    uint64_t m_version = 0;
+};
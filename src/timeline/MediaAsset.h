@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <memory>
 
 enum class MediaType {
     Video,
@@ -27,6 +28,11 @@ struct MediaAsset {
     bool hasVideo = false;
     bool hasAudio = false;
 
-    // Image: pre-decoded RGBA pixels (decoded once at import)
-    std::vector<uint8_t> imageData;
+    // True while MediaImporter is still probing the file. Clips referencing
+    // a pending asset are placeholders and must not be played or exported.
+    bool pending = false;
+
+    // Image: pre-decoded RGBA pixels (decoded once at import). Immutable and
+    // shared, so copying an asset or a timeline snapshot never copies pixels.
+    std::shared_ptr<const std::vector<uint8_t>> imageData;
 };
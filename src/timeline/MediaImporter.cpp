@@ -0,0 +1,185 @@
+#include "timeline/MediaImporter.h"
+#include <algorithm>
+#include <cstdio>
+#include <cctype>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/dict.h>
+}
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#define STBI_ONLY_BMP
+#define STBI_ONLY_TGA
+#include "stb_image.h"
+
+MediaImporter::~MediaImporter() {
+    shutdown();
+}
+
+void MediaImporter::start(const ImportSettings& settings) {
+    shutdown();
+    m_settings = settings;
+    m_abort.store(false);
+
+    int count = settings.workerCount;
+    if (count <= 0) {
+        count = static_cast<int>(std::thread::hardware_concurrency());
+        count = std::clamp(count, 1, 8);
+    }
+    for (int i = 0; i < count; i++) {
+        m_workers.emplace_back(&MediaImporter::workerLoop, this);
+    }
+}
+
+void MediaImporter::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_abort.store(true);
+        m_jobs.clear();
+    }
+    m_jobCond.notify_all();
+    for (auto& t : m_workers) {
+        if (t.joinable()) t.join();
+    }
+    m_workers.clear();
+
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    m_results.clear();
+    m_pending.store(0);
+}
+
+void MediaImporter::enqueue(uint32_t assetId, const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_jobs.push_back({assetId, path});
+    }
+    m_pending++;
+    m_jobCond.notify_one();
+}
+
+std::vector<ImportResult> MediaImporter::takeResults() {
+    std::vector<ImportResult> out;
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    out.swap(m_results);
+    return out;
+}
+
+void MediaImporter::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_jobMutex);
+            m_jobCond.wait(lock, [this] { return !m_jobs.empty() || m_abort.load(); });
+            if (m_abort.load()) return;
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        ImportResult result;
+        result.assetId = job.assetId;
+        result.ok = probe(job.path, m_settings, result.asset, result.error);
+
+        {
+            std::lock_guard<std::mutex> lock(m_resultMutex);
+            m_results.push_back(std::move(result));
+        }
+        m_pending--;
+    }
+}
+
+bool MediaImporter::isImagePath(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) return false;
+    std::string ext = path.substr(dot);
+    for (auto& c : ext) c = std::tolower(c);
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" ||
+           ext == ".bmp" || ext == ".tga";
+}
+
+static bool probeImage(const std::string& path, MediaAsset& asset, std::string& error) {
+    int w, h, channels;
+    unsigned char* pixels = stbi_load(path.c_str(), &w, &h, &channels, 4); // Force RGBA
+    if (!pixels) {
+        error = stbi_failure_reason();
+        return false;
+    }
+
+    asset.type = MediaType::Image;
+    asset.width = w;
+    asset.height = h;
+    asset.duration = 5.0;  // Default 5-second duration for images
+    asset.hasVideo = false;
+    asset.hasAudio = false;
+
+    // Store pre-decoded RGBA pixels
+    size_t dataSize = static_cast<size_t>(w) * h * 4;
+    asset.imageData = std::make_shared<const std::vector<uint8_t>>(pixels, pixels + dataSize);
+    stbi_image_free(pixels);
+    return true;
+}
+
+bool MediaImporter::probe(const std::string& path, const ImportSettings& settings,
+                          MediaAsset& asset, std::string& error) {
+    asset.filePath = path;
+
+    if (isImagePath(path)) {
+        return probeImage(path, asset, error);
+    }
+
+    AVDictionary* opts = nullptr;
+    if (settings.probeSize > 0)
+        av_dict_set_int(&opts, "probesize", settings.probeSize, 0);
+    if (settings.analyzeDuration > 0)
+        av_dict_set_int(&opts, "analyzeduration", settings.analyzeDuration, 0);
+
+    AVFormatContext* fmt = nullptr;
+    int ret = avformat_open_input(&fmt, path.c_str(), nullptr, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        error = "could not open file";
+        return false;
+    }
+    if (avformat_find_stream_info(fmt, nullptr) < 0) {
+        avformat_close_input(&fmt);
+        error = "could not find stream info";
+        return false;
+    }
+
+    int videoIdx = -1, audioIdx = -1;
+    for (unsigned i = 0; i < fmt->nb_streams; i++) {
+        auto ct = fmt->streams[i]->codecpar->codec_type;
+        if (ct == AVMEDIA_TYPE_VIDEO && videoIdx < 0) videoIdx = i;
+        else if (ct == AVMEDIA_TYPE_AUDIO && audioIdx < 0) audioIdx = i;
+    }
+
+    if (videoIdx >= 0) {
+        auto* par = fmt->streams[videoIdx]->codecpar;
+        auto fr = fmt->streams[videoIdx]->avg_frame_rate;
+        asset.hasVideo = true;
+        asset.width = par->width;
+        asset.height = par->height;
+        asset.fps = (fr.num > 0 && fr.den > 0) ? av_q2d(fr) : 30.0;
+    }
+    if (audioIdx >= 0) {
+        auto* par = fmt->streams[audioIdx]->codecpar;
+        asset.hasAudio = true;
+        asset.sampleRate = par->sample_rate;
+        asset.channels = par->ch_layout.nb_channels;
+    }
+
+    if (fmt->duration != AV_NOPTS_VALUE) {
+        asset.duration = static_cast<double>(fmt->duration) / AV_TIME_BASE;
+    }
+
+    asset.type = asset.hasVideo ? MediaType::Video : MediaType::Audio;
+    avformat_close_input(&fmt);
+
+    if (!asset.hasVideo && !asset.hasAudio) {
+        error = "no audio or video streams";
+        return false;
+    }
+    return true;
+}
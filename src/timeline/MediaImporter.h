@@ -0,0 +1,76 @@
+#pragma once
+
+#include "timeline/MediaAsset.h"
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Tunables for the import worker pool.
+struct ImportSettings {
+    int workerCount = 0;              // 0 = one per hardware thread (capped at 8)
+
+    // First-pass probing limits handed to avformat_find_stream_info.
+    // Smaller values return faster but may miss late-starting streams.
+    int64_t probeSize = 1 << 20;      // bytes (FFmpeg default is 5 MB)
+    int64_t analyzeDuration = 0;      // microseconds, 0 = FFmpeg default
+};
+
+// Outcome of probing/decoding one file on a worker thread.
+struct ImportResult {
+    uint32_t assetId = 0;             // placeholder asset created by Timeline::beginImport
+    bool ok = false;
+    MediaAsset asset;                 // filled metadata (+ pixels for images)
+    std::string error;
+};
+
+// Probes media files and decodes still images on a pool of worker threads,
+// so dropping many files never blocks the UI thread. The main thread enqueues
+// placeholder asset IDs and collects finished results once per frame.
+class MediaImporter {
+public:
+    ~MediaImporter();
+
+    void start(const ImportSettings& settings = {});
+    void shutdown();
+
+    // Queue a file for probing. assetId is echoed back in the result.
+    void enqueue(uint32_t assetId, const std::string& path);
+
+    // Move all finished results out (main thread, non-blocking).
+    std::vector<ImportResult> takeResults();
+
+    // Jobs queued or in flight
+    size_t pendingCount() const { return m_pending.load(); }
+
+    // Synchronous probe used by the workers. Thread-safe.
+    static bool probe(const std::string& path, const ImportSettings& settings,
+                      MediaAsset& out, std::string& error);
+
+    static bool isImagePath(const std::string& path);
+
+private:
+    struct Job {
+        uint32_t assetId;
+        std::string path;
+    };
+
+    void workerLoop();
+
+    ImportSettings m_settings;
+    std::vector<std::thread> m_workers;
+
+    std::deque<Job> m_jobs;
+    std::mutex m_jobMutex;
+    std::condition_variable m_jobCond;
+
+    std::vector<ImportResult> m_results;
+    std::mutex m_resultMutex;
+
+    std::atomic<size_t> m_pending{0};
+    std::atomic<bool> m_abort{false};
+};
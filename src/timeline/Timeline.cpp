@@ -1,18 +1,8 @@
 #include "timeline/Timeline.h"
+#include "timeline/MediaImporter.h"
+#include "media/TimeStretch.h"
 #include <algorithm>
-#include <cstdio>
-#include <cctype>
-
-extern "C" {
-#include <libavformat/avformat.h>
-}
-
-#define STB_IMAGE_IMPLEMENTATION
-#define STBI_ONLY_PNG
-#define STBI_ONLY_JPEG
-#define STBI_ONLY_BMP
-#define STBI_ONLY_TGA
-#include "stb_image.h"
+#include <utility>
 
 Timeline::Timeline() = default;
 
@@ -22,36 +12,151 @@ uint32_t Timeline::addTrack(const std::string& name, TrackType type) {
     track.id = id;
     track.name = name;
     track.type = type;
-    m_tracks[id] = std::move(track);
-    m_trackOrder.push_back(id);
+    m_tracks.write()[id] = std::move(track);
+    m_trackOrder.write().push_back(id);
     return id;
 }
 
 Track* Timeline::getTrack(uint32_t trackId) {
-    auto it = m_tracks.find(trackId);
-    return it != m_tracks.end() ? &it->second : nullptr;
+    auto& tracks = m_tracks.write();
+    auto it = tracks.find(trackId);
+    return it != tracks.end() ? &it->second : nullptr;
 }
 
 const Track* Timeline::getTrack(uint32_t trackId) const {
-    auto it = m_tracks.find(trackId);
-    return it != m_tracks.end() ? &it->second : nullptr;
+    const auto& tracks = m_tracks.read();
+    auto it = tracks.find(trackId);
+    return it != tracks.end() ? &it->second : nullptr;
+}
+
+uint32_t Timeline::addBus(const std::string& name, uint32_t parentId) {
+    uint32_t id = m_nextBusId++;
+    AudioBus bus;
+    bus.id = id;
+    bus.name = name;
+    bus.parentId = getBus(parentId) ? parentId : 0;
+    m_buses.write()[id] = std::move(bus);
+    m_routingVersion++;
+    return id;
+}
+
+AudioBus* Timeline::getBus(uint32_t busId) {
+    auto& buses = m_buses.write();
+    auto it = buses.find(busId);
+    return it != buses.end() ? &it->second : nullptr;
+}
+
+const AudioBus* Timeline::getBus(uint32_t busId) const {
+    const auto& buses = m_buses.read();
+    auto it = buses.find(busId);
+    return it != buses.end() ? &it->second : nullptr;
+}
+
+void Timeline::removeBus(uint32_t busId) {
+    auto& buses = m_buses.write();
+    auto it = buses.find(busId);
+    if (it == buses.end()) return;
+    uint32_t parentId = it->second.parentId;
+    buses.erase(it);
+
+    for (auto& [id, bus] : buses) {
+        if (bus.parentId == busId) bus.parentId = parentId;
+    }
+    for (auto& [id, track] : m_tracks.write()) {
+        if (track.busId == busId) track.busId = parentId;
+    }
+    m_routingVersion++;
+}
+
+bool Timeline::setBusParent(uint32_t busId, uint32_t parentId) {
+    const Timeline& self = *this;
+    if (!self.getBus(busId) || (parentId != 0 && !self.getBus(parentId))) return false;
+
+    // Walk up from the new parent; reaching busId means a cycle
+    for (uint32_t id = parentId; id != 0;) {
+        if (id == busId) return false;
+        const AudioBus* bus = self.getBus(id);
+        id = bus ? bus->parentId : 0;
+    }
+    getBus(busId)->parentId = parentId;
+    m_routingVersion++;
+    return true;
+}
+
+void Timeline::setTrackBus(uint32_t trackId, uint32_t busId) {
+    auto* track = getTrack(trackId);
+    if (!track) return;
+    track->busId = getBus(busId) ? busId : 0;
+    m_routingVersion++;
+}
+
+void Timeline::setMasterEffects(const AudioEffectChain& chain) {
+    m_masterEffects = chain;
+    m_masterEffectsVersion = nextCowStamp();
+}
+
+uint64_t Timeline::getEditVersion() const {
+    // Stamps never repeat, so the newest one identifies the whole state
+    return std::max({m_assets.version(), m_tracks.version(), m_clips.version(),
+                     m_trackOrder.version(), m_buses.version(), m_masterEffectsVersion});
+}
+
+void Timeline::setTrackAutomation(uint32_t trackId, AutomationParam param, AutomationCurve curve) {
+    auto* track = getTrack(trackId);
+    if (!track) return;
+    (param == AutomationParam::Volume ? track->volumeCurve : track->panCurve) = std::move(curve);
+    m_automationVersion++;
+}
+
+void Timeline::setClipAutomation(uint32_t clipId, AutomationParam param, AutomationCurve curve) {
+    auto* clip = getClip(clipId);
+    if (!clip) return;
+    (param == AutomationParam::Volume ? clip->volumeCurve : clip->panCurve) = std::move(curve);
+    m_automationVersion++;
+}
+
+void Timeline::setClipFades(uint32_t clipId, double fadeIn, double fadeOut) {
+    auto* clip = getClip(clipId);
+    if (!clip) return;
+    double duration = clip->getDuration();
+    clip->fadeIn = std::clamp(fadeIn, 0.0, duration);
+    clip->fadeOut = std::clamp(fadeOut, 0.0, duration);
+}
+
+bool Timeline::crossfade(uint32_t clipIdA, uint32_t clipIdB) {
+    const Timeline& self = *this;
+    const Clip* a = self.getClip(clipIdA);
+    const Clip* b = self.getClip(clipIdB);
+    if (!a || !b) return false;
+    if (a->timelineStart > b->timelineStart) std::swap(a, b);
+
+    // Only a tail overlapping a head; a clip inside another has no seam
+    double overlap = a->getTimelineEnd() - b->timelineStart;
+    if (overlap <= 0.0 || b->getTimelineEnd() <= a->getTimelineEnd()) return false;
+    uint32_t first = a->id, second = b->id;
+    double firstFadeIn = a->fadeIn, secondFadeOut = b->fadeOut;
+    setClipFades(first, firstFadeIn, overlap);
+    setClipFades(second, overlap, secondFadeOut);
+    return true;
 }
 
 uint32_t Timeline::addAsset(MediaAsset asset) {
     uint32_t id = m_nextAssetId++;
     asset.id = id;
-    m_assets[id] = std::move(asset);
+    m_assets.write()[id] = std::move(asset);
     return id;
 }
 
 MediaAsset* Timeline::getAsset(uint32_t assetId) {
-    auto it = m_assets.find(assetId);
-    return it != m_assets.end() ? &it->second : nullptr;
+    auto& assets = m_assets.write();
+    auto it = assets.find(assetId);
+    return it != assets.end() ? &it->second : nullptr;
 }
 
 const MediaAsset* Timeline::getAsset(uint32_t assetId) const {
-    auto it = m_assets.find(assetId);
-    return it != m_assets.end() ? &it->second : nullptr;
+    const auto& assets = m_assets.read();
+    auto it = assets.find(assetId);
+    return it != assets.end() ? &it->second : nullptr;
 }
 
 uint32_t Timeline::addClip(uint32_t trackId, uint32_t assetId,
@@ -68,33 +173,34 @@ uint32_t Timeline::addClip(uint32_t trackId, uint32_t assetId,
     clip.sourceIn = sourceIn;
     clip.sourceOut = sourceOut;
 
-    m_clips[id] = clip;
-    track->clipIds.push_back(id);
-    sortTrackClips(trackId);
+    m_clips.write()[id] = clip;
+    track->clips.insert(id, clip.timelineStart, clip.getTimelineEnd());
     return id;
 }
 
 Clip* Timeline::getClip(uint32_t clipId) {
-    auto it = m_clips.find(clipId);
-    return it != m_clips.end() ? &it->second : nullptr;
+    auto& clips = m_clips.write();
+    auto it = clips.find(clipId);
+    return it != clips.end() ? &it->second : nullptr;
 }
 
 const Clip* Timeline::getClip(uint32_t clipId) const {
-    auto it = m_clips.find(clipId);
-    return it != m_clips.end() ? &it->second : nullptr;
+    const auto& clips = m_clips.read();
+    auto it = clips.find(clipId);
+    return it != clips.end() ? &it->second : nullptr;
 }
 
 void Timeline::removeClip(uint32_t clipId) {
-    auto it = m_clips.find(clipId);
-    if (it == m_clips.end()) return;
+    auto& clips = m_clips.write();
+    auto it = clips.find(clipId);
+    if (it == clips.end()) return;
 
     uint32_t trackId = it->second.trackId;
-    m_clips.erase(it);
+    clips.erase(it);
 
     auto* track = getTrack(trackId);
     if (track) {
-        auto& ids = track->clipIds;
-        ids.erase(std::remove(ids.begin(), ids.end(), clipId), ids.end());
+        track->clips.erase(clipId);
     }
 }
 
@@ -102,41 +208,91 @@ void Timeline::moveClip(uint32_t clipId, uint32_t newTrackId, double newTimeline
     auto* clip = getClip(clipId);
     if (!clip) return;
 
-    // Remove from old track
-    if (clip->trackId != newTrackId) {
-        auto* oldTrack = getTrack(clip->trackId);
-        if (oldTrack) {
-            auto& ids = oldTrack->clipIds;
-            ids.erase(std::remove(ids.begin(), ids.end(), clipId), ids.end());
-        }
+    // Stay on the old track if the new one doesn't exist
+    if (!getTrack(newTrackId)) newTrackId = clip->trackId;
 
-        // Add to new track
-        auto* newTrack = getTrack(newTrackId);
-        if (newTrack) {
-            newTrack->clipIds.push_back(clipId);
-            clip->trackId = newTrackId;
-            sortTrackClips(newTrackId);
-        }
+    if (auto* oldTrack = getTrack(clip->trackId)) {
+        oldTrack->clips.erase(clipId);
     }
-
+    clip->trackId = newTrackId;
     clip->timelineStart = newTimelineStart;
-    sortTrackClips(clip->trackId);
+    if (auto* track = getTrack(newTrackId)) {
+        track->clips.insert(clipId, clip->timelineStart, clip->getTimelineEnd());
+    }
+}
+
+void Timeline::setClipTiming(uint32_t clipId, double timelineStart, double sourceIn, double sourceOut) {
+    // Unchanged: leave the tables (and the edit version) alone
+    const Clip* current = std::as_const(*this).getClip(clipId);
+    if (!current || (current->timelineStart == timelineStart &&
+                     current->sourceIn == sourceIn && current->sourceOut == sourceOut)) {
+        return;
+    }
+
+    auto* clip = getClip(clipId);
+
+    clip->timelineStart = timelineStart;
+    clip->sourceIn = sourceIn;
+    clip->sourceOut = sourceOut;
+    if (auto* track = getTrack(clip->trackId)) {
+        track->clips.insert(clipId, clip->timelineStart, clip->getTimelineEnd());
+    }
+}
+
+void Timeline::setClipSpeed(uint32_t clipId, double speed) {
+    auto* clip = getClip(clipId);
+    if (!clip) return;
+
+    clip->speed = std::clamp(speed, TimeStretch::MIN_SPEED, TimeStretch::MAX_SPEED);
+    clip->fadeIn = std::min(clip->fadeIn, clip->getDuration());
+    clip->fadeOut = std::min(clip->fadeOut, clip->getDuration());
+    if (auto* track = getTrack(clip->trackId)) {
+        track->clips.insert(clipId, clip->timelineStart, clip->getTimelineEnd());
+    }
+    m_automationVersion++;
+}
+
+void Timeline::rippleDelete(uint32_t clipId) {
+    const auto* clip = std::as_const(*this).getClip(clipId);
+    if (!clip) return;
+
+    uint32_t trackId = clip->trackId;
+    double end = clip->getTimelineEnd();
+    double duration = clip->getDuration();
+    removeClip(clipId);
+    shiftTrack(trackId, end, -duration);
+}
+
+uint32_t Timeline::rippleInsert(uint32_t trackId, uint32_t assetId,
+                                double timelineStart, double sourceIn, double sourceOut) {
+    if (!std::as_const(*this).getTrack(trackId)) return 0;
+    shiftTrack(trackId, timelineStart, sourceOut - sourceIn);
+    return addClip(trackId, assetId, timelineStart, sourceIn, sourceOut);
+}
+
+void Timeline::rippleTrim(uint32_t clipId, double sourceIn, double sourceOut) {
+    const auto* clip = std::as_const(*this).getClip(clipId);
+    if (!clip) return;
+
+    uint32_t trackId = clip->trackId;
+    double start = clip->timelineStart;
+    double oldEnd = clip->getTimelineEnd();
+    double delta = (sourceOut - sourceIn) / clip->speed - clip->getDuration();
+    setClipTiming(clipId, start, sourceIn, sourceOut);
+    shiftTrack(trackId, oldEnd, delta);
 }
 
 const Clip* Timeline::getActiveClipOnTrack(uint32_t trackId, double time) const {
     const auto* track = getTrack(trackId);
     if (!track) return nullptr;
 
-    for (uint32_t clipId : track->clipIds) {
-        const auto* clip = getClip(clipId);
-        if (clip && clip->containsTime(time)) return clip;
-    }
-    return nullptr;
+    uint32_t clipId = track->clips.clipIdAt(time);
+    return clipId ? getClip(clipId) : nullptr;
 }
 
 std::vector<const Clip*> Timeline::getActiveClips(double time) const {
     std::vector<const Clip*> result;
-    for (uint32_t trackId : m_trackOrder) {
+    for (uint32_t trackId : m_trackOrder.read()) {
         const auto* clip = getActiveClipOnTrack(trackId, time);
         if (clip) result.push_back(clip);
     }
@@ -144,156 +300,191 @@ std::vector<const Clip*> Timeline::getActiveClips(double time) const {
 }
 
 double Timeline::getTotalDuration() const {
+    // Every clip is on a track, and each track index keeps its latest end
     double maxEnd = 0.0;
-    for (auto& [id, clip] : m_clips) {
-        double end = clip.getTimelineEnd();
-        if (end > maxEnd) maxEnd = end;
+    for (auto& [id, track] : m_tracks.read()) {
+        maxEnd = std::max(maxEnd, track.clips.maxEnd());
     }
     return maxEnd;
 }
 
-static bool isImageExtension(const std::string& path) {
-    size_t dot = path.find_last_of('.');
-    if (dot == std::string::npos) return false;
-    std::string ext = path.substr(dot);
-    for (auto& c : ext) c = std::tolower(c);
-    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" ||
-           ext == ".bmp" || ext == ".tga";
-}
-
-uint32_t Timeline::importFile(const std::string& path) {
-    // Check if it's an image file
-    if (isImageExtension(path)) {
-        return importImage(path);
-    }
-
-    // Probe the file with FFmpeg to get metadata
-    AVFormatContext* fmt = nullptr;
-    if (avformat_open_input(&fmt, path.c_str(), nullptr, nullptr) < 0) {
-        fprintf(stderr, "Timeline: could not open %s\n", path.c_str());
-        return 0;
-    }
-    if (avformat_find_stream_info(fmt, nullptr) < 0) {
-        avformat_close_input(&fmt);
-        return 0;
-    }
-
+uint32_t Timeline::beginImport(const std::string& path) {
     MediaAsset asset;
     asset.filePath = path;
-
-    int videoIdx = -1, audioIdx = -1;
-    for (unsigned i = 0; i < fmt->nb_streams; i++) {
-        auto ct = fmt->streams[i]->codecpar->codec_type;
-        if (ct == AVMEDIA_TYPE_VIDEO && videoIdx < 0) videoIdx = i;
-        else if (ct == AVMEDIA_TYPE_AUDIO && audioIdx < 0) audioIdx = i;
-    }
-
-    if (videoIdx >= 0) {
-        auto* par = fmt->streams[videoIdx]->codecpar;
-        auto fr = fmt->streams[videoIdx]->avg_frame_rate;
-        asset.hasVideo = true;
-        asset.width = par->width;
-        asset.height = par->height;
-        asset.fps = (fr.num > 0 && fr.den > 0) ? av_q2d(fr) : 30.0;
-    }
-    if (audioIdx >= 0) {
-        auto* par = fmt->streams[audioIdx]->codecpar;
-        asset.hasAudio = true;
-        asset.sampleRate = par->sample_rate;
-        asset.channels = par->ch_layout.nb_channels;
+    asset.pending = true;
+    asset.duration = PLACEHOLDER_DURATION;
+
+    uint32_t trackId = 0;
+    if (MediaImporter::isImagePath(path)) {
+        asset.type = MediaType::Image;
+        trackId = findTrackByType(TrackType::Image);
+        if (!trackId) {
+            trackId = addTrack("Image 1", TrackType::Image);
+        }
+    } else {
+        // Most files have video; audio-only files are moved on completion
+        asset.type = MediaType::Video;
+        trackId = findTrackByType(TrackType::Video);
+        if (!trackId) trackId = findTrackByType(TrackType::Audio);
     }
 
-    if (fmt->duration != AV_NOPTS_VALUE) {
-        asset.duration = static_cast<double>(fmt->duration) / AV_TIME_BASE;
+    // Find the current end of timeline for placing new clips
+    double placeAt = getTotalDuration();
+    uint32_t assetId = addAsset(std::move(asset));
+    if (trackId) {
+        addClip(trackId, assetId, placeAt, 0.0, PLACEHOLDER_DURATION);
     }
+    return assetId;
+}
 
-    asset.type = asset.hasVideo ? MediaType::Video : MediaType::Audio;
-    avformat_close_input(&fmt);
+bool Timeline::completeImport(uint32_t assetId, MediaAsset probed) {
+    auto* asset = getAsset(assetId);
+    if (!asset || !asset->pending) return false;
 
-    uint32_t assetId = addAsset(std::move(asset));
-    const auto* a = getAsset(assetId);
-
-    // Find the current end of timeline for placing new clips
-    double placeAt = getTotalDuration();
+    probed.id = assetId;
+    probed.filePath = asset->filePath;
+    probed.pending = false;
+    *asset = std::move(probed);
 
-    // Auto-create clips: video on first video track, audio on first audio track
-    if (a->hasVideo) {
-        uint32_t vTrack = findTrackByType(TrackType::Video);
-        if (vTrack) {
-            addClip(vTrack, assetId, placeAt, 0.0, a->duration);
+    // The placeholder may have been moved or deleted by the user meanwhile
+    uint32_t placeholderId = 0;
+    for (auto& [clipId, clip] : m_clips.read()) {
+        if (clip.assetId == assetId) { placeholderId = clipId; break; }
+    }
+    if (!placeholderId) return true;
+
+    auto* clip = getClip(placeholderId);
+    uint32_t importTrack = clip->trackId;
+    double placeAt = clip->timelineStart;
+    double oldEnd = clip->getTimelineEnd();
+
+    // The placeholder becomes the video (or image, or audio-only) clip and
+    // stays on its track if that suits the media, else goes to the first
+    // track that does. The audio of a file with video goes on the first
+    // audio track.
+    uint32_t aTrack = findTrackByType(TrackType::Audio);
+    uint32_t wantTrack = clip->trackId;
+    if (asset->type != MediaType::Image) {
+        TrackType wantType = asset->hasVideo ? TrackType::Video : TrackType::Audio;
+        const auto* track = std::as_const(*this).getTrack(clip->trackId);
+        if (!track || track->type != wantType) {
+            wantTrack = asset->hasVideo ? findTrackByType(TrackType::Video) : aTrack;
         }
     }
-    if (a->hasAudio) {
-        uint32_t aTrack = findTrackByType(TrackType::Audio);
-        if (aTrack) {
-            addClip(aTrack, assetId, placeAt, 0.0, a->duration);
+
+    if (!wantTrack) {
+        removeClip(placeholderId);
+    } else {
+        if (wantTrack != clip->trackId) {
+            moveClip(placeholderId, wantTrack, placeAt);
         }
+        setClipTiming(placeholderId, clip->timelineStart, clip->sourceIn, asset->duration);
+    }
+    if (asset->hasVideo && asset->hasAudio && aTrack) {
+        addClip(aTrack, assetId, placeAt, 0.0, asset->duration);
     }
 
-    return assetId;
+    shiftLaterImports(importTrack, assetId, oldEnd, (placeAt + asset->duration) - oldEnd);
+    return true;
 }
 
-uint32_t Timeline::importImage(const std::string& path) {
-    int w, h, channels;
-    unsigned char* pixels = stbi_load(path.c_str(), &w, &h, &channels, 4); // Force RGBA
-    if (!pixels) {
-        fprintf(stderr, "Timeline: failed to load image %s: %s\n",
-                path.c_str(), stbi_failure_reason());
-        return 0;
+void Timeline::failImport(uint32_t assetId) {
+    std::vector<uint32_t> clipIds;
+    uint32_t gapTrack = 0;
+    double gapStart = -1.0, gapEnd = -1.0;
+    for (auto& [clipId, clip] : m_clips.read()) {
+        if (clip.assetId != assetId) continue;
+        clipIds.push_back(clipId);
+        gapTrack = clip.trackId;
+        gapStart = clip.timelineStart;
+        gapEnd = clip.getTimelineEnd();
     }
+    for (uint32_t clipId : clipIds) {
+        removeClip(clipId);
+    }
+    m_assets.write().erase(assetId);
 
-    MediaAsset asset;
-    asset.filePath = path;
-    asset.type = MediaType::Image;
-    asset.width = w;
-    asset.height = h;
-    asset.duration = 5.0;  // Default 5-second duration for images
-    asset.hasVideo = false;
-    asset.hasAudio = false;
-
-    // Store pre-decoded RGBA pixels
-    size_t dataSize = static_cast<size_t>(w) * h * 4;
-    asset.imageData.assign(pixels, pixels + dataSize);
-    stbi_image_free(pixels);
-
-    uint32_t assetId = addAsset(std::move(asset));
-
-    // Create or find an Image track
-    uint32_t imgTrack = findTrackByType(TrackType::Image);
-    if (!imgTrack) {
-        imgTrack = addTrack("Image 1", TrackType::Image);
+    // Close the hole left by the placeholder
+    if (gapEnd > gapStart) {
+        shiftLaterImports(gapTrack, assetId, gapEnd, gapStart - gapEnd);
     }
+}
 
-    double placeAt = getTotalDuration();
-    const auto* a = getAsset(assetId);
-    addClip(imgTrack, assetId, placeAt, 0.0, a->duration);
+void Timeline::shiftLaterImports(uint32_t trackId, uint32_t assetId, double fromTime, double delta) {
+    if (delta == 0.0) return;
+    const auto* track = std::as_const(*this).getTrack(trackId);
+    if (!track) return;
 
-    return assetId;
+    // Imports queued behind this one are pending placeholders with higher
+    // asset IDs (allocated in import order) at or after fromTime. Usually
+    // they are all that follows, and the whole tail moves in O(log n);
+    // clips the user put among them stay where they are.
+    const auto& assets = m_assets.read();
+    std::vector<ClipSpan> placeholders;
+    bool onlyPlaceholders = true;
+    track->clips.forEachOverlapping(fromTime - 1e-6, 1e300, [&](const ClipSpan& span) {
+        if (span.start < fromTime - 1e-6) return;
+        const auto* clip = std::as_const(*this).getClip(span.clipId);
+        auto asset = clip ? assets.find(clip->assetId) : assets.end();
+        if (asset != assets.end() && asset->second.pending && clip->assetId > assetId) {
+            placeholders.push_back(span);
+        } else {
+            onlyPlaceholders = false;
+        }
+    });
+    if (placeholders.empty()) return;
+
+    if (onlyPlaceholders) {
+        shiftTrack(trackId, fromTime, delta);
+        return;
+    }
+    for (const ClipSpan& span : placeholders) {
+        const auto* clip = std::as_const(*this).getClip(span.clipId);
+        setClipTiming(span.clipId, std::max(0.0, span.start + delta), clip->sourceIn, clip->sourceOut);
+    }
 }
 
 uint32_t Timeline::findTrackByType(TrackType type) const {
-    for (uint32_t trackId : m_trackOrder) {
-        const auto* track = getTrack(trackId);
+    for (uint32_t trackId : m_trackOrder.read()) {
+        const auto* track = std::as_const(*this).getTrack(trackId);
         if (track && track->type == type) return trackId;
     }
     return 0;
 }
 
-void Timeline::sortTrackClips(uint32_t trackId) {
+void Timeline::shiftTrack(uint32_t trackId, double fromTime, double delta) {
+    if (delta == 0.0) return;
     auto* track = getTrack(trackId);
     if (!track) return;
-    std::sort(track->clipIds.begin(), track->clipIds.end(),
-              [this](uint32_t a, uint32_t b) {
-                  const auto* ca = getClip(a);
-                  const auto* cb = getClip(b);
-                  if (!ca || !cb) return false;
-                  return ca->timelineStart < cb->timelineStart;
-              });
+
+    // Moving back, spans would pass any that start in [from + delta, from),
+    // which a range shift can't do (overlapping clips, e.g. crossfades).
+    // Take those out and put them back after, so the shift stays O(log n).
+    double from = fromTime - 1e-6;
+    std::vector<ClipSpan> passed;
+    if (delta < 0.0) {
+        track->clips.forEachOverlapping(from + delta, from, [&](const ClipSpan& span) {
+            if (span.start >= from + delta) passed.push_back(span);
+        });
+        for (const ClipSpan& span : passed) track->clips.erase(span.clipId);
+    }
+    track->clips.shiftFrom(from, delta);
+    for (const ClipSpan& span : passed) track->clips.insert(span.clipId, span.start, span.end);
+
+    // Write the moved starts back. Spans from the new edit point on are the
+    // moved ones plus any earlier ones still overlapping, whose start is
+    // unchanged.
+    auto& clips = m_clips.write();
+    track->clips.forEachOverlapping(from + std::min(delta, 0.0), 1e300, [&](const ClipSpan& span) {
+        auto it = clips.find(span.clipId);
+        if (it != clips.end()) it->second.timelineStart = span.start;
+    });
 }
 
 void Timeline::swapTracks(int indexA, int indexB) {
+    auto& order = m_trackOrder.write();
     if (indexA < 0 || indexB < 0 ||
-        indexA >= (int)m_trackOrder.size() || indexB >= (int)m_trackOrder.size())
+        indexA >= (int)order.size() || indexB >= (int)order.size())
         return;
-    std::swap(m_trackOrder[indexA], m_trackOrder[indexB]);
+    std::swap(order[indexA], order[indexB]);
 }
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "timeline/MediaAsset.h"
+#include "timeline/CowPtr.h"
+#include "timeline/ClipIndex.h"
+#include "timeline/Automation.h"
+#include "media/AudioEffects.h"
 #include <vector>
 #include <string>
 #include <unordered_map>
@@ -16,13 +20,17 @@ struct Clip {
     double timelineStart = 0.0; // where the clip starts on the timeline (seconds)
     double sourceIn = 0.0;      // source start offset (seconds)
     double sourceOut = 0.0;     // source end offset (seconds)
+    double speed = 1.0;         // source seconds per timeline second (see Timeline::setClipSpeed)
 
-    // Derived: duration on timeline = sourceOut - sourceIn
-    double getDuration() const { return sourceOut - sourceIn; }
+    // Derived: duration on timeline = (sourceOut - sourceIn) / speed
+    double getDuration() const { return (sourceOut - sourceIn) / speed; }
 
-    // Map timeline time to source time
+    // Map timeline time to source time and back
     double toSourceTime(double timelineTime) const {
-        return (timelineTime - timelineStart) + sourceIn;
+        return (timelineTime - timelineStart) * speed + sourceIn;
+    }
+    double toTimelineTime(double sourceTime) const {
+        return (sourceTime - sourceIn) / speed + timelineStart;
     }
 
     // Check if timeline time falls within this clip
@@ -32,6 +40,14 @@ struct Clip {
     }
 
     double getTimelineEnd() const { return timelineStart + getDuration(); }
+
+    // Audio: equal-power fades at either end (seconds; read live by the
+    // mixer, like the timing), and keyframed gain and pan (see
+    // Timeline::setClipAutomation)
+    double fadeIn = 0.0;
+    double fadeOut = 0.0;
+    AutomationCurve volumeCurve;
+    AutomationCurve panCurve;
 };
 
 enum class TrackType {
@@ -45,25 +61,90 @@ struct Track {
     std::string name;
     TrackType type = TrackType::Video;
 
-    std::vector<uint32_t> clipIds;  // ordered by timelineStart
+    ClipIndex clips;  // spans ordered by timelineStart
 
     bool muted = false;
     bool visible = true;
     float volume = 1.0f;           // 0.0 - 1.0, for audio tracks
+    float pan = 0.0f;              // -1.0 (left) - 1.0 (right), for audio tracks
+    AutomationCurve volumeCurve;   // audio tracks: keyframed, see setTrackAutomation
+    AutomationCurve panCurve;
+    uint32_t busId = 0;            // audio tracks: bus fed, 0 = master (see setTrackBus)
+    AudioEffectChain effects;      // audio tracks: inserts, before volume
+};
+
+// Audio sub-mix (e.g. dialogue, music, effects). Tracks and other buses
+// feed into it and it feeds its parent, ending at the master output.
+struct AudioBus {
+    uint32_t id = 0;
+    std::string name;
+    uint32_t parentId = 0;         // 0 = master (see setBusParent)
+
+    bool muted = false;
+    float volume = 1.0f;           // 0.0 - 1.0
 };
 
 // Owns all assets, tracks, clips. Provides timeline queries.
+//
+// The asset, track and clip tables are copy-on-write, so copying a Timeline
+// is O(1) and shares everything with the original until one side edits.
+// Use snapshot() to hand a frozen view to another thread (export, undo,
+// background analysis) while the UI keeps editing. A snapshot must only be
+// read on the receiving thread; copying or editing it there is fine too.
+// Non-const accessors detach the table they touch, so pointers obtained
+// before a snapshot may no longer alias the snapshot's data afterwards.
+//
+// Each track indexes its clips by time (ClipIndex). Change a clip's timing
+// through setClipTiming(), moveClip() or the ripple edits, never by writing
+// the Clip fields directly, or the index goes stale.
+//
+// Ripple edits shift every later clip on the track in the index in
+// O(log n), then write the new starts back to the clips they moved. Const
+// accessors never modify anything, so a snapshot is safe to read from any
+// one thread.
 class Timeline {
 public:
     Timeline();
 
+    // Frozen copy sharing all tables with this timeline. O(1).
+    Timeline snapshot() const { return *this; }
+
     // Track management
     uint32_t addTrack(const std::string& name, TrackType type);
     Track* getTrack(uint32_t trackId);
     const Track* getTrack(uint32_t trackId) const;
-    const std::vector<uint32_t>& getTrackOrder() const { return m_trackOrder; }
+    const std::vector<uint32_t>& getTrackOrder() const { return m_trackOrder.read(); }
     void swapTracks(int indexA, int indexB);
 
+    // Audio bus routing. Volume and mute may be written directly through
+    // getBus(); anything that changes the routing bumps getRoutingVersion().
+    // setBusParent() refuses a parent that would form a cycle. Removing a bus
+    // re-routes whatever fed it to its parent.
+    uint32_t addBus(const std::string& name, uint32_t parentId = 0);
+    AudioBus* getBus(uint32_t busId);
+    const AudioBus* getBus(uint32_t busId) const;
+    void removeBus(uint32_t busId);
+    bool setBusParent(uint32_t busId, uint32_t parentId);
+    void setTrackBus(uint32_t trackId, uint32_t busId);
+    const std::unordered_map<uint32_t, AudioBus>& getAllBuses() const { return m_buses.read(); }
+    uint64_t getRoutingVersion() const { return m_routingVersion; }
+
+    // Inserts on the master output, after every track and bus is summed.
+    // Read live by the mixer, like track volume.
+    const AudioEffectChain& getMasterEffects() const { return m_masterEffects; }
+    void setMasterEffects(const AudioEffectChain& chain);
+
+    // Automation. Curves are swapped in whole and bump
+    // getAutomationVersion(), which has playback hand the new curves to the
+    // mixer; fades are read live. crossfade() fades the second clip in over
+    // its overlap with the end of the first and the first out, returning
+    // false if they don't overlap.
+    void setTrackAutomation(uint32_t trackId, AutomationParam param, AutomationCurve curve);
+    void setClipAutomation(uint32_t clipId, AutomationParam param, AutomationCurve curve);
+    void setClipFades(uint32_t clipId, double fadeIn, double fadeOut);
+    bool crossfade(uint32_t clipIdA, uint32_t clipIdB);
+    uint64_t getAutomationVersion() const { return m_automationVersion; }
+
     // Asset management
     uint32_t addAsset(MediaAsset asset);
     MediaAsset* getAsset(uint32_t assetId);
@@ -76,34 +157,71 @@ public:
     const Clip* getClip(uint32_t clipId) const;
     void removeClip(uint32_t clipId);
     void moveClip(uint32_t clipId, uint32_t newTrackId, double newTimelineStart);
-
-    // Queries
+    void setClipTiming(uint32_t clipId, double timelineStart, double sourceIn, double sourceOut);
+
+    // Play a clip faster or slower (clamped to TimeStretch's range), keeping
+    // its start and source range; the clip gets shorter or longer and later
+    // clips don't move. Audio is time-stretched at the original pitch. The
+    // mixer sets retimed clips up when published, so this bumps
+    // getAutomationVersion() too.
+    void setClipSpeed(uint32_t clipId, double speed);
+
+    // Ripple edits: later clips on the same track (those starting at or
+    // after the edit point) move to close or open the gap. O(log n) in the
+    // number of clips on the track plus a pass writing back the k clips
+    // moved. A clip straddling an insert point is left where it is; split
+    // it first.
+    void rippleDelete(uint32_t clipId);
+    uint32_t rippleInsert(uint32_t trackId, uint32_t assetId,
+                          double timelineStart, double sourceIn, double sourceOut);
+    void rippleTrim(uint32_t clipId, double sourceIn, double sourceOut);
+
+    // Queries. Per-track lookups are O(log n); the duration is O(tracks).
     const Clip* getActiveClipOnTrack(uint32_t trackId, double time) const;
     std::vector<const Clip*> getActiveClips(double time) const;
     double getTotalDuration() const;
 
-    // Import a media file, auto-creating appropriate clips
-    // Returns the asset ID (0 on failure)
-    uint32_t importFile(const std::string& path);
+    // Asynchronous import (see MediaImporter). beginImport() adds a pending
+    // asset plus a placeholder clip at the end of the timeline and returns
+    // the asset ID. completeImport() fills in the probed metadata, resizes
+    // the placeholder and adds the audio clip; failImport() removes both.
+    // Later imports are shifted so queued files stay back-to-back.
+    uint32_t beginImport(const std::string& path);
+    bool completeImport(uint32_t assetId, MediaAsset probed);
+    void failImport(uint32_t assetId);
 
     // Find first track of a given type, or 0 if none
     uint32_t findTrackByType(TrackType type) const;
 
     // Get all tracks/clips/assets
-    const std::unordered_map<uint32_t, Track>& getAllTracks() const { return m_tracks; }
-    const std::unordered_map<uint32_t, Clip>& getAllClips() const { return m_clips; }
-    const std::unordered_map<uint32_t, MediaAsset>& getAllAssets() const { return m_assets; }
+    const std::unordered_map<uint32_t, Track>& getAllTracks() const { return m_tracks.read(); }
+    const std::unordered_map<uint32_t, Clip>& getAllClips() const { return m_clips.read(); }
+    const std::unordered_map<uint32_t, MediaAsset>& getAllAssets() const { return m_assets.read(); }
+
+    // Stamp of the latest edit (see CowPtr::version()): changes whenever
+    // anything that feeds playback may have, including writes through the
+    // non-const accessors or assigning another timeline over this one. O(1).
+    uint64_t getEditVersion() const;
+
+    // Placeholder length used until the real duration is known
+    static constexpr double PLACEHOLDER_DURATION = 5.0;
 
 private:
-    uint32_t importImage(const std::string& path);
-    void sortTrackClips(uint32_t trackId);
+    void shiftTrack(uint32_t trackId, double fromTime, double delta);
+    void shiftLaterImports(uint32_t trackId, uint32_t assetId, double fromTime, double delta);
 
     uint32_t m_nextAssetId = 1;
     uint32_t m_nextTrackId = 1;
     uint32_t m_nextClipId = 1;
-
-    std::unordered_map<uint32_t, MediaAsset> m_assets;
-    std::unordered_map<uint32_t, Track> m_tracks;
-    std::unordered_map<uint32_t, Clip> m_clips;
-    std::vector<uint32_t> m_trackOrder;  // display order
+    uint32_t m_nextBusId = 1;
+    uint64_t m_routingVersion = 0;
+    uint64_t m_automationVersion = 0;
+
+    CowPtr<std::unordered_map<uint32_t, MediaAsset>> m_assets;
+    CowPtr<std::unordered_map<uint32_t, Track>> m_tracks;
+    CowPtr<std::unordered_map<uint32_t, Clip>> m_clips;
+    CowPtr<std::vector<uint32_t>> m_trackOrder;  // display order
+    CowPtr<std::unordered_map<uint32_t, AudioBus>> m_buses;
+    AudioEffectChain m_masterEffects = AudioEffectChain::master();
+    uint64_t m_masterEffectsVersion = nextCowStamp();
 };
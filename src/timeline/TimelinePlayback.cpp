@@ -1,8 +1,11 @@
 #include "timeline/TimelinePlayback.h"
 #include "media/AudioOutput.h"
+#include "media/AudioPcmCache.h"
 #include <algorithm>
 #include <chrono>
 #include <cstdio>
+#include <thread>
+#include <utility>
 
 static double wallClock() {
     using namespace std::chrono;
@@ -15,19 +18,42 @@ TimelinePlayback::~TimelinePlayback() {
 
 void TimelinePlayback::init(VulkanContext& ctx) {
     m_vkCtx = &ctx;
+    m_imageCache.init(ctx);
+    m_frameAllocator.init(ctx);
+    if (!m_yuvConverter.init(ctx)) {
+        fprintf(stderr, "TimelinePlayback: GPU YUV conversion unavailable, using RGBA uploads\n");
+        m_yuvConverter.shutdown(ctx);
+    }
+    m_texturePool.init(ctx, &m_yuvConverter);
+
+    // Helpers for mixing bus sub-mixes in parallel; leave most cores to
+    // the decoders
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    m_audioMixer.setWorkerCount(std::clamp(cores / 4, 0, 3));
+
+    m_mixdown.start(m_mixdownBudget);
+    if (m_mixdown.isEnabled()) m_audioMixer.setMixdown(&m_mixdown);
 }
 
 void TimelinePlayback::shutdown() {
     stop();
+    m_mixdown.shutdown();
 
+    forgetHeldFrames();
     m_clipPlayers.clear();
+    m_pcmClips.clear();
     m_activeClipIds.clear();
+    // Audio output is shut down before this, so nothing reads the queues
+    // or the tables
+    m_retiredPlayers.clear();
+    m_retiredTables.clear();
+    m_sourceTables.reset();
 
     if (m_vkCtx) {
-        for (auto& [trackId, state] : m_trackStates) {
-            state.uploader.shutdown(*m_vkCtx);
-            state.texture.shutdown(*m_vkCtx);
-        }
+        m_texturePool.shutdown();
+        m_imageCache.shutdown(*m_vkCtx);
+        m_frameAllocator.shutdown();
+        m_yuvConverter.shutdown(*m_vkCtx);  // after textures free their sets
     }
     m_trackStates.clear();
     m_pendingUploads.clear();
@@ -59,6 +85,7 @@ void TimelinePlayback::play() {
     }
     m_masterClock.set(startPos);
     m_masterClock.resume();
+    m_audioMixer.setPlayhead(startPos);
     m_firstFrameReceived = false;
     m_audioStarted = false;
     m_debugLastPrint = wallClock();
@@ -68,6 +95,10 @@ void TimelinePlayback::play() {
     m_fpsCounterStart = wallClock();
     m_fpsCounterFrames = 0;
 
+    // Mixdown keys aren't kept up to date while stopped: catch up on edits
+    // before the render thread reads its first block
+    if (m_audioCache) m_mixdown.update(*m_timeline, *m_audioCache, startPos);
+
     if (m_audioOutput) {
         m_audioOutput->startWithMixer(m_audioMixer, m_masterClock);
     }
@@ -106,15 +137,19 @@ void TimelinePlayback::stop() {
     if (m_state == State::Stopped) return;
 
     for (auto& [clipId, player] : m_clipPlayers) {
-        player->stop();
+        retirePlayer(std::move(player));
     }
+    forgetHeldFrames();
     m_clipPlayers.clear();
+    m_pcmClips.clear();
     m_activeClipIds.clear();
 
-    m_audioMixer.clearSources();
+    publishAudioSources({});
+    reapRetiredPlayers();
 
     if (m_audioOutput) {
         m_audioOutput->pause();
+        m_audioOutput->discardBuffered();
     }
 
     m_masterClock.set(0.0);
@@ -131,18 +166,25 @@ void TimelinePlayback::seek(double timelineSeconds) {
     double duration = getDuration();
     timelineSeconds = std::clamp(timelineSeconds, 0.0, duration);
 
-    if (m_audioOutput && m_audioStarted) {
+    // Scrub audio keeps running through the seeks a drag makes
+    if (m_audioOutput && m_audioStarted && !m_scrubbing) {
         m_audioOutput->pause();
     }
+    if (m_audioOutput && !m_scrubbing) {
+        // Audio mixed ahead is from before the seek
+        m_audioOutput->discardBuffered();
+    }
 
     m_masterClock.set(timelineSeconds);
 
     for (auto& [clipId, player] : m_clipPlayers) {
-        player->stop();
+        retirePlayer(std::move(player));
     }
+    forgetHeldFrames();
     m_clipPlayers.clear();
+    m_pcmClips.clear();
     m_activeClipIds.clear();
-    m_audioMixer.clearSources();
+    publishAudioSources({});
 
     m_firstFrameReceived = false;
 
@@ -160,9 +202,55 @@ void TimelinePlayback::seek(double timelineSeconds) {
     }
 }
 
+void TimelinePlayback::scrub(double timelineSeconds) {
+    if (!m_timeline) return;
+
+    if (!m_scrubbing) {
+        // Scrubbing needs the clips loaded and the output started, as when
+        // paused; the transport then stays paused under the drag
+        m_playAfterScrub = m_state == State::Playing;
+        if (m_state == State::Stopped) play();
+        pause();
+
+        m_scrubbing = true;
+        m_audioMixer.setScrubbing(true);
+        if (m_audioOutput) {
+            m_audioOutput->discardBuffered();
+            m_audioOutput->setScrubbing(true);
+            m_audioOutput->resume();
+        }
+    } else if (timelineSeconds == m_scrubTime) {
+        return;  // held still; the grains die away on their own
+    }
+
+    m_scrubTime = timelineSeconds;
+    seek(timelineSeconds);
+    m_audioMixer.scrubTo(m_masterClock.get());
+}
+
+void TimelinePlayback::endScrub() {
+    if (!m_scrubbing) return;
+
+    m_scrubbing = false;
+    m_audioMixer.setScrubbing(false);
+    if (m_audioOutput) {
+        m_audioOutput->pause();
+        m_audioOutput->setScrubbing(false);
+        m_audioOutput->discardBuffered();
+    }
+
+    // Land on the last position properly (clock lock, playhead)
+    seek(m_masterClock.get());
+    if (m_playAfterScrub) play();
+}
+
 void TimelinePlayback::update() {
+    reapRetiredPlayers();
+
     if (!m_timeline || m_state == State::Stopped) return;
 
+    if (m_audioCache) m_mixdown.update(*m_timeline, *m_audioCache, m_masterClock.get());
+
     // Use raw master clock for clip management decisions — NOT getPlaybackClock()
     // which subtracts SDL buffer latency and can report a time before a clip
     // transition point, causing the transition to immediately reverse.
@@ -176,18 +264,11 @@ void TimelinePlayback::update() {
         if (!track) continue;
         if (!track->visible && track->type != TrackType::Audio) continue;
 
-        for (uint32_t clipId : track->clipIds) {
-            const auto* clip = m_timeline->getClip(clipId);
-            if (!clip) continue;
-
-            double clipStart = clip->timelineStart;
-            double clipEnd = clip->getTimelineEnd();
+        if (track->type == TrackType::Image) continue;
 
-            if (clipEnd > currentTime && clipStart < lookahead) {
-                if (track->type == TrackType::Image) continue;
-                neededClipIds.insert(clipId);
-            }
-        }
+        track->clips.forEachOverlapping(currentTime, lookahead, [&](const ClipSpan& span) {
+            neededClipIds.insert(span.clipId);
+        });
     }
 
     std::vector<uint32_t> toRemove;
@@ -197,24 +278,42 @@ void TimelinePlayback::update() {
         }
     }
 
-    // Clear mixer sources BEFORE destroying any players to prevent the audio
-    // callback from accessing freed AudioFrameQueue memory (use-after-free).
-    if (!toRemove.empty()) {
-        m_audioMixer.clearSources();
-    }
-
+    // Removed players are retired, not destroyed: the mixer may be
+    // reading their queues until the rebuilt source set is adopted
     for (uint32_t clipId : toRemove) {
         deactivateClip(clipId);
     }
 
     bool sourcesChanged = !toRemove.empty();
+    if (m_audioMixer.hasSources() && m_timeline->getEditVersion() != m_sourceEditVersion) {
+        sourcesChanged = true;
+    }
     for (uint32_t clipId : neededClipIds) {
         if (m_activeClipIds.find(clipId) == m_activeClipIds.end()) {
             activateClip(clipId);
             sourcesChanged = true;
+            continue;
+        }
+
+        // Switch a decoding audio clip over once its asset is cached. The
+        // mixer reads the cache at its playhead, so playback carries on.
+        auto player = m_clipPlayers.find(clipId);
+        if (player == m_clipPlayers.end() || player->second->hasVideo()) continue;
+        const auto* clip = m_timeline->getClip(clipId);
+        if (clip && cachedAudio(*clip)) {
+            deactivateClip(clipId);
+            activateClip(clipId);
+            sourcesChanged = true;
         }
     }
 
+    // Have the cached audio about to play read in off the mixer's thread
+    for (const auto& [clipId, pcm] : m_pcmClips) {
+        const auto* clip = m_timeline->getClip(clipId);
+        if (!clip) continue;
+        pcm->prefetch(clip->toSourceTime(std::max(currentTime, clip->timelineStart)), 2.0 * clip->speed);
+    }
+
     if (sourcesChanged) {
         // No clock lock needed here — readSource uses:
         //   1) sourceIn check to discard pre-roll frames from keyframe seeking
@@ -235,7 +334,26 @@ std::vector<LayerInfo> TimelinePlayback::prepareFrame(int swapchainFrameIndex) {
 
     if (!m_timeline || !m_vkCtx) return layers;
 
+    m_texturePool.beginFrame();
+    m_imageCache.beginFrame(*m_vkCtx);
+    m_frameAllocator.beginFrame();
+    releaseHeldFrames(swapchainFrameIndex);
+
+    // Keep stills resident only while some clip still references them.
+    // Which ones do only changes with an edit.
+    uint64_t editVersion = m_timeline->getEditVersion();
+    if (editVersion != m_liveImageVersion) {
+        m_liveImageAssets.clear();
+        for (auto& [clipId, clip] : m_timeline->getAllClips()) {
+            const auto* asset = m_timeline->getAsset(clip.assetId);
+            if (asset && asset->type == MediaType::Image) m_liveImageAssets.insert(clip.assetId);
+        }
+        m_imageCache.retainOnly(m_liveImageAssets);
+        m_liveImageVersion = editVersion;
+    }
+
     double currentTime = getCurrentTime();
+    releaseIdleTrackStates(currentTime);
 
     for (uint32_t trackId : m_timeline->getTrackOrder()) {
         const auto* track = m_timeline->getTrack(trackId);
@@ -249,24 +367,16 @@ std::vector<LayerInfo> TimelinePlayback::prepareFrame(int swapchainFrameIndex) {
         if (!asset) continue;
 
         if (track->type == TrackType::Image) {
-            if (asset->imageData.empty() || asset->width <= 0 || asset->height <= 0) continue;
+            if (!asset->imageData || asset->width <= 0 || asset->height <= 0) continue;
 
-            auto& state = ensureTrackRenderState(trackId, asset->width, asset->height);
-
-            int uploadSlot = state.texture.acquireUploadSlot();
-            state.uploader.stage(*m_vkCtx, swapchainFrameIndex,
-                                  asset->imageData.data(), asset->width, asset->height);
-            state.texture.promoteUploadSlot();
-
-            PendingUpload pu;
-            pu.trackId = trackId;
-            pu.uploadSlot = uploadSlot;
-            pu.width = asset->width;
-            pu.height = asset->height;
-            m_pendingUploads.push_back(pu);
+            // Uploaded once, then reused from the cache every frame
+            VkDescriptorSet ds = m_imageCache.acquire(*m_vkCtx, asset->id,
+                                                      asset->imageData->data(),
+                                                      asset->width, asset->height);
+            if (!ds) continue;
 
             LayerInfo layer;
-            layer.descriptorSet = state.texture.getDisplayDescriptor();
+            layer.descriptorSet = ds;
             layer.width = asset->width;
             layer.height = asset->height;
             layer.trackId = trackId;
@@ -279,23 +389,11 @@ std::vector<LayerInfo> TimelinePlayback::prepareFrame(int swapchainFrameIndex) {
             auto& player = it->second;
             double sourceTime = clip->toSourceTime(currentTime);
 
-            int w = 0, h = 0;
-            bool isNewFrame = false;
-            const uint8_t* frameData = player->getVideoFrameAtTime(sourceTime, w, h, &isNewFrame);
-
-            if (!frameData || w <= 0 || h <= 0) {
-                // No frame yet — show last texture if available
-                auto stateIt = m_trackStates.find(trackId);
-                if (stateIt != m_trackStates.end() && stateIt->second.initialized) {
-                    LayerInfo layer;
-                    layer.descriptorSet = stateIt->second.texture.getDisplayDescriptor();
-                    layer.width = stateIt->second.lastWidth;
-                    layer.height = stateIt->second.lastHeight;
-                    layer.trackId = trackId;
-                    layers.push_back(layer);
-                }
-                m_debugHeldFrames++;
-                continue;
+            VideoFrameRef frame;
+            bool isNewFrame = player->acquireVideoFrameAtTime(sourceTime, frame);
+            if (isNewFrame && (!frame.handle || frame.width <= 0 || frame.height <= 0)) {
+                player->releaseVideoFrame();
+                isNewFrame = false;
             }
 
             if (isNewFrame) {
@@ -306,11 +404,11 @@ std::vector<LayerInfo> TimelinePlayback::prepareFrame(int swapchainFrameIndex) {
             }
 
             if (!isNewFrame) {
-                // Still showing held frame — add existing texture as layer, skip re-upload
+                // No new frame — show last texture if available, skip re-upload
                 auto stateIt = m_trackStates.find(trackId);
                 if (stateIt != m_trackStates.end() && stateIt->second.initialized) {
                     LayerInfo layer;
-                    layer.descriptorSet = stateIt->second.texture.getDisplayDescriptor();
+                    layer.descriptorSet = stateIt->second.texture->getDisplayDescriptor();
                     layer.width = stateIt->second.lastWidth;
                     layer.height = stateIt->second.lastHeight;
                     layer.trackId = trackId;
@@ -323,21 +421,42 @@ std::vector<LayerInfo> TimelinePlayback::prepareFrame(int swapchainFrameIndex) {
                 m_firstFrameReceived = true;
             }
 
-            auto& state = ensureTrackRenderState(trackId, w, h);
+            int w = frame.width;
+            int h = frame.height;
+            auto& state = ensureTrackRenderState(trackId, w, h, frame.yuv);
+            if (!state.initialized) {
+                player->releaseVideoFrame();
+                continue;
+            }
 
-            int uploadSlot = state.texture.acquireUploadSlot();
-            state.uploader.stage(*m_vkCtx, swapchainFrameIndex, frameData, w, h);
-            state.texture.promoteUploadSlot();
+            // The decoder wrote straight into mapped staging memory; copy
+            // from the queue slot and keep it reserved until the GPU is done.
+            int uploadSlot = state.texture->acquireUploadSlot();
+            state.texture->promoteUploadSlot();
+            m_frameAllocator.flush(frame.handle);
+            m_heldFrames[swapchainFrameIndex].push_back(clip->id);
 
             PendingUpload pu;
             pu.trackId = trackId;
             pu.uploadSlot = uploadSlot;
             pu.width = w;
             pu.height = h;
+            pu.srcBuffer = MappedFrameAllocator::bufferOf(frame.handle)->buffer;
+            pu.rowLength = static_cast<uint32_t>(frame.linesize / 4);
+            pu.yuv = frame.yuv;
+            if (frame.yuv) {
+                for (int i = 0; i < 3; i++) {
+                    pu.planes.offset[i] = static_cast<uint32_t>(frame.planeOffset[i]);
+                    pu.planes.linesize[i] = static_cast<uint32_t>(frame.planeLinesize[i]);
+                }
+                pu.color.kr = frame.kr;
+                pu.color.kb = frame.kb;
+                pu.color.fullRange = frame.fullRange;
+            }
             m_pendingUploads.push_back(pu);
 
             LayerInfo layer;
-            layer.descriptorSet = state.texture.getDisplayDescriptor();
+            layer.descriptorSet = state.texture->getDisplayDescriptor();
             layer.width = w;
             layer.height = h;
             layer.trackId = trackId;
@@ -362,13 +481,15 @@ std::vector<LayerInfo> TimelinePlayback::prepareFrame(int swapchainFrameIndex) {
         if (now - m_debugLastPrint >= 1.0) {
             fprintf(stderr,
                 "[TIMELINE] t=%.2f/%.2f | clips=%zu layers=%zu | "
-                "video=%.1ffps new=%llu held=%llu | audio=%s",
+                "video=%.1ffps new=%llu held=%llu | audio=%s latency=%.1fms mixdown=%ds",
                 currentTime, getDuration(),
                 m_activeClipIds.size(), layers.size(),
                 m_videoFps,
                 (unsigned long long)m_debugNewFrames,
                 (unsigned long long)m_debugHeldFrames,
-                m_audioStarted ? "on" : "off");
+                m_audioStarted ? "on" : "off",
+                m_audioOutput ? m_audioOutput->getLatency() * 1000.0 : 0.0,
+                m_mixdown.getReadyBlockCount());
 
             // Verbose: per-clip queue depths
             if (m_verbose) {
@@ -397,13 +518,21 @@ std::vector<LayerInfo> TimelinePlayback::prepareFrame(int swapchainFrameIndex) {
 }
 
 void TimelinePlayback::recordUploads(VkCommandBuffer cmd, int swapchainFrameIndex) {
+    m_imageCache.recordUploads(cmd);
+
     for (auto& pu : m_pendingUploads) {
         auto it = m_trackStates.find(pu.trackId);
-        if (it == m_trackStates.end()) continue;
-
-        it->second.uploader.recordUpload(cmd, swapchainFrameIndex,
-                                          it->second.texture, pu.uploadSlot,
-                                          pu.width, pu.height);
+        if (it == m_trackStates.end() || !it->second.texture) continue;
+
+        if (pu.yuv) {
+            m_yuvConverter.record(cmd, pu.srcBuffer, pu.planes,
+                                  *it->second.texture, pu.uploadSlot,
+                                  pu.width, pu.height, pu.color);
+        } else {
+            TextureUploader::recordUploadFrom(cmd, pu.srcBuffer, pu.rowLength,
+                                              *it->second.texture, pu.uploadSlot,
+                                              pu.width, pu.height);
+        }
     }
     m_pendingUploads.clear();
 }
@@ -415,23 +544,37 @@ double TimelinePlayback::getCurrentTime() const {
     return m_masterClock.get();
 }
 
+bool TimelinePlayback::isUnderLoad() const {
+    if (m_state != State::Playing) return false;
+    for (const auto& [clipId, player] : m_clipPlayers) {
+        if (player->hasVideo() && player->getVideoFrameQueueSize() < 2) return true;
+    }
+    return false;
+}
+
 double TimelinePlayback::getDuration() const {
     if (!m_timeline) return 0.0;
     return m_timeline->getTotalDuration();
 }
 
-TrackRenderState& TimelinePlayback::ensureTrackRenderState(uint32_t trackId, int width, int height) {
+TrackRenderState& TimelinePlayback::ensureTrackRenderState(uint32_t trackId, int width, int height,
+                                                           bool yuv) {
     auto& state = m_trackStates[trackId];
 
+    // Size or layout changed (e.g. the next clip has another resolution):
+    // swap in a pooled texture. The old one is only recycled once no frame
+    // in flight can still be sampling it, so there is no device wait here.
+    if (state.initialized &&
+        (state.lastWidth != width || state.lastHeight != height ||
+         state.texture->isYuv() != yuv)) {
+        m_texturePool.release(state.texture);
+        state.texture = nullptr;
+        state.initialized = false;
+    }
+
     if (!state.initialized) {
-        state.texture.init(*m_vkCtx, width, height);
-        state.uploader.init(*m_vkCtx, width, height);
-        state.initialized = true;
-        state.lastWidth = width;
-        state.lastHeight = height;
-    } else if (state.lastWidth != width || state.lastHeight != height) {
-        state.texture.resize(*m_vkCtx, width, height);
-        state.uploader.ensureCapacity(*m_vkCtx, width, height);
+        state.texture = m_texturePool.acquire(width, height, yuv);
+        state.initialized = state.texture != nullptr;
         state.lastWidth = width;
         state.lastHeight = height;
     }
@@ -439,6 +582,22 @@ TrackRenderState& TimelinePlayback::ensureTrackRenderState(uint32_t trackId, int
     return state;
 }
 
+void TimelinePlayback::releaseIdleTrackStates(double time) {
+    // Tracks that were deleted or have nothing under the playhead hand their
+    // texture back so another track can reuse it
+    for (auto it = m_trackStates.begin(); it != m_trackStates.end();) {
+        const auto* track = m_timeline->getTrack(it->first);
+        bool keep = track && track->type == TrackType::Video &&
+                    m_timeline->getActiveClipOnTrack(it->first, time);
+        if (keep) {
+            ++it;
+            continue;
+        }
+        if (it->second.texture) m_texturePool.release(it->second.texture);
+        it = m_trackStates.erase(it);
+    }
+}
+
 void TimelinePlayback::activateClip(uint32_t clipId) {
     const auto* clip = m_timeline->getClip(clipId);
     if (!clip) return;
@@ -447,7 +606,7 @@ void TimelinePlayback::activateClip(uint32_t clipId) {
     if (!track) return;
 
     const auto* asset = m_timeline->getAsset(clip->assetId);
-    if (!asset) return;
+    if (!asset || asset->pending) return;
 
     // Determine which streams to decode based on track type
     // This prevents unconsumed streams from blocking the pipeline
@@ -456,13 +615,29 @@ void TimelinePlayback::activateClip(uint32_t clipId) {
 
     if (!needVideo && !needAudio) return;
 
+    // Cached audio needs no player at all
+    if (needAudio) {
+        if (auto pcm = cachedAudio(*clip)) {
+            if (m_verbose) {
+                fprintf(stderr, "[TIMELINE] Activate clip %u on %s (cached audio)\n",
+                        clipId, track->name.c_str());
+            }
+            m_pcmClips[clipId] = std::move(pcm);
+            m_activeClipIds.insert(clipId);
+            return;
+        }
+    }
+
     auto player = std::make_unique<ClipPlayer>();
+    player->setFrameAllocator(&m_frameAllocator);
+    player->setOutputYuv(m_yuvConverter.isReady());
     if (!player->open(asset->filePath, needVideo, needAudio, AudioMixer::OUTPUT_SAMPLE_RATE)) {
         fprintf(stderr, "TimelinePlayback: failed to open clip %u: %s\n",
                 clipId, asset->filePath.c_str());
         return;
     }
 
+    player->setAudioStretch(clip->speed, clip->sourceIn);
     player->play();
 
     // Seek to the right source position based on current timeline time
@@ -481,32 +656,65 @@ void TimelinePlayback::activateClip(uint32_t clipId) {
     m_activeClipIds.insert(clipId);
 }
 
+std::shared_ptr<const PcmBuffer> TimelinePlayback::cachedAudio(const Clip& clip) const {
+    if (!m_audioCache) return nullptr;
+    const auto* asset = m_timeline->getAsset(clip.assetId);
+    if (!asset || !asset->hasAudio) return nullptr;
+    return m_audioCache->get(asset->id, asset->filePath);
+}
+
 void TimelinePlayback::deactivateClip(uint32_t clipId) {
     auto it = m_clipPlayers.find(clipId);
     if (it != m_clipPlayers.end()) {
         if (m_verbose) {
             fprintf(stderr, "[TIMELINE] Deactivate clip %u\n", clipId);
         }
-        it->second->stop();
+        retirePlayer(std::move(it->second));
         m_clipPlayers.erase(it);
     }
+    // Cached buffers live as long as the cache, so nothing to retire
+    m_pcmClips.erase(clipId);
     m_activeClipIds.erase(clipId);
+
+    // Its queue is gone; the staging buffers themselves outlive in-flight
+    // copies via MappedFrameAllocator's deferred free.
+    for (auto& held : m_heldFrames) {
+        held.erase(std::remove(held.begin(), held.end(), clipId), held.end());
+    }
+}
+
+void TimelinePlayback::releaseHeldFrames(int swapchainFrameIndex) {
+    for (uint32_t clipId : m_heldFrames[swapchainFrameIndex]) {
+        auto it = m_clipPlayers.find(clipId);
+        if (it != m_clipPlayers.end()) it->second->releaseVideoFrame();
+    }
+    m_heldFrames[swapchainFrameIndex].clear();
+}
+
+void TimelinePlayback::forgetHeldFrames() {
+    for (auto& held : m_heldFrames) held.clear();
 }
 
 void TimelinePlayback::rebuildAudioSources() {
     if (!m_timeline) return;
 
+    // The mixer reads the clips, tracks and buses from a snapshot it shares
+    // ownership of, not from the live timeline the UI keeps editing
+    auto tables = std::make_shared<const Timeline>(m_timeline->snapshot());
+    m_sourceEditVersion = m_timeline->getEditVersion();
+
     std::vector<AudioMixSource> sources;
 
     for (auto& [clipId, player] : m_clipPlayers) {
         if (!player->hasAudio()) continue;
 
-        const auto* clip = m_timeline->getClip(clipId);
+        const auto* clip = tables->getClip(clipId);
         if (!clip) continue;
 
-        const auto* track = m_timeline->getTrack(clip->trackId);
+        const auto* track = tables->getTrack(clip->trackId);
         if (!track || track->type != TrackType::Audio) continue;
 
+        player->setAudioStretch(clip->speed, clip->sourceIn);
         AudioMixSource src;
         src.queue = &player->getAudioFrameQueue();
         src.clip = clip;
@@ -516,5 +724,52 @@ void TimelinePlayback::rebuildAudioSources() {
         sources.push_back(src);
     }
 
-    m_audioMixer.setSources(std::move(sources));
+    for (auto& [clipId, pcm] : m_pcmClips) {
+        const auto* clip = tables->getClip(clipId);
+        if (!clip) continue;
+
+        const auto* track = tables->getTrack(clip->trackId);
+        if (!track || track->type != TrackType::Audio) continue;
+
+        AudioMixSource src;
+        src.pcm = pcm.get();
+        src.clip = clip;
+        src.track = track;
+        src.clipId = clipId;
+        sources.push_back(src);
+    }
+
+    std::vector<const AudioBus*> buses;
+    for (const auto& [busId, bus] : tables->getAllBuses()) buses.push_back(&bus);
+    const AudioEffectChain* masterEffects = &tables->getMasterEffects();
+    publishAudioSources(std::move(sources), buses, masterEffects, std::move(tables));
+}
+
+void TimelinePlayback::publishAudioSources(std::vector<AudioMixSource> sources,
+                                           const std::vector<const AudioBus*>& buses,
+                                           const AudioEffectChain* masterEffects,
+                                           std::shared_ptr<const Timeline> tables) {
+    uint64_t token = m_audioMixer.setSources(std::move(sources), buses, masterEffects);
+    for (auto& retired : m_retiredPlayers) {
+        if (retired.published) continue;
+        retired.token = token;
+        retired.published = true;
+    }
+    if (m_sourceTables) m_retiredTables.push_back({std::move(m_sourceTables), token});
+    m_sourceTables = std::move(tables);
+}
+
+void TimelinePlayback::retirePlayer(std::unique_ptr<ClipPlayer> player) {
+    m_retiredPlayers.push_back({std::move(player), 0, false});
+}
+
+void TimelinePlayback::reapRetiredPlayers() {
+    m_audioMixer.reclaim();
+    // Destroying a player stops its threads and frees its queues
+    std::erase_if(m_retiredPlayers, [this](const RetiredPlayer& retired) {
+        return retired.published && m_audioMixer.isReleased(retired.token);
+    });
+    std::erase_if(m_retiredTables, [this](const RetiredTables& retired) {
+        return m_audioMixer.isReleased(retired.token);
+    });
 }
@@ -4,8 +4,14 @@
 #include "timeline/ClipPlayer.h"
 #include "media/Clock.h"
 #include "media/AudioMixer.h"
+#include "media/MixdownCache.h"
 #include "vulkan/VideoTexture.h"
+#include "vulkan/VideoTexturePool.h"
 #include "vulkan/TextureUploader.h"
+#include "vulkan/ImageTextureCache.h"
+#include "vulkan/MappedFrameAllocator.h"
+#include "vulkan/YuvConverter.h"
+#include "vulkan/Swapchain.h"
 #include <unordered_map>
 #include <unordered_set>
 #include <memory>
@@ -14,11 +20,14 @@
 
 struct VulkanContext;
 class AudioOutput;
+class AudioPcmCache;
+class PcmBuffer;
 
-// Per-track GPU resources for video/image rendering.
+// Per-track GPU resources for video rendering. Uploads copy straight from
+// the ClipPlayer's mapped FrameQueue slot, so no per-track staging is needed.
+// The texture is borrowed from the shared VideoTexturePool.
 struct TrackRenderState {
-    VideoTexture texture;
-    TextureUploader uploader;
+    VideoTexture* texture = nullptr;
     bool initialized = false;
     int lastWidth = 0;
     int lastHeight = 0;
@@ -38,6 +47,13 @@ struct PendingUpload {
     int uploadSlot = 0;
     int width = 0;
     int height = 0;
+    VkBuffer srcBuffer = VK_NULL_HANDLE;   // mapped FrameQueue slot (copy source)
+    uint32_t rowLength = 0;                // in pixels, 0 = tightly packed
+
+    // YUV 4:2:0 slot: planes are copied and converted on the GPU
+    bool yuv = false;
+    YuvPlaneLayout planes;
+    YuvColorInfo color;
 };
 
 // Central orchestrator: owns ClipPlayer pool, per-track GPU resources,
@@ -49,14 +65,26 @@ public:
 
     ~TimelinePlayback();
 
-    void setTimeline(Timeline* timeline) { m_timeline = timeline; }
+    void setTimeline(const Timeline* timeline) { m_timeline = timeline; }
 
     void init(VulkanContext& ctx);
     void shutdown();
 
     void setAudioOutput(AudioOutput* ao) { m_audioOutput = ao; }
+
+    // Audio clips whose asset is decoded in the cache play from it, without
+    // a decoder. The cache must outlive this.
+    void setAudioCache(AudioPcmCache* cache) { m_audioCache = cache; }
+
+    // Memory for the pre-rendered mix of settled timeline ranges (see
+    // MixdownCache), 0 = always mix live. Before init(); needs the audio
+    // cache, as only cached audio is pre-rendered.
+    void setMixdownBudget(size_t bytes) { m_mixdownBudget = bytes; }
     void setVerbose(bool v) { m_verbose = v; }
 
+    // GPU memory for still-image textures (see ImageTextureCache)
+    void setImageCacheBudget(VkDeviceSize bytes) { m_imageCache.setBudget(bytes); }
+
     // Transport controls
     void play();
     void pause();
@@ -64,6 +92,13 @@ public:
     void stop();
     void seek(double timelineSeconds);
 
+    // Ruler drags. scrub() moves the playhead like seek() but keeps audio
+    // running, playing grains that follow the drag (from cached audio).
+    // endScrub() lands on the last position and resumes if it was playing.
+    void scrub(double timelineSeconds);
+    void endScrub();
+    bool isScrubbing() const { return m_scrubbing; }
+
     // Called each frame: activate/deactivate ClipPlayers based on playhead.
     void update();
 
@@ -84,27 +119,85 @@ public:
     double getVideoFps() const { return m_videoFps; }
     size_t getActiveClipCount() const { return m_activeClipIds.size(); }
 
+    // Playing with some video decoder close to running dry; background work
+    // (e.g. thumbnail generation) should back off
+    bool isUnderLoad() const;
+
 private:
-    TrackRenderState& ensureTrackRenderState(uint32_t trackId, int width, int height);
+    TrackRenderState& ensureTrackRenderState(uint32_t trackId, int width, int height,
+                                             bool yuv = false);
     void activateClip(uint32_t clipId);
+    std::shared_ptr<const PcmBuffer> cachedAudio(const Clip& clip) const;
     void deactivateClip(uint32_t clipId);
     void rebuildAudioSources();
-
-    Timeline* m_timeline = nullptr;
+    void publishAudioSources(std::vector<AudioMixSource> sources,
+                             const std::vector<const AudioBus*>& buses = {},
+                             const AudioEffectChain* masterEffects = nullptr,
+                             std::shared_ptr<const Timeline> tables = nullptr);
+    void retirePlayer(std::unique_ptr<ClipPlayer> player);
+    void reapRetiredPlayers();
+    void releaseHeldFrames(int swapchainFrameIndex);
+    void forgetHeldFrames();
+    void releaseIdleTrackStates(double time);
+
+    const Timeline* m_timeline = nullptr;
     VulkanContext* m_vkCtx = nullptr;
     AudioOutput* m_audioOutput = nullptr;
+    AudioPcmCache* m_audioCache = nullptr;
 
     State m_state = State::Stopped;
     Clock m_masterClock;
     bool m_audioStarted = false;
     bool m_verbose = false;
+    bool m_scrubbing = false;
+    bool m_playAfterScrub = false;
+    double m_scrubTime = 0.0;
 
     std::unordered_map<uint32_t, std::unique_ptr<ClipPlayer>> m_clipPlayers;
-    std::unordered_map<uint32_t, TrackRenderState> m_trackStates;
+    std::unordered_map<uint32_t, std::shared_ptr<const PcmBuffer>> m_pcmClips;  // active, cached audio
+
+    // Deactivated players whose audio queue the mixer may still be reading.
+    // Stopping a player frees its queued frames, so it is kept running
+    // until the mixer releases the source set published after it left.
+    struct RetiredPlayer {
+        std::unique_ptr<ClipPlayer> player;
+        uint64_t token = 0;
+        bool published = false;  // token is valid
+    };
+    std::vector<RetiredPlayer> m_retiredPlayers;
+
+    // Snapshot the published sources point into (their Clip, Track, bus and
+    // effect pointers), so an edit that detaches the live tables can't free
+    // them under the mixer. Replaced ones are kept, like retired players,
+    // until the mixer releases the list that used them.
+    struct RetiredTables {
+        std::shared_ptr<const Timeline> timeline;
+        uint64_t token = 0;
+    };
+    std::shared_ptr<const Timeline> m_sourceTables;
+    std::vector<RetiredTables> m_retiredTables;
+    std::unordered_map<uint32_t, TrackRenderState> m_trackStates;  // video tracks
+    VideoTexturePool m_texturePool;                                   // backs m_trackStates
+    ImageTextureCache m_imageCache;                                   // image tracks
+    std::unordered_set<uint32_t> m_liveImageAssets;  // image assets some clip uses
+    uint64_t m_liveImageVersion = 0;                 // timeline edit version of the above
+
+    // Decoded video frames land directly in these mapped staging buffers.
+    // A slot copied during frame N is handed back to its ClipPlayer once
+    // frame N's fence has been waited on (same swapchain frame index).
+    MappedFrameAllocator m_frameAllocator;
+    YuvConverter m_yuvConverter;            // unused (RGBA path) if init failed
+    std::vector<uint32_t> m_heldFrames[Swapchain::MAX_FRAMES_IN_FLIGHT];  // clip IDs
     std::vector<PendingUpload> m_pendingUploads;
     AudioMixer m_audioMixer;
+    MixdownCache m_mixdown;  // attached to m_audioMixer when enabled
+    size_t m_mixdownBudget = MixdownCache::DEFAULT_BUDGET;
     std::unordered_set<uint32_t> m_activeClipIds;
 
+    // Timeline edit version m_sourceTables was taken at; update() publishes
+    // a fresh snapshot once the live timeline has moved on
+    uint64_t m_sourceEditVersion = 0;
+
     bool m_firstFrameReceived = false;
 
     // Stats
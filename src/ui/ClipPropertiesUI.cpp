@@ -1,8 +1,11 @@
 #include "ui/ClipPropertiesUI.h"
 #include "timeline/Timeline.h"
+#include "media/TimeStretch.h"
 #include <imgui.h>
 #include <algorithm>
+#include <cmath>
 #include <cstdio>
+#include <vector>
 
 static const char* mediaTypeName(MediaType type) {
     switch (type) {
@@ -22,7 +25,158 @@ static const char* trackTypeName(TrackType type) {
     return "Unknown";
 }
 
-void ClipPropertiesUI::render(Timeline& timeline, uint32_t selectedClipId, double fps) {
+// Buses in creation order
+static std::vector<const AudioBus*> sortedBuses(const Timeline& timeline) {
+    std::vector<const AudioBus*> buses;
+    for (const auto& [busId, bus] : timeline.getAllBuses()) buses.push_back(&bus);
+    std::sort(buses.begin(), buses.end(),
+              [](const AudioBus* a, const AudioBus* b) { return a->id < b->id; });
+    return buses;
+}
+
+// Keyframes of one curve: edit a key's value, remove it, or key the
+// current value at `time`. Returns true with `curve` replaced on an edit.
+static bool curveEditor(const char* label, AutomationCurve& curve, double time,
+                        float minValue, float maxValue, float defaultValue) {
+    std::vector<AutomationPoint> points = curve.points();
+    bool changed = false;
+
+    ImGui::PushID(label);
+    ImGui::Text("%s: %zu keys", label, points.size());
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Key at Playhead")) {
+        time = std::max(0.0, time);
+        AutomationPoint point{time, curve.evaluate(time, defaultValue)};
+        auto it = std::find_if(points.begin(), points.end(),
+                               [&](const AutomationPoint& p) { return std::abs(p.time - time) < 1e-4; });
+        if (it != points.end()) *it = point;
+        else points.push_back(point);
+        changed = true;
+    }
+
+    int removeIndex = -1;
+    for (size_t i = 0; i < points.size(); i++) {
+        ImGui::PushID(static_cast<int>(i));
+        ImGui::Text("%8.3f s", points[i].time);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120);
+        changed |= ImGui::SliderFloat("##value", &points[i].value, minValue, maxValue, "%.2f");
+        ImGui::SameLine();
+        if (ImGui::SmallButton("x")) removeIndex = static_cast<int>(i);
+        ImGui::PopID();
+    }
+    if (removeIndex >= 0) {
+        points.erase(points.begin() + removeIndex);
+        changed = true;
+    }
+    ImGui::PopID();
+
+    if (changed) curve.setPoints(std::move(points));
+    return changed;
+}
+
+// Nearest clip on the same track that starts earlier and runs into `clip`
+static uint32_t previousOverlapping(const Track& track, const Clip& clip) {
+    uint32_t found = 0;
+    double foundStart = -1.0;
+    track.clips.forEach([&](const ClipSpan& span) {
+        if (span.clipId == clip.id || span.start >= clip.timelineStart) return;
+        if (span.end > clip.timelineStart && span.start > foundStart) {
+            found = span.clipId;
+            foundStart = span.start;
+        }
+    });
+    return found;
+}
+
+// Pick a bus to feed (0 = master). Returns true if the selection changed.
+static bool busCombo(const char* label, const std::vector<const AudioBus*>& buses,
+                     uint32_t& busId, uint32_t excludeId = 0) {
+    const char* preview = "Master";
+    for (const auto* bus : buses) {
+        if (bus->id == busId) preview = bus->name.c_str();
+    }
+
+    bool changed = false;
+    ImGui::SetNextItemWidth(120);
+    if (ImGui::BeginCombo(label, preview)) {
+        if (ImGui::Selectable("Master", busId == 0)) {
+            busId = 0;
+            changed = true;
+        }
+        for (const auto* bus : buses) {
+            if (bus->id == excludeId) continue;
+            ImGui::PushID(static_cast<int>(bus->id));
+            if (ImGui::Selectable(bus->name.c_str(), bus->id == busId)) {
+                busId = bus->id;
+                changed = true;
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndCombo();
+    }
+    return changed;
+}
+
+// Insert effect controls, editing a copy. Returns true if anything changed.
+static bool effectChainEditor(AudioEffectChain& chain) {
+    static const char* const BAND_TYPES[] = {"Low Shelf", "Peak", "High Shelf", "Low Pass", "High Pass"};
+    bool changed = false;
+
+    changed |= ImGui::Checkbox("EQ", &chain.eqEnabled);
+    if (chain.eqEnabled) {
+        for (int b = 0; b < AudioEffectChain::EQ_BANDS; b++) {
+            EqBand& band = chain.eq[b];
+            ImGui::PushID(b);
+            int type = static_cast<int>(band.type);
+            ImGui::SetNextItemWidth(100);
+            if (ImGui::Combo("##type", &type, BAND_TYPES, IM_ARRAYSIZE(BAND_TYPES))) {
+                band.type = static_cast<EqBandType>(type);
+                changed = true;
+            }
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(120);
+            changed |= ImGui::SliderFloat("Hz", &band.frequency, 20.0f, 20000.0f, "%.0f",
+                                          ImGuiSliderFlags_Logarithmic);
+            ImGui::SetNextItemWidth(100);
+            changed |= ImGui::SliderFloat("dB", &band.gainDb, -18.0f, 18.0f, "%.1f");
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(100);
+            changed |= ImGui::SliderFloat("Q", &band.q, 0.1f, 10.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+            ImGui::PopID();
+        }
+    }
+
+    auto& comp = chain.compressor;
+    changed |= ImGui::Checkbox("Compressor", &comp.enabled);
+    if (comp.enabled) {
+        ImGui::SetNextItemWidth(120);
+        changed |= ImGui::SliderFloat("Threshold", &comp.thresholdDb, -60.0f, 0.0f, "%.1f dB");
+        ImGui::SetNextItemWidth(120);
+        changed |= ImGui::SliderFloat("Ratio", &comp.ratio, 1.0f, 20.0f, "%.1f:1");
+        ImGui::SetNextItemWidth(120);
+        changed |= ImGui::SliderFloat("Attack", &comp.attackMs, 0.1f, 100.0f, "%.1f ms",
+                                      ImGuiSliderFlags_Logarithmic);
+        ImGui::SetNextItemWidth(120);
+        changed |= ImGui::SliderFloat("Release##comp", &comp.releaseMs, 10.0f, 1000.0f, "%.0f ms",
+                                      ImGuiSliderFlags_Logarithmic);
+        ImGui::SetNextItemWidth(120);
+        changed |= ImGui::SliderFloat("Makeup", &comp.makeupDb, 0.0f, 24.0f, "%.1f dB");
+    }
+
+    auto& limiter = chain.limiter;
+    changed |= ImGui::Checkbox("Limiter", &limiter.enabled);
+    if (limiter.enabled) {
+        ImGui::SetNextItemWidth(120);
+        changed |= ImGui::SliderFloat("Ceiling", &limiter.ceilingDb, -12.0f, 0.0f, "%.1f dB");
+        ImGui::SetNextItemWidth(120);
+        changed |= ImGui::SliderFloat("Release##limiter", &limiter.releaseMs, 1.0f, 500.0f, "%.0f ms",
+                                      ImGuiSliderFlags_Logarithmic);
+    }
+    return changed;
+}
+
+void ClipPropertiesUI::render(Timeline& timeline, uint32_t selectedClipId, double fps, double playhead) {
     ImGui::Begin("Clip Properties");
 
     if (selectedClipId == 0) {
@@ -31,15 +185,18 @@ void ClipPropertiesUI::render(Timeline& timeline, uint32_t selectedClipId, doubl
         return;
     }
 
-    auto* clip = timeline.getClip(selectedClipId);
+    // Read through the const accessors: edits below go through the
+    // Timeline's setters, so an idle panel never detaches a table
+    const Timeline& view = timeline;
+    const auto* clip = view.getClip(selectedClipId);
     if (!clip) {
         ImGui::TextDisabled("Clip not found");
         ImGui::End();
         return;
     }
 
-    const auto* track = timeline.getTrack(clip->trackId);
-    const auto* asset = timeline.getAsset(clip->assetId);
+    const auto* track = view.getTrack(clip->trackId);
+    const auto* asset = view.getAsset(clip->assetId);
 
     double frameDuration = (fps > 0.0) ? (1.0 / fps) : (1.0 / 30.0);
 
@@ -53,29 +210,41 @@ void ClipPropertiesUI::render(Timeline& timeline, uint32_t selectedClipId, doubl
 
         ImGui::SetNextItemWidth(120);
         if (ImGui::InputDouble("Timeline Start", &timelineStart, 0.0, 0.0, "%.3f")) {
-            clip->timelineStart = std::max(0.0, timelineStart);
+            timeline.setClipTiming(clip->id, std::max(0.0, timelineStart),
+                                   clip->sourceIn, clip->sourceOut);
         }
 
         // Nudge buttons for frame-accurate positioning
         ImGui::SameLine();
         if (ImGui::SmallButton("-##nudgeL")) {
-            clip->timelineStart = std::max(0.0, clip->timelineStart - frameDuration);
+            timeline.setClipTiming(clip->id, std::max(0.0, clip->timelineStart - frameDuration),
+                                   clip->sourceIn, clip->sourceOut);
         }
         ImGui::SameLine();
         if (ImGui::SmallButton("+##nudgeR")) {
-            clip->timelineStart += frameDuration;
+            timeline.setClipTiming(clip->id, clip->timelineStart + frameDuration,
+                                   clip->sourceIn, clip->sourceOut);
         }
 
         ImGui::SetNextItemWidth(120);
         if (ImGui::InputDouble("Source In", &sourceIn, 0.0, 0.0, "%.3f")) {
             double maxIn = clip->sourceOut - 0.01;
-            clip->sourceIn = std::clamp(sourceIn, 0.0, maxIn);
+            timeline.setClipTiming(clip->id, clip->timelineStart,
+                                   std::clamp(sourceIn, 0.0, maxIn), clip->sourceOut);
         }
 
         ImGui::SetNextItemWidth(120);
         if (ImGui::InputDouble("Source Out", &sourceOut, 0.0, 0.0, "%.3f")) {
             double maxOut = asset ? asset->duration : 3600.0;
-            clip->sourceOut = std::clamp(sourceOut, clip->sourceIn + 0.01, maxOut);
+            timeline.setClipTiming(clip->id, clip->timelineStart, clip->sourceIn,
+                                   std::clamp(sourceOut, clip->sourceIn + 0.01, maxOut));
+        }
+
+        float speed = static_cast<float>(clip->speed);
+        ImGui::SetNextItemWidth(120);
+        if (ImGui::SliderFloat("Speed", &speed, static_cast<float>(TimeStretch::MIN_SPEED),
+                               static_cast<float>(TimeStretch::MAX_SPEED), "%.2fx", ImGuiSliderFlags_Logarithmic)) {
+            timeline.setClipSpeed(clip->id, speed);
         }
 
         // Read-only derived values
@@ -87,6 +256,118 @@ void ClipPropertiesUI::render(Timeline& timeline, uint32_t selectedClipId, doubl
     if (track && ImGui::CollapsingHeader("Track", ImGuiTreeNodeFlags_DefaultOpen)) {
         ImGui::Text("Name: %s", track->name.c_str());
         ImGui::Text("Type: %s", trackTypeName(track->type));
+
+        if (track->type == TrackType::Audio) {
+            auto buses = sortedBuses(view);
+            uint32_t busId = track->busId;
+            if (busCombo("Output", buses, busId)) {
+                timeline.setTrackBus(track->id, busId);
+            }
+
+            float pan = track->pan;
+            ImGui::SetNextItemWidth(120);
+            if (ImGui::SliderFloat("Pan", &pan, -1.0f, 1.0f, "%.2f")) {
+                timeline.getTrack(track->id)->pan = pan;
+            }
+        }
+    }
+
+    // --- Automation ---
+    // Volume keys scale the static volume; pan keys replace the static pan.
+    // Track keys are in timeline time, clip keys from the clip's start.
+    if (track && track->type == TrackType::Audio &&
+        ImGui::CollapsingHeader("Automation")) {
+        double duration = clip->getDuration();
+        float fadeIn = static_cast<float>(clip->fadeIn);
+        float fadeOut = static_cast<float>(clip->fadeOut);
+        ImGui::SetNextItemWidth(120);
+        bool fadesChanged = ImGui::SliderFloat("Fade In", &fadeIn, 0.0f, static_cast<float>(duration), "%.2f s");
+        ImGui::SetNextItemWidth(120);
+        fadesChanged |= ImGui::SliderFloat("Fade Out", &fadeOut, 0.0f, static_cast<float>(duration), "%.2f s");
+        if (fadesChanged) timeline.setClipFades(clip->id, fadeIn, fadeOut);
+
+        uint32_t previousId = previousOverlapping(*track, *clip);
+        ImGui::BeginDisabled(previousId == 0);
+        if (ImGui::Button("Crossfade With Previous")) timeline.crossfade(previousId, clip->id);
+        ImGui::EndDisabled();
+
+        ImGui::SeparatorText("Clip");
+        double clipTime = playhead - clip->timelineStart;
+        AutomationCurve curve = clip->volumeCurve;
+        if (curveEditor("Volume##clip", curve, clipTime, 0.0f, 1.0f, 1.0f)) {
+            timeline.setClipAutomation(clip->id, AutomationParam::Volume, std::move(curve));
+        }
+        curve = clip->panCurve;
+        if (curveEditor("Pan##clip", curve, clipTime, -1.0f, 1.0f, 0.0f)) {
+            timeline.setClipAutomation(clip->id, AutomationParam::Pan, std::move(curve));
+        }
+
+        ImGui::SeparatorText("Track");
+        curve = track->volumeCurve;
+        if (curveEditor("Volume##track", curve, playhead, 0.0f, 1.0f, 1.0f)) {
+            timeline.setTrackAutomation(track->id, AutomationParam::Volume, std::move(curve));
+        }
+        curve = track->panCurve;
+        if (curveEditor("Pan##track", curve, playhead, -1.0f, 1.0f, track->pan)) {
+            timeline.setTrackAutomation(track->id, AutomationParam::Pan, std::move(curve));
+        }
+    }
+
+    // --- Effects ---
+    if (track && track->type == TrackType::Audio &&
+        ImGui::CollapsingHeader("Track Effects")) {
+        AudioEffectChain chain = track->effects;
+        ImGui::PushID("track effects");
+        if (effectChainEditor(chain)) timeline.getTrack(track->id)->effects = chain;
+        ImGui::PopID();
+    }
+    if (track && track->type == TrackType::Audio &&
+        ImGui::CollapsingHeader("Master Effects")) {
+        AudioEffectChain chain = view.getMasterEffects();
+        ImGui::PushID("master effects");
+        if (effectChainEditor(chain)) timeline.setMasterEffects(chain);
+        ImGui::PopID();
+    }
+
+    // --- Buses ---
+    // Writes go through getBus() only on an actual edit, so an idle panel
+    // never detaches the bus table from an export snapshot
+    if (track && track->type == TrackType::Audio &&
+        ImGui::CollapsingHeader("Audio Buses", ImGuiTreeNodeFlags_DefaultOpen)) {
+        auto buses = sortedBuses(view);
+        uint32_t removeId = 0;
+
+        for (const auto* bus : buses) {
+            ImGui::PushID(static_cast<int>(bus->id));
+            ImGui::TextUnformatted(bus->name.c_str());
+
+            bool muted = bus->muted;
+            ImGui::SameLine();
+            if (ImGui::Checkbox("Mute", &muted)) timeline.getBus(bus->id)->muted = muted;
+
+            float volume = bus->volume;
+            ImGui::SetNextItemWidth(120);
+            if (ImGui::SliderFloat("Volume", &volume, 0.0f, 1.0f, "%.2f")) {
+                timeline.getBus(bus->id)->volume = volume;
+            }
+
+            uint32_t parentId = bus->parentId;
+            if (busCombo("Output", buses, parentId, bus->id) &&
+                !timeline.setBusParent(bus->id, parentId)) {
+                fprintf(stderr, "Bus '%s' can't feed a bus that feeds it\n", bus->name.c_str());
+            }
+
+            ImGui::SameLine();
+            if (ImGui::SmallButton("Remove")) removeId = bus->id;
+            ImGui::PopID();
+        }
+        if (removeId) timeline.removeBus(removeId);
+
+        if (ImGui::Button("New Bus")) {
+            char name[32];
+            snprintf(name, sizeof(name), "Bus %zu", buses.size() + 1);
+            timeline.addBus(name);
+        }
     }
 
     // --- Media ---
@@ -6,5 +6,6 @@ class Timeline;
 
 class ClipPropertiesUI {
 public:
-    void render(Timeline& timeline, uint32_t selectedClipId, double fps);
+    // `playhead` (timeline seconds) is where new automation keys go
+    void render(Timeline& timeline, uint32_t selectedClipId, double fps, double playhead);
 };
@@ -1,8 +1,32 @@
 #include "ui/ExportDialog.h"
+#include "timeline/Timeline.h"
 #include <imgui.h>
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 
+void ExportDialog::setStemSources(const Timeline& timeline) {
+    std::vector<StemChoice> choices;
+    auto offer = [&](bool bus, uint32_t id, const std::string& name) {
+        StemChoice choice{{name, bus, id}, false};
+        for (const auto& old : m_stemChoices) {
+            if (old.stem.bus == bus && old.stem.id == id) choice.enabled = old.enabled;
+        }
+        choices.push_back(choice);
+    };
+
+    std::vector<const AudioBus*> buses;
+    for (const auto& [id, bus] : timeline.getAllBuses()) buses.push_back(&bus);
+    std::sort(buses.begin(), buses.end(), [](const AudioBus* a, const AudioBus* b) { return a->id < b->id; });
+    for (const AudioBus* bus : buses) offer(true, bus->id, bus->name);
+
+    for (uint32_t trackId : timeline.getTrackOrder()) {
+        const Track* track = timeline.getTrack(trackId);
+        if (track && track->type == TrackType::Audio) offer(false, track->id, track->name);
+    }
+    m_stemChoices = std::move(choices);
+}
+
 bool ExportDialog::render(ExportSettings& settings, bool& visible) {
     if (!visible) return false;
 
@@ -58,6 +82,21 @@ bool ExportDialog::render(ExportSettings& settings, bool& visible) {
             settings.audioBitrate = rates[abrIndex];
         }
 
+        // Stems come out of the same mixing pass as the full mix
+        if (!m_stemChoices.empty() && ImGui::TreeNode("Stems")) {
+            for (size_t i = 0; i < m_stemChoices.size(); i++) {
+                auto& choice = m_stemChoices[i];
+                ImGui::PushID(static_cast<int>(i));
+                ImGui::Checkbox(choice.stem.name.c_str(), &choice.enabled);
+                ImGui::SameLine();
+                ImGui::TextDisabled(choice.stem.bus ? "(bus)" : "(track)");
+                ImGui::PopID();
+            }
+            const char* stemOutputOptions[] = { "Audio streams in the file", "Separate .m4a files" };
+            ImGui::Combo("Stems To", &m_stemOutputIndex, stemOutputOptions, 2);
+            ImGui::TreePop();
+        }
+
         ImGui::Separator();
 
         // Apply resolution/fps selections
@@ -88,7 +127,14 @@ bool ExportDialog::render(ExportSettings& settings, bool& visible) {
 
         settings.outputPath = m_outputPath;
 
+        settings.stems.clear();
+        for (const auto& choice : m_stemChoices) {
+            if (choice.enabled) settings.stems.push_back(choice.stem);
+        }
+        settings.stemOutput = m_stemOutputIndex == 1 ? StemOutput::SeparateFiles : StemOutput::AudioStreams;
+
         ImGui::Text("Output: %dx%d @ %.0f fps", settings.width, settings.height, settings.fps);
+        if (!settings.stems.empty()) ImGui::Text("+ %zu audio stems", settings.stems.size());
 
         ImGui::Spacing();
         if (ImGui::Button("Export", ImVec2(120, 0))) {
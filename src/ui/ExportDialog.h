@@ -2,6 +2,9 @@
 
 #include "export/ExportSettings.h"
 #include "export/ExportSession.h"
+#include <vector>
+
+class Timeline;
 
 class ExportDialog {
 public:
@@ -16,12 +19,23 @@ public:
         m_sourceWidth = w; m_sourceHeight = h; m_sourceFps = fps;
     }
 
+    // Offer the timeline's buses and audio tracks as stems. Keeps the
+    // choices of ones offered before.
+    void setStemSources(const Timeline& timeline);
+
 private:
     char m_outputPath[512] = "output.mp4";
     int m_codecIndex = 0;
     int m_resIndex = 0;  // 0=source, 1=1080p, 2=720p, 3=480p
     int m_fpsIndex = 0;  // 0=source, 1=60, 2=30, 3=24
 
+    struct StemChoice {
+        ExportStem stem;
+        bool enabled = false;
+    };
+    std::vector<StemChoice> m_stemChoices;
+    int m_stemOutputIndex = 0;  // 0=audio streams, 1=separate files
+
     // Source dimensions (set from settings before render)
     int m_sourceWidth = 0;
     int m_sourceHeight = 0;
@@ -1,17 +1,24 @@
 #include "ui/TimelineUI.h"
 #include "timeline/Timeline.h"
+#include "media/ThumbnailService.h"
+#include "media/WaveformService.h"
+#include "vulkan/ThumbnailAtlas.h"
 #include <imgui.h>
 #include <imgui_internal.h>
 #include <algorithm>
 #include <cstdio>
+#include <utility>
 #include <cmath>
 
 // Color constants
 static const ImU32 COL_VIDEO_CLIP    = IM_COL32(70, 130, 200, 255);
 static const ImU32 COL_AUDIO_CLIP    = IM_COL32(70, 180, 100, 255);
 static const ImU32 COL_IMAGE_CLIP    = IM_COL32(200, 180, 60, 255);
+static const ImU32 COL_PENDING_CLIP  = IM_COL32(90, 90, 100, 255);
 static const ImU32 COL_CLIP_SELECTED = IM_COL32(255, 255, 255, 80);
 static const ImU32 COL_CLIP_BORDER   = IM_COL32(255, 255, 255, 100);
+static const ImU32 COL_WAVEFORM_PEAK = IM_COL32(20, 70, 35, 200);
+static const ImU32 COL_WAVEFORM_RMS  = IM_COL32(150, 230, 170, 220);
 static const ImU32 COL_PLAYHEAD      = IM_COL32(220, 50, 50, 255);
 static const ImU32 COL_RULER_BG      = IM_COL32(40, 40, 45, 255);
 static const ImU32 COL_RULER_TICK    = IM_COL32(180, 180, 180, 255);
@@ -198,11 +205,20 @@ void TimelineUI::render(Timeline& timeline, double currentTime, double totalDura
                         continue;
                     }
 
-                    const auto* track = timeline.getTrack(trackId);
+                    const auto* track = std::as_const(timeline).getTrack(trackId);
                     if (!track) { clickTrackY += TRACK_HEIGHT; continue; }
 
-                    for (uint32_t clipId : track->clipIds) {
-                        const auto* clip = timeline.getClip(clipId);
+                    // Only clips within a pixel of the cursor can be hit
+                    double mouseTime = m_viewStart + ((mousePos.x - laneX) / laneWidth) * m_viewDuration;
+                    double pixelTime = m_viewDuration / laneWidth;
+                    std::vector<uint32_t> candidates;
+                    track->clips.forEachOverlapping(mouseTime - pixelTime, mouseTime + pixelTime,
+                                                    [&](const ClipSpan& span) {
+                        candidates.push_back(span.clipId);
+                    });
+
+                    for (uint32_t clipId : candidates) {
+                        const auto* clip = std::as_const(timeline).getClip(clipId);
                         if (!clip) continue;
 
                         float startFrac = static_cast<float>((clip->timelineStart - m_viewStart) / m_viewDuration);
@@ -227,6 +243,7 @@ void TimelineUI::render(Timeline& timeline, double currentTime, double totalDura
                             } else {
                                 m_draggingClip = true;
                                 m_dragClipId = clipId;
+                                buildSnapEdges(timeline, clipId);
                                 m_dragOrigTrackId = clip->trackId;
                                 double mouseTime = m_viewStart + ((mousePos.x - laneX) / laneWidth) * m_viewDuration;
                                 m_dragStartOffset = mouseTime - clip->timelineStart;
@@ -272,7 +289,7 @@ void TimelineUI::render(Timeline& timeline, double currentTime, double totalDura
             double mouseTime = m_viewStart + ((mousePos.x - laneX) / laneWidth) * m_viewDuration;
             double newStart = mouseTime - m_dragStartOffset;
             newStart = std::max(0.0, newStart);
-            auto* clip = timeline.getClip(m_dragClipId);
+            const auto* clip = std::as_const(timeline).getClip(m_dragClipId);
             if (clip) {
                 double clipDur = clip->getDuration();
 
@@ -281,8 +298,8 @@ void TimelineUI::render(Timeline& timeline, double currentTime, double totalDura
                 uint32_t targetTrackId = clip->trackId;
                 for (size_t i = 0; i < trackOrder.size(); i++) {
                     if (mousePos.y >= clickTrackY && mousePos.y < clickTrackY + TRACK_HEIGHT) {
-                        const auto* candidateTrack = timeline.getTrack(trackOrder[i]);
-                        const auto* currentTrack = timeline.getTrack(clip->trackId);
+                        const auto* candidateTrack = std::as_const(timeline).getTrack(trackOrder[i]);
+                        const auto* currentTrack = std::as_const(timeline).getTrack(clip->trackId);
                         if (candidateTrack && currentTrack &&
                             candidateTrack->type == currentTrack->type) {
                             targetTrackId = trackOrder[i];
@@ -323,20 +340,15 @@ void TimelineUI::render(Timeline& timeline, double currentTime, double totalDura
                 trySnapStart(currentTime);
                 trySnapEnd(currentTime);
 
-                // Snap to all clip edges on all tracks
-                for (uint32_t tId : trackOrder) {
-                    const auto* t = timeline.getTrack(tId);
-                    if (!t) continue;
-                    for (uint32_t cId : t->clipIds) {
-                        if (cId == m_dragClipId) continue;
-                        const auto* other = timeline.getClip(cId);
-                        if (!other) continue;
-                        trySnapStart(other->timelineStart);
-                        trySnapStart(other->getTimelineEnd());
-                        trySnapEnd(other->timelineStart);
-                        trySnapEnd(other->getTimelineEnd());
-                    }
-                }
+                // Snap to clip edges on all tracks: only the edges either
+                // side of each dragged edge can be the closest
+                auto trySnapNearest = [&](double edgeTime, auto&& trySnap) {
+                    auto it = std::lower_bound(m_snapEdges.begin(), m_snapEdges.end(), edgeTime);
+                    if (it != m_snapEdges.end()) trySnap(*it);
+                    if (it != m_snapEdges.begin()) trySnap(*(it - 1));
+                };
+                trySnapNearest(newStart, trySnapStart);
+                trySnapNearest(newStart + clipDur, trySnapEnd);
 
                 if (bestSnapDist < snapThreshold) {
                     newStart = std::max(0.0, bestSnapStart);
@@ -344,16 +356,17 @@ void TimelineUI::render(Timeline& timeline, double currentTime, double totalDura
                     m_snapTime = bestSnapIndicator;
                 }
 
-                // Overlap prevention: push to nearest gap on target track
-                const auto* targetTrack = timeline.getTrack(targetTrackId);
+                // Overlap prevention: push to nearest gap on target track.
+                // Clips ending before newStart can't overlap, and once one
+                // starts past the (possibly pushed) end, none later can.
+                const auto* targetTrack = std::as_const(timeline).getTrack(targetTrackId);
                 if (targetTrack) {
-                    for (uint32_t otherId : targetTrack->clipIds) {
-                        if (otherId == m_dragClipId) continue;
-                        const auto* other = timeline.getClip(otherId);
-                        if (!other) continue;
+                    targetTrack->clips.forEachOverlapping(newStart, 1e300, [&](const ClipSpan& other) {
+                        if (other.start >= newStart + clipDur) return false;
+                        if (other.clipId == m_dragClipId) return true;
 
-                        double otherStart = other->timelineStart;
-                        double otherEnd = other->getTimelineEnd();
+                        double otherStart = other.start;
+                        double otherEnd = other.end;
                         double newEnd = newStart + clipDur;
 
                         if (newStart < otherEnd && newEnd > otherStart) {
@@ -365,13 +378,15 @@ void TimelineUI::render(Timeline& timeline, double currentTime, double totalDura
                                 newStart = snapRight;
                             }
                         }
-                    }
+                        return true;
+                    });
                 }
 
+                // Held still: no edit, so playback and the mixdown keep theirs
                 if (targetTrackId != clip->trackId) {
                     timeline.moveClip(m_dragClipId, targetTrackId, newStart);
-                } else {
-                    clip->timelineStart = newStart;
+                } else if (newStart != clip->timelineStart) {
+                    timeline.setClipTiming(m_dragClipId, newStart, clip->sourceIn, clip->sourceOut);
                 }
             }
         }
@@ -388,23 +403,28 @@ void TimelineUI::render(Timeline& timeline, double currentTime, double totalDura
                 m_snapTime = currentTime;
             }
 
-            auto* clip = timeline.getClip(m_trimClipId);
-            const auto* asset = clip ? timeline.getAsset(clip->assetId) : nullptr;
+            const auto* clip = std::as_const(timeline).getClip(m_trimClipId);
+            const auto* asset = clip ? std::as_const(timeline).getAsset(clip->assetId) : nullptr;
             if (clip && asset) {
                 if (m_draggingEdge == -1) {
                     double delta = mouseTime - m_trimOrigTimelineStart;
-                    double newSourceIn = m_trimOrigSourceIn + delta;
+                    double newSourceIn = m_trimOrigSourceIn + delta * clip->speed;
                     newSourceIn = std::clamp(newSourceIn, 0.0, clip->sourceOut - 0.1);
-                    clip->sourceIn = newSourceIn;
-                    clip->timelineStart = m_trimOrigTimelineStart + (newSourceIn - m_trimOrigSourceIn);
+                    if (newSourceIn != clip->sourceIn) {
+                        timeline.setClipTiming(m_trimClipId,
+                                               m_trimOrigTimelineStart + (newSourceIn - m_trimOrigSourceIn) / clip->speed,
+                                               newSourceIn, clip->sourceOut);
+                    }
                 } else {
                     double clipEndTime = mouseTime;
-                    double newSourceOut = clip->sourceIn + (clipEndTime - clip->timelineStart);
+                    double newSourceOut = clip->toSourceTime(clipEndTime);
                     double maxDuration = (asset->type == MediaType::Image)
                         ? 3600.0  // Images: allow up to 1 hour
                         : asset->duration;
                     newSourceOut = std::clamp(newSourceOut, clip->sourceIn + 0.1, maxDuration);
-                    clip->sourceOut = newSourceOut;
+                    if (newSourceOut != clip->sourceOut) {
+                        timeline.setClipTiming(m_trimClipId, clip->timelineStart, clip->sourceIn, newSourceOut);
+                    }
                 }
             }
         }
@@ -430,21 +450,30 @@ void TimelineUI::render(Timeline& timeline, double currentTime, double totalDura
                 m_selectedClipId = 0;
             }
         }
+        if (ImGui::MenuItem("Ripple Delete")) {
+            if (m_selectedClipId != 0) {
+                timeline.rippleDelete(m_selectedClipId);
+                m_selectedClipId = 0;
+            }
+        }
         if (ImGui::MenuItem("Split at Playhead", "S")) {
             if (m_selectedClipId != 0) {
-                auto* clip = timeline.getClip(m_selectedClipId);
+                const auto* clip = std::as_const(timeline).getClip(m_selectedClipId);
                 if (clip && clip->containsTime(m_currentPlayheadTime)) {
                     double splitSource = clip->toSourceTime(m_currentPlayheadTime);
                     // Create new clip for the right half
                     double rightStart = m_currentPlayheadTime;
                     double rightSourceIn = splitSource;
                     double rightSourceOut = clip->sourceOut;
+                    double speed = clip->speed;
                     uint32_t rightId = timeline.addClip(
                         clip->trackId, clip->assetId,
                         rightStart, rightSourceIn, rightSourceOut);
+                    timeline.setClipSpeed(rightId, speed);
                     // Trim left clip
-                    clip->sourceOut = splitSource;
-                    (void)rightId;
+                    clip = std::as_const(timeline).getClip(m_selectedClipId);
+                    timeline.setClipTiming(m_selectedClipId, clip->timelineStart,
+                                           clip->sourceIn, splitSource);
                 }
             }
         }
@@ -460,15 +489,19 @@ void TimelineUI::render(Timeline& timeline, double currentTime, double totalDura
     // ---- Keyboard shortcut: S = split selected clip at playhead ----
     if (!ImGui::GetIO().WantCaptureKeyboard && ImGui::IsKeyPressed(ImGuiKey_S)) {
         if (m_selectedClipId != 0) {
-            auto* clip = timeline.getClip(m_selectedClipId);
+            const auto* clip = std::as_const(timeline).getClip(m_selectedClipId);
             if (clip && clip->containsTime(m_currentPlayheadTime)) {
                 double splitSource = clip->toSourceTime(m_currentPlayheadTime);
                 double rightStart = m_currentPlayheadTime;
                 double rightSourceIn = splitSource;
                 double rightSourceOut = clip->sourceOut;
-                timeline.addClip(clip->trackId, clip->assetId,
-                                  rightStart, rightSourceIn, rightSourceOut);
-                clip->sourceOut = splitSource;
+                double speed = clip->speed;
+                uint32_t rightId = timeline.addClip(clip->trackId, clip->assetId,
+                                                    rightStart, rightSourceIn, rightSourceOut);
+                timeline.setClipSpeed(rightId, speed);
+                clip = std::as_const(timeline).getClip(m_selectedClipId);
+                timeline.setClipTiming(m_selectedClipId, clip->timelineStart,
+                                       clip->sourceIn, splitSource);
             }
         }
     }
@@ -525,7 +558,8 @@ void TimelineUI::renderTrackHeader(float x, float y, float width, float height,
                                     Timeline& timeline, uint32_t trackId,
                                     int trackIndex, int trackCount) {
     ImDrawList* drawList = ImGui::GetWindowDrawList();
-    auto* track = timeline.getTrack(trackId);
+    // Read through the const accessor every frame; only a click writes
+    const auto* track = std::as_const(timeline).getTrack(trackId);
     if (!track) return;
 
     drawList->AddRectFilled(ImVec2(x, y), ImVec2(x + width, y + height), COL_HEADER_BG);
@@ -570,7 +604,7 @@ void TimelineUI::renderTrackHeader(float x, float y, float width, float height,
         ImGui::PushStyleColor(ImGuiCol_Button,
             track->muted ? ImVec4(0.7f, 0.2f, 0.2f, 1.0f) : ImVec4(0.3f, 0.3f, 0.35f, 1.0f));
         if (ImGui::SmallButton("M")) {
-            track->muted = !track->muted;
+            timeline.getTrack(trackId)->muted = !track->muted;
         }
         ImGui::PopStyleColor();
     }
@@ -579,7 +613,7 @@ void TimelineUI::renderTrackHeader(float x, float y, float width, float height,
         ImGui::PushStyleColor(ImGuiCol_Button,
             track->visible ? ImVec4(0.3f, 0.3f, 0.35f, 1.0f) : ImVec4(0.7f, 0.2f, 0.2f, 1.0f));
         if (ImGui::SmallButton("V")) {
-            track->visible = !track->visible;
+            timeline.getTrack(trackId)->visible = !track->visible;
         }
         ImGui::PopStyleColor();
     }
@@ -588,20 +622,50 @@ void TimelineUI::renderTrackHeader(float x, float y, float width, float height,
 }
 
 void TimelineUI::renderTrackLane(float x, float y, float width, float height,
-                                  Timeline& timeline, uint32_t trackId, double totalDuration) {
+                                  const Timeline& timeline, uint32_t trackId, double totalDuration) {
     ImDrawList* drawList = ImGui::GetWindowDrawList();
-    auto* track = timeline.getTrack(trackId);
+    const auto* track = timeline.getTrack(trackId);
     if (!track) return;
 
-    for (uint32_t clipId : track->clipIds) {
+    // Only clips in view are visited. Those too narrow to show as a clip
+    // are counted per pixel column and drawn as density bars below; the
+    // index hands over whole runs of them narrower than a pixel at once.
+    int columns = std::max(1, static_cast<int>(std::ceil(width)));
+    double pixelsPerSecond = width / m_viewDuration;
+    m_laneDensity.assign(columns, 0);
+    std::vector<uint32_t> visible;
+    track->clips.forEachOverlappingCoarse(
+        m_viewStart, m_viewStart + m_viewDuration,
+        MIN_CLIP_PIXELS / pixelsPerSecond, 1.0 / pixelsPerSecond,
+        [&](const ClipSpan& span) { visible.push_back(span.clipId); },
+        [&](double start, double end, uint32_t count) {
+            int c0 = std::clamp(static_cast<int>((start - m_viewStart) * pixelsPerSecond), 0, columns - 1);
+            int c1 = std::clamp(static_cast<int>((end - m_viewStart) * pixelsPerSecond), c0, columns - 1);
+            for (int c = c0; c <= c1; c++) {
+                m_laneDensity[c] = static_cast<uint16_t>(std::min<uint32_t>(UINT16_MAX, m_laneDensity[c] + count));
+            }
+        });
+
+    ImU32 baseColor = getClipColor(track->type) & ~IM_COL32_A_MASK;
+    for (int c = 0; c < columns;) {
+        if (!m_laneDensity[c]) { c++; continue; }
+        int runStart = c;
+        int peak = 0;
+        for (; c < columns && m_laneDensity[c]; c++) peak = std::max(peak, (int)m_laneDensity[c]);
+
+        // More clips per pixel reads as a denser bar
+        int alpha = std::min(255, 90 + 30 * peak);
+        drawList->AddRectFilled(ImVec2(x + runStart, y + 2), ImVec2(x + c, y + height - 2),
+                                baseColor | (static_cast<ImU32>(alpha) << IM_COL32_A_SHIFT));
+    }
+
+    for (uint32_t clipId : visible) {
         const auto* clip = timeline.getClip(clipId);
         if (!clip) continue;
 
         double clipStart = clip->timelineStart;
         double clipEnd = clip->getTimelineEnd();
 
-        if (clipEnd < m_viewStart || clipStart > m_viewStart + m_viewDuration) continue;
-
         float startFrac = static_cast<float>((clipStart - m_viewStart) / m_viewDuration);
         float endFrac = static_cast<float>((clipEnd - m_viewStart) / m_viewDuration);
 
@@ -615,9 +679,19 @@ void TimelineUI::renderTrackLane(float x, float y, float width, float height,
         float clipY1 = y + 2;
         float clipY2 = y + height - 2;
 
-        ImU32 color = getClipColor(track->type);
+        const auto* asset = timeline.getAsset(clip->assetId);
+        bool pending = asset && asset->pending;
+
+        ImU32 color = pending ? COL_PENDING_CLIP : getClipColor(track->type);
         drawList->AddRectFilled(ImVec2(clipX1, clipY1), ImVec2(clipX2, clipY2), color, 3.0f);
 
+        if (asset && !pending && asset->hasVideo && track->type == TrackType::Video) {
+            renderClipThumbnails(*clip, *asset, x, width, clipX1, clipX2, clipY1, clipY2);
+        }
+        if (asset && !pending && asset->hasAudio && track->type == TrackType::Audio) {
+            renderClipWaveform(*clip, *asset, x, width, clipX1, clipX2, clipY1, clipY2);
+        }
+
         if (clipId == m_selectedClipId) {
             drawList->AddRectFilled(ImVec2(clipX1, clipY1), ImVec2(clipX2, clipY2),
                                      COL_CLIP_SELECTED, 3.0f);
@@ -626,7 +700,6 @@ void TimelineUI::renderTrackLane(float x, float y, float width, float height,
         drawList->AddRect(ImVec2(clipX1, clipY1), ImVec2(clipX2, clipY2),
                           COL_CLIP_BORDER, 3.0f);
 
-        const auto* asset = timeline.getAsset(clip->assetId);
         if (asset && (clipX2 - clipX1) > 30) {
             const auto& path = asset->filePath;
             size_t lastSlash = path.find_last_of('/');
@@ -636,11 +709,115 @@ void TimelineUI::renderTrackLane(float x, float y, float width, float height,
             ImVec2 textPos(clipX1 + 4, clipY1 + 2);
             drawList->PushClipRect(ImVec2(clipX1, clipY1), ImVec2(clipX2, clipY2), true);
             drawList->AddText(textPos, IM_COL32(255, 255, 255, 220), filename);
+            if (pending) {
+                drawList->AddText(ImVec2(clipX1 + 4, clipY1 + 16),
+                                  IM_COL32(255, 255, 255, 140), "Loading...");
+            }
             drawList->PopClipRect();
         }
     }
 }
 
+void TimelineUI::renderClipThumbnails(const Clip& clip, const MediaAsset& asset, float laneX,
+                                      float laneWidth, float clipX1, float clipX2,
+                                      float clipY1, float clipY2) {
+    if (!m_thumbnailService || !m_thumbnailAtlas || m_viewDuration <= 0) return;
+
+    // One thumbnail per tile, at the coarsest level whose spacing still
+    // leaves room for a full tile, so zooming out requests fewer of them
+    float tileH = clipY2 - clipY1;
+    float tileW = tileH * ThumbnailService::THUMB_WIDTH / ThumbnailService::THUMB_HEIGHT;
+    double pixelsPerSecond = laneWidth / m_viewDuration;
+    int level = ThumbnailService::levelForSpacing(tileW / pixelsPerSecond * clip.speed);
+    int64_t step = ThumbnailService::ticksPerStep(level);
+    double spacing = step * ThumbnailService::TICK_SECONDS;
+
+    // Visible part of the clip, in source time
+    double srcFrom = clip.toSourceTime(m_viewStart + (clipX1 - laneX) / pixelsPerSecond);
+    double srcTo = clip.toSourceTime(m_viewStart + (clipX2 - laneX) / pixelsPerSecond);
+    if (asset.duration > 0) srcTo = std::min(srcTo, asset.duration);
+    int64_t first = static_cast<int64_t>(std::floor(std::max(srcFrom, 0.0) / spacing));
+    int64_t last = static_cast<int64_t>(std::floor(srcTo / spacing));
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    ImTextureID atlasTexture = (ImTextureID)m_thumbnailAtlas->getDescriptor();
+    drawList->PushClipRect(ImVec2(clipX1, clipY1), ImVec2(clipX2, clipY2), true);
+
+    // Neighbouring ticks often resolve to the same keyframe; that picture is
+    // drawn once, at the time it actually shows
+    uint64_t lastFrame = 0;
+    bool drewAny = false;
+    for (int64_t k = first; k <= last; k++) {
+        int64_t tick = k * step;
+        ThumbnailService::FrameRef frame;
+        bool known = m_thumbnailService->frameFor(asset.id, tick, frame);
+        if (!known || !m_thumbnailAtlas->has(frame.frame)) {
+            m_thumbnailService->request(asset.id, asset.filePath, tick);
+        }
+
+        // Until it arrives, stand in with a coarser level's thumbnail
+        ThumbnailAtlas::Region region;
+        bool found = known && m_thumbnailAtlas->lookup(frame.frame, region);
+        for (int up = 1; !found && up <= 3 && level + up <= ThumbnailService::MAX_LEVEL; up++) {
+            int64_t coarse = ThumbnailService::ticksPerStep(level + up);
+            found = m_thumbnailService->frameFor(asset.id, (tick / coarse) * coarse, frame) &&
+                    m_thumbnailAtlas->lookup(frame.frame, region);
+        }
+        if (!found || (drewAny && frame.frame == lastFrame)) continue;
+        lastFrame = frame.frame;
+        drewAny = true;
+
+        double tileTime = clip.toTimelineTime(frame.time);
+        float tx = laneX + static_cast<float>((tileTime - m_viewStart) * pixelsPerSecond);
+        float tw = tileH * region.width / region.height;
+        drawList->AddImage(atlasTexture, ImVec2(tx, clipY1), ImVec2(tx + tw, clipY2),
+                           ImVec2(region.u0, region.v0), ImVec2(region.u1, region.v1));
+    }
+
+    drawList->PopClipRect();
+}
+
+void TimelineUI::renderClipWaveform(const Clip& clip, const MediaAsset& asset, float laneX,
+                                    float laneWidth, float clipX1, float clipX2,
+                                    float clipY1, float clipY2) {
+    if (!m_waveforms || m_viewDuration <= 0) return;
+    auto peaks = m_waveforms->get(asset.id, asset.filePath);
+    if (!peaks) return;
+
+    // One peak query per pixel column, each served from the pyramid level
+    // closest to the column's width in samples
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    double secondsPerPixel = m_viewDuration / laneWidth;
+    float mid = (clipY1 + clipY2) * 0.5f;
+    float halfHeight = (clipY2 - clipY1) * 0.5f - 1.0f;
+
+    for (float px = std::floor(clipX1); px < clipX2; px += 1.0f) {
+        double t = m_viewStart + (px - laneX) * secondsPerPixel;
+        double src = clip.toSourceTime(t);
+        float mn, mx, rms;
+        if (!peaks->query(src, src + secondsPerPixel * clip.speed, mn, mx, rms)) continue;
+
+        drawList->AddRectFilled(ImVec2(px, mid - mx * halfHeight),
+                                ImVec2(px + 1.0f, mid - mn * halfHeight + 1.0f), COL_WAVEFORM_PEAK);
+        drawList->AddRectFilled(ImVec2(px, mid - rms * halfHeight),
+                                ImVec2(px + 1.0f, mid + rms * halfHeight + 1.0f), COL_WAVEFORM_RMS);
+    }
+}
+
+void TimelineUI::buildSnapEdges(const Timeline& timeline, uint32_t excludeClipId) {
+    m_snapEdges.clear();
+    for (uint32_t trackId : timeline.getTrackOrder()) {
+        const auto* track = timeline.getTrack(trackId);
+        if (!track) continue;
+        track->clips.forEach([&](const ClipSpan& span) {
+            if (span.clipId == excludeClipId) return;
+            m_snapEdges.push_back(span.start);
+            m_snapEdges.push_back(span.end);
+        });
+    }
+    std::sort(m_snapEdges.begin(), m_snapEdges.end());
+}
+
 void TimelineUI::renderPlayhead(float x, float y, float height,
                                  double currentTime, double totalDuration, float laneWidth) {
     if (m_viewDuration <= 0) return;
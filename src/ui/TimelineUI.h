@@ -1,8 +1,14 @@
 #pragma once
 
+#include <vector>
 #include <cstdint>
 
 class Timeline;
+struct Clip;
+struct MediaAsset;
+class ThumbnailService;
+class ThumbnailAtlas;
+class WaveformService;
 
 class TimelineUI {
 public:
@@ -12,6 +18,9 @@ public:
     bool hasSeekRequest() const { return m_seekRequested; }
     double getSeekTime() const { m_seekRequested = false; return m_seekTime; }
 
+    // The playhead is being dragged along the ruler (seeks are scrubs)
+    bool isScrubbing() const { return m_draggingRuler; }
+
     // Selection
     uint32_t getSelectedClipId() const { return m_selectedClipId; }
 
@@ -22,17 +31,33 @@ public:
     // Pass current playhead time for split-at-playhead
     void setCurrentTime(double t) { m_currentPlayheadTime = t; }
 
+    // Thumbnail strips on video clips (optional; both must outlive this)
+    void setThumbnails(ThumbnailService* service, ThumbnailAtlas* atlas) {
+        m_thumbnailService = service;
+        m_thumbnailAtlas = atlas;
+    }
+
+    // Waveforms on audio clips (optional; must outlive this)
+    void setWaveforms(WaveformService* service) { m_waveforms = service; }
+
 private:
     void renderTimeRuler(float x, float y, float width, float height,
                          double totalDuration);
     void renderTrackHeader(float x, float y, float width, float height,
                            Timeline& timeline, uint32_t trackId, int trackIndex, int trackCount);
     void renderTrackLane(float x, float y, float width, float height,
-                         Timeline& timeline, uint32_t trackId, double totalDuration);
+                         const Timeline& timeline, uint32_t trackId, double totalDuration);
     void renderPlayhead(float x, float y, float height, double currentTime,
                         double totalDuration, float laneWidth);
     void renderScrollbar(float x, float y, float width, float height,
                          double totalDuration);
+    void buildSnapEdges(const Timeline& timeline, uint32_t excludeClipId);
+    void renderClipThumbnails(const Clip& clip, const MediaAsset& asset, float laneX,
+                              float laneWidth, float clipX1, float clipX2,
+                              float clipY1, float clipY2);
+    void renderClipWaveform(const Clip& clip, const MediaAsset& asset, float laneX,
+                            float laneWidth, float clipX1, float clipX2,
+                            float clipY1, float clipY2);
 
     // View state
     double m_viewStart = 0.0;         // leftmost visible time
@@ -76,6 +101,14 @@ private:
     // Snap state
     bool m_snapActive = false;
     double m_snapTime = 0.0;
+    std::vector<double> m_snapEdges;  // sorted clip starts/ends, built when a drag begins
+
+    // Per-pixel-column count of sub-pixel clips, reused across lanes
+    std::vector<uint16_t> m_laneDensity;
+
+    ThumbnailService* m_thumbnailService = nullptr;
+    ThumbnailAtlas* m_thumbnailAtlas = nullptr;
+    WaveformService* m_waveforms = nullptr;
 
     // Layout constants
     static constexpr float TRACK_HEADER_WIDTH = 120.0f;
@@ -83,4 +116,5 @@ private:
     static constexpr float RULER_HEIGHT = 24.0f;
     static constexpr float MIN_TRACK_HEIGHT = 30.0f;
     static constexpr float SCROLLBAR_HEIGHT = 14.0f;
+    static constexpr float MIN_CLIP_PIXELS = 3.0f;  // narrower clips draw as density bars
 };
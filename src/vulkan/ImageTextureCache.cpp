@@ -0,0 +1,278 @@
+#include "vulkan/ImageTextureCache.h"
+#include "vulkan/VulkanContext.h"
+#include "vulkan/Swapchain.h"
+#include <imgui.h>
+#include <imgui_impl_vulkan.h>
+#include <cstring>
+#include <iterator>
+#include <cstdio>
+
+bool ImageTextureCache::init(VulkanContext& ctx) {
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+    if (vkCreateSampler(ctx.device, &samplerInfo, nullptr, &m_sampler) != VK_SUCCESS) {
+        fprintf(stderr, "ImageTextureCache: failed to create sampler\n");
+        return false;
+    }
+    return true;
+}
+
+void ImageTextureCache::shutdown(VulkanContext& ctx) {
+    for (auto& [assetId, entry] : m_entries) {
+        retire(entry);
+    }
+    m_entries.clear();
+    m_failed.clear();
+
+    // Staging buffers of copies that were never recorded
+    for (auto& pc : m_pendingCopies) {
+        Retired r;
+        r.buffer = pc.staging;
+        r.bufferAllocation = pc.stagingAllocation;
+        m_retired.push_back(r);
+    }
+    m_pendingCopies.clear();
+
+    destroyRetired(ctx, true);
+    m_residentBytes = 0;
+
+    if (m_sampler) { vkDestroySampler(ctx.device, m_sampler, nullptr); m_sampler = VK_NULL_HANDLE; }
+}
+
+void ImageTextureCache::beginFrame(VulkanContext& ctx) {
+    m_frame++;
+    destroyRetired(ctx, false);
+}
+
+VkDescriptorSet ImageTextureCache::acquire(VulkanContext& ctx, uint32_t assetId,
+                                           const uint8_t* rgba, uint32_t width, uint32_t height) {
+    if (m_failed.count(assetId)) return VK_NULL_HANDLE;
+
+    auto it = m_entries.find(assetId);
+    if (it != m_entries.end()) {
+        if (it->second.width == width && it->second.height == height) {
+            it->second.lastUsedFrame = m_frame;
+            return it->second.descriptor;
+        }
+        // Asset was replaced with different dimensions
+        m_residentBytes -= it->second.bytes;
+        retire(it->second);
+        m_entries.erase(it);
+    }
+
+    Entry entry;
+    entry.width = width;
+    entry.height = height;
+    entry.bytes = static_cast<VkDeviceSize>(width) * height * 4;
+    entry.lastUsedFrame = m_frame;
+
+    // Make room only once the new texture exists, so a failure doesn't cost
+    // the textures that would have been evicted for it
+    if (!createEntry(ctx, entry, rgba)) {
+        retire(entry);
+        m_failed.insert(assetId);
+        return VK_NULL_HANDLE;
+    }
+    evictToBudget(entry.bytes);
+
+    m_residentBytes += entry.bytes;
+    VkDescriptorSet ds = entry.descriptor;
+    m_entries[assetId] = entry;
+    return ds;
+}
+
+bool ImageTextureCache::createEntry(VulkanContext& ctx, Entry& entry, const uint8_t* rgba) {
+    VkImageCreateInfo imgInfo{};
+    imgInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imgInfo.imageType = VK_IMAGE_TYPE_2D;
+    imgInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    imgInfo.extent = {entry.width, entry.height, 1};
+    imgInfo.mipLevels = 1;
+    imgInfo.arrayLayers = 1;
+    imgInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imgInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imgInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imgInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    if (vmaCreateImage(ctx.allocator, &imgInfo, &allocInfo,
+                       &entry.image, &entry.allocation, nullptr) != VK_SUCCESS) {
+        fprintf(stderr, "ImageTextureCache: failed to create %ux%u image\n",
+                entry.width, entry.height);
+        return false;
+    }
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = entry.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(ctx.device, &viewInfo, nullptr, &entry.view) != VK_SUCCESS) {
+        fprintf(stderr, "ImageTextureCache: failed to create image view\n");
+        return false;
+    }
+
+    entry.descriptor = ImGui_ImplVulkan_AddTexture(
+        m_sampler, entry.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    if (!entry.descriptor) {
+        fprintf(stderr, "ImageTextureCache: failed to register texture with ImGui\n");
+        return false;
+    }
+
+    // One-shot staging buffer, released once the copy has executed
+    PendingCopy pc;
+    pc.image = entry.image;
+    pc.width = entry.width;
+    pc.height = entry.height;
+
+    VkBufferCreateInfo bufInfo{};
+    bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufInfo.size = entry.bytes;
+    bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    VmaAllocationCreateInfo stagingInfo{};
+    stagingInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    stagingInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VmaAllocationInfo mappedInfo{};
+    if (vmaCreateBuffer(ctx.allocator, &bufInfo, &stagingInfo,
+                        &pc.staging, &pc.stagingAllocation, &mappedInfo) != VK_SUCCESS) {
+        fprintf(stderr, "ImageTextureCache: failed to create staging buffer\n");
+        return false;
+    }
+    memcpy(mappedInfo.pMappedData, rgba, entry.bytes);
+    vmaFlushAllocation(ctx.allocator, pc.stagingAllocation, 0, entry.bytes);
+
+    m_pendingCopies.push_back(pc);
+    return true;
+}
+
+void ImageTextureCache::recordUploads(VkCommandBuffer cmd) {
+    for (auto& pc : m_pendingCopies) {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = pc.image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(cmd,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = {pc.width, pc.height, 1};
+
+        vkCmdCopyBufferToImage(cmd, pc.staging, pc.image,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(cmd,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        Retired r;
+        r.frame = m_frame;
+        r.buffer = pc.staging;
+        r.bufferAllocation = pc.stagingAllocation;
+        m_retired.push_back(r);
+    }
+    m_pendingCopies.clear();
+}
+
+void ImageTextureCache::retainOnly(const std::unordered_set<uint32_t>& liveAssetIds) {
+    for (auto it = m_failed.begin(); it != m_failed.end();) {
+        it = liveAssetIds.count(*it) ? std::next(it) : m_failed.erase(it);
+    }
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (liveAssetIds.count(it->first)) {
+            ++it;
+            continue;
+        }
+        m_residentBytes -= it->second.bytes;
+        retire(it->second);
+        it = m_entries.erase(it);
+    }
+}
+
+void ImageTextureCache::evictToBudget(VkDeviceSize incoming) {
+    // Least-recently-used first, never anything drawn this frame
+    while (!m_entries.empty() && m_residentBytes + incoming > m_budget) {
+        auto victim = m_entries.end();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->second.lastUsedFrame == m_frame) continue;
+            if (victim == m_entries.end() || it->second.lastUsedFrame < victim->second.lastUsedFrame) {
+                victim = it;
+            }
+        }
+        if (victim == m_entries.end()) break;
+
+        m_residentBytes -= victim->second.bytes;
+        retire(victim->second);
+        m_entries.erase(victim);
+    }
+}
+
+void ImageTextureCache::retire(Entry& entry) {
+    // A copy for this image may still be queued; drop it with the image
+    for (auto it = m_pendingCopies.begin(); it != m_pendingCopies.end(); ++it) {
+        if (it->image == entry.image) {
+            Retired r;
+            r.frame = m_frame;
+            r.buffer = it->staging;
+            r.bufferAllocation = it->stagingAllocation;
+            m_retired.push_back(r);
+            m_pendingCopies.erase(it);
+            break;
+        }
+    }
+
+    Retired r;
+    r.frame = m_frame;
+    r.image = entry.image;
+    r.allocation = entry.allocation;
+    r.view = entry.view;
+    r.descriptor = entry.descriptor;
+    m_retired.push_back(r);
+    entry = Entry{};
+}
+
+void ImageTextureCache::destroyRetired(VulkanContext& ctx, bool all) {
+    for (auto it = m_retired.begin(); it != m_retired.end();) {
+        // Frame N's command buffer is guaranteed complete once frame
+        // N + MAX_FRAMES_IN_FLIGHT has started (its fence was waited on).
+        if (!all && m_frame < it->frame + Swapchain::MAX_FRAMES_IN_FLIGHT) {
+            ++it;
+            continue;
+        }
+        if (it->descriptor) ImGui_ImplVulkan_RemoveTexture(it->descriptor);
+        if (it->view) vkDestroyImageView(ctx.device, it->view, nullptr);
+        if (it->image) vmaDestroyImage(ctx.allocator, it->image, it->allocation);
+        if (it->buffer) vmaDestroyBuffer(ctx.allocator, it->buffer, it->bufferAllocation);
+        it = m_retired.erase(it);
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cstdint>
+
+struct VulkanContext;
+
+// GPU-resident textures for still images, keyed by asset ID.
+//
+// A still is uploaded once and then drawn from its descriptor every frame
+// with no further staging or copies. Entries are dropped when their asset is
+// no longer referenced by any clip, or least-recently-used first when the
+// total exceeds the memory budget. Destruction is deferred until every frame
+// in flight that could still sample the image has completed.
+class ImageTextureCache {
+public:
+    static constexpr VkDeviceSize DEFAULT_BUDGET = 1024ull * 1024 * 1024;  // 1 GiB
+
+    bool init(VulkanContext& ctx);
+    void shutdown(VulkanContext& ctx);
+
+    void setBudget(VkDeviceSize bytes) { m_budget = bytes; }
+
+    // Call once per rendered frame before any acquire(). Frees resources
+    // retired long enough ago that no in-flight frame can reference them.
+    void beginFrame(VulkanContext& ctx);
+
+    // Return the descriptor for an asset's texture, creating it and queueing
+    // the one-time upload if it isn't resident yet. Returns VK_NULL_HANDLE
+    // on allocation failure; the asset isn't tried again until retainOnly()
+    // has dropped it.
+    VkDescriptorSet acquire(VulkanContext& ctx, uint32_t assetId,
+                            const uint8_t* rgba, uint32_t width, uint32_t height);
+
+    // Record copies for textures created since the last call.
+    void recordUploads(VkCommandBuffer cmd);
+
+    // Drop entries (and failures) whose asset is not in liveAssetIds.
+    void retainOnly(const std::unordered_set<uint32_t>& liveAssetIds);
+
+    size_t getResidentCount() const { return m_entries.size(); }
+    VkDeviceSize getResidentBytes() const { return m_residentBytes; }
+
+private:
+    struct Entry {
+        VkImage image = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkDescriptorSet descriptor = VK_NULL_HANDLE;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        VkDeviceSize bytes = 0;
+        uint64_t lastUsedFrame = 0;
+    };
+
+    struct PendingCopy {
+        VkBuffer staging = VK_NULL_HANDLE;
+        VmaAllocation stagingAllocation = VK_NULL_HANDLE;
+        VkImage image = VK_NULL_HANDLE;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    // Resources waiting for the GPU to finish with them
+    struct Retired {
+        uint64_t frame = 0;
+        VkImage image = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkDescriptorSet descriptor = VK_NULL_HANDLE;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VmaAllocation bufferAllocation = VK_NULL_HANDLE;
+    };
+
+    bool createEntry(VulkanContext& ctx, Entry& entry, const uint8_t* rgba);
+    void retire(Entry& entry);
+    void destroyRetired(VulkanContext& ctx, bool all);
+    void evictToBudget(VkDeviceSize incoming);
+
+    VkSampler m_sampler = VK_NULL_HANDLE;
+    std::unordered_map<uint32_t, Entry> m_entries;
+    std::unordered_set<uint32_t> m_failed;  // assets whose texture couldn't be created
+    std::vector<PendingCopy> m_pendingCopies;
+    std::vector<Retired> m_retired;
+
+    VkDeviceSize m_budget = DEFAULT_BUDGET;
+    VkDeviceSize m_residentBytes = 0;
+    uint64_t m_frame = 0;
+};
@@ -0,0 +1,81 @@
+#include "vulkan/MappedFrameAllocator.h"
+#include "vulkan/VulkanContext.h"
+#include "vulkan/Swapchain.h"
+#include <cstdio>
+
+MappedFrameAllocator::~MappedFrameAllocator() {
+    shutdown();
+}
+
+void MappedFrameAllocator::shutdown() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& r : m_retired) {
+        destroy(r.buffer);
+    }
+    m_retired.clear();
+}
+
+FrameSlotAllocator::Block MappedFrameAllocator::allocate(size_t bytes) {
+    Block block;
+    if (!m_ctx) return block;
+
+    VkBufferCreateInfo bufInfo{};
+    bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufInfo.size = bytes;
+    bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    // Written sequentially by sws_scale, never read back on the CPU
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    auto* buf = new Buffer();
+    VmaAllocationInfo info{};
+    if (vmaCreateBuffer(m_ctx->allocator, &bufInfo, &allocInfo,
+                        &buf->buffer, &buf->allocation, &info) != VK_SUCCESS) {
+        fprintf(stderr, "MappedFrameAllocator: failed to create %zu byte buffer\n", bytes);
+        delete buf;
+        return block;
+    }
+    buf->size = bytes;
+
+    block.data = static_cast<uint8_t*>(info.pMappedData);
+    block.handle = buf;
+    return block;
+}
+
+void MappedFrameAllocator::free(Block& block) {
+    auto* buf = static_cast<Buffer*>(block.handle);
+    block = {};
+    if (!buf) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_retired.push_back({m_frame, buf});
+}
+
+void MappedFrameAllocator::beginFrame() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frame++;
+    for (auto it = m_retired.begin(); it != m_retired.end();) {
+        if (m_frame < it->frame + Swapchain::MAX_FRAMES_IN_FLIGHT) {
+            ++it;
+            continue;
+        }
+        destroy(it->buffer);
+        it = m_retired.erase(it);
+    }
+}
+
+void MappedFrameAllocator::flush(void* handle) {
+    auto* buf = static_cast<Buffer*>(handle);
+    if (!buf || !m_ctx) return;
+    vmaFlushAllocation(m_ctx->allocator, buf->allocation, 0, VK_WHOLE_SIZE);
+}
+
+void MappedFrameAllocator::destroy(Buffer* buffer) {
+    if (!buffer) return;
+    if (m_ctx && buffer->buffer) {
+        vmaDestroyBuffer(m_ctx->allocator, buffer->buffer, buffer->allocation);
+    }
+    delete buffer;
+}
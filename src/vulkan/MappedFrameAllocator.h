@@ -0,0 +1,55 @@
+#pragma once
+
+#include "media/FrameQueue.h"
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+struct VulkanContext;
+
+// FrameSlotAllocator backed by persistently mapped, host-visible VMA buffers.
+// FrameQueue slots allocated from it can be used directly as the source of
+// vkCmdCopyBufferToImage, so decoded frames reach the GPU without any
+// intermediate CPU copies.
+//
+// Freed buffers are destroyed MAX_FRAMES_IN_FLIGHT frames later, because a
+// ClipPlayer may be torn down while a copy from one of its slots is in flight.
+class MappedFrameAllocator : public FrameSlotAllocator {
+public:
+    struct Buffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+    };
+
+    ~MappedFrameAllocator() override;
+
+    void init(VulkanContext& ctx) { m_ctx = &ctx; }
+    void shutdown();
+
+    Block allocate(size_t bytes) override;
+    void free(Block& block) override;
+
+    // Call once per rendered frame after the frame's fence has been waited on
+    void beginFrame();
+
+    // Make CPU writes visible to the GPU (no-op on coherent memory)
+    void flush(void* handle);
+
+    static const Buffer* bufferOf(void* handle) { return static_cast<const Buffer*>(handle); }
+
+private:
+    struct Retired {
+        uint64_t frame = 0;
+        Buffer* buffer = nullptr;
+    };
+
+    void destroy(Buffer* buffer);
+
+    VulkanContext* m_ctx = nullptr;
+    std::mutex m_mutex;
+    std::vector<Retired> m_retired;
+    uint64_t m_frame = 0;
+};
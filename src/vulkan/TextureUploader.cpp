@@ -14,6 +14,7 @@ void TextureUploader::shutdown(VulkanContext& ctx) {
             vmaDestroyBuffer(ctx.allocator, m_stagingBuffers[i], m_stagingAllocations[i]);
             m_stagingBuffers[i] = VK_NULL_HANDLE;
             m_stagingAllocations[i] = VK_NULL_HANDLE;
+            m_stagingMapped[i] = nullptr;
         }
     }
     m_stagingSize = 0;
@@ -29,6 +30,7 @@ bool TextureUploader::ensureCapacity(VulkanContext& ctx, uint32_t width, uint32_
             vmaDestroyBuffer(ctx.allocator, m_stagingBuffers[i], m_stagingAllocations[i]);
             m_stagingBuffers[i] = VK_NULL_HANDLE;
             m_stagingAllocations[i] = VK_NULL_HANDLE;
+            m_stagingMapped[i] = nullptr;
         }
     }
 
@@ -42,11 +44,13 @@ bool TextureUploader::ensureCapacity(VulkanContext& ctx, uint32_t width, uint32_
         allocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
         allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
 
+        VmaAllocationInfo mappedInfo{};
         if (vmaCreateBuffer(ctx.allocator, &bufInfo, &allocInfo,
-                            &m_stagingBuffers[i], &m_stagingAllocations[i], nullptr) != VK_SUCCESS) {
+                            &m_stagingBuffers[i], &m_stagingAllocations[i], &mappedInfo) != VK_SUCCESS) {
             fprintf(stderr, "Failed to create staging buffer %d\n", i);
             return false;
         }
+        m_stagingMapped[i] = mappedInfo.pMappedData;
     }
 
     m_stagingSize = needed;
@@ -57,19 +61,22 @@ void TextureUploader::stage(VulkanContext& ctx, int frameIndex,
                              const uint8_t* data, uint32_t width, uint32_t height) {
     VkDeviceSize size = static_cast<VkDeviceSize>(width) * height * 4;
 
-    void* mapped;
-    vmaMapMemory(ctx.allocator, m_stagingAllocations[frameIndex], &mapped);
-    memcpy(mapped, data, size);
-    vmaUnmapMemory(ctx.allocator, m_stagingAllocations[frameIndex]);
+    memcpy(m_stagingMapped[frameIndex], data, size);
     vmaFlushAllocation(ctx.allocator, m_stagingAllocations[frameIndex], 0, size);
 }
 
 void TextureUploader::recordUpload(VkCommandBuffer cmd, int frameIndex,
                                     VideoTexture& texture, int slot,
                                     uint32_t width, uint32_t height) {
+    recordUploadFrom(cmd, m_stagingBuffers[frameIndex], 0, texture, slot, width, height);
+}
+
+void TextureUploader::recordUploadFrom(VkCommandBuffer cmd, VkBuffer src, uint32_t rowLength,
+                                        VideoTexture& texture, int slot,
+                                        uint32_t width, uint32_t height) {
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;  // fully overwritten below
     barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -85,11 +92,12 @@ void TextureUploader::recordUpload(VkCommandBuffer cmd, int frameIndex,
         0, 0, nullptr, 0, nullptr, 1, &barrier);
 
     VkBufferImageCopy region{};
+    region.bufferRowLength = rowLength;
     region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     region.imageSubresource.layerCount = 1;
     region.imageExtent = {width, height, 1};
 
-    vkCmdCopyBufferToImage(cmd, m_stagingBuffers[frameIndex], texture.getImage(slot),
+    vkCmdCopyBufferToImage(cmd, src, texture.getImage(slot),
                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
 
     barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
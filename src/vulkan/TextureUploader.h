@@ -23,11 +23,18 @@ public:
                       VideoTexture& texture, int slot,
                       uint32_t width, uint32_t height);
 
+    // Same, but copy from a caller-owned buffer (e.g. a mapped FrameQueue slot)
+    // instead of the internal staging buffer. rowLength is in pixels.
+    static void recordUploadFrom(VkCommandBuffer cmd, VkBuffer src, uint32_t rowLength,
+                                 VideoTexture& texture, int slot,
+                                 uint32_t width, uint32_t height);
+
     bool ensureCapacity(VulkanContext& ctx, uint32_t width, uint32_t height);
 
 private:
     // One staging buffer per frame-in-flight to avoid GPU/CPU race
     VkBuffer m_stagingBuffers[Swapchain::MAX_FRAMES_IN_FLIGHT]{};
     VmaAllocation m_stagingAllocations[Swapchain::MAX_FRAMES_IN_FLIGHT]{};
+    void* m_stagingMapped[Swapchain::MAX_FRAMES_IN_FLIGHT]{};  // persistently mapped
     VkDeviceSize m_stagingSize = 0;
 };
@@ -0,0 +1,247 @@
+#include "vulkan/ThumbnailAtlas.h"
+#include "vulkan/VulkanContext.h"
+#include "vulkan/Swapchain.h"
+#include <imgui.h>
+#include <imgui_impl_vulkan.h>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+bool ThumbnailAtlas::init(VulkanContext& ctx, uint32_t cellWidth, uint32_t cellHeight) {
+    m_cellWidth = cellWidth;
+    m_cellHeight = cellHeight;
+    m_columns = ATLAS_SIZE / cellWidth;
+    uint32_t rows = ATLAS_SIZE / cellHeight;
+    m_cells.assign(m_columns * rows, Cell{});
+    m_freeCells.clear();
+    for (int i = static_cast<int>(m_cells.size()) - 1; i >= 0; i--) m_freeCells.push_back(i);
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+    if (vkCreateSampler(ctx.device, &samplerInfo, nullptr, &m_sampler) != VK_SUCCESS) {
+        fprintf(stderr, "ThumbnailAtlas: failed to create sampler\n");
+        return false;
+    }
+
+    VkImageCreateInfo imgInfo{};
+    imgInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imgInfo.imageType = VK_IMAGE_TYPE_2D;
+    imgInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    imgInfo.extent = {ATLAS_SIZE, ATLAS_SIZE, 1};
+    imgInfo.mipLevels = 1;
+    imgInfo.arrayLayers = 1;
+    imgInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imgInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imgInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imgInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    if (vmaCreateImage(ctx.allocator, &imgInfo, &allocInfo,
+                       &m_image, &m_allocation, nullptr) != VK_SUCCESS) {
+        fprintf(stderr, "ThumbnailAtlas: failed to create atlas image\n");
+        return false;
+    }
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = m_image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(ctx.device, &viewInfo, nullptr, &m_view) != VK_SUCCESS) {
+        fprintf(stderr, "ThumbnailAtlas: failed to create image view\n");
+        return false;
+    }
+
+    m_descriptor = ImGui_ImplVulkan_AddTexture(m_sampler, m_view,
+                                               VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    if (!m_descriptor) {
+        fprintf(stderr, "ThumbnailAtlas: failed to register texture with ImGui\n");
+        return false;
+    }
+
+    // One segment of MAX_UPLOADS_PER_FRAME cells per frame in flight
+    VkBufferCreateInfo bufInfo{};
+    bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufInfo.size = static_cast<VkDeviceSize>(cellWidth) * cellHeight * 4 *
+                   MAX_UPLOADS_PER_FRAME * Swapchain::MAX_FRAMES_IN_FLIGHT;
+    bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    VmaAllocationCreateInfo stagingAlloc{};
+    stagingAlloc.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    stagingAlloc.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VmaAllocationInfo mappedInfo{};
+    if (vmaCreateBuffer(ctx.allocator, &bufInfo, &stagingAlloc,
+                        &m_staging, &m_stagingAllocation, &mappedInfo) != VK_SUCCESS) {
+        fprintf(stderr, "ThumbnailAtlas: failed to create staging buffer\n");
+        return false;
+    }
+    m_stagingMapped = static_cast<uint8_t*>(mappedInfo.pMappedData);
+    return true;
+}
+
+void ThumbnailAtlas::shutdown(VulkanContext& ctx) {
+    if (m_staging) {
+        vmaDestroyBuffer(ctx.allocator, m_staging, m_stagingAllocation);
+        m_staging = VK_NULL_HANDLE;
+        m_stagingAllocation = VK_NULL_HANDLE;
+        m_stagingMapped = nullptr;
+    }
+    if (m_descriptor) { ImGui_ImplVulkan_RemoveTexture(m_descriptor); m_descriptor = VK_NULL_HANDLE; }
+    if (m_view) { vkDestroyImageView(ctx.device, m_view, nullptr); m_view = VK_NULL_HANDLE; }
+    if (m_image) {
+        vmaDestroyImage(ctx.allocator, m_image, m_allocation);
+        m_image = VK_NULL_HANDLE;
+        m_allocation = VK_NULL_HANDLE;
+    }
+    if (m_sampler) { vkDestroySampler(ctx.device, m_sampler, nullptr); m_sampler = VK_NULL_HANDLE; }
+
+    m_cells.clear();
+    m_freeCells.clear();
+    m_cellOf.clear();
+    m_pending.clear();
+    m_queuedKeys.clear();
+    m_copies.clear();
+    m_initialized = false;
+}
+
+void ThumbnailAtlas::submit(uint64_t key, std::vector<uint8_t> rgba, int width, int height) {
+    if (width <= 0 || height <= 0 ||
+        static_cast<uint32_t>(width) > m_cellWidth || static_cast<uint32_t>(height) > m_cellHeight ||
+        rgba.size() < static_cast<size_t>(width) * height * 4) {
+        return;
+    }
+    if (!m_queuedKeys.insert(key).second) return;
+    m_pending.push_back({key, std::move(rgba), width, height});
+}
+
+void ThumbnailAtlas::beginFrame(VulkanContext& ctx) {
+    m_frame++;
+    m_copies.clear();
+    if (!m_stagingMapped) return;
+
+    VkDeviceSize cellBytes = static_cast<VkDeviceSize>(m_cellWidth) * m_cellHeight * 4;
+    VkDeviceSize segment = (m_frame % Swapchain::MAX_FRAMES_IN_FLIGHT) * cellBytes * MAX_UPLOADS_PER_FRAME;
+
+    while (!m_pending.empty() && m_copies.size() < MAX_UPLOADS_PER_FRAME) {
+        Pending& p = m_pending.front();
+        int index = takeCell();
+        if (index < 0) break;  // every cell is on screen or in flight; retry next frame
+
+        Cell& cell = m_cells[index];
+        cell.key = p.key;
+        cell.width = p.width;
+        cell.height = p.height;
+        cell.occupied = true;
+        cell.lastUsedFrame = m_frame;
+        m_cellOf[p.key] = index;
+
+        VkDeviceSize offset = segment + m_copies.size() * cellBytes;
+        memcpy(m_stagingMapped + offset, p.rgba.data(), static_cast<size_t>(p.width) * p.height * 4);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {static_cast<int32_t>((index % m_columns) * m_cellWidth),
+                              static_cast<int32_t>((index / m_columns) * m_cellHeight), 0};
+        region.imageExtent = {static_cast<uint32_t>(p.width), static_cast<uint32_t>(p.height), 1};
+        m_copies.push_back(region);
+
+        m_queuedKeys.erase(p.key);
+        m_pending.pop_front();
+    }
+
+    if (!m_copies.empty()) {
+        vmaFlushAllocation(ctx.allocator, m_stagingAllocation, segment, cellBytes * m_copies.size());
+    }
+}
+
+void ThumbnailAtlas::recordUploads(VkCommandBuffer cmd) {
+    if (m_copies.empty()) return;
+
+    // Cells not being written keep their contents, so only the very first
+    // upload may discard the image
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = m_initialized ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                                      : VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = m_image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    vkCmdCopyBufferToImage(cmd, m_staging, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(m_copies.size()), m_copies.data());
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    m_initialized = true;
+    m_copies.clear();
+}
+
+bool ThumbnailAtlas::lookup(uint64_t key, Region& out) {
+    auto it = m_cellOf.find(key);
+    if (it == m_cellOf.end()) return false;
+
+    Cell& cell = m_cells[it->second];
+    cell.lastUsedFrame = m_frame;
+
+    // Inset by half a texel so linear filtering never reads a neighbour
+    float x = static_cast<float>((it->second % m_columns) * m_cellWidth);
+    float y = static_cast<float>((it->second / m_columns) * m_cellHeight);
+    const float inv = 1.0f / ATLAS_SIZE;
+    out.u0 = (x + 0.5f) * inv;
+    out.v0 = (y + 0.5f) * inv;
+    out.u1 = (x + cell.width - 0.5f) * inv;
+    out.v1 = (y + cell.height - 0.5f) * inv;
+    out.width = cell.width;
+    out.height = cell.height;
+    return true;
+}
+
+int ThumbnailAtlas::takeCell() {
+    if (!m_freeCells.empty()) {
+        int index = m_freeCells.back();
+        m_freeCells.pop_back();
+        return index;
+    }
+
+    // Least recently drawn cell that no frame in flight may be sampling
+    int victim = -1;
+    for (int i = 0; i < static_cast<int>(m_cells.size()); i++) {
+        const Cell& c = m_cells[i];
+        if (m_frame < c.lastUsedFrame + Swapchain::MAX_FRAMES_IN_FLIGHT) continue;
+        if (victim < 0 || c.lastUsedFrame < m_cells[victim].lastUsedFrame) victim = i;
+    }
+    if (victim >= 0) m_cellOf.erase(m_cells[victim].key);
+    return victim;
+}
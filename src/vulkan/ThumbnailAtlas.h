@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cstdint>
+
+struct VulkanContext;
+
+// One GPU texture holding many small thumbnails in fixed-size cells, so the
+// timeline draws every visible thumbnail from a single descriptor.
+//
+// Submitted thumbnails are copied into cells at most MAX_UPLOADS_PER_FRAME
+// per frame through a persistently mapped staging ring. When the atlas is
+// full the least recently drawn cell is reused, but only once no frame in
+// flight can still be sampling it.
+class ThumbnailAtlas {
+public:
+    static constexpr uint32_t ATLAS_SIZE = 2048;
+    static constexpr int MAX_UPLOADS_PER_FRAME = 32;
+
+    // Texture coordinates of a resident thumbnail
+    struct Region {
+        float u0 = 0.0f, v0 = 0.0f, u1 = 0.0f, v1 = 0.0f;
+        int width = 0;
+        int height = 0;
+    };
+
+    bool init(VulkanContext& ctx, uint32_t cellWidth, uint32_t cellHeight);
+    void shutdown(VulkanContext& ctx);
+
+    // Queue RGBA pixels (at most one cell in size) for upload under key
+    void submit(uint64_t key, std::vector<uint8_t> rgba, int width, int height);
+
+    // Call once per rendered frame before any lookup(): places queued
+    // thumbnails into cells and stages their pixels
+    void beginFrame(VulkanContext& ctx);
+
+    // Record copies for thumbnails placed this frame (before the render pass)
+    void recordUploads(VkCommandBuffer cmd);
+
+    // Region of a resident thumbnail; marks it as drawn this frame
+    bool lookup(uint64_t key, Region& out);
+
+    // Resident or waiting for upload
+    bool has(uint64_t key) const { return m_cellOf.count(key) || m_queuedKeys.count(key); }
+
+    VkDescriptorSet getDescriptor() const { return m_descriptor; }
+
+private:
+    struct Cell {
+        uint64_t key = 0;
+        uint64_t lastUsedFrame = 0;
+        int width = 0;
+        int height = 0;
+        bool occupied = false;
+    };
+
+    struct Pending {
+        uint64_t key = 0;
+        std::vector<uint8_t> rgba;
+        int width = 0;
+        int height = 0;
+    };
+
+    int takeCell();
+
+    VkImage m_image = VK_NULL_HANDLE;
+    VmaAllocation m_allocation = VK_NULL_HANDLE;
+    VkImageView m_view = VK_NULL_HANDLE;
+    VkSampler m_sampler = VK_NULL_HANDLE;
+    VkDescriptorSet m_descriptor = VK_NULL_HANDLE;
+    bool m_initialized = false;  // image has left UNDEFINED layout
+
+    VkBuffer m_staging = VK_NULL_HANDLE;
+    VmaAllocation m_stagingAllocation = VK_NULL_HANDLE;
+    uint8_t* m_stagingMapped = nullptr;
+
+    uint32_t m_cellWidth = 0;
+    uint32_t m_cellHeight = 0;
+    uint32_t m_columns = 0;
+    std::vector<Cell> m_cells;
+    std::vector<int> m_freeCells;
+    std::unordered_map<uint64_t, int> m_cellOf;
+
+    std::deque<Pending> m_pending;
+    std::unordered_set<uint64_t> m_queuedKeys;
+    std::vector<VkBufferImageCopy> m_copies;  // placed this frame
+
+    uint64_t m_frame = 0;
+};
@@ -1,10 +1,13 @@
 #include "vulkan/VideoTexture.h"
 #include "vulkan/VulkanContext.h"
+#include "vulkan/YuvConverter.h"
 #include <cstdio>
 
-bool VideoTexture::init(VulkanContext& ctx, uint32_t width, uint32_t height) {
+bool VideoTexture::init(VulkanContext& ctx, uint32_t width, uint32_t height,
+                        YuvConverter* yuv) {
     m_width = width;
     m_height = height;
+    m_yuv = yuv;
 
     // Create sampler
     VkSamplerCreateInfo samplerInfo{};
@@ -28,17 +31,6 @@ void VideoTexture::shutdown(VulkanContext& ctx) {
     if (m_sampler) { vkDestroySampler(ctx.device, m_sampler, nullptr); m_sampler = VK_NULL_HANDLE; }
 }
 
-bool VideoTexture::resize(VulkanContext& ctx, uint32_t width, uint32_t height) {
-    if (width == m_width && height == m_height) return true;
-    vkDeviceWaitIdle(ctx.device);
-    destroyResources(ctx);
-    m_width = width;
-    m_height = height;
-    m_uploadSlot = 0;
-    m_displaySlot = 0;
-    return createResources(ctx);
-}
-
 int VideoTexture::acquireUploadSlot() {
     // Use the slot after the display slot, wrapping around
     m_uploadSlot = (m_displaySlot + 1) % SLOT_COUNT;
@@ -62,6 +54,7 @@ bool VideoTexture::createResources(VulkanContext& ctx) {
         imgInfo.samples = VK_SAMPLE_COUNT_1_BIT;
         imgInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
         imgInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        if (m_yuv) imgInfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;  // written by the converter
         imgInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
         VmaAllocationCreateInfo allocInfo{};
@@ -73,25 +66,9 @@ bool VideoTexture::createResources(VulkanContext& ctx) {
             return false;
         }
 
-        // Transition to shader read optimal
-        VkCommandBuffer cmd = ctx.beginSingleTimeCommands();
-        VkImageMemoryBarrier barrier{};
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.image = m_images[i];
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.levelCount = 1;
-        barrier.subresourceRange.layerCount = 1;
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        vkCmdPipelineBarrier(cmd,
-            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-            0, 0, nullptr, 0, nullptr, 1, &barrier);
-        ctx.endSingleTimeCommands(cmd);
+        // No initial layout transition (which would need a queue wait): a
+        // slot is only displayed after an upload, and uploads transition
+        // from UNDEFINED since they overwrite the whole image.
 
         // Create image view
         VkImageViewCreateInfo viewInfo{};
@@ -115,12 +92,71 @@ bool VideoTexture::createResources(VulkanContext& ctx) {
             fprintf(stderr, "Failed to register texture %d with ImGui\n", i);
             return false;
         }
+
+        if (m_yuv) {
+            uint32_t cw = (m_width + 1) / 2, ch = (m_height + 1) / 2;
+            if (!createPlane(ctx, m_planes[i][0], m_width, m_height) ||
+                !createPlane(ctx, m_planes[i][1], cw, ch) ||
+                !createPlane(ctx, m_planes[i][2], cw, ch)) {
+                return false;
+            }
+            m_convertSets[i] = m_yuv->allocateSet(ctx, m_planes[i][0].view, m_planes[i][1].view,
+                                                  m_planes[i][2].view, m_imageViews[i]);
+            if (!m_convertSets[i]) return false;
+        }
+    }
+    return true;
+}
+
+bool VideoTexture::createPlane(VulkanContext& ctx, Plane& plane, uint32_t width, uint32_t height) {
+    VkImageCreateInfo imgInfo{};
+    imgInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imgInfo.imageType = VK_IMAGE_TYPE_2D;
+    imgInfo.format = VK_FORMAT_R8_UNORM;
+    imgInfo.extent = {width, height, 1};
+    imgInfo.mipLevels = 1;
+    imgInfo.arrayLayers = 1;
+    imgInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imgInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imgInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imgInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VmaAllocationCreateInfo allocInfo{};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    if (vmaCreateImage(ctx.allocator, &imgInfo, &allocInfo,
+                       &plane.image, &plane.allocation, nullptr) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to create %ux%u plane image\n", width, height);
+        return false;
+    }
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = plane.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VK_FORMAT_R8_UNORM;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(ctx.device, &viewInfo, nullptr, &plane.view) != VK_SUCCESS) {
+        fprintf(stderr, "Failed to create plane image view\n");
+        return false;
     }
     return true;
 }
 
 void VideoTexture::destroyResources(VulkanContext& ctx) {
     for (int i = 0; i < SLOT_COUNT; i++) {
+        if (m_convertSets[i]) {
+            m_yuv->freeSet(ctx, m_convertSets[i]);
+            m_convertSets[i] = VK_NULL_HANDLE;
+        }
+        for (auto& plane : m_planes[i]) {
+            if (plane.view) vkDestroyImageView(ctx.device, plane.view, nullptr);
+            if (plane.image) vmaDestroyImage(ctx.allocator, plane.image, plane.allocation);
+            plane = Plane{};
+        }
         if (m_descriptorSets[i]) {
             ImGui_ImplVulkan_RemoveTexture(m_descriptorSets[i]);
             m_descriptorSets[i] = VK_NULL_HANDLE;
@@ -6,17 +6,19 @@
 #include <imgui_impl_vulkan.h>
 
 struct VulkanContext;
+class YuvConverter;
 
+// Triple-buffered RGBA texture for a video layer. With a YuvConverter each
+// slot also gets three R8 plane images (Y full size, U/V half size) that
+// frames are uploaded into; the converter then writes the RGBA image.
 class VideoTexture {
 public:
     static constexpr int SLOT_COUNT = 3;
 
-    bool init(VulkanContext& ctx, uint32_t width, uint32_t height);
+    bool init(VulkanContext& ctx, uint32_t width, uint32_t height,
+              YuvConverter* yuv = nullptr);
     void shutdown(VulkanContext& ctx);
 
-    // Reinitialize with new dimensions
-    bool resize(VulkanContext& ctx, uint32_t width, uint32_t height);
-
     // Get the current display slot's descriptor set for ImGui::Image()
     VkDescriptorSet getDisplayDescriptor() const { return m_descriptorSets[m_displaySlot]; }
 
@@ -25,6 +27,9 @@ public:
     void promoteUploadSlot();
 
     VkImage getImage(int slot) const { return m_images[slot]; }
+    VkImage getPlaneImage(int slot, int plane) const { return m_planes[slot][plane].image; }
+    VkDescriptorSet getConvertSet(int slot) const { return m_convertSets[slot]; }
+    bool isYuv() const { return m_yuv != nullptr; }
     uint32_t getWidth() const { return m_width; }
     uint32_t getHeight() const { return m_height; }
 
@@ -38,9 +43,19 @@ private:
     VkDescriptorSet m_descriptorSets[SLOT_COUNT]{};
     VkSampler m_sampler = VK_NULL_HANDLE;
 
+    struct Plane {
+        VkImage image = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+    };
+    YuvConverter* m_yuv = nullptr;
+    Plane m_planes[SLOT_COUNT][3]{};
+    VkDescriptorSet m_convertSets[SLOT_COUNT]{};
+
     int m_uploadSlot = 0;
     int m_displaySlot = 0;
 
     bool createResources(VulkanContext& ctx);
+    bool createPlane(VulkanContext& ctx, Plane& plane, uint32_t width, uint32_t height);
     void destroyResources(VulkanContext& ctx);
 };
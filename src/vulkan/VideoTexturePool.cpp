@@ -0,0 +1,84 @@
+#include "vulkan/VideoTexturePool.h"
+#include "vulkan/VulkanContext.h"
+#include "vulkan/Swapchain.h"
+#include <algorithm>
+#include <cstdio>
+
+VideoTexturePool::~VideoTexturePool() {
+    shutdown();
+}
+
+void VideoTexturePool::shutdown() {
+    if (!m_ctx) return;
+    for (auto& t : m_inUse) t->shutdown(*m_ctx);
+    for (auto& e : m_retired) e.texture->shutdown(*m_ctx);
+    for (auto& e : m_idle) e.texture->shutdown(*m_ctx);
+    m_inUse.clear();
+    m_retired.clear();
+    m_idle.clear();
+    m_ctx = nullptr;
+}
+
+void VideoTexturePool::beginFrame() {
+    m_frame++;
+
+    // No frame can reference these any more: they become reusable
+    for (auto it = m_retired.begin(); it != m_retired.end();) {
+        if (m_frame < it->frame + Swapchain::MAX_FRAMES_IN_FLIGHT) {
+            ++it;
+            continue;
+        }
+        m_idle.push_back({std::move(it->texture), m_frame});
+        it = m_retired.erase(it);
+    }
+
+    // Free the oldest beyond the cap, and any left unused too long
+    while (!m_idle.empty() &&
+           (m_idle.size() > MAX_IDLE || m_frame - m_idle.front().frame > MAX_IDLE_FRAMES)) {
+        freeOldestIdle();
+    }
+}
+
+void VideoTexturePool::freeOldestIdle() {
+    m_idle.front().texture->shutdown(*m_ctx);
+    m_idle.erase(m_idle.begin());
+}
+
+VideoTexture* VideoTexturePool::acquire(uint32_t width, uint32_t height, bool yuv) {
+    if (!m_ctx) return nullptr;
+
+    for (auto it = m_idle.begin(); it != m_idle.end(); ++it) {
+        if (matches(*it->texture, width, height, yuv)) {
+            m_inUse.push_back(std::move(it->texture));
+            m_idle.erase(it);
+            return m_inUse.back().get();
+        }
+    }
+
+    // Idle textures of other sizes make way before the limit is hit
+    auto alive = [this] { return m_inUse.size() + m_retired.size() + m_idle.size(); };
+    while (alive() >= MAX_TEXTURES && !m_idle.empty()) freeOldestIdle();
+    if (alive() >= MAX_TEXTURES) {
+        fprintf(stderr, "VideoTexturePool: %d textures in use, not creating another\n", MAX_TEXTURES);
+        return nullptr;
+    }
+
+    auto texture = std::make_unique<VideoTexture>();
+    if (!texture->init(*m_ctx, width, height, yuv ? m_yuv : nullptr)) {
+        fprintf(stderr, "VideoTexturePool: failed to create %ux%u%s texture\n",
+                width, height, yuv ? " yuv" : "");
+        texture->shutdown(*m_ctx);
+        return nullptr;
+    }
+    m_inUse.push_back(std::move(texture));
+    return m_inUse.back().get();
+}
+
+void VideoTexturePool::release(VideoTexture* texture) {
+    auto it = std::find_if(m_inUse.begin(), m_inUse.end(),
+                           [texture](const auto& t) { return t.get() == texture; });
+    if (it == m_inUse.end()) return;
+
+    m_retired.push_back({std::move(*it), m_frame});
+    m_inUse.erase(it);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "vulkan/VideoTexture.h"
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+struct VulkanContext;
+class YuvConverter;
+
+// Recycles VideoTextures across tracks, keyed by (format, width, height).
+//
+// A texture handed back with release() may still be sampled by a frame in
+// flight, so it sits on a retirement list until MAX_FRAMES_IN_FLIGHT frames
+// have begun (their fences were waited on) before it can be reused or
+// destroyed. Switching a track between clips of different resolution is
+// then just a pool lookup, with no vkDeviceWaitIdle stall. Idle textures are
+// capped in number and age, so sizes that stop being played are freed.
+class VideoTexturePool {
+public:
+    // Idle textures kept across all sizes, and frames one may sit unused
+    // before it is freed (~5 s at 60 fps)
+    static constexpr int MAX_IDLE = 4;
+    static constexpr uint64_t MAX_IDLE_FRAMES = 300;
+
+    // Textures alive at once (in use, retired and idle). YuvConverter sizes
+    // its descriptor pool for this many.
+    static constexpr int MAX_TEXTURES = 64;
+
+    ~VideoTexturePool();
+
+    void init(VulkanContext& ctx, YuvConverter* yuv) { m_ctx = &ctx; m_yuv = yuv; }
+    void shutdown();
+
+    // Call once per rendered frame after the frame's fence has been waited on
+    void beginFrame();
+
+    // yuv selects the plane-upload + GPU conversion layout (needs a converter)
+    VideoTexture* acquire(uint32_t width, uint32_t height, bool yuv);
+    void release(VideoTexture* texture);
+
+private:
+    struct Entry {
+        std::unique_ptr<VideoTexture> texture;
+        uint64_t frame = 0;  // when it was released, or went idle
+    };
+
+    void freeOldestIdle();
+
+    static bool matches(const VideoTexture& t, uint32_t width, uint32_t height, bool yuv) {
+        return t.getWidth() == width && t.getHeight() == height && t.isYuv() == yuv;
+    }
+
+    VulkanContext* m_ctx = nullptr;
+    YuvConverter* m_yuv = nullptr;
+
+    std::vector<std::unique_ptr<VideoTexture>> m_inUse;
+    std::vector<Entry> m_retired;  // waiting on in-flight frames
+    std::vector<Entry> m_idle;     // ready for reuse, oldest first
+    uint64_t m_frame = 0;
+};
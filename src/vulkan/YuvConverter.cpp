@@ -0,0 +1,274 @@
+#include "vulkan/YuvConverter.h"
+#include "vulkan/VulkanContext.h"
+#include "vulkan/VideoTexture.h"
+#include "vulkan/VideoTexturePool.h"
+#include <cstdio>
+
+static const uint32_t kYuvToRgbaSpv[] = {
+#include "shaders/yuv_to_rgba.comp.inc"
+};
+
+namespace {
+
+struct PushConstants {
+    float rowR[4];
+    float rowG[4];
+    float rowB[4];
+    int32_t size[2];
+};
+
+// Fold range expansion and the Y'CbCr -> R'G'B' matrix into affine rows
+// applied to normalized (y, u, v, 1) samples.
+void buildRows(const YuvColorInfo& c, PushConstants& pc) {
+    float kr = c.kr, kb = c.kb, kg = 1.0f - kr - kb;
+
+    float yScale = c.fullRange ? 1.0f : 255.0f / 219.0f;
+    float yOffset = c.fullRange ? 0.0f : 16.0f / 255.0f;
+    float cScale = c.fullRange ? 1.0f : 255.0f / 224.0f;
+    float cCenter = 128.0f / 255.0f;
+
+    float rCr = 2.0f * (1.0f - kr);
+    float gCb = -2.0f * kb * (1.0f - kb) / kg;
+    float gCr = -2.0f * kr * (1.0f - kr) / kg;
+    float bCb = 2.0f * (1.0f - kb);
+
+    auto row = [&](float* out, float aCb, float aCr) {
+        out[0] = yScale;
+        out[1] = aCb * cScale;
+        out[2] = aCr * cScale;
+        out[3] = -yScale * yOffset - (aCb + aCr) * cScale * cCenter;
+    };
+    row(pc.rowR, 0.0f, rCr);
+    row(pc.rowG, gCb, gCr);
+    row(pc.rowB, bCb, 0.0f);
+}
+
+} // namespace
+
+bool YuvConverter::init(VulkanContext& ctx) {
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    if (vkCreateSampler(ctx.device, &samplerInfo, nullptr, &m_sampler) != VK_SUCCESS) {
+        fprintf(stderr, "YuvConverter: failed to create sampler\n");
+        return false;
+    }
+
+    VkDescriptorSetLayoutBinding bindings[4]{};
+    for (int i = 0; i < 3; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    bindings[3].binding = 3;
+    bindings[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[3].descriptorCount = 1;
+    bindings[3].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 4;
+    layoutInfo.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(ctx.device, &layoutInfo, nullptr, &m_setLayout) != VK_SUCCESS) {
+        fprintf(stderr, "YuvConverter: failed to create descriptor set layout\n");
+        return false;
+    }
+
+    // One set per slot of every texture the pool can hold at once
+    constexpr uint32_t MAX_SETS = VideoTexture::SLOT_COUNT * VideoTexturePool::MAX_TEXTURES;
+    VkDescriptorPoolSize poolSizes[2]{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = MAX_SETS * 3;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[1].descriptorCount = MAX_SETS;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    poolInfo.maxSets = MAX_SETS;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+    if (vkCreateDescriptorPool(ctx.device, &poolInfo, nullptr, &m_pool) != VK_SUCCESS) {
+        fprintf(stderr, "YuvConverter: failed to create descriptor pool\n");
+        return false;
+    }
+
+    VkPushConstantRange pushRange{};
+    pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushRange.size = sizeof(PushConstants);
+
+    VkPipelineLayoutCreateInfo plInfo{};
+    plInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    plInfo.setLayoutCount = 1;
+    plInfo.pSetLayouts = &m_setLayout;
+    plInfo.pushConstantRangeCount = 1;
+    plInfo.pPushConstantRanges = &pushRange;
+    if (vkCreatePipelineLayout(ctx.device, &plInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
+        fprintf(stderr, "YuvConverter: failed to create pipeline layout\n");
+        return false;
+    }
+
+    VkShaderModuleCreateInfo smInfo{};
+    smInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    smInfo.codeSize = sizeof(kYuvToRgbaSpv);
+    smInfo.pCode = kYuvToRgbaSpv;
+    VkShaderModule module;
+    if (vkCreateShaderModule(ctx.device, &smInfo, nullptr, &module) != VK_SUCCESS) {
+        fprintf(stderr, "YuvConverter: failed to create shader module\n");
+        return false;
+    }
+
+    VkComputePipelineCreateInfo cpInfo{};
+    cpInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    cpInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    cpInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    cpInfo.stage.module = module;
+    cpInfo.stage.pName = "main";
+    cpInfo.layout = m_pipelineLayout;
+
+    VkResult res = vkCreateComputePipelines(ctx.device, VK_NULL_HANDLE, 1, &cpInfo,
+                                            nullptr, &m_pipeline);
+    vkDestroyShaderModule(ctx.device, module, nullptr);
+    if (res != VK_SUCCESS) {
+        fprintf(stderr, "YuvConverter: failed to create compute pipeline\n");
+        m_pipeline = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+void YuvConverter::shutdown(VulkanContext& ctx) {
+    if (m_pipeline) { vkDestroyPipeline(ctx.device, m_pipeline, nullptr); m_pipeline = VK_NULL_HANDLE; }
+    if (m_pipelineLayout) { vkDestroyPipelineLayout(ctx.device, m_pipelineLayout, nullptr); m_pipelineLayout = VK_NULL_HANDLE; }
+    if (m_pool) { vkDestroyDescriptorPool(ctx.device, m_pool, nullptr); m_pool = VK_NULL_HANDLE; }
+    if (m_setLayout) { vkDestroyDescriptorSetLayout(ctx.device, m_setLayout, nullptr); m_setLayout = VK_NULL_HANDLE; }
+    if (m_sampler) { vkDestroySampler(ctx.device, m_sampler, nullptr); m_sampler = VK_NULL_HANDLE; }
+}
+
+VkDescriptorSet YuvConverter::allocateSet(VulkanContext& ctx, VkImageView y, VkImageView u,
+                                          VkImageView v, VkImageView rgbaOut) {
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_setLayout;
+
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    if (vkAllocateDescriptorSets(ctx.device, &allocInfo, &set) != VK_SUCCESS) {
+        fprintf(stderr, "YuvConverter: descriptor pool exhausted\n");
+        return VK_NULL_HANDLE;
+    }
+
+    VkDescriptorImageInfo planes[3]{};
+    VkImageView views[3] = {y, u, v};
+    for (int i = 0; i < 3; i++) {
+        planes[i].sampler = m_sampler;
+        planes[i].imageView = views[i];
+        planes[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    VkDescriptorImageInfo outInfo{};
+    outInfo.imageView = rgbaOut;
+    outInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkWriteDescriptorSet writes[4]{};
+    for (int i = 0; i < 4; i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = (i < 3) ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+                                           : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[i].pImageInfo = (i < 3) ? &planes[i] : &outInfo;
+    }
+    vkUpdateDescriptorSets(ctx.device, 4, writes, 0, nullptr);
+    return set;
+}
+
+void YuvConverter::freeSet(VulkanContext& ctx, VkDescriptorSet set) {
+    if (set && m_pool) vkFreeDescriptorSets(ctx.device, m_pool, 1, &set);
+}
+
+void YuvConverter::record(VkCommandBuffer cmd, VkBuffer src, const YuvPlaneLayout& layout,
+                          VideoTexture& texture, int slot, uint32_t width, uint32_t height,
+                          const YuvColorInfo& color) {
+    uint32_t chromaW = (width + 1) / 2;
+    uint32_t chromaH = (height + 1) / 2;
+
+    // Planes: (discard) -> transfer dst, output: (discard) -> general
+    VkImageMemoryBarrier barriers[4]{};
+    for (int i = 0; i < 4; i++) {
+        auto& b = barriers[i];
+        b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        b.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        b.subresourceRange.levelCount = 1;
+        b.subresourceRange.layerCount = 1;
+        b.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        if (i < 3) {
+            b.image = texture.getPlaneImage(slot, i);
+            b.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            b.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        } else {
+            b.image = texture.getImage(slot);
+            b.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            b.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        }
+    }
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, 4, barriers);
+
+    for (int i = 0; i < 3; i++) {
+        VkBufferImageCopy region{};
+        region.bufferOffset = layout.offset[i];
+        region.bufferRowLength = layout.linesize[i];  // R8: bytes == texels
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = (i == 0) ? VkExtent3D{width, height, 1}
+                                      : VkExtent3D{chromaW, chromaH, 1};
+        vkCmdCopyBufferToImage(cmd, src, texture.getPlaneImage(slot, i),
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+
+    // Planes: transfer dst -> shader read for the compute pass
+    for (int i = 0; i < 3; i++) {
+        barriers[i].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barriers[i].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barriers[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barriers[i].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    }
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, 3, barriers);
+
+    PushConstants pc{};
+    buildRows(color, pc);
+    pc.size[0] = static_cast<int32_t>(width);
+    pc.size[1] = static_cast<int32_t>(height);
+
+    VkDescriptorSet set = texture.getConvertSet(slot);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout,
+                            0, 1, &set, 0, nullptr);
+    vkCmdPushConstants(cmd, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+                       0, sizeof(pc), &pc);
+    vkCmdDispatch(cmd, (width + 15) / 16, (height + 15) / 16, 1);
+
+    // Output: general -> shader read for the viewport
+    auto& out = barriers[3];
+    out.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    out.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    out.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    out.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &out);
+}
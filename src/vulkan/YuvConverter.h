@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+struct VulkanContext;
+class VideoTexture;
+
+// Where each plane of a packed YUV 4:2:0 frame lives inside a source buffer.
+struct YuvPlaneLayout {
+    uint32_t offset[3]{};       // bytes from buffer start (Y, U, V)
+    uint32_t linesize[3]{};     // bytes per row
+};
+
+// Colour metadata needed to turn Y'CbCr into R'G'B'.
+struct YuvColorInfo {
+    float kr = 0.2126f;         // luma coefficients (BT.709 by default)
+    float kb = 0.0722f;
+    bool fullRange = false;     // JPEG/full range instead of 16-235/240
+};
+
+// GPU YUV 4:2:0 -> RGBA conversion for the preview viewport.
+//
+// Decoded frames are uploaded as three R8 planes (1.5 bytes/pixel instead
+// of 4), then a compute pass applies the BT.601/709/2020 matrix and range
+// expansion and writes the RGBA slot that ImGui samples. It needs only core
+// Vulkan 1.0 compute and works on software ICDs such as lavapipe.
+class YuvConverter {
+public:
+    bool init(VulkanContext& ctx);
+    void shutdown(VulkanContext& ctx);
+
+    bool isReady() const { return m_pipeline != VK_NULL_HANDLE; }
+
+    // Descriptor set binding three plane views and the RGBA output view.
+    // Owned by the caller; free with freeSet().
+    VkDescriptorSet allocateSet(VulkanContext& ctx, VkImageView y, VkImageView u,
+                                VkImageView v, VkImageView rgbaOut);
+    void freeSet(VulkanContext& ctx, VkDescriptorSet set);
+
+    // Record plane copies from src and the conversion into texture's slot.
+    void record(VkCommandBuffer cmd, VkBuffer src, const YuvPlaneLayout& layout,
+                VideoTexture& texture, int slot, uint32_t width, uint32_t height,
+                const YuvColorInfo& color);
+
+private:
+    VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool m_pool = VK_NULL_HANDLE;
+    VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline m_pipeline = VK_NULL_HANDLE;
+    VkSampler m_sampler = VK_NULL_HANDLE;
+};
@@ -0,0 +1,136 @@
+// Regression tests for the timeline model (Timeline and its ClipIndex).
+// Each check compares what the index answers against the clips' own
+// timing, which is what playback, export and the lanes rely on agreeing.
+//
+//   cmake -S . -B build -DVIDEO_EDITOR_TESTS=ON && cmake --build build --target timeline-test
+//   ctest --test-dir build --output-on-failure
+
+#include "timeline/Timeline.h"
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool ok, const char* test, const char* what) {
+    if (ok) return;
+    fprintf(stderr, "FAIL %s: %s\n", test, what);
+    g_failures++;
+}
+
+bool near(double a, double b) { return std::abs(a - b) < 1e-9; }
+
+// Every clip on the track is found by its start and by a range query over
+// its extent, and the index holds the clip's current timing
+void checkTrackConsistent(const Timeline& timeline, uint32_t trackId, const char* test) {
+    const Track* track = timeline.getTrack(trackId);
+    check(track != nullptr, test, "track missing");
+    if (!track) return;
+
+    for (const auto& [clipId, clip] : timeline.getAllClips()) {
+        if (clip.trackId != trackId) continue;
+
+        ClipSpan span;
+        bool indexed = track->clips.find(clipId, span);
+        check(indexed, test, "clip not indexed");
+        if (!indexed) continue;
+        check(near(span.start, clip.timelineStart) && near(span.end, clip.getTimelineEnd()),
+              test, "index span differs from clip timing");
+
+        bool seen = false;
+        track->clips.forEachOverlapping(clip.timelineStart, clip.getTimelineEnd(), [&](const ClipSpan& s) {
+            if (s.clipId == clipId) seen = true;
+        });
+        check(seen, test, "range query misses clip");
+
+        // Whichever clip is reported at the start must contain it
+        uint32_t at = track->clips.clipIdAt(clip.timelineStart);
+        const Clip* atClip = timeline.getClip(at);
+        check(atClip && atClip->containsTime(clip.timelineStart), test, "clipIdAt misses clip start");
+    }
+}
+
+// A [0,10), B [5,15) overlapping it (a crossfade), C [10,20)
+struct Overlapping {
+    Timeline timeline;
+    uint32_t track = 0;
+    uint32_t a = 0, b = 0, c = 0;
+
+    Overlapping() {
+        track = timeline.addTrack("Audio 1", TrackType::Audio);
+        a = timeline.addClip(track, 1, 0.0, 0.0, 10.0);
+        b = timeline.addClip(track, 1, 5.0, 0.0, 10.0);
+        c = timeline.addClip(track, 1, 10.0, 0.0, 10.0);
+    }
+};
+
+void testRippleDeleteOverlapping() {
+    const char* test = "rippleDelete with overlapping clips";
+    Overlapping o;
+    o.timeline.rippleDelete(o.a);
+
+    const Timeline& t = o.timeline;
+    const Clip* b = t.getClip(o.b);
+    const Clip* c = t.getClip(o.c);
+    check(t.getClip(o.a) == nullptr, test, "deleted clip still there");
+    check(b && near(b->timelineStart, 5.0), test, "clip starting before the edit point moved");
+    check(c && near(c->timelineStart, 0.0), test, "later clip not shifted back");
+
+    const Track* track = t.getTrack(o.track);
+    check(track->clips.clipIdAt(1.0) == o.c, test, "clipIdAt(1) misses the shifted clip");
+    bool seen = false;
+    track->clips.forEachOverlapping(0.0, 4.0, [&](const ClipSpan& s) { seen |= s.clipId == o.c; });
+    check(seen, test, "forEachOverlapping(0, 4) misses the shifted clip");
+    checkTrackConsistent(t, o.track, test);
+}
+
+void testRippleTrimOverlapping() {
+    const char* test = "rippleTrim with overlapping clips";
+    Overlapping o;
+    o.timeline.rippleTrim(o.a, 0.0, 5.0);  // A ends at 5: C moves back to 5
+
+    const Timeline& t = o.timeline;
+    const Clip* a = t.getClip(o.a);
+    const Clip* b = t.getClip(o.b);
+    const Clip* c = t.getClip(o.c);
+    check(a && near(a->getTimelineEnd(), 5.0), test, "trimmed clip has the wrong end");
+    check(b && near(b->timelineStart, 5.0), test, "clip starting before the edit point moved");
+    check(c && near(c->timelineStart, 5.0), test, "later clip not shifted back");
+
+    const Track* track = t.getTrack(o.track);
+    bool seen = false;
+    track->clips.forEachOverlapping(5.0, 6.0, [&](const ClipSpan& s) { seen |= s.clipId == o.c; });
+    check(seen, test, "forEachOverlapping(5, 6) misses the shifted clip");
+    checkTrackConsistent(t, o.track, test);
+}
+
+void testRippleSnapshotUnaffected() {
+    const char* test = "ripple edit after a snapshot";
+    Overlapping o;
+    Timeline snapshot = o.timeline.snapshot();
+    o.timeline.rippleDelete(o.a);
+
+    const Clip* c = snapshot.getClip(o.c);
+    check(snapshot.getClip(o.a) != nullptr, test, "snapshot lost the deleted clip");
+    check(c && near(c->timelineStart, 10.0), test, "snapshot saw the shift");
+    checkTrackConsistent(snapshot, o.track, test);
+    checkTrackConsistent(o.timeline, o.track, test);
+}
+
+} // namespace
+
+int main() {
+    testRippleDeleteOverlapping();
+    testRippleTrimOverlapping();
+    testRippleSnapshotUnaffected();
+
+    if (g_failures) {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("timeline tests passed\n");
+    return 0;
+}